@@ -89,22 +89,23 @@ namespace ceras
     template <Expression Ex>
     auto constexpr softmax( Ex const& ex ) noexcept
     {
-        return make_unary_operator( []<Tensor Tsor>( Tsor const& input ) noexcept
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        return make_unary_operator( ceras_private::elementwise_forward{ forward_cache, []<Tensor Tsor>( Tsor const& input, Tsor& x ) noexcept
                                     {
                                         better_assert( !input.empty(), "softmax forward: input tensor is empty!" );
-                                        Tsor x = deep_copy( input );
+                                        if ( x.data() != input.data() )
+                                            std::copy( input.begin(), input.end(), x.begin() );
                                         std::size_t const last_dim = *(x.shape().rbegin());
                                         std::size_t const rest_dim = x.size() / last_dim;
-                                        for ( auto idx : range( rest_dim ) )
+                                        parallel_for( [&]( unsigned long idx )
                                         {
                                             auto [begin, end] = std::make_tuple( x.begin()+idx*last_dim, x.begin()+(idx+1)*last_dim );
                                             typename Tsor::value_type const mx = *std::max_element( begin, end );
                                             for_each( begin, end, [mx]( auto & v ){ v = std::exp( v-mx ); } );
                                             typename Tsor::value_type const sum = std::accumulate( begin, end, typename Tsor::value_type{0} );
                                             for_each( begin, end, [sum]( auto & v ){ v /= sum; } );
-                                        }
-                                        return x;
-                                    },
+                                        }, rest_dim, 30.0 * static_cast<double>( last_dim ) );
+                                    } },
                                     []<Tensor Tsor>( Tsor const&, Tsor const& output, Tsor const& grad ) noexcept
                                     {
                                         better_assert( !has_nan( grad ), "backprop: upcoming gradient for activation softmax contains NaN" );
@@ -251,15 +252,10 @@ namespace ceras
     {
         std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
         std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
-        return make_unary_operator( [forward_cache]<Tensor Tsor>( Tsor const& input ) noexcept
+        return make_unary_operator( ceras_private::elementwise_forward{ forward_cache, []<Tensor Tsor>( Tsor const& input, Tsor& output ) noexcept
                                     {
-                                        Tsor& ans = context_cast<Tsor>( forward_cache );
-                                        ans.resize( input.shape() );
-                                        std::copy( input.begin(), input.end(), ans.begin() );
-                                        //auto ans = input.deep_copy();
-                                        ans.map( [](auto& x){ x = 1.0 / (1.0+std::exp(-x)); } );
-                                        return ans;
-                                    },
+                                        for_each( output.begin(), output.end(), input.begin(), []( auto& o, auto x ){ o = 1.0 / (1.0+std::exp(-x)); } );
+                                    } },
                                     [backward_cache]<Tensor Tsor>( Tsor const&, Tsor const& output, Tsor const& grad ) noexcept
                                     {
                                         Tsor& ans = context_cast<Tsor>( backward_cache );
@@ -281,17 +277,12 @@ namespace ceras
             {
                 return []( std::shared_ptr<std::any> forward_cache ) noexcept
                 {
-                    return [forward_cache]<Tensor Tsor>( Tsor const& input ) noexcept
+                    return ceras_private::elementwise_forward{ forward_cache, []<Tensor Tsor>( Tsor const& input, Tsor& output ) noexcept
                     {
                         better_assert( input.size(), "relu::forward: empty input." );
                         typedef typename Tsor::value_type value_type;
-                        Tsor& ans = context_cast<Tsor>( forward_cache );
-                        ans.resize( input.shape()  );
-
-                        for_each( ans.begin(), ans.end(), input.begin(), [](auto& o, auto x){ o = std::max(x, value_type{0}); } );
-
-                        return ans;
-                    };
+                        for_each( output.begin(), output.end(), input.begin(), [](auto& o, auto x){ o = std::max(x, value_type{0}); } );
+                    } };
                 };
             }
 
@@ -304,8 +295,8 @@ namespace ceras
                     better_assert( grad.size(), "relu::backward: empty grad." );
                     typedef typename Tsor::value_type value_type;
                     Tsor ans = grad; // shallow copy
-                    //for_each( ans.begin(), ans.end(), input.begin(), []( auto& v, auto x ){ if ( x <= value_type{0} ) v = value_type{0}; } );
-                    for_each( ans.begin(), ans.end(), input.begin(), []( auto& v, auto x ){  v *= ( x > value_type{0} ); } );
+                    // reading the output, as the input may have been overwritten by it: x > 0 if and only if relu(x) > 0
+                    for_each( ans.begin(), ans.end(), output.begin(), []( auto& v, auto o ){  v *= ( o > value_type{0} ); } );
                     return ans;
                 };
             }
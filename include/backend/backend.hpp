@@ -6,6 +6,7 @@
 
 #include "./cuda.hpp"
 #include "./cblas.hpp"
+#include "./cpu.hpp"
 
 namespace ceras::backend
 {
@@ -0,0 +1,876 @@
+#ifndef CPU_HPP_INCLUDED_QXBNVKZRHWTJMSOFLEPAGUDYICQWZMNBVXLKJHGFDSAPOIUYTREWQ
+#define CPU_HPP_INCLUDED_QXBNVKZRHWTJMSOFLEPAGUDYICQWZMNBVXLKJHGFDSAPOIUYTREWQ
+
+#include "../includes.hpp"
+#include "../config.hpp"
+#include "../utils/better_assert.hpp"
+#include "../utils/parallel.hpp"
+#include "../utils/cpu_features.hpp"
+
+#if CERAS_X86
+#include <immintrin.h>
+#endif
+
+namespace ceras
+{
+
+    ///
+    /// @brief Block sizes used by the packed CPU GEMM.
+    ///
+    /// A `row_block x depth_block` block of A is packed to stay in L2, and a `depth_block x col_block` block of B is packed to stay in L3.
+    /// The micro-kernel then streams register tiles from these packed panels, keeping one depth slice of a B panel in L1.
+    /// Large products are divided into 2D blocks of the output and, for tall-skinny shapes, also along the depth, one block per thread.
+    /// Modifications take effect on the next call of `cpu_gemm`.
+    ///
+    /// \code{.cpp}
+    /// get_cpu_gemm_config().depth_block = 384;
+    /// \endcode
+    ///
+    struct cpu_gemm_config
+    {
+        unsigned long row_block = 144;
+        unsigned long depth_block = 256;
+        unsigned long col_block = 4096;
+        unsigned long threads = 0; ///< threads used by one GEMM, 0 for all the cores
+        unsigned long parallel_threshold = 1UL << 21; ///< minimal m*n*k of a GEMM running on more than one thread
+        unsigned long cblas_threshold = 0; ///< minimal m*n*k of a GEMM sent to CBLAS, if compiled with CBLAS
+    };
+
+    ///
+    /// @brief Key of the configurations tuned for this host: the CPU model, the instruction set in use and the number of hardware threads.
+    ///
+    inline std::string cpu_gemm_tuning_key()
+    {
+        return cpu_model() + std::string{ "|" } + isa_name( current_isa() ) + std::string{ "|" } + std::to_string( std::thread::hardware_concurrency() );
+    }
+
+    ///
+    /// @brief The file keeping the tuned configurations, one line per host.
+    ///
+    /// It is the environment variable `CERAS_GEMM_TUNING_CACHE` if set, or `$HOME/.cache/ceras/cpu_gemm_tuning.txt`. Empty if neither is available.
+    ///
+    inline std::filesystem::path cpu_gemm_tuning_cache()
+    {
+        if ( char const* path = std::getenv( "CERAS_GEMM_TUNING_CACHE" ); path )
+            return std::filesystem::path{ path };
+        if ( char const* home = std::getenv( "HOME" ); home )
+            return std::filesystem::path{ home } / ".cache" / "ceras" / "cpu_gemm_tuning.txt";
+        return std::filesystem::path{};
+    }
+
+    namespace ceras_private
+    {
+        // the value of the line `key\tvalue` of a tuning cache file, if any
+        inline std::optional<std::string> read_tuning_cache( std::filesystem::path const& cache_file, std::string const& key )
+        {
+            std::ifstream ifs{ cache_file };
+            for ( std::string line; std::getline( ifs, line ); )
+            {
+                auto const tab = line.find( '\t' );
+                if ( tab != std::string::npos && line.substr( 0, tab ) == key )
+                    return line.substr( tab + 1 );
+            }
+            return std::nullopt;
+        }
+
+        // write the line `key\tvalue` to a tuning cache file, replacing the former one of the same key; false if the file cannot be written
+        inline bool write_tuning_cache( std::filesystem::path const& cache_file, std::string const& key, std::string const& value )
+        {
+            if ( cache_file.empty() )
+                return false;
+
+            std::vector<std::string> lines;
+            {
+                std::ifstream ifs{ cache_file };
+                for ( std::string line; std::getline( ifs, line ); )
+                    if ( line.substr( 0, line.find( '\t' ) ) != key )
+                        lines.push_back( line );
+            }
+            lines.push_back( key + std::string{ "\t" } + value );
+
+            std::error_code ec;
+            if ( cache_file.has_parent_path() )
+                std::filesystem::create_directories( cache_file.parent_path(), ec );
+            // write aside then rename, so that concurrent processes never read a truncated file
+            std::filesystem::path const temporary = cache_file.string() + std::string{ ".tmp" } + std::to_string( std::hash<std::thread::id>{}( std::this_thread::get_id() ) ^
+                                                                                                      static_cast<std::size_t>( std::chrono::steady_clock::now().time_since_epoch().count() ) );
+            {
+                std::ofstream ofs{ temporary };
+                if ( !ofs )
+                    return false;
+                for ( auto const& line : lines )
+                    ofs << line << "\n";
+                if ( !ofs.good() )
+                    return false;
+            }
+            std::filesystem::rename( temporary, cache_file, ec );
+            if ( !ec )
+                return true;
+            std::filesystem::remove( temporary, ec );
+            return false;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Read the configuration tuned for `key` from the cache file.
+    ///
+    inline std::optional<cpu_gemm_config> load_cpu_gemm_config( std::filesystem::path const& cache_file = cpu_gemm_tuning_cache(), std::string const& key = cpu_gemm_tuning_key() )
+    {
+        auto const value = ceras_private::read_tuning_cache( cache_file, key );
+        if ( !value )
+            return std::nullopt;
+        cpu_gemm_config config;
+        std::istringstream iss{ *value };
+        if ( iss >> config.row_block >> config.depth_block >> config.col_block >> config.threads >> config.parallel_threshold >> config.cblas_threshold &&
+             config.row_block && config.depth_block && config.col_block )
+            return config;
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief Write the configuration tuned for `key` to the cache file, replacing the former one of the same key.
+    /// @return False if the cache file cannot be written.
+    ///
+    inline bool save_cpu_gemm_config( cpu_gemm_config const& config, std::filesystem::path const& cache_file = cpu_gemm_tuning_cache(), std::string const& key = cpu_gemm_tuning_key() )
+    {
+        return ceras_private::write_tuning_cache( cache_file, key, std::to_string( config.row_block ) + " " + std::to_string( config.depth_block ) + " " + std::to_string( config.col_block ) + " " +
+                                                                   std::to_string( config.threads ) + " " + std::to_string( config.parallel_threshold ) + " " + std::to_string( config.cblas_threshold ) );
+    }
+
+    ///
+    /// @brief The configuration in use, initialized from the cache file of `tune_cpu_gemm` if this host has been tuned.
+    ///
+    inline cpu_gemm_config& get_cpu_gemm_config() noexcept
+    {
+        static cpu_gemm_config config = load_cpu_gemm_config().value_or( cpu_gemm_config{} );
+        return config;
+    }
+
+    namespace ceras_private
+    {
+
+        // growing aligned buffer, released at thread exit
+        template< typename T >
+        struct gemm_buffer
+        {
+            T* data_ = nullptr;
+            unsigned long size_ = 0;
+
+            T* get( unsigned long size )
+            {
+                if ( size > size_ )
+                {
+                    release();
+                    data_ = static_cast<T*>( ::operator new( size * sizeof(T), std::align_val_t{memory_alignment} ) );
+                    size_ = size;
+                }
+                return data_;
+            }
+
+            void release() noexcept
+            {
+                if ( data_ )
+                    ::operator delete( data_, std::align_val_t{memory_alignment} );
+                data_ = nullptr;
+                size_ = 0;
+            }
+
+            ~gemm_buffer() noexcept
+            {
+                release();
+            }
+        };
+
+        // thread-local packing buffer, `Index` distinguishes the lhs and rhs panels
+        template< typename T, unsigned long Index >
+        T* gemm_scratch( unsigned long size )
+        {
+            thread_local gemm_buffer<T> buffer;
+            return buffer.get( size );
+        }
+
+        // a matrix whose element (r, c) is stored at data_[r*row_stride_ + c*col_stride_]
+        template< typename T >
+        struct strided_matrix
+        {
+            T const* data_;
+            unsigned long row_stride_;
+            unsigned long col_stride_;
+
+            T operator()( unsigned long r, unsigned long c ) const noexcept
+            {
+                return data_[r*row_stride_ + c*col_stride_];
+            }
+        };
+
+        // an operand packed in advance into panels spanning the whole depth, the layout produced by `pack_lhs` and `pack_rhs` over the full matrix
+        template< typename T >
+        struct prepacked_panels
+        {
+            T const* data_;
+            unsigned long depth_;
+            unsigned long panel_; // MR for a lhs, NR for a rhs
+
+            // the panel holding row (lhs) or column (rhs) `index`, starting from `depth_first`
+            T const* panel( unsigned long index, unsigned long depth_first ) const noexcept
+            {
+                return data_ + ( index / panel_ ) * depth_ * panel_ + depth_first * panel_;
+            }
+        };
+
+        template< typename T >
+        struct is_prepacked : std::false_type {};
+
+        template< typename T >
+        struct is_prepacked<prepacked_panels<T>> : std::true_type {};
+
+        template< typename T >
+        inline constexpr bool is_prepacked_v = is_prepacked<T>::value;
+
+        // pack rows [row_first, row_first+rows) and depth [depth_first, depth_first+depth) of lhs into MR-row panels,
+        // each panel stores MR consecutive values per depth step, padding the last panel with zeros
+        template< unsigned long MR, typename T, typename Lhs >
+        void pack_lhs( Lhs const& lhs, unsigned long row_first, unsigned long rows, unsigned long depth_first, unsigned long depth, T* __restrict__ buffer ) noexcept
+        {
+            for ( unsigned long r = 0; r < rows; r += MR )
+            {
+                unsigned long const mr = std::min( MR, rows - r );
+                for ( unsigned long d = 0; d != depth; ++d )
+                {
+                    for ( unsigned long i = 0; i != mr; ++i )
+                        buffer[i] = lhs( row_first+r+i, depth_first+d );
+                    for ( unsigned long i = mr; i != MR; ++i )
+                        buffer[i] = T{0};
+                    buffer += MR;
+                }
+            }
+        }
+
+        // pack depth [depth_first, depth_first+depth) and cols [col_first, col_first+cols) of rhs into NR-column panels
+        template< unsigned long NR, typename T, typename Rhs >
+        void pack_rhs( Rhs const& rhs, unsigned long depth_first, unsigned long depth, unsigned long col_first, unsigned long cols, T* __restrict__ buffer ) noexcept
+        {
+            for ( unsigned long c = 0; c < cols; c += NR )
+            {
+                unsigned long const nr = std::min( NR, cols - c );
+                for ( unsigned long d = 0; d != depth; ++d )
+                {
+                    for ( unsigned long j = 0; j != nr; ++j )
+                        buffer[j] = rhs( depth_first+d, col_first+c+j );
+                    for ( unsigned long j = nr; j != NR; ++j )
+                        buffer[j] = T{0};
+                    buffer += NR;
+                }
+            }
+        }
+
+        // portable MR x NR micro-kernel, C[MR x NR] (+)= packed_a[MR x depth] * packed_b[depth x NR]
+        template< typename T, unsigned long MR, unsigned long NR >
+        struct generic_kernel
+        {
+            typedef T value_type;
+            static constexpr unsigned long row_tile = MR;
+            static constexpr unsigned long col_tile = NR;
+
+            static void run( unsigned long depth, T const* __restrict__ a, T const* __restrict__ b, T* __restrict__ c, unsigned long ldc, bool accumulate ) noexcept
+            {
+                T acc[MR][NR] = {};
+                for ( unsigned long d = 0; d != depth; ++d, a += MR, b += NR )
+                    for ( unsigned long i = 0; i != MR; ++i )
+                        for ( unsigned long j = 0; j != NR; ++j )
+                            acc[i][j] += a[i] * b[j];
+
+                for ( unsigned long i = 0; i != MR; ++i )
+                    for ( unsigned long j = 0; j != NR; ++j )
+                        c[i*ldc+j] = accumulate ? c[i*ldc+j] + acc[i][j] : acc[i][j];
+            }
+        };
+
+        // MR x (NV*Simd::width) micro-kernel holding the whole C tile in vector registers,
+        // compiled for the instruction set of Simd by running the loops through its trampoline.
+        // The lambda never exists out of line, so passing vectors to the Simd functions does not cross an ABI boundary.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+        template< typename Simd, unsigned long MR, unsigned long NV >
+        struct simd_kernel
+        {
+            typedef typename Simd::value_type value_type;
+            typedef typename Simd::type vector_type;
+            static constexpr unsigned long row_tile = MR;
+            static constexpr unsigned long col_tile = NV * Simd::width;
+
+            static void run( unsigned long depth, value_type const* __restrict__ a, value_type const* __restrict__ b, value_type* __restrict__ c, unsigned long ldc, bool accumulate ) noexcept
+            {
+                Simd::invoke( [=]()
+                {
+                    vector_type acc[MR][NV];
+                    for ( unsigned long i = 0; i != MR; ++i )
+                        for ( unsigned long v = 0; v != NV; ++v )
+                            acc[i][v] = Simd::zero();
+
+                    value_type const* pa = a;
+                    value_type const* pb = b;
+                    for ( unsigned long d = 0; d != depth; ++d, pa += MR, pb += col_tile )
+                    {
+                        vector_type b_row[NV];
+                        for ( unsigned long v = 0; v != NV; ++v )
+                            b_row[v] = Simd::load( pb + v*Simd::width );
+                        for ( unsigned long i = 0; i != MR; ++i )
+                        {
+                            vector_type const a_value = Simd::broadcast( pa + i );
+                            for ( unsigned long v = 0; v != NV; ++v )
+                                acc[i][v] = Simd::fmadd( a_value, b_row[v], acc[i][v] );
+                        }
+                    }
+
+                    for ( unsigned long i = 0; i != MR; ++i )
+                        for ( unsigned long v = 0; v != NV; ++v )
+                        {
+                            value_type* p = c + i*ldc + v*Simd::width;
+                            Simd::store( p, accumulate ? Simd::add( Simd::loadu( p ), acc[i][v] ) : acc[i][v] );
+                        }
+                } );
+            }
+        };
+#pragma GCC diagnostic pop
+
+#if CERAS_X86
+CERAS_BEGIN_TARGET( CERAS_TARGET_SSE42 )
+        struct sse42_float
+        {
+            typedef float value_type;
+            typedef __m128 type;
+            static constexpr unsigned long width = 4;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_sse42( func ); }
+            static type zero() noexcept { return _mm_setzero_ps(); }
+            static type load( float const* p ) noexcept { return _mm_load_ps( p ); }
+            static type loadu( float const* p ) noexcept { return _mm_loadu_ps( p ); }
+            static void store( float* p, type v ) noexcept { _mm_storeu_ps( p, v ); }
+            static type broadcast( float const* p ) noexcept { return _mm_set1_ps( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+            static type add( type a, type b ) noexcept { return _mm_add_ps( a, b ); }
+        };
+
+        struct sse42_double
+        {
+            typedef double value_type;
+            typedef __m128d type;
+            static constexpr unsigned long width = 2;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_sse42( func ); }
+            static type zero() noexcept { return _mm_setzero_pd(); }
+            static type load( double const* p ) noexcept { return _mm_load_pd( p ); }
+            static type loadu( double const* p ) noexcept { return _mm_loadu_pd( p ); }
+            static void store( double* p, type v ) noexcept { _mm_storeu_pd( p, v ); }
+            static type broadcast( double const* p ) noexcept { return _mm_set1_pd( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm_add_pd( _mm_mul_pd( a, b ), c ); }
+            static type add( type a, type b ) noexcept { return _mm_add_pd( a, b ); }
+        };
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX2 )
+        struct avx2_float
+        {
+            typedef float value_type;
+            typedef __m256 type;
+            static constexpr unsigned long width = 8;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx2( func ); }
+            static type zero() noexcept { return _mm256_setzero_ps(); }
+            static type load( float const* p ) noexcept { return _mm256_load_ps( p ); }
+            static type loadu( float const* p ) noexcept { return _mm256_loadu_ps( p ); }
+            static void store( float* p, type v ) noexcept { _mm256_storeu_ps( p, v ); }
+            static type broadcast( float const* p ) noexcept { return _mm256_broadcast_ss( p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm256_fmadd_ps( a, b, c ); }
+            static type add( type a, type b ) noexcept { return _mm256_add_ps( a, b ); }
+        };
+
+        struct avx2_double
+        {
+            typedef double value_type;
+            typedef __m256d type;
+            static constexpr unsigned long width = 4;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx2( func ); }
+            static type zero() noexcept { return _mm256_setzero_pd(); }
+            static type load( double const* p ) noexcept { return _mm256_load_pd( p ); }
+            static type loadu( double const* p ) noexcept { return _mm256_loadu_pd( p ); }
+            static void store( double* p, type v ) noexcept { _mm256_storeu_pd( p, v ); }
+            static type broadcast( double const* p ) noexcept { return _mm256_broadcast_sd( p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm256_fmadd_pd( a, b, c ); }
+            static type add( type a, type b ) noexcept { return _mm256_add_pd( a, b ); }
+        };
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX512 )
+        struct avx512_float
+        {
+            typedef float value_type;
+            typedef __m512 type;
+            static constexpr unsigned long width = 16;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx512( func ); }
+            static type zero() noexcept { return _mm512_setzero_ps(); }
+            static type load( float const* p ) noexcept { return _mm512_load_ps( p ); }
+            static type loadu( float const* p ) noexcept { return _mm512_loadu_ps( p ); }
+            static void store( float* p, type v ) noexcept { _mm512_storeu_ps( p, v ); }
+            static type broadcast( float const* p ) noexcept { return _mm512_set1_ps( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm512_fmadd_ps( a, b, c ); }
+            static type add( type a, type b ) noexcept { return _mm512_add_ps( a, b ); }
+        };
+
+        struct avx512_double
+        {
+            typedef double value_type;
+            typedef __m512d type;
+            static constexpr unsigned long width = 8;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx512( func ); }
+            static type zero() noexcept { return _mm512_setzero_pd(); }
+            static type load( double const* p ) noexcept { return _mm512_load_pd( p ); }
+            static type loadu( double const* p ) noexcept { return _mm512_loadu_pd( p ); }
+            static void store( double* p, type v ) noexcept { _mm512_storeu_pd( p, v ); }
+            static type broadcast( double const* p ) noexcept { return _mm512_set1_pd( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm512_fmadd_pd( a, b, c ); }
+            static type add( type a, type b ) noexcept { return _mm512_add_pd( a, b ); }
+        };
+CERAS_END_TARGET
+#endif
+
+        //
+        // Call func( Kernel{} ) with the micro-kernel of T for the given instruction set:
+        // 8 x 48 floats with AVX-512 (24 accumulators out of 32 registers), 6 x 16 with AVX2 and 6 x 8 with SSE4.2 (12 out of 16),
+        // and the same number of vectors for doubles.
+        //
+        template< typename T, typename Function >
+        decltype(auto) with_gemm_kernel( isa instruction_set, Function&& func )
+        {
+#if CERAS_X86
+            typedef std::conditional_t<std::is_same_v<T, float>, sse42_float, sse42_double> sse42_type;
+            typedef std::conditional_t<std::is_same_v<T, float>, avx2_float, avx2_double> avx2_type;
+            typedef std::conditional_t<std::is_same_v<T, float>, avx512_float, avx512_double> avx512_type;
+            if constexpr ( std::is_same_v<T, float> || std::is_same_v<T, double> )
+            {
+                switch ( instruction_set )
+                {
+                    case isa::avx512: return func( simd_kernel<avx512_type, 8, 3>{} );
+                    case isa::avx2: return func( simd_kernel<avx2_type, 6, 2>{} );
+                    case isa::sse42: return func( simd_kernel<sse42_type, 6, 2>{} );
+                    default: break;
+                }
+            }
+#endif
+            return func( generic_kernel<T, 4, 8>{} );
+        }
+
+        // the epilogue of a plain GEMM
+        struct no_epilogue
+        {
+            template< typename T >
+            void operator()( T*, unsigned long, unsigned long, unsigned long, unsigned long, unsigned long ) const noexcept {}
+        };
+
+        template< typename Epilogue >
+        inline constexpr bool has_epilogue_v = !std::is_same_v<Epilogue, no_epilogue>;
+
+        inline unsigned long round_up( unsigned long value, unsigned long unit ) noexcept
+        {
+            return ( ( value + unit - 1 ) / unit ) * unit;
+        }
+
+        //
+        // C[rows x cols] = lhs[row_first.., depth_first..] * rhs[depth_first.., col_first..], over `depth` steps,
+        // with C pointing to the top-left corner of the output block, row-major with leading dimension ldc
+        //
+        // Loop order follows the Goto/BLIS scheme: the col-block of rhs is packed once per depth-block,
+        // the row-block of lhs is packed once per (col-block, depth-block), and the micro-kernel walks register tiles.
+        // The epilogue is applied to every micro-tile right after its last depth-block, while the tile is still in L1.
+        //
+        template< typename Kernel, typename T, typename Lhs, typename Rhs, typename Epilogue = no_epilogue >
+        void packed_gemm_block( Lhs const& lhs, Rhs const& rhs, unsigned long row_first, unsigned long rows, unsigned long depth_first, unsigned long depth,
+                                unsigned long col_first, unsigned long cols, T* C, unsigned long ldc, Epilogue const& epilogue = Epilogue{} )
+        {
+            constexpr unsigned long MR = Kernel::row_tile;
+            constexpr unsigned long NR = Kernel::col_tile;
+
+            if ( depth == 0 )
+            {
+                for ( unsigned long r = 0; r != rows; ++r )
+                    std::fill_n( C + r*ldc, cols, T{0} );
+                epilogue( C, ldc, row_first, rows, col_first, cols );
+                return;
+            }
+
+            cpu_gemm_config const& config = get_cpu_gemm_config();
+            unsigned long const row_block = std::min( round_up( std::max( config.row_block, MR ), MR ), round_up( rows, MR ) );
+            unsigned long const col_block = std::min( round_up( std::max( config.col_block, NR ), NR ), round_up( cols, NR ) );
+            unsigned long const depth_block = std::min( std::max( config.depth_block, 1UL ), depth );
+
+            T* rhs_buffer = is_prepacked_v<Rhs> ? nullptr : gemm_scratch<T, 0>( depth_block * col_block );
+            T* lhs_buffer = is_prepacked_v<Lhs> ? nullptr : gemm_scratch<T, 1>( row_block * depth_block );
+            alignas(memory_alignment) T tile[MR*NR];
+
+            for ( unsigned long jc = 0; jc < cols; jc += col_block )
+            {
+                unsigned long const nc = std::min( col_block, cols - jc );
+                for ( unsigned long pc = 0; pc < depth; pc += depth_block )
+                {
+                    unsigned long const kc = std::min( depth_block, depth - pc );
+                    bool const accumulate = pc != 0;
+                    bool const last = pc + kc == depth;
+                    if constexpr( !is_prepacked_v<Rhs> )
+                        pack_rhs<NR>( rhs, depth_first+pc, kc, col_first+jc, nc, rhs_buffer );
+
+                    for ( unsigned long ic = 0; ic < rows; ic += row_block )
+                    {
+                        unsigned long const mc = std::min( row_block, rows - ic );
+                        if constexpr( !is_prepacked_v<Lhs> )
+                            pack_lhs<MR>( lhs, row_first+ic, mc, depth_first+pc, kc, lhs_buffer );
+
+                        for ( unsigned long jr = 0; jr < nc; jr += NR )
+                        {
+                            unsigned long const nr = std::min( NR, nc - jr );
+                            T const* b_panel;
+                            if constexpr( is_prepacked_v<Rhs> )
+                                b_panel = rhs.panel( col_first+jc+jr, depth_first+pc );
+                            else
+                                b_panel = rhs_buffer + jr * kc;
+
+                            for ( unsigned long ir = 0; ir < mc; ir += MR )
+                            {
+                                unsigned long const mr = std::min( MR, mc - ir );
+                                T const* a_panel;
+                                if constexpr( is_prepacked_v<Lhs> )
+                                    a_panel = lhs.panel( row_first+ic+ir, depth_first+pc );
+                                else
+                                    a_panel = lhs_buffer + ir * kc;
+                                T* c = C + (ic+ir)*ldc + jc + jr;
+
+                                if ( mr == MR && nr == NR )
+                                    Kernel::run( kc, a_panel, b_panel, c, ldc, accumulate );
+                                else // partial tile on the border
+                                {
+                                    Kernel::run( kc, a_panel, b_panel, tile, NR, false );
+                                    for ( unsigned long i = 0; i != mr; ++i )
+                                        for ( unsigned long j = 0; j != nr; ++j )
+                                            c[i*ldc+j] = accumulate ? c[i*ldc+j] + tile[i*NR+j] : tile[i*NR+j];
+                                }
+
+                                if constexpr( has_epilogue_v<Epilogue> )
+                                    if ( last )
+                                        epilogue( c, ldc, row_first+ic+ir, mr, col_first+jc+jr, nr );
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // work decomposition of a GEMM: a grid_rows x grid_cols grid of output blocks, each block optionally split along the depth
+        struct gemm_partition
+        {
+            unsigned long grid_rows = 1;
+            unsigned long grid_cols = 1;
+            unsigned long depth_splits = 1;
+
+            unsigned long tasks() const noexcept
+            {
+                return grid_rows * grid_cols * depth_splits;
+            }
+        };
+
+        // the depth of a split should be long enough to amortize packing and the final reduction
+        inline constexpr unsigned long min_split_depth = 128;
+
+        //
+        // Choose a 2D grid of at most `threads` blocks minimizing the micro-tiles of the busiest block.
+        // If the output has fewer micro-tiles than threads (tall-skinny products such as the weight gradient of a narrow Dense layer),
+        // the remaining threads split the depth, and the partial products are reduced afterwards.
+        //
+        inline gemm_partition make_gemm_partition( unsigned long rows, unsigned long depth, unsigned long cols, unsigned long row_tile, unsigned long col_tile, unsigned long threads ) noexcept
+        {
+            unsigned long const row_tiles = ( rows + row_tile - 1 ) / row_tile;
+            unsigned long const col_tiles = ( cols + col_tile - 1 ) / col_tile;
+
+            gemm_partition ans;
+            unsigned long best_load = row_tiles * col_tiles;
+            for ( unsigned long grid_rows = 1; grid_rows <= std::min( threads, row_tiles ); ++grid_rows )
+            {
+                unsigned long const grid_cols = std::min( threads / grid_rows, col_tiles );
+                unsigned long const load = ( (row_tiles + grid_rows - 1) / grid_rows ) * ( (col_tiles + grid_cols - 1) / grid_cols );
+                if ( load < best_load || ( load == best_load && grid_rows * grid_cols < ans.grid_rows * ans.grid_cols ) )
+                {
+                    best_load = load;
+                    ans.grid_rows = grid_rows;
+                    ans.grid_cols = grid_cols;
+                }
+            }
+
+            unsigned long const grid = ans.grid_rows * ans.grid_cols;
+            if ( grid * 2 <= threads )
+                ans.depth_splits = std::max( 1UL, std::min( threads / grid, depth / min_split_depth ) );
+
+            return ans;
+        }
+
+        // C[rows x cols] = epilogue( lhs[rows x depth] * rhs[depth x cols] ), distributed over threads according to `make_gemm_partition`
+        template< typename Kernel, typename T, typename Lhs, typename Rhs, typename Epilogue = no_epilogue >
+        void packed_gemm( Lhs const& lhs, Rhs const& rhs, unsigned long rows, unsigned long depth, unsigned long cols, T* C, unsigned long ldc, Epilogue const& epilogue = Epilogue{} )
+        {
+            constexpr unsigned long MR = Kernel::row_tile;
+            constexpr unsigned long NR = Kernel::col_tile;
+
+            cpu_gemm_config const& config = get_cpu_gemm_config();
+            unsigned long threads = config.threads ? config.threads : parallel_threads();
+            if constexpr( parallel_mode == 0 )
+                threads = 1;
+
+            if ( threads <= 1 || rows * depth * cols < config.parallel_threshold )
+            {
+                packed_gemm_block<Kernel>( lhs, rhs, 0UL, rows, 0UL, depth, 0UL, cols, C, ldc, epilogue );
+                return;
+            }
+
+            gemm_partition const partition = make_gemm_partition( rows, depth, cols, MR, NR, threads );
+            unsigned long const block_rows = round_up( ( rows + partition.grid_rows - 1 ) / partition.grid_rows, MR );
+            unsigned long const block_cols = round_up( ( cols + partition.grid_cols - 1 ) / partition.grid_cols, NR );
+            unsigned long const split_depth = ( depth + partition.depth_splits - 1 ) / partition.depth_splits;
+            unsigned long const grid = partition.grid_rows * partition.grid_cols;
+
+            // the first depth split writes to C, the others to private partial products
+            T* partials = ( partition.depth_splits > 1 ) ? gemm_scratch<T, 2>( ( partition.depth_splits - 1 ) * rows * cols ) : nullptr;
+
+            parallel( [&]( unsigned long task )
+            {
+                unsigned long const split = task / grid;
+                unsigned long const row_first = ( ( task % grid ) / partition.grid_cols ) * block_rows;
+                unsigned long const col_first = ( ( task % grid ) % partition.grid_cols ) * block_cols;
+                unsigned long const depth_first = split * split_depth;
+                if ( row_first >= rows || col_first >= cols || depth_first >= depth )
+                    return;
+
+                unsigned long const block_r = std::min( block_rows, rows - row_first );
+                unsigned long const block_c = std::min( block_cols, cols - col_first );
+                unsigned long const block_d = std::min( split_depth, depth - depth_first );
+                if ( partition.depth_splits == 1 )
+                    packed_gemm_block<Kernel>( lhs, rhs, row_first, block_r, depth_first, block_d, col_first, block_c, C + row_first*ldc + col_first, ldc, epilogue );
+                else if ( split == 0 )
+                    packed_gemm_block<Kernel>( lhs, rhs, row_first, block_r, depth_first, block_d, col_first, block_c, C + row_first*ldc + col_first, ldc );
+                else
+                    packed_gemm_block<Kernel>( lhs, rhs, row_first, block_r, depth_first, block_d, col_first, block_c, partials + (split-1)*rows*cols + row_first*cols + col_first, cols );
+            }, 0UL, partition.tasks(), 1UL );
+
+            if ( partition.depth_splits == 1 )
+                return;
+
+            unsigned long const used_splits = ( depth + split_depth - 1 ) / split_depth;
+            parallel( [&]( unsigned long r )
+            {
+                T* c = C + r * ldc;
+                for ( unsigned long split = 1; split < used_splits; ++split )
+                {
+                    T const* p = partials + (split-1)*rows*cols + r*cols;
+                    for ( unsigned long j = 0; j != cols; ++j )
+                        c[j] += p[j];
+                }
+                epilogue( c, ldc, r, 1UL, 0UL, cols ); // once the partial products are reduced
+            }, 0UL, rows );
+        }
+
+        // C[b] = lhs[b] * rhs[b] for b in [0, batch), all the blocks of all the problems scheduled in one parallel region
+        template< typename Kernel, typename T, typename Lhs, typename Rhs >
+        void packed_batched_gemm( std::vector<Lhs> const& lhs, std::vector<Rhs> const& rhs, unsigned long rows, unsigned long depth, unsigned long cols, T* C )
+        {
+            constexpr unsigned long MR = Kernel::row_tile;
+            constexpr unsigned long NR = Kernel::col_tile;
+            unsigned long const batch = lhs.size();
+            unsigned long const output_size = rows * cols;
+
+            cpu_gemm_config const& config = get_cpu_gemm_config();
+            unsigned long threads = config.threads ? config.threads : parallel_threads();
+            if constexpr( parallel_mode == 0 )
+                threads = 1;
+
+            if ( threads <= 1 || batch * rows * depth * cols < config.parallel_threshold )
+            {
+                for ( unsigned long b = 0; b != batch; ++b )
+                    packed_gemm_block<Kernel>( lhs[b], rhs[b], 0UL, rows, 0UL, depth, 0UL, cols, C + b * output_size, cols );
+                return;
+            }
+
+            // split the problems only if there are fewer problems than threads, never along the depth
+            gemm_partition partition = make_gemm_partition( rows, depth, cols, MR, NR, ( threads + batch - 1 ) / batch );
+            partition.depth_splits = 1;
+            unsigned long const block_rows = round_up( ( rows + partition.grid_rows - 1 ) / partition.grid_rows, MR );
+            unsigned long const block_cols = round_up( ( cols + partition.grid_cols - 1 ) / partition.grid_cols, NR );
+            unsigned long const grid = partition.tasks();
+
+            parallel( [&]( unsigned long task )
+            {
+                unsigned long const b = task / grid;
+                unsigned long const row_first = ( ( task % grid ) / partition.grid_cols ) * block_rows;
+                unsigned long const col_first = ( ( task % grid ) % partition.grid_cols ) * block_cols;
+                if ( row_first >= rows || col_first >= cols )
+                    return;
+                unsigned long const block_r = std::min( block_rows, rows - row_first );
+                unsigned long const block_c = std::min( block_cols, cols - col_first );
+                packed_gemm_block<Kernel>( lhs[b], rhs[b], row_first, block_r, 0UL, depth, col_first, block_c, C + b * output_size + row_first * cols + col_first, cols );
+            }, 0UL, batch * grid, 1UL );
+        }
+
+    }//namespace ceras_private
+
+    ///
+    /// @brief Cache-blocked GEMM with packed panels and SIMD micro-kernels, `C <= A * B`.
+    ///
+    /// @param A Row-major matrix of [m x n], or [n x m] if `a_transposed` is true.
+    /// @param B Row-major matrix of [n x k], or [k x n] if `b_transposed` is true.
+    /// @param C Row-major matrix of [m x k].
+    /// @param epilogue Optional action on the finished blocks of C, called as `epilogue( c, ldc, row_first, rows, col_first, cols )` with `c` pointing to `C[row_first][col_first]`.
+    ///                 It runs while the block is still in cache, for example to add a bias and apply an activation.
+    ///
+    template< typename T, typename Epilogue = ceras_private::no_epilogue > requires std::floating_point<T>
+    void cpu_gemm( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        strided_matrix<T> const lhs = a_transposed ? strided_matrix<T>{ A, 1UL, m } : strided_matrix<T>{ A, n, 1UL };
+        strided_matrix<T> const rhs = b_transposed ? strided_matrix<T>{ B, 1UL, n } : strided_matrix<T>{ B, k, 1UL };
+        with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, m, n, k, C, k, epilogue ); } );
+    }
+
+    ///
+    /// @brief Batched GEMM, `C[b] <= A[b] * B[b]` for b in [0, batch).
+    ///
+    /// @param a_stride Distance between two consecutive matrices of A. 0 broadcasts the same matrix to all the problems.
+    /// @param b_stride Distance between two consecutive matrices of B. 0 broadcasts the same matrix to all the problems.
+    /// @param C Output of [batch x m x k], packed contiguously.
+    ///
+    template< typename T > requires std::floating_point<T>
+    void cpu_batched_gemm( T const* A, bool a_transposed, unsigned long a_stride, T const* B, bool b_transposed, unsigned long b_stride,
+                           unsigned long batch, unsigned long m, unsigned long n, unsigned long k, T* C )
+    {
+        using namespace ceras_private;
+        std::vector<strided_matrix<T>> lhs;
+        std::vector<strided_matrix<T>> rhs;
+        lhs.reserve( batch );
+        rhs.reserve( batch );
+        for ( unsigned long b = 0; b != batch; ++b )
+        {
+            T const* a = A + b * a_stride;
+            T const* bb = B + b * b_stride;
+            lhs.push_back( a_transposed ? strided_matrix<T>{ a, 1UL, m } : strided_matrix<T>{ a, n, 1UL } );
+            rhs.push_back( b_transposed ? strided_matrix<T>{ bb, 1UL, n } : strided_matrix<T>{ bb, k, 1UL } );
+        }
+        with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_batched_gemm<Kernel>( lhs, rhs, m, n, k, C ); } );
+    }
+
+    ///
+    /// @brief A matrix packed in advance into the panel layout of `cpu_gemm`.
+    ///
+    /// Packing is the only part of a GEMM touching the memory layout of the operands. Operands reused across many products,
+    /// such as the weights of a layer, can be packed once by `cpu_pack_lhs` or `cpu_pack_rhs` and passed to `cpu_gemm` as they are.
+    /// The panel width depends on the micro-kernel, hence products with a packed matrix use the instruction set it was packed for.
+    ///
+    template< typename T >
+    struct packed_matrix
+    {
+        std::shared_ptr<T> data_;
+        unsigned long rows_ = 0;
+        unsigned long cols_ = 0;
+        unsigned long panel_ = 0; ///< rows per panel if packed as a lhs, columns per panel if packed as a rhs
+        isa isa_ = isa::generic; ///< instruction set of the micro-kernel the panels are laid out for
+
+        bool empty() const noexcept
+        {
+            return !data_;
+        }
+    };
+
+    namespace ceras_private
+    {
+        template< typename T, typename Operand >
+        packed_matrix<T> make_packed_matrix( Operand const& operand, unsigned long rows, unsigned long cols, bool as_lhs )
+        {
+            isa const instruction_set = current_isa();
+            return with_gemm_kernel<T>( instruction_set, [&]<typename Kernel>( Kernel ) -> packed_matrix<T>
+            {
+                unsigned long const panel = as_lhs ? Kernel::row_tile : Kernel::col_tile;
+                unsigned long const size = round_up( as_lhs ? rows : cols, panel ) * ( as_lhs ? cols : rows );
+
+                packed_matrix<T> ans;
+                ans.data_ = std::shared_ptr<T>( static_cast<T*>( ::operator new( std::max( size, 1UL ) * sizeof(T), std::align_val_t{memory_alignment} ) ),
+                                                []( T* p ) noexcept { ::operator delete( p, std::align_val_t{memory_alignment} ); } );
+                ans.rows_ = rows;
+                ans.cols_ = cols;
+                ans.panel_ = panel;
+                ans.isa_ = instruction_set;
+
+                if ( as_lhs )
+                    pack_lhs<Kernel::row_tile>( operand, 0UL, rows, 0UL, cols, ans.data_.get() );
+                else
+                    pack_rhs<Kernel::col_tile>( operand, 0UL, rows, 0UL, cols, ans.data_.get() );
+                return ans;
+            } );
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Pack A, of [m x n] or [n x m] if `a_transposed`, as the lhs operand of `cpu_gemm`.
+    ///
+    template< typename T > requires std::floating_point<T>
+    packed_matrix<T> cpu_pack_lhs( T const* A, bool a_transposed, unsigned long m, unsigned long n )
+    {
+        using namespace ceras_private;
+        strided_matrix<T> const lhs = a_transposed ? strided_matrix<T>{ A, 1UL, m } : strided_matrix<T>{ A, n, 1UL };
+        return make_packed_matrix<T>( lhs, m, n, true );
+    }
+
+    ///
+    /// @brief Pack B, of [n x k] or [k x n] if `b_transposed`, as the rhs operand of `cpu_gemm`.
+    ///
+    template< typename T > requires std::floating_point<T>
+    packed_matrix<T> cpu_pack_rhs( T const* B, bool b_transposed, unsigned long n, unsigned long k )
+    {
+        using namespace ceras_private;
+        strided_matrix<T> const rhs = b_transposed ? strided_matrix<T>{ B, 1UL, n } : strided_matrix<T>{ B, k, 1UL };
+        return make_packed_matrix<T>( rhs, n, k, false );
+    }
+
+    ///
+    /// @brief `C <= epilogue( A * B )`, with A packed by `cpu_pack_lhs`.
+    ///
+    template< typename T, typename Epilogue = ceras_private::no_epilogue > requires std::floating_point<T>
+    void cpu_gemm( packed_matrix<T> const& A, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        better_assert( A.rows_ == m && A.cols_ == n, "cpu_gemm: packed lhs does not match the product." );
+        prepacked_panels<T> const lhs{ A.data_.get(), n, A.panel_ };
+        strided_matrix<T> const rhs = b_transposed ? strided_matrix<T>{ B, 1UL, n } : strided_matrix<T>{ B, k, 1UL };
+        with_gemm_kernel<T>( A.isa_, [&]<typename Kernel>( Kernel )
+        {
+            better_assert( A.panel_ == Kernel::row_tile, "cpu_gemm: packed lhs does not match the micro-kernel." );
+            packed_gemm<Kernel>( lhs, rhs, m, n, k, C, k, epilogue );
+        } );
+    }
+
+    ///
+    /// @brief `C <= epilogue( A * B )`, with B packed by `cpu_pack_rhs`.
+    ///
+    template< typename T, typename Epilogue = ceras_private::no_epilogue > requires std::floating_point<T>
+    void cpu_gemm( T const* A, bool a_transposed, packed_matrix<T> const& B, unsigned long m, unsigned long n, unsigned long k, T* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        better_assert( B.rows_ == n && B.cols_ == k, "cpu_gemm: packed rhs does not match the product." );
+        strided_matrix<T> const lhs = a_transposed ? strided_matrix<T>{ A, 1UL, m } : strided_matrix<T>{ A, n, 1UL };
+        prepacked_panels<T> const rhs{ B.data_.get(), n, B.panel_ };
+        with_gemm_kernel<T>( B.isa_, [&]<typename Kernel>( Kernel )
+        {
+            better_assert( B.panel_ == Kernel::col_tile, "cpu_gemm: packed rhs does not match the micro-kernel." );
+            packed_gemm<Kernel>( lhs, rhs, m, n, k, C, k, epilogue );
+        } );
+    }
+
+}//namespace ceras
+
+#endif//CPU_HPP_INCLUDED_QXBNVKZRHWTJMSOFLEPAGUDYICQWZMNBVXLKJHGFDSAPOIUYTREWQ
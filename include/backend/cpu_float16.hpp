@@ -0,0 +1,258 @@
+#ifndef CPU_FLOAT16_HPP_INCLUDED_KQWZMNTHXRBVJLPYGDECAUSOIFMZKQRTWXHNBVLJPGYDECAUSO
+#define CPU_FLOAT16_HPP_INCLUDED_KQWZMNTHXRBVJLPYGDECAUSOIFMZKQRTWXHNBVLJPGYDECAUSO
+
+#include "../includes.hpp"
+#include "../config.hpp"
+#include "../utils/cpu_features.hpp"
+#include "../utils/float16.hpp"
+#include "./cpu.hpp"
+
+namespace ceras
+{
+
+    namespace ceras_private
+    {
+        template< half_precision T >
+        void widen_generic( T const* src, unsigned long n, float* dst ) noexcept
+        {
+            for ( unsigned long idx = 0; idx != n; ++idx )
+                dst[idx] = static_cast<float>( src[idx] );
+        }
+
+        template< half_precision T >
+        void narrow_generic( float const* src, unsigned long n, T* dst ) noexcept
+        {
+            for ( unsigned long idx = 0; idx != n; ++idx )
+                dst[idx] = T{ src[idx] };
+        }
+
+#if CERAS_X86
+CERAS_BEGIN_TARGET( CERAS_TARGET_F16C )
+        inline void widen_f16c( float16 const* src, unsigned long n, float* dst ) noexcept
+        {
+            unsigned long idx = 0;
+            for ( ; idx + 8 <= n; idx += 8 )
+                _mm256_storeu_ps( dst + idx, _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( src + idx ) ) ) );
+            widen_generic( src + idx, n - idx, dst + idx );
+        }
+
+        inline void narrow_f16c( float const* src, unsigned long n, float16* dst ) noexcept
+        {
+            unsigned long idx = 0;
+            for ( ; idx + 8 <= n; idx += 8 )
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + idx ), _mm256_cvtps_ph( _mm256_loadu_ps( src + idx ), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ) );
+            narrow_generic( src + idx, n - idx, dst + idx );
+        }
+
+        inline void widen_avx2( bfloat16 const* src, unsigned long n, float* dst ) noexcept
+        {
+            unsigned long idx = 0;
+            for ( ; idx + 8 <= n; idx += 8 )
+            {
+                __m256i const bits = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<__m128i const*>( src + idx ) ) );
+                _mm256_storeu_ps( dst + idx, _mm256_castsi256_ps( _mm256_slli_epi32( bits, 16 ) ) );
+            }
+            widen_generic( src + idx, n - idx, dst + idx );
+        }
+
+        // the rounding of `float_to_bfloat16_bits`, 8 values at once
+        inline void narrow_avx2( float const* src, unsigned long n, bfloat16* dst ) noexcept
+        {
+            unsigned long idx = 0;
+            for ( ; idx + 8 <= n; idx += 8 )
+            {
+                __m256i const bits = _mm256_castps_si256( _mm256_loadu_ps( src + idx ) );
+                __m256i const odd = _mm256_and_si256( _mm256_srli_epi32( bits, 16 ), _mm256_set1_epi32( 1 ) );
+                __m256i const rounded = _mm256_srli_epi32( _mm256_add_epi32( bits, _mm256_add_epi32( odd, _mm256_set1_epi32( 0x7fff ) ) ), 16 );
+                __m256i const quiet_nan = _mm256_or_si256( _mm256_srli_epi32( bits, 16 ), _mm256_set1_epi32( 0x40 ) );
+                __m256i const nan = _mm256_cmpgt_epi32( _mm256_and_si256( bits, _mm256_set1_epi32( 0x7fffffff ) ), _mm256_set1_epi32( 0x7f800000 ) ); // not folded by -ffast-math
+                __m256i const ans = _mm256_blendv_epi8( rounded, quiet_nan, nan );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + idx ), _mm_packus_epi32( _mm256_castsi256_si128( ans ), _mm256_extracti128_si256( ans, 1 ) ) );
+            }
+            narrow_generic( src + idx, n - idx, dst + idx );
+        }
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX512BF16 )
+        // vcvtneps2bf16 rounds to the nearest even as well, but flushes subnormal floats to zero
+        inline void narrow_avx512bf16( float const* src, unsigned long n, bfloat16* dst ) noexcept
+        {
+            unsigned long idx = 0;
+            for ( ; idx + 16 <= n; idx += 16 )
+            {
+                __m256bh const ans = _mm512_cvtneps_pbh( _mm512_loadu_ps( src + idx ) );
+                std::memcpy( static_cast<void*>( dst + idx ), &ans, sizeof( ans ) ); // the bits of 16 bfloat16s
+            }
+            narrow_generic( src + idx, n - idx, dst + idx );
+        }
+CERAS_END_TARGET
+
+        // 0 without F16C, 1 with F16C, 2 with F16C and AVX-512 BF16
+        inline unsigned long float16_conversion_level() noexcept
+        {
+            static unsigned long const ans = []()
+            {
+                __builtin_cpu_init();
+                if ( !__builtin_cpu_supports( "f16c" ) || detected_isa() < isa::avx2 )
+                    return 0UL;
+                return ( detected_isa() == isa::avx512 && __builtin_cpu_supports( "avx512bw" ) && __builtin_cpu_supports( "avx512vl" ) && __builtin_cpu_supports( "avx512bf16" ) ) ? 2UL : 1UL;
+            }();
+            return ans;
+        }
+#endif
+
+        // the conversion level usable with the instruction set in use
+        inline unsigned long float16_conversion() noexcept
+        {
+#if CERAS_X86
+            if ( current_isa() < isa::avx2 )
+                return 0UL;
+            return ( current_isa() == isa::avx512 ) ? float16_conversion_level() : std::min( float16_conversion_level(), 1UL );
+#else
+            return 0UL;
+#endif
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Convert n 16-bit floats to float, with F16C or AVX2 if available.
+    ///
+    inline void convert( float16 const* src, unsigned long n, float* dst ) noexcept
+    {
+        using namespace ceras_private;
+#if CERAS_X86
+        if ( float16_conversion() >= 1 )
+            return widen_f16c( src, n, dst );
+#endif
+        widen_generic( src, n, dst );
+    }
+
+    inline void convert( bfloat16 const* src, unsigned long n, float* dst ) noexcept
+    {
+        using namespace ceras_private;
+#if CERAS_X86
+        if ( float16_conversion() >= 1 )
+            return widen_avx2( src, n, dst );
+#endif
+        widen_generic( src, n, dst );
+    }
+
+    ///
+    /// @brief Round n floats to 16-bit floats, to the nearest even, with F16C, AVX-512 BF16 or AVX2 if available.
+    ///
+    inline void convert( float const* src, unsigned long n, float16* dst ) noexcept
+    {
+        using namespace ceras_private;
+#if CERAS_X86
+        if ( float16_conversion() >= 1 )
+            return narrow_f16c( src, n, dst );
+#endif
+        narrow_generic( src, n, dst );
+    }
+
+    inline void convert( float const* src, unsigned long n, bfloat16* dst ) noexcept
+    {
+        using namespace ceras_private;
+#if CERAS_X86
+        if ( float16_conversion() == 2 )
+            return narrow_avx512bf16( src, n, dst );
+        if ( float16_conversion() == 1 )
+            return narrow_avx2( src, n, dst );
+#endif
+        narrow_generic( src, n, dst );
+    }
+
+    namespace ceras_private
+    {
+        // a 16-bit float matrix read as float, the values being widened while packed into the float panels of `packed_gemm`
+        template< half_precision T >
+        struct widened_matrix
+        {
+            T const* data_;
+            unsigned long row_stride_;
+            unsigned long col_stride_;
+
+            float operator()( unsigned long r, unsigned long c ) const noexcept
+            {
+                return static_cast<float>( data_[r*row_stride_ + c*col_stride_] );
+            }
+        };
+
+        // apply the float epilogue of the caller to a finished block of float accumulators, then round it to the 16-bit output
+        template< half_precision T, typename Epilogue >
+        struct narrowing_epilogue
+        {
+            T* output_;
+            unsigned long ldo_;
+            Epilogue const& epilogue_;
+
+            void operator()( float* c, unsigned long ldc, unsigned long row_first, unsigned long rows, unsigned long col_first, unsigned long cols ) const noexcept
+            {
+                epilogue_( c, ldc, row_first, rows, col_first, cols );
+                for ( unsigned long r = 0; r != rows; ++r )
+                    convert( c + r * ldc, cols, output_ + ( row_first + r ) * ldo_ + col_first );
+            }
+        };
+    }//namespace ceras_private
+
+    ///
+    /// @brief GEMM of 16-bit floats, `C <= epilogue( A * B )`, accumulated in float.
+    ///
+    /// A and B are widened to float while packed, the float micro-kernels accumulate in float registers,
+    /// and each block of C is rounded to 16 bits once finished, after the epilogue, which works on the float values.
+    /// Only the packing and the output touch 16-bit memory, halving the traffic of the operands.
+    /// With F16C, float16 operands are rather widened beforehand by vcvtph2ps, much faster than converting the scattered values of the panels.
+    ///
+    template< half_precision T, typename Epilogue = ceras_private::no_epilogue >
+    void cpu_gemm( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        float* accumulators = gemm_scratch<float, 3>( m*k );
+        narrowing_epilogue<T, Epilogue> const narrowing{ C, k, epilogue };
+        auto const& run = [&]( auto const& lhs, auto const& rhs )
+        {
+            with_gemm_kernel<float>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, m, n, k, accumulators, k, narrowing ); } );
+        };
+
+        if constexpr( std::is_same_v<T, float16> )
+        {
+            if ( float16_conversion() >= 1 )
+            {
+                float* a = gemm_scratch<float, 4>( m*n );
+                float* b = gemm_scratch<float, 5>( n*k );
+                convert( A, m*n, a );
+                convert( B, n*k, b );
+                run( a_transposed ? strided_matrix<float>{ a, 1UL, m } : strided_matrix<float>{ a, n, 1UL }, b_transposed ? strided_matrix<float>{ b, 1UL, n } : strided_matrix<float>{ b, k, 1UL } );
+                return;
+            }
+        }
+        run( a_transposed ? widened_matrix<T>{ A, 1UL, m } : widened_matrix<T>{ A, n, 1UL }, b_transposed ? widened_matrix<T>{ B, 1UL, n } : widened_matrix<T>{ B, k, 1UL } );
+    }
+
+    ///
+    /// @brief Batched GEMM of 16-bit floats, `C[b] <= A[b] * B[b]` for b in [0, batch), accumulated in float.
+    ///
+    template< half_precision T >
+    void cpu_batched_gemm( T const* A, bool a_transposed, unsigned long a_stride, T const* B, bool b_transposed, unsigned long b_stride,
+                           unsigned long batch, unsigned long m, unsigned long n, unsigned long k, T* C )
+    {
+        using namespace ceras_private;
+        std::vector<widened_matrix<T>> lhs;
+        std::vector<widened_matrix<T>> rhs;
+        lhs.reserve( batch );
+        rhs.reserve( batch );
+        for ( unsigned long b = 0; b != batch; ++b )
+        {
+            T const* a = A + b * a_stride;
+            T const* bb = B + b * b_stride;
+            lhs.push_back( a_transposed ? widened_matrix<T>{ a, 1UL, m } : widened_matrix<T>{ a, n, 1UL } );
+            rhs.push_back( b_transposed ? widened_matrix<T>{ bb, 1UL, n } : widened_matrix<T>{ bb, k, 1UL } );
+        }
+        float* accumulators = gemm_scratch<float, 3>( batch*m*k );
+        with_gemm_kernel<float>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_batched_gemm<Kernel>( lhs, rhs, m, n, k, accumulators ); } );
+        convert( accumulators, batch*m*k, C );
+    }
+
+}//namespace ceras
+
+#endif//CPU_FLOAT16_HPP_INCLUDED_KQWZMNTHXRBVJLPYGDECAUSOIFMZKQRTWXHNBVLJPGYDECAUSO
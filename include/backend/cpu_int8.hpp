@@ -0,0 +1,450 @@
+#ifndef CPU_INT8_HPP_INCLUDED_VNQXHRKZTMWJLBPYDGCESAUOIFKRZXMQWTNVHLJBYPGDCAEUSOIK
+#define CPU_INT8_HPP_INCLUDED_VNQXHRKZTMWJLBPYDGCESAUOIFKRZXMQWTNVHLJBYPGDCAEUSOIK
+
+#include "../includes.hpp"
+#include "../config.hpp"
+#include "../utils/better_assert.hpp"
+#include "../utils/cpu_features.hpp"
+#include "./cpu.hpp"
+
+namespace ceras
+{
+
+    namespace ceras_private
+    {
+        //
+        // Int8 operands are packed in groups of consecutive values along the depth, one group per 32-bit lane, and the traits below plug into
+        // `simd_kernel`, whose `fmadd` then adds the dot product of two groups to a 32-bit accumulator:
+        //
+        // - pairs of values sign-extended to 16 bits, multiplied by pmaddwd, for the generic, SSE4.2, AVX2 and AVX-512BW kernels;
+        // - quadruplets of bytes multiplied by vpdpbusd with AVX-512 VNNI, twice the products per instruction. It multiplies unsigned bytes by
+        //   signed ones, hence the activations are offset by 128 to fit in [1, 255], and 128 times the sum of each weight channel is subtracted
+        //   from the accumulators afterwards.
+        //
+        struct generic_int8
+        {
+            typedef std::int32_t value_type;
+            typedef std::int32_t type;
+            static constexpr unsigned long width = 1;
+            static constexpr unsigned long group = 2;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_generic( func ); }
+            static type zero() noexcept { return 0; }
+            static type load( std::int32_t const* p ) noexcept { return *p; }
+            static type loadu( std::int32_t const* p ) noexcept { return *p; }
+            static void store( std::int32_t* p, type v ) noexcept { *p = v; }
+            static type broadcast( std::int32_t const* p ) noexcept { return *p; }
+            static type fmadd( type a, type b, type c ) noexcept
+            {
+                return c + static_cast<std::int16_t>( a & 0xffff ) * static_cast<std::int16_t>( b & 0xffff ) + ( a >> 16 ) * ( b >> 16 );
+            }
+            static type add( type a, type b ) noexcept { return a + b; }
+        };
+
+#if CERAS_X86
+CERAS_BEGIN_TARGET( CERAS_TARGET_SSE42 )
+        struct sse42_int8
+        {
+            typedef std::int32_t value_type;
+            typedef __m128i type;
+            static constexpr unsigned long width = 4;
+            static constexpr unsigned long group = 2;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_sse42( func ); }
+            static type zero() noexcept { return _mm_setzero_si128(); }
+            static type load( std::int32_t const* p ) noexcept { return _mm_load_si128( reinterpret_cast<__m128i const*>( p ) ); }
+            static type loadu( std::int32_t const* p ) noexcept { return _mm_loadu_si128( reinterpret_cast<__m128i const*>( p ) ); }
+            static void store( std::int32_t* p, type v ) noexcept { _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), v ); }
+            static type broadcast( std::int32_t const* p ) noexcept { return _mm_set1_epi32( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm_add_epi32( _mm_madd_epi16( a, b ), c ); }
+            static type add( type a, type b ) noexcept { return _mm_add_epi32( a, b ); }
+        };
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX2 )
+        struct avx2_int8
+        {
+            typedef std::int32_t value_type;
+            typedef __m256i type;
+            static constexpr unsigned long width = 8;
+            static constexpr unsigned long group = 2;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx2( func ); }
+            static type zero() noexcept { return _mm256_setzero_si256(); }
+            static type load( std::int32_t const* p ) noexcept { return _mm256_load_si256( reinterpret_cast<__m256i const*>( p ) ); }
+            static type loadu( std::int32_t const* p ) noexcept { return _mm256_loadu_si256( reinterpret_cast<__m256i const*>( p ) ); }
+            static void store( std::int32_t* p, type v ) noexcept { _mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), v ); }
+            static type broadcast( std::int32_t const* p ) noexcept { return _mm256_set1_epi32( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm256_add_epi32( _mm256_madd_epi16( a, b ), c ); }
+            static type add( type a, type b ) noexcept { return _mm256_add_epi32( a, b ); }
+        };
+CERAS_END_TARGET
+
+        // the 16-bit multiplications of 512-bit vectors need AVX-512BW and the byte dot products AVX-512 VNNI, beyond the AVX-512 target of the float kernels
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX512BW )
+        template< typename Function >
+        [[gnu::flatten]] void invoke_avx512bw( Function const& func )
+        {
+            func();
+        }
+
+        struct avx512bw_int8
+        {
+            typedef std::int32_t value_type;
+            typedef __m512i type;
+            static constexpr unsigned long width = 16;
+            static constexpr unsigned long group = 2;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx512bw( func ); }
+            static type zero() noexcept { return _mm512_setzero_si512(); }
+            static type load( std::int32_t const* p ) noexcept { return _mm512_load_si512( p ); }
+            static type loadu( std::int32_t const* p ) noexcept { return _mm512_loadu_si512( p ); }
+            static void store( std::int32_t* p, type v ) noexcept { _mm512_storeu_si512( p, v ); }
+            static type broadcast( std::int32_t const* p ) noexcept { return _mm512_set1_epi32( *p ); }
+            static type fmadd( type a, type b, type c ) noexcept { return _mm512_add_epi32( _mm512_madd_epi16( a, b ), c ); }
+            static type add( type a, type b ) noexcept { return _mm512_add_epi32( a, b ); }
+        };
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX512VNNI )
+        template< typename Function >
+        [[gnu::flatten]] void invoke_avx512vnni( Function const& func )
+        {
+            func();
+        }
+
+        // `Unsigned_Lhs` tells which operand holds the offset activations
+        template< bool Unsigned_Lhs >
+        struct avx512vnni_int8 : avx512bw_int8
+        {
+            static constexpr unsigned long group = 4;
+            template< typename Function >
+            static void invoke( Function const& func ) { invoke_avx512vnni( func ); }
+            static type fmadd( type a, type b, type c ) noexcept
+            {
+                if constexpr( Unsigned_Lhs )
+                    return _mm512_dpbusd_epi32( c, a, b );
+                else
+                    return _mm512_dpbusd_epi32( c, b, a );
+            }
+        };
+CERAS_END_TARGET
+
+        // 0 without AVX-512BW, 1 with AVX-512BW, 2 with AVX-512BW and AVX-512 VNNI
+        inline unsigned long int8_avx512_level() noexcept
+        {
+            static unsigned long const ans = []()
+            {
+                __builtin_cpu_init();
+                if ( !__builtin_cpu_supports( "avx512bw" ) )
+                    return 0UL;
+                return __builtin_cpu_supports( "avx512vnni" ) ? 2UL : 1UL;
+            }();
+            return ans;
+        }
+#endif
+
+        //
+        // Call func( Kernel{} ) with the int8 micro-kernel for the given instruction set:
+        // 8 x 48 with AVX-512 (VNNI if available, else AVX-512BW, else falling back to AVX2), 6 x 16 with AVX2 and 6 x 8 with SSE4.2.
+        // `activation_is_lhs` tells the VNNI kernel which operand is unsigned.
+        //
+        template< typename Function >
+        decltype(auto) with_int8_gemm_kernel( isa instruction_set, bool activation_is_lhs, Function&& func )
+        {
+#if CERAS_X86
+            switch ( instruction_set )
+            {
+                case isa::avx512:
+                    if ( int8_avx512_level() == 2 )
+                        return activation_is_lhs ? func( simd_kernel<avx512vnni_int8<true>, 8, 3>{} ) : func( simd_kernel<avx512vnni_int8<false>, 8, 3>{} );
+                    if ( int8_avx512_level() == 1 )
+                        return func( simd_kernel<avx512bw_int8, 8, 3>{} );
+                    [[fallthrough]];
+                case isa::avx2: return func( simd_kernel<avx2_int8, 6, 2>{} );
+                case isa::sse42: return func( simd_kernel<sse42_int8, 6, 2>{} );
+                default: break;
+            }
+#endif
+            return func( simd_kernel<generic_int8, 4, 8>{} );
+        }
+
+        // the values in a group of a kernel, 2 or 4
+        template< typename Kernel >
+        struct int8_group;
+
+        template< typename Simd, unsigned long MR, unsigned long NV >
+        struct int8_group<simd_kernel<Simd, MR, NV>> : std::integral_constant<unsigned long, Simd::group> {};
+
+        template< typename Kernel >
+        inline constexpr unsigned long int8_group_v = int8_group<Kernel>::value;
+
+        inline std::int32_t quantize_int8( float x, float inverse_scale ) noexcept
+        {
+            return static_cast<std::int32_t>( std::lrint( std::clamp( x * inverse_scale, -127.0f, 127.0f ) ) );
+        }
+
+        //
+        // A float matrix, (r, c) at data_[r*row_stride_ + c*col_stride_], read as a matrix of int8 groups along the depth, quantized on the fly while packed.
+        // The depth is the columns of a lhs and the rows of a rhs. Each row of a lhs, or each column of a rhs, has its own scale if scale_stride_ is 1,
+        // or they all share the first one if it is 0. The quantized values are offset by `offset_`, 128 for the activations of the VNNI kernels.
+        //
+        template< bool Lhs, unsigned long Group >
+        struct int8_groups
+        {
+            float const* data_;
+            unsigned long row_stride_;
+            unsigned long col_stride_;
+            unsigned long depth_;
+            float const* inverse_scales_;
+            unsigned long scale_stride_;
+            std::int32_t offset_;
+
+            std::int32_t operator()( unsigned long r, unsigned long c ) const noexcept
+            {
+                constexpr unsigned long bits = 32 / Group;
+                constexpr std::uint32_t mask = ( 1U << bits ) - 1U;
+                unsigned long const first = Group * ( Lhs ? c : r );
+                float const inverse_scale = inverse_scales_[( Lhs ? r : c ) * scale_stride_];
+
+                std::uint32_t ans = 0;
+                for ( unsigned long g = 0; g != Group; ++g )
+                    if ( unsigned long const d = first + g; d < depth_ )
+                    {
+                        float const x = Lhs ? data_[r*row_stride_ + d*col_stride_] : data_[d*row_stride_ + c*col_stride_];
+                        ans |= ( static_cast<std::uint32_t>( quantize_int8( x, inverse_scale ) + offset_ ) & mask ) << ( g * bits );
+                    }
+                return static_cast<std::int32_t>( ans );
+            }
+        };
+
+        //
+        // Requantization of the int32 tiles: C = ( accumulator - correction ) * row_scale * col_scale, written to the float output,
+        // followed by the float epilogue of the caller on the same block.
+        //
+        template< typename Epilogue >
+        struct int8_requantization
+        {
+            float* output_;
+            unsigned long ldo_;
+            float const* row_scales_;
+            unsigned long row_scale_stride_;
+            float const* col_scales_;
+            unsigned long col_scale_stride_;
+            std::int32_t const* row_corrections_; // one per row, or nullptr
+            std::int32_t const* col_corrections_; // one per column, or nullptr
+            Epilogue const& epilogue_;
+
+            void operator()( std::int32_t* c, unsigned long ldc, unsigned long row_first, unsigned long rows, unsigned long col_first, unsigned long cols ) const noexcept
+            {
+                for ( unsigned long r = 0; r != rows; ++r )
+                {
+                    std::int32_t* accumulator = c + r * ldc;
+                    if ( row_corrections_ )
+                        for ( unsigned long j = 0; j != cols; ++j )
+                            accumulator[j] -= row_corrections_[row_first + r];
+                    if ( col_corrections_ )
+                        for ( unsigned long j = 0; j != cols; ++j )
+                            accumulator[j] -= col_corrections_[col_first + j];
+
+                    float* out = output_ + ( row_first + r ) * ldo_ + col_first;
+                    float const row_scale = row_scales_[( row_first + r ) * row_scale_stride_];
+                    if ( col_scale_stride_ == 0 )
+                    {
+                        float const scale = row_scale * col_scales_[0];
+                        for ( unsigned long j = 0; j != cols; ++j )
+                            out[j] = static_cast<float>( accumulator[j] ) * scale;
+                    }
+                    else
+                    {
+                        float const* col_scales = col_scales_ + col_first;
+                        for ( unsigned long j = 0; j != cols; ++j )
+                            out[j] = static_cast<float>( accumulator[j] ) * row_scale * col_scales[j];
+                    }
+                }
+                epilogue_( output_ + row_first * ldo_ + col_first, ldo_, row_first, rows, col_first, cols );
+            }
+        };
+
+        // the largest magnitude in x[0, n)
+        inline float max_magnitude( float const* x, unsigned long n ) noexcept
+        {
+            float ans = 0.0f;
+            for ( unsigned long idx = 0; idx != n; ++idx )
+                ans = std::max( ans, std::abs( x[idx] ) );
+            return ans;
+        }
+
+        // the scale of a symmetric int8 quantization covering [-range, range]
+        inline float int8_scale( float range ) noexcept
+        {
+            return range > 0.0f ? range / 127.0f : 1.0f;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief A matrix quantized to int8 with one scale per output channel, and packed for `cpu_gemm_int8`.
+    ///
+    /// A weight matrix quantized as the lhs of a product has a scale per row, as the rhs a scale per column.
+    /// Values are packed in groups along the depth, the layout consumed by the int8 micro-kernel of the instruction set in use.
+    ///
+    struct quantized_matrix
+    {
+        packed_matrix<std::int32_t> panels_; ///< [rows x groups] panels of a lhs, [groups x cols] of a rhs
+        std::vector<float> scales_; ///< dequantization scales, one per row of a lhs or per column of a rhs
+        std::vector<std::int32_t> corrections_; ///< subtracted from the accumulators of each channel, empty unless the activations are offset
+        unsigned long rows_ = 0;
+        unsigned long cols_ = 0;
+        unsigned long group_ = 0; ///< values per 32-bit lane of the panels
+
+        bool empty() const noexcept
+        {
+            return panels_.empty();
+        }
+    };
+
+    namespace ceras_private
+    {
+        // quantize a float matrix of [rows x cols] with per-channel scales, and pack it as a lhs or a rhs of int8 groups
+        inline quantized_matrix make_quantized_matrix( strided_matrix<float> const& operand, unsigned long rows, unsigned long cols, bool as_lhs )
+        {
+            quantized_matrix ans;
+            ans.rows_ = rows;
+            ans.cols_ = cols;
+
+            unsigned long const channels = as_lhs ? rows : cols;
+            unsigned long const depth = as_lhs ? cols : rows;
+            auto const& at = [&]( unsigned long channel, unsigned long idx ) { return as_lhs ? operand( channel, idx ) : operand( idx, channel ); };
+            ans.scales_.resize( channels );
+            std::vector<float> inverse_scales( channels );
+            for ( unsigned long channel = 0; channel != channels; ++channel )
+            {
+                float range = 0.0f;
+                for ( unsigned long idx = 0; idx != depth; ++idx )
+                    range = std::max( range, std::abs( at( channel, idx ) ) );
+                ans.scales_[channel] = int8_scale( range );
+                inverse_scales[channel] = 1.0f / ans.scales_[channel];
+            }
+
+            isa const instruction_set = current_isa();
+            with_int8_gemm_kernel( instruction_set, !as_lhs, [&]<typename Kernel>( Kernel )
+            {
+                constexpr unsigned long group = int8_group_v<Kernel>;
+                unsigned long const groups = ( depth + group - 1 ) / group;
+                unsigned long const panel = as_lhs ? Kernel::row_tile : Kernel::col_tile;
+                unsigned long const size = round_up( channels, panel ) * groups;
+
+                packed_matrix<std::int32_t>& panels = ans.panels_;
+                panels.data_ = std::shared_ptr<std::int32_t>( static_cast<std::int32_t*>( ::operator new( std::max( size, 1UL ) * sizeof(std::int32_t), std::align_val_t{memory_alignment} ) ),
+                                                              []( std::int32_t* p ) noexcept { ::operator delete( p, std::align_val_t{memory_alignment} ); } );
+                panels.rows_ = as_lhs ? rows : groups;
+                panels.cols_ = as_lhs ? groups : cols;
+                panels.panel_ = panel;
+                panels.isa_ = instruction_set;
+                ans.group_ = group;
+
+                if ( as_lhs )
+                    pack_lhs<Kernel::row_tile>( int8_groups<true, group>{ operand.data_, operand.row_stride_, operand.col_stride_, depth, inverse_scales.data(), 1UL, 0 }, 0UL, rows, 0UL, groups, panels.data_.get() );
+                else
+                    pack_rhs<Kernel::col_tile>( int8_groups<false, group>{ operand.data_, operand.row_stride_, operand.col_stride_, depth, inverse_scales.data(), 1UL, 0 }, 0UL, groups, 0UL, cols, panels.data_.get() );
+
+                if constexpr( group == 4 ) // activations offset by 128
+                {
+                    ans.corrections_.resize( channels );
+                    for ( unsigned long channel = 0; channel != channels; ++channel )
+                    {
+                        std::int32_t sum = 0;
+                        for ( unsigned long idx = 0; idx != depth; ++idx )
+                            sum += quantize_int8( at( channel, idx ), inverse_scales[channel] );
+                        ans.corrections_[channel] = 128 * sum;
+                    }
+                }
+            } );
+            return ans;
+        }
+
+        inline void check_int8_depth( unsigned long n )
+        {
+            // an accumulator sums n products of at most 255 * 127 in magnitude
+            better_assert( n <= ( 1UL << 31 ) / ( 255UL * 127UL ), "cpu_gemm_int8: the depth ", n, " may overflow the int32 accumulators." );
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Quantize A, of [m x n] or [n x m] if `a_transposed`, to int8 with a scale per row, as the lhs operand of `cpu_gemm_int8`.
+    ///
+    inline quantized_matrix cpu_quantize_lhs( float const* A, bool a_transposed, unsigned long m, unsigned long n )
+    {
+        using namespace ceras_private;
+        return make_quantized_matrix( a_transposed ? strided_matrix<float>{ A, 1UL, m } : strided_matrix<float>{ A, n, 1UL }, m, n, true );
+    }
+
+    ///
+    /// @brief Quantize B, of [n x k] or [k x n] if `b_transposed`, to int8 with a scale per column, as the rhs operand of `cpu_gemm_int8`.
+    ///
+    inline quantized_matrix cpu_quantize_rhs( float const* B, bool b_transposed, unsigned long n, unsigned long k )
+    {
+        using namespace ceras_private;
+        return make_quantized_matrix( b_transposed ? strided_matrix<float>{ B, 1UL, n } : strided_matrix<float>{ B, k, 1UL }, n, k, false );
+    }
+
+    ///
+    /// @brief Int8 GEMM, `C <= epilogue( A * B )`, with A quantized on the fly and B quantized by `cpu_quantize_rhs`.
+    ///
+    /// A is quantized symmetrically with the scale `a_range / 127`, values beyond `a_range` saturating, and the products are accumulated in int32.
+    /// The accumulators are requantized to float with the scales of A and of the columns of B, then passed to the epilogue while still in cache.
+    ///
+    /// @param A Row-major float matrix of [m x n], or [n x m] if `a_transposed` is true.
+    /// @param a_range The calibrated largest magnitude of A. If not positive, the largest magnitude of this A is used.
+    /// @param B A [n x k] matrix quantized by `cpu_quantize_rhs`.
+    /// @param C Row-major float matrix of [m x k].
+    /// @param epilogue Optional action on the finished blocks of C, as in `cpu_gemm`.
+    ///
+    template< typename Epilogue = ceras_private::no_epilogue >
+    void cpu_gemm_int8( float const* A, bool a_transposed, float a_range, quantized_matrix const& B, unsigned long m, unsigned long n, unsigned long k, float* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        better_assert( B.rows_ == n && B.cols_ == k, "cpu_gemm_int8: quantized rhs does not match the product." );
+        check_int8_depth( n );
+        float const a_scale = int8_scale( a_range > 0.0f ? a_range : max_magnitude( A, m*n ) );
+        float const a_inverse_scale = 1.0f / a_scale;
+
+        prepacked_panels<std::int32_t> const rhs{ B.panels_.data_.get(), B.panels_.rows_, B.panels_.panel_ };
+        std::int32_t* accumulators = gemm_scratch<std::int32_t, 3>( m*k );
+        int8_requantization<Epilogue> const requantization{ C, k, &a_scale, 0UL, B.scales_.data(), 1UL, nullptr, B.corrections_.empty() ? nullptr : B.corrections_.data(), epilogue };
+        with_int8_gemm_kernel( B.panels_.isa_, true, [&]<typename Kernel>( Kernel )
+        {
+            constexpr unsigned long group = int8_group_v<Kernel>;
+            better_assert( B.panels_.panel_ == Kernel::col_tile && B.group_ == group, "cpu_gemm_int8: quantized rhs does not match the micro-kernel." );
+            int8_groups<true, group> const lhs{ A, a_transposed ? 1UL : n, a_transposed ? m : 1UL, n, &a_inverse_scale, 0UL, group == 4 ? 128 : 0 };
+            packed_gemm<Kernel>( lhs, rhs, m, B.panels_.rows_, k, accumulators, k, requantization );
+        } );
+    }
+
+    ///
+    /// @brief Int8 GEMM, `C <= epilogue( A * B )`, with A quantized by `cpu_quantize_lhs` and B quantized on the fly with the scale `b_range / 127`.
+    ///
+    template< typename Epilogue = ceras_private::no_epilogue >
+    void cpu_gemm_int8( quantized_matrix const& A, float const* B, bool b_transposed, float b_range, unsigned long m, unsigned long n, unsigned long k, float* C, Epilogue const& epilogue = Epilogue{} )
+    {
+        using namespace ceras_private;
+        better_assert( A.rows_ == m && A.cols_ == n, "cpu_gemm_int8: quantized lhs does not match the product." );
+        check_int8_depth( n );
+        float const b_scale = int8_scale( b_range > 0.0f ? b_range : max_magnitude( B, n*k ) );
+        float const b_inverse_scale = 1.0f / b_scale;
+
+        prepacked_panels<std::int32_t> const lhs{ A.panels_.data_.get(), A.panels_.cols_, A.panels_.panel_ };
+        std::int32_t* accumulators = gemm_scratch<std::int32_t, 3>( m*k );
+        int8_requantization<Epilogue> const requantization{ C, k, A.scales_.data(), 1UL, &b_scale, 0UL, A.corrections_.empty() ? nullptr : A.corrections_.data(), nullptr, epilogue };
+        with_int8_gemm_kernel( A.panels_.isa_, false, [&]<typename Kernel>( Kernel )
+        {
+            constexpr unsigned long group = int8_group_v<Kernel>;
+            better_assert( A.panels_.panel_ == Kernel::row_tile && A.group_ == group, "cpu_gemm_int8: quantized lhs does not match the micro-kernel." );
+            int8_groups<false, group> const rhs{ B, b_transposed ? 1UL : k, b_transposed ? n : 1UL, n, &b_inverse_scale, 0UL, group == 4 ? 128 : 0 };
+            packed_gemm<Kernel>( lhs, rhs, m, A.panels_.cols_, k, accumulators, k, requantization );
+        } );
+    }
+
+}//namespace ceras
+
+#endif//CPU_INT8_HPP_INCLUDED_VNQXHRKZTMWJLBPYDGCESAUOIFKRZXMQWTNVHLJBYPGDCAEUSOIK
@@ -0,0 +1,179 @@
+#ifndef CPU_TUNER_HPP_INCLUDED_ZKWQPMRHXNBTGVLDYJECAUSIFOKQZRMXWPNLTHBVGYDJCEASUIO
+#define CPU_TUNER_HPP_INCLUDED_ZKWQPMRHXNBTGVLDYJECAUSIFOKQZRMXWPNLTHBVGYDJCEASUIO
+
+#include "../includes.hpp"
+#include "../config.hpp"
+#include "./cpu.hpp"
+#include "./cblas.hpp"
+
+namespace ceras
+{
+
+    namespace ceras_private
+    {
+        // the shortest wall time in seconds of a few runs of func, after a warm-up run
+        template< typename Function >
+        double shortest_time( Function const& func, unsigned long repeats = 3 )
+        {
+            func();
+            double ans = std::numeric_limits<double>::max();
+            for ( [[maybe_unused]] auto _ : range( repeats ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                func();
+                ans = std::min( ans, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return ans;
+        }
+
+        // float operands of the tuning problems, large enough for the biggest of them
+        struct tuning_problem
+        {
+            std::vector<float> a_;
+            std::vector<float> b_;
+            std::vector<float> c_;
+
+            tuning_problem( unsigned long max_size ) : a_( max_size, 0.5f ), b_( max_size, 0.25f ), c_( max_size, 0.0f ) {}
+
+            double time_cpu_gemm( cpu_gemm_config const& config, unsigned long m, unsigned long n, unsigned long k )
+            {
+                cpu_gemm_config const backup = get_cpu_gemm_config();
+                get_cpu_gemm_config() = config;
+                double const ans = shortest_time( [&](){ cpu_gemm( a_.data(), false, b_.data(), false, m, n, k, c_.data() ); } );
+                get_cpu_gemm_config() = backup;
+                return ans;
+            }
+
+            double time_cblas_gemm( unsigned long m, unsigned long n, unsigned long k )
+            {
+                return shortest_time( [&](){ cblas_gemm( a_.data(), false, b_.data(), false, m, n, k, c_.data() ); } );
+            }
+        };
+
+        // try every candidate of one field of the configuration, keeping the fastest
+        template< typename Field >
+        void tune_field( tuning_problem& problem, cpu_gemm_config& config, Field field, std::vector<unsigned long> const& candidates,
+                         unsigned long m, unsigned long n, unsigned long k, bool verbose, char const* name )
+        {
+            double best = problem.time_cpu_gemm( config, m, n, k );
+            for ( auto candidate : candidates )
+            {
+                cpu_gemm_config trial = config;
+                trial.*field = candidate;
+                double const elapsed = problem.time_cpu_gemm( trial, m, n, k );
+                if ( elapsed < best )
+                {
+                    best = elapsed;
+                    config = trial;
+                }
+            }
+            if ( verbose )
+                std::cout << "tune_cpu_gemm: " << name << " = " << config.*field << ", " << 2.0e-9 * m * n * k / best << " GFLOP/s" << std::endl;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Search the fastest configuration of `cpu_gemm` for this host, use it, and save it to the cache file.
+    ///
+    /// It tries, in turn, the depth, row and column blocks on a single thread, then the number of threads, then the smallest product worth running on
+    /// several threads. With CBLAS it also measures the smallest product CBLAS runs faster than `cpu_gemm`.
+    /// Tuning takes a few seconds. The saved configuration is loaded at startup by `get_cpu_gemm_config`.
+    ///
+    /// @param cache_file The file to save the configuration to. Nothing is saved if empty.
+    /// @param verbose Print the tuned values.
+    ///
+    /// \code{.cpp}
+    /// tune_cpu_gemm(); // once per host, the next processes start with the tuned configuration
+    /// \endcode
+    ///
+    inline cpu_gemm_config tune_cpu_gemm( std::filesystem::path const& cache_file = cpu_gemm_tuning_cache(), bool verbose = false )
+    {
+        using namespace ceras_private;
+        unsigned long const max_dim = 512;
+        // spanning several blocks in all the dimensions
+        unsigned long const m = 256;
+        unsigned long const n = 768;
+        unsigned long const k = 2048;
+        tuning_problem problem{ std::max( n * k, max_dim * max_dim ) };
+
+        cpu_gemm_config config = get_cpu_gemm_config();
+        unsigned long const hardware_threads = std::max( 1U, std::thread::hardware_concurrency() );
+
+        // cache blocks, single-threaded
+        config.threads = 1;
+        tune_field( problem, config, &cpu_gemm_config::depth_block, { 128UL, 192UL, 256UL, 384UL, 512UL }, m, n, k, verbose, "depth_block" );
+        tune_field( problem, config, &cpu_gemm_config::row_block, { 48UL, 96UL, 144UL, 192UL, 288UL }, m, n, k, verbose, "row_block" );
+        tune_field( problem, config, &cpu_gemm_config::col_block, { 1024UL, 2048UL, 4096UL, 8192UL }, m, n, k, verbose, "col_block" );
+
+        // threads, on a problem large enough to feed all of them
+        if ( hardware_threads > 1 )
+        {
+            std::vector<unsigned long> candidates;
+            for ( unsigned long threads = 2; threads < hardware_threads; threads *= 2 )
+                candidates.push_back( threads );
+            candidates.push_back( hardware_threads );
+            config.parallel_threshold = 0;
+            tune_field( problem, config, &cpu_gemm_config::threads, candidates, max_dim, max_dim, max_dim, verbose, "threads" );
+        }
+
+        // smallest cube worth the threads
+        if ( config.threads != 1 )
+        {
+            cpu_gemm_config single = config;
+            single.threads = 1;
+            cpu_gemm_config multiple = config;
+            multiple.parallel_threshold = 0;
+            config.parallel_threshold = max_dim * max_dim * max_dim;
+            for ( unsigned long dim : { 32UL, 48UL, 64UL, 96UL, 128UL, 192UL, 256UL, 384UL } )
+                if ( problem.time_cpu_gemm( multiple, dim, dim, dim ) < problem.time_cpu_gemm( single, dim, dim, dim ) )
+                {
+                    config.parallel_threshold = dim * dim * dim;
+                    break;
+                }
+            if ( verbose )
+                std::cout << "tune_cpu_gemm: parallel_threshold = " << config.parallel_threshold << std::endl;
+        }
+        else
+        {
+            config.parallel_threshold = cpu_gemm_config{}.parallel_threshold;
+        }
+
+        // smallest cube CBLAS is faster than cpu_gemm
+        if constexpr( cblas_mode )
+        {
+            config.cblas_threshold = std::numeric_limits<unsigned long>::max();
+            for ( unsigned long dim : { 8UL, 16UL, 32UL, 64UL, 128UL, 256UL, 512UL } )
+                if ( problem.time_cblas_gemm( dim, dim, dim ) < problem.time_cpu_gemm( config, dim, dim, dim ) )
+                {
+                    config.cblas_threshold = dim * dim * dim;
+                    break;
+                }
+            if ( verbose )
+                std::cout << "tune_cpu_gemm: cblas_threshold = " << config.cblas_threshold << std::endl;
+        }
+
+        if ( config.threads == hardware_threads )
+            config.threads = 0;
+
+        get_cpu_gemm_config() = config;
+        if ( !cache_file.empty() && !save_cpu_gemm_config( config, cache_file ) && verbose )
+            std::cout << "tune_cpu_gemm: failed to write " << cache_file << std::endl;
+        return config;
+    }
+
+    ///
+    /// @brief Tune `cpu_gemm` at its first use if the environment variable `CERAS_GEMM_AUTOTUNE` is set and this host has not been tuned yet.
+    ///
+    inline void auto_tune_cpu_gemm()
+    {
+        [[maybe_unused]] static bool const tuned = []()
+        {
+            if ( std::getenv( "CERAS_GEMM_AUTOTUNE" ) && !load_cpu_gemm_config() )
+                tune_cpu_gemm();
+            return true;
+        }();
+    }
+
+}//namespace ceras
+
+#endif//CPU_TUNER_HPP_INCLUDED_ZKWQPMRHXNBTGVLDYJECAUSIFOKQZRMXWPNLTHBVGYDJCEASUIO
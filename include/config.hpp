@@ -76,6 +76,15 @@ namespace ceras
     /// \code
     ///
     inline int learning_phase = 1;
+
+    ///
+    /// @brief In-place execution flag.
+    ///
+    /// When `true`, an elementwise operator, such as `relu`, `sigmoid`, `tanh` or `softmax`, writes its output into its input,
+    /// if the input is the output of an operator such as a `plus` or a matrix multiplication, and no other operator reads it.
+    /// Set to `false` to give each of these operators an output of its own.
+    ///
+    inline bool in_place_execution = true;
 }
 
 #endif//FBXYAXRPGSNHIXESHOGNYHPVEWWVSRSRJLQPIRIFENBGNMGFLJNMWXDNQLHKOAGBNYGBJRLBD
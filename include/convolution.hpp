@@ -0,0 +1,1281 @@
+#ifndef CONVOLUTION_HPP_INCLUDED_QXWMZKTRHBNVJLPGYEDCAUSOIFKZQMRXTWHBVNJLPGYEDCAUSOI
+#define CONVOLUTION_HPP_INCLUDED_QXWMZKTRHBNVJLPGYEDCAUSOIFKZQMRXTWHBVNJLPGYEDCAUSOI
+
+#include "./includes.hpp"
+#include "./config.hpp"
+#include "./tensor.hpp"
+#include "./utils/parallel.hpp"
+#include "./utils/cpu_features.hpp"
+
+namespace ceras
+{
+
+    ///
+    /// @brief Algorithms computing a 2D convolution.
+    ///
+    enum class conv2d_algorithm
+    {
+        automatic,      ///< Winograd where the kernel, the strides and the dilations allow it, implicit GEMM otherwise
+        img2col,        ///< the receptive fields gathered in a matrix, multiplied with the kernels by gemm
+        implicit_gemm,  ///< the receptive fields gathered straight into the packed panels of gemm, never stored as a matrix
+        winograd_2x2,   ///< Winograd F(2x2, 3x3), with 2.25x fewer multiplications than img2col
+        winograd_4x4,   ///< Winograd F(4x4, 3x3), with 4x fewer multiplications than img2col and a slightly larger rounding error
+        depthwise,      ///< a direct kernel per channel, for depthwise convolutions, those of as many groups as channels
+        pointwise,      ///< a GEMM on the input itself, for 1x1 kernels without padding
+        autotuned       ///< the fastest of the algorithms which apply, timed at the first convolution of each geometry and saved to `conv2d_tuning_cache()`
+    };
+
+    ///
+    /// @brief The name of a convolution algorithm, as written to the tuning cache.
+    ///
+    inline char const* conv2d_algorithm_name( conv2d_algorithm algorithm ) noexcept
+    {
+        switch ( algorithm )
+        {
+            case conv2d_algorithm::automatic: return "automatic";
+            case conv2d_algorithm::img2col: return "img2col";
+            case conv2d_algorithm::implicit_gemm: return "implicit_gemm";
+            case conv2d_algorithm::winograd_2x2: return "winograd_2x2";
+            case conv2d_algorithm::winograd_4x4: return "winograd_4x4";
+            case conv2d_algorithm::depthwise: return "depthwise";
+            case conv2d_algorithm::pointwise: return "pointwise";
+            case conv2d_algorithm::autotuned: return "autotuned";
+        }
+        return "unknown";
+    }
+
+    ///
+    /// @brief The algorithm of the convolutions of `conv2d` and `general_conv2d`, `conv2d_algorithm::automatic` by default.
+    ///
+    /// Winograd algorithms apply to 3x3 kernels of unit strides and dilations only, other convolutions use the implicit GEMM.
+    /// Where the implicit GEMM does not apply, for 16-bit floats, or with CBLAS or CUDA doing the products, img2col is used.
+    ///
+    /// \code{.cpp}
+    /// convolution_algorithm = conv2d_algorithm::img2col; // to compare with the Winograd results
+    /// \endcode
+    ///
+    /// It is `conv2d_algorithm::autotuned` if the environment variable `CERAS_CONV2D_AUTOTUNE` is set.
+    ///
+    inline conv2d_algorithm convolution_algorithm = std::getenv( "CERAS_CONV2D_AUTOTUNE" ) ? conv2d_algorithm::autotuned : conv2d_algorithm::automatic;
+
+    ///
+    /// @brief The largest workspace of a convolution, in bytes, 256 MiB by default.
+    ///
+    /// img2col convolves the batch in chunks of as many images as their img2col matrix fits in, one image at least, reusing the matrix from chunk to chunk.
+    /// The Winograd transforms are not chunked: where those of the whole batch exceed the limit, the implicit GEMM, of no workspace, is used instead.
+    ///
+    /// \code{.cpp}
+    /// convolution_workspace_limit = 64UL << 20; // at most 64 MiB of img2col matrix per convolution
+    /// \endcode
+    ///
+    inline unsigned long convolution_workspace_limit = 1UL << 28;
+
+    ///
+    /// @brief The dimensions of the convolution of a [batch, rows, cols, channels] input with [filters, kernel_rows, kernel_cols, channels/groups] kernels.
+    ///
+    /// The kernels are read as [filters, channels/groups, kernel_rows, kernel_cols] matrices, the order img2col gathers the receptive fields in.
+    /// The channels and the filters are split in `groups` groups, the filters of a group seeing the channels of the same group only.
+    ///
+    struct conv2d_geometry
+    {
+        unsigned long batch;
+        unsigned long rows;
+        unsigned long cols;
+        unsigned long channels;
+        unsigned long filters;
+        unsigned long kernel_rows;
+        unsigned long kernel_cols;
+        unsigned long row_padding;
+        unsigned long col_padding;
+        unsigned long row_stride;
+        unsigned long col_stride;
+        unsigned long row_dilation;
+        unsigned long col_dilation;
+        unsigned long groups = 1;
+
+        unsigned long output_rows() const noexcept
+        {
+            return ( rows + 2 * row_padding - ( row_dilation * (kernel_rows - 1) + 1 ) ) / row_stride + 1;
+        }
+
+        unsigned long output_cols() const noexcept
+        {
+            return ( cols + 2 * col_padding - ( col_dilation * (kernel_cols - 1) + 1 ) ) / col_stride + 1;
+        }
+
+        // the number of output pixels, the rows of the img2col matrix
+        unsigned long pixels() const noexcept
+        {
+            return batch * output_rows() * output_cols();
+        }
+
+        // the size of a receptive field in the channels of a group, the columns of the img2col matrix
+        unsigned long depth() const noexcept
+        {
+            return kernel_rows * kernel_cols * channels / groups;
+        }
+
+        bool operator==( conv2d_geometry const& ) const noexcept = default;
+    };
+
+    template< typename T >
+    conv2d_algorithm select_conv2d_algorithm( conv2d_geometry const& g, conv2d_algorithm setting = convolution_algorithm );
+
+    namespace ceras_private
+    {
+        // the algorithms which apply to g, the first being that of `conv2d_algorithm::automatic`
+        template< typename T >
+        std::vector<conv2d_algorithm> conv2d_algorithm_candidates( conv2d_geometry const& g )
+        {
+            std::vector<conv2d_algorithm> ans;
+            for ( auto setting : { conv2d_algorithm::automatic, conv2d_algorithm::img2col, conv2d_algorithm::implicit_gemm, conv2d_algorithm::winograd_2x2, conv2d_algorithm::winograd_4x4 } )
+                if ( auto const algorithm = select_conv2d_algorithm<T>( g, setting ); std::find( ans.begin(), ans.end(), algorithm ) == ans.end() )
+                    ans.push_back( algorithm );
+            return ans;
+        }
+
+        // the algorithms tuned in this process, by `conv2d_tuning_key`
+        inline std::map<std::string, conv2d_algorithm>& tuned_conv2d_algorithms() noexcept
+        {
+            static std::map<std::string, conv2d_algorithm> ans;
+            return ans;
+        }
+
+        inline std::mutex& tuned_conv2d_algorithms_mutex() noexcept
+        {
+            static std::mutex ans;
+            return ans;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief The file keeping the tuned convolution algorithms, one line per host and convolution geometry.
+    ///
+    /// It is the environment variable `CERAS_CONV2D_TUNING_CACHE` if set, or `$HOME/.cache/ceras/conv2d_tuning.txt`. Empty if neither is available.
+    ///
+    inline std::filesystem::path conv2d_tuning_cache()
+    {
+        if ( char const* path = std::getenv( "CERAS_CONV2D_TUNING_CACHE" ); path )
+            return std::filesystem::path{ path };
+        if ( char const* home = std::getenv( "HOME" ); home )
+            return std::filesystem::path{ home } / ".cache" / "ceras" / "conv2d_tuning.txt";
+        return std::filesystem::path{};
+    }
+
+    ///
+    /// @brief Key of the algorithm tuned for a convolution: the host key of `cpu_gemm_tuning_key`, the size of the values and the geometry.
+    ///
+    template< typename T >
+    std::string conv2d_tuning_key( conv2d_geometry const& g )
+    {
+        std::string ans = cpu_gemm_tuning_key() + std::string{ "|" } + ( std::floating_point<T> ? "float" : "storage" ) + std::to_string( 8 * sizeof( T ) );
+        for ( unsigned long dimension : { g.batch, g.rows, g.cols, g.channels, g.filters, g.kernel_rows, g.kernel_cols, g.row_padding, g.col_padding,
+                                          g.row_stride, g.col_stride, g.row_dilation, g.col_dilation, g.groups } )
+            ans += std::string{ "|" } + std::to_string( dimension );
+        return ans;
+    }
+
+    ///
+    /// @brief The algorithm tuned for the convolution of `key`, from this process or from the cache file.
+    ///
+    inline std::optional<conv2d_algorithm> load_conv2d_algorithm( std::string const& key, std::filesystem::path const& cache_file = conv2d_tuning_cache() )
+    {
+        using namespace ceras_private;
+        std::lock_guard<std::mutex> const lock{ tuned_conv2d_algorithms_mutex() };
+        if ( auto const itor = tuned_conv2d_algorithms().find( key ); itor != tuned_conv2d_algorithms().end() )
+            return itor->second;
+        if ( auto const value = read_tuning_cache( cache_file, key ); value )
+            for ( auto algorithm : { conv2d_algorithm::img2col, conv2d_algorithm::implicit_gemm, conv2d_algorithm::winograd_2x2, conv2d_algorithm::winograd_4x4,
+                                     conv2d_algorithm::depthwise, conv2d_algorithm::pointwise } )
+                if ( *value == conv2d_algorithm_name( algorithm ) )
+                {
+                    tuned_conv2d_algorithms()[key] = algorithm;
+                    return algorithm;
+                }
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief Keep the algorithm tuned for the convolution of `key` for this process, and write it to the cache file.
+    /// @return False if the cache file cannot be written.
+    ///
+    inline bool save_conv2d_algorithm( std::string const& key, conv2d_algorithm algorithm, std::filesystem::path const& cache_file = conv2d_tuning_cache() )
+    {
+        using namespace ceras_private;
+        std::lock_guard<std::mutex> const lock{ tuned_conv2d_algorithms_mutex() };
+        tuned_conv2d_algorithms()[key] = algorithm;
+        return write_tuning_cache( cache_file, key, conv2d_algorithm_name( algorithm ) );
+    }
+
+    ///
+    /// @brief The algorithm computing a convolution, following `setting`, `convolution_algorithm` by default.
+    ///
+    /// `conv2d_algorithm::automatic` selects F(4x4, 3x3) for outputs of 4 rows and columns at least, and F(2x2, 3x3) for smaller ones.
+    /// A single channel or filter leaves too little work for the GEMMs to pay for the transforms of the Winograd algorithms, the implicit GEMM is used then.
+    /// An algorithm which does not apply falls back to the implicit GEMM, or to img2col.
+    /// Grouped convolutions are computed by the implicit GEMM, group by group, and depthwise convolutions by `conv2d_algorithm::depthwise`, whatever the setting.
+    /// Unless img2col or the implicit GEMM is asked for, 1x1 kernels without padding use `conv2d_algorithm::pointwise`: the [BS*R*C, CH] input is multiplied
+    /// with the kernels as it is for unit strides, and read while packed for larger ones, where the implicit GEMM applies.
+    /// Winograd algorithms whose transforms would exceed `convolution_workspace_limit` fall back as well.
+    /// `conv2d_algorithm::autotuned` gives the algorithm tuned for g, or `conv2d_algorithm::autotuned` itself if g has not been tuned yet and more than one algorithm applies;
+    /// the convolution then times them, see `conv2d`.
+    ///
+    template< typename T >
+    conv2d_algorithm select_conv2d_algorithm( conv2d_geometry const& g, conv2d_algorithm setting )
+    {
+        if ( setting == conv2d_algorithm::autotuned )
+        {
+            auto const candidates = ceras_private::conv2d_algorithm_candidates<T>( g );
+            if ( candidates.size() == 1 )
+                return candidates.front();
+            auto const tuned = load_conv2d_algorithm( conv2d_tuning_key<T>( g ) );
+            return tuned ? *tuned : conv2d_algorithm::autotuned;
+        }
+
+        bool const implicit = std::floating_point<T> && !cuda_mode && !cblas_mode;
+        if ( g.groups > 1 )
+            return ( g.groups == g.channels ) ? conv2d_algorithm::depthwise : ( std::floating_point<T> ? conv2d_algorithm::implicit_gemm : conv2d_algorithm::img2col );
+        bool const winograd = std::floating_point<T> && g.kernel_rows == 3 && g.kernel_cols == 3 && g.row_stride == 1 && g.col_stride == 1 &&
+                              g.row_dilation == 1 && g.col_dilation == 1 && g.row_padding <= 2 && g.col_padding <= 2;
+        bool const pointwise = g.kernel_rows == 1 && g.kernel_cols == 1 && g.row_padding == 0 && g.col_padding == 0 && ( implicit || ( g.row_stride == 1 && g.col_stride == 1 ) );
+        conv2d_algorithm const fallback = pointwise ? conv2d_algorithm::pointwise : ( implicit ? conv2d_algorithm::implicit_gemm : conv2d_algorithm::img2col );
+        // the transformed input, or output gradient, of the whole batch is of (m+2)^2 values per m x m tile
+        auto const& fits = [&g]( unsigned long m ) noexcept
+        {
+            unsigned long const tiles = g.batch * ( ( g.output_rows() + m - 1 ) / m ) * ( ( g.output_cols() + m - 1 ) / m );
+            return ( m + 2 ) * ( m + 2 ) * tiles * std::max( g.channels, g.filters ) * sizeof( T ) <= convolution_workspace_limit;
+        };
+        switch ( setting )
+        {
+            case conv2d_algorithm::img2col: return conv2d_algorithm::img2col;
+            case conv2d_algorithm::implicit_gemm: return implicit ? conv2d_algorithm::implicit_gemm : conv2d_algorithm::img2col;
+            case conv2d_algorithm::winograd_2x2: return ( winograd && fits( 2 ) ) ? conv2d_algorithm::winograd_2x2 : fallback;
+            case conv2d_algorithm::winograd_4x4: return ( winograd && fits( 4 ) ) ? conv2d_algorithm::winograd_4x4 : fallback;
+            default: break;
+        }
+        if ( !winograd || g.channels < 4 || g.filters < 4 )
+            return fallback;
+        if ( g.output_rows() >= 4 && g.output_cols() >= 4 )
+            return fits( 4 ) ? conv2d_algorithm::winograd_4x4 : fallback;
+        return fits( 2 ) ? conv2d_algorithm::winograd_2x2 : fallback;
+    }
+
+    namespace ceras_private
+    {
+        // the number of images of the chunks of a convolution whose workspace is of `image_workspace` T per image, in [1, batch]
+        template< typename T >
+        unsigned long images_per_chunk( unsigned long batch, unsigned long image_workspace ) noexcept
+        {
+            unsigned long const images = convolution_workspace_limit / std::max( image_workspace * sizeof( T ), 1UL );
+            return std::clamp( images, 1UL, std::max( batch, 1UL ) );
+        }
+
+        // the geometry of `images` images of the batch of g
+        inline conv2d_geometry chunk_geometry( conv2d_geometry g, unsigned long images ) noexcept
+        {
+            g.batch = images;
+            return g;
+        }
+
+        // the output index along an axis whose receptive field holds the (padded) input index at the kernel offset, or -1 if there is none
+        inline long output_index( unsigned long index, unsigned long offset, unsigned long stride, unsigned long outputs ) noexcept
+        {
+            if ( index < offset || ( index - offset ) % stride )
+                return -1L;
+            unsigned long const ans = ( index - offset ) / stride;
+            return ( ans < outputs ) ? static_cast<long>( ans ) : -1L;
+        }
+
+        //
+        // col[p][ch*kernel_rows*kernel_cols + r*kernel_cols + c] <= input[b][y*row_stride-row_padding+r*row_dilation][x*col_stride-col_padding+c*col_dilation][ch],
+        // zero out of the input, for the output pixel p = (b*output_rows + y)*output_cols + x.
+        // col is rather [depth x pixels] if `transposed`, the layout of the `img2col` operator.
+        //
+        template< typename T >
+        void img2col_matrix( T const* input, conv2d_geometry const& g, T* col, bool transposed = false )
+        {
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            unsigned long const depth = g.depth();
+            if ( transposed )
+            {
+                // a segment of output_cols entries of every row for each output row, whose receptive fields span a few input rows only
+                unsigned long const pixels = g.pixels();
+                parallel( [&]( unsigned long output_row )
+                {
+                    unsigned long const b = output_row / output_rows;
+                    unsigned long const y = output_row % output_rows;
+                    isa_dispatch( [&]()
+                    {
+                        for ( unsigned long d = 0; d != depth; ++d )
+                        {
+                            unsigned long const ch = d / kernel_size;
+                            std::int64_t const row = static_cast<std::int64_t>( y * g.row_stride + ( ( d % kernel_size ) / g.kernel_cols ) * g.row_dilation ) - static_cast<std::int64_t>( g.row_padding );
+                            std::int64_t const c = static_cast<std::int64_t>( ( d % g.kernel_cols ) * g.col_dilation ) - static_cast<std::int64_t>( g.col_padding );
+                            T* dst = col + d * pixels + output_row * output_cols;
+                            if ( row < 0 || row >= static_cast<std::int64_t>( g.rows ) )
+                            {
+                                std::fill_n( dst, output_cols, T{0} );
+                                continue;
+                            }
+                            T const* src = input + ( b * g.rows + row ) * g.cols * g.channels + ch;
+                            for ( unsigned long x = 0; x != output_cols; ++x )
+                            {
+                                std::int64_t const column = static_cast<std::int64_t>( x * g.col_stride ) + c;
+                                dst[x] = ( column >= 0 && column < static_cast<std::int64_t>( g.cols ) ) ? src[column * g.channels] : T{0};
+                            }
+                        }
+                    } );
+                }, 0UL, g.batch * output_rows );
+                return;
+            }
+
+            parallel( [&]( unsigned long output_row )
+            {
+                unsigned long const b = output_row / output_rows;
+                unsigned long const y = output_row % output_rows;
+                isa_dispatch( [&]()
+                {
+                    for ( unsigned long x = 0; x != output_cols; ++x )
+                    {
+                        T* field = col + ( output_row * output_cols + x ) * depth;
+                        for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                        {
+                            std::int64_t const row = static_cast<std::int64_t>( y * g.row_stride + r * g.row_dilation ) - static_cast<std::int64_t>( g.row_padding );
+                            for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                            {
+                                std::int64_t const column = static_cast<std::int64_t>( x * g.col_stride + c * g.col_dilation ) - static_cast<std::int64_t>( g.col_padding );
+                                T* dst = field + r * g.kernel_cols + c;
+                                if ( row < 0 || row >= static_cast<std::int64_t>( g.rows ) || column < 0 || column >= static_cast<std::int64_t>( g.cols ) )
+                                {
+                                    for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                        dst[ch*kernel_size] = T{0};
+                                    continue;
+                                }
+                                T const* src = input + ( ( b * g.rows + row ) * g.cols + column ) * g.channels;
+                                for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                    dst[ch*kernel_size] = src[ch];
+                            }
+                        }
+                    }
+                } );
+            }, 0UL, g.batch * output_rows );
+        }
+
+        //
+        // The adjoint of `img2col_matrix`: input <= the sum of the columns of col over the receptive fields of each input pixel.
+        // Rather than scattering the receptive fields, which overlap, each input pixel gathers the entries of the output pixels it is seen by,
+        // so that the input rows are written by a single task each, with no race and no zero filling.
+        //
+        template< typename T >
+        void col2img_matrix( T const* col, conv2d_geometry const& g, T* input, bool transposed = false )
+        {
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            unsigned long const pixel_stride = transposed ? 1UL : g.depth();
+            unsigned long const depth_stride = transposed ? g.pixels() : 1UL;
+            parallel( [&]( unsigned long input_row )
+            {
+                unsigned long const b = input_row / g.rows;
+                unsigned long const y = input_row % g.rows + g.row_padding;
+                isa_dispatch( [&]()
+                {
+                    T* dst = input + input_row * g.cols * g.channels;
+                    std::fill_n( dst, g.cols * g.channels, T{0} );
+                    for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                    {
+                        long const output_row = output_index( y, r * g.row_dilation, g.row_stride, output_rows );
+                        if ( output_row < 0 )
+                            continue;
+                        for ( unsigned long x = 0; x != g.cols; ++x )
+                            for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                            {
+                                long const output_col = output_index( x + g.col_padding, c * g.col_dilation, g.col_stride, output_cols );
+                                if ( output_col < 0 )
+                                    continue;
+                                T const* src = col + ( ( b * output_rows + output_row ) * output_cols + output_col ) * pixel_stride + ( r * g.kernel_cols + c ) * depth_stride;
+                                for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                    dst[x*g.channels+ch] += src[ch*kernel_size*depth_stride];
+                            }
+                    }
+                } );
+            }, 0UL, g.batch * g.rows, 1UL );
+        }
+
+        // the offsets of the entries [first, first+count) of a receptive field, ch*kernel_rows*kernel_cols + r*kernel_cols + c, in the input
+        struct field_offset
+        {
+            std::int64_t row_;
+            std::int64_t col_;
+            unsigned long channel_;
+        };
+
+        inline field_offset const* field_offsets( conv2d_geometry const& g, unsigned long first, unsigned long count )
+        {
+            thread_local std::vector<field_offset> ans;
+            ans.resize( count );
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            for ( unsigned long idx = 0; idx != count; ++idx )
+            {
+                unsigned long const d = first + idx;
+                unsigned long const position = d % kernel_size;
+                ans[idx] = field_offset{ static_cast<std::int64_t>( ( position / g.kernel_cols ) * g.row_dilation ), static_cast<std::int64_t>( ( position % g.kernel_cols ) * g.col_dilation ), d / kernel_size };
+            }
+            return ans.data();
+        }
+
+        //
+        // The [pixels x depth] matrix of `img2col_matrix`, read from the input while packed into the panels of `packed_gemm`, by the overloads
+        // of `pack_lhs` and `pack_rhs` below: the implicit GEMM never stores it. For a grouped convolution, input_ points to the first channel of a group.
+        //
+        template< typename T >
+        struct receptive_fields
+        {
+            T const* input_;
+            conv2d_geometry g_;
+            unsigned long output_rows_;
+            unsigned long output_cols_;
+
+            receptive_fields( T const* input, conv2d_geometry const& g ) noexcept : input_{ input }, g_{ g }, output_rows_{ g.output_rows() }, output_cols_{ g.output_cols() } {}
+
+            // the top-left corner of the receptive field of the output pixel p, in its image
+            struct origin
+            {
+                std::int64_t row_;
+                std::int64_t col_;
+                T const* image_;
+            };
+
+            origin origin_of( unsigned long p ) const noexcept
+            {
+                unsigned long const x = p % output_cols_;
+                unsigned long const y = ( p / output_cols_ ) % output_rows_;
+                unsigned long const b = p / ( output_cols_ * output_rows_ );
+                return origin{ static_cast<std::int64_t>( y * g_.row_stride ) - static_cast<std::int64_t>( g_.row_padding ),
+                               static_cast<std::int64_t>( x * g_.col_stride ) - static_cast<std::int64_t>( g_.col_padding ),
+                               input_ + b * g_.rows * g_.cols * g_.channels };
+            }
+
+            T at( origin const& o, field_offset const& f ) const noexcept
+            {
+                std::int64_t const row = o.row_ + f.row_;
+                std::int64_t const col = o.col_ + f.col_;
+                if ( row < 0 || row >= static_cast<std::int64_t>( g_.rows ) || col < 0 || col >= static_cast<std::int64_t>( g_.cols ) )
+                    return T{0};
+                return o.image_[( row * g_.cols + col ) * g_.channels + f.channel_];
+            }
+        };
+
+        // the receptive fields of the output pixels [row_first, row_first+rows) as the lhs of `packed_gemm`
+        template< unsigned long MR, typename T >
+        void pack_lhs( receptive_fields<T> const& lhs, unsigned long row_first, unsigned long rows, unsigned long depth_first, unsigned long depth, T* __restrict__ buffer )
+        {
+            field_offset const* offsets = field_offsets( lhs.g_, depth_first, depth );
+            for ( unsigned long r = 0; r < rows; r += MR )
+            {
+                unsigned long const mr = std::min( MR, rows - r );
+                for ( unsigned long i = 0; i != mr; ++i )
+                {
+                    auto const origin = lhs.origin_of( row_first + r + i );
+                    for ( unsigned long d = 0; d != depth; ++d )
+                        buffer[d*MR+i] = lhs.at( origin, offsets[d] );
+                }
+                for ( unsigned long i = mr; i != MR; ++i )
+                    for ( unsigned long d = 0; d != depth; ++d )
+                        buffer[d*MR+i] = T{0};
+                buffer += MR * depth;
+            }
+        }
+
+        // the receptive fields of the output pixels [depth_first, depth_first+depth) as the rhs of `packed_gemm`, for the gradient of the kernels
+        template< unsigned long NR, typename T >
+        void pack_rhs( receptive_fields<T> const& rhs, unsigned long depth_first, unsigned long depth, unsigned long col_first, unsigned long cols, T* __restrict__ buffer )
+        {
+            field_offset const* offsets = field_offsets( rhs.g_, col_first, cols );
+            for ( unsigned long c = 0; c < cols; c += NR )
+            {
+                unsigned long const nr = std::min( NR, cols - c );
+                for ( unsigned long d = 0; d != depth; ++d )
+                {
+                    auto const origin = rhs.origin_of( depth_first + d );
+                    for ( unsigned long j = 0; j != nr; ++j )
+                        buffer[j] = rhs.at( origin, offsets[c+j] );
+                    for ( unsigned long j = nr; j != NR; ++j )
+                        buffer[j] = T{0};
+                    buffer += NR;
+                }
+            }
+        }
+
+        //
+        // The matrix of the output gradient seen by the input pixels of a stride phase, those at (row_first_ + t*row_stride, col_first_ + u*col_stride),
+        // in the filters of a group, grad_ pointing to the first of them: the entry k*filters + nc of an input pixel is the gradient of the filter nc at the output pixel whose receptive field holds the input pixel
+        // at the kernel position positions_[k], or zero if there is none.
+        // The input pixels of a phase are reached by the same kernel positions only, so that no product of the strided zeros is computed.
+        // Its product with the kernels of these positions rearranged to [positions*filters x channels] is the input gradient, without the scattering of col2img.
+        //
+        template< typename T >
+        struct gradient_fields
+        {
+            T const* grad_;
+            conv2d_geometry g_;
+            unsigned long output_rows_;
+            unsigned long output_cols_;
+            unsigned long row_first_;
+            unsigned long col_first_;
+            unsigned long phase_rows_;
+            unsigned long phase_cols_;
+            unsigned long const* positions_;
+        };
+
+        // the output gradient seen by the input pixels [row_first, row_first+rows) of a phase as the lhs of `packed_gemm`, copied by runs of filters
+        template< unsigned long MR, typename T >
+        void pack_lhs( gradient_fields<T> const& lhs, unsigned long row_first, unsigned long rows, unsigned long depth_first, unsigned long depth, T* __restrict__ buffer )
+        {
+            conv2d_geometry const& g = lhs.g_;
+            unsigned long const filters = g.filters / g.groups;
+            for ( unsigned long r = 0; r < rows; r += MR )
+            {
+                unsigned long const mr = std::min( MR, rows - r );
+                for ( unsigned long i = 0; i != mr; ++i )
+                {
+                    unsigned long const p = row_first + r + i;
+                    unsigned long const x = lhs.col_first_ + ( p % lhs.phase_cols_ ) * g.col_stride + g.col_padding;
+                    unsigned long const y = lhs.row_first_ + ( ( p / lhs.phase_cols_ ) % lhs.phase_rows_ ) * g.row_stride + g.row_padding;
+                    T const* image = lhs.grad_ + ( p / ( lhs.phase_cols_ * lhs.phase_rows_ ) ) * lhs.output_rows_ * lhs.output_cols_ * g.filters;
+                    for ( unsigned long d = 0; d != depth; )
+                    {
+                        unsigned long const position = lhs.positions_[( depth_first + d ) / filters];
+                        unsigned long const filter = ( depth_first + d ) % filters;
+                        unsigned long const run = std::min( filters - filter, depth - d );
+                        long const output_row = output_index( y, ( position / g.kernel_cols ) * g.row_dilation, g.row_stride, lhs.output_rows_ );
+                        long const output_col = output_index( x, ( position % g.kernel_cols ) * g.col_dilation, g.col_stride, lhs.output_cols_ );
+                        if ( output_row < 0 || output_col < 0 )
+                        {
+                            for ( unsigned long idx = 0; idx != run; ++idx )
+                                buffer[(d+idx)*MR+i] = T{0};
+                        }
+                        else
+                        {
+                            T const* src = image + ( output_row * lhs.output_cols_ + output_col ) * g.filters + filter;
+                            for ( unsigned long idx = 0; idx != run; ++idx )
+                                buffer[(d+idx)*MR+i] = src[idx];
+                        }
+                        d += run;
+                    }
+                }
+                for ( unsigned long i = mr; i != MR; ++i )
+                    for ( unsigned long d = 0; d != depth; ++d )
+                        buffer[d*MR+i] = T{0};
+                buffer += MR * depth;
+            }
+        }
+
+        //
+        // Convolution by implicit GEMM: output[pixels x filters] <= receptive fields[pixels x depth] * kernels'[depth x filters],
+        // the receptive fields being gathered into the packed panels of the GEMM, and the kernels read from their packed copy if given.
+        // Grouped convolutions run a GEMM per group, on the channels, the kernels and the output columns of the group.
+        //
+        template< typename T >
+        void implicit_gemm_conv2d( T const* input, T const* weight, packed_matrix<T> const* packed_weight, conv2d_geometry const& g, T* output )
+        {
+            auto_tune_cpu_gemm();
+            unsigned long const pixels = g.pixels();
+            unsigned long const depth = g.depth();
+            if ( packed_weight && g.groups == 1 )
+            {
+                receptive_fields<T> const lhs{ input, g };
+                prepacked_panels<T> const rhs{ packed_weight->data_.get(), depth, packed_weight->panel_ };
+                with_gemm_kernel<T>( packed_weight->isa_, [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, pixels, depth, g.filters, output, g.filters ); } );
+                return;
+            }
+            unsigned long const channels = g.channels / g.groups;
+            unsigned long const filters = g.filters / g.groups;
+            for ( unsigned long group = 0; group != g.groups; ++group )
+            {
+                receptive_fields<T> const lhs{ input + group * channels, g };
+                strided_matrix<T> const rhs{ weight + group * filters * depth, 1UL, depth };
+                with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, pixels, depth, filters, output + group * filters, g.filters ); } );
+            }
+        }
+
+        //
+        // input_grad[input pixels x channels] <= gradient fields[input pixels x positions*filters] * rearranged kernels, phase by phase and group by group:
+        // for unit strides the single phase is written in place, otherwise each phase goes through a buffer of its pixels.
+        //
+        template< typename T >
+        void implicit_gemm_conv2d_input_gradient( T const* grad, T const* weight, conv2d_geometry const& g, T* input_grad )
+        {
+            auto_tune_cpu_gemm();
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const channels = g.channels / g.groups;
+            unsigned long const filters = g.filters / g.groups;
+            std::vector<unsigned long> positions;
+            tensor<T> kernels;
+            tensor<T> phase_grad;
+            for ( unsigned long row_first = 0; row_first != std::min( g.row_stride, g.rows ); ++row_first )
+                for ( unsigned long col_first = 0; col_first != std::min( g.col_stride, g.cols ); ++col_first )
+                {
+                    unsigned long const phase_rows = ( g.rows - row_first + g.row_stride - 1 ) / g.row_stride;
+                    unsigned long const phase_cols = ( g.cols - col_first + g.col_stride - 1 ) / g.col_stride;
+                    unsigned long const phase_pixels = g.batch * phase_rows * phase_cols;
+                    bool const in_place = g.row_stride == 1 && g.col_stride == 1;
+
+                    positions.clear();
+                    for ( unsigned long position = 0; position != kernel_size; ++position )
+                        if ( ( row_first + g.row_padding ) % g.row_stride == ( ( position / g.kernel_cols ) * g.row_dilation ) % g.row_stride &&
+                             ( col_first + g.col_padding ) % g.col_stride == ( ( position % g.kernel_cols ) * g.col_dilation ) % g.col_stride )
+                            positions.push_back( position );
+
+                    T* phase_output = input_grad;
+                    if ( !in_place )
+                    {
+                        phase_grad.resize( {phase_pixels, g.channels} );
+                        phase_output = phase_grad.data();
+                    }
+
+                    if ( positions.empty() )
+                        std::fill_n( phase_output, phase_pixels * g.channels, T{0} );
+                    else
+                    {
+                        kernels.resize( {positions.size() * filters, channels} );
+                        for ( unsigned long group = 0; group != g.groups; ++group )
+                        {
+                            for ( unsigned long k = 0; k != positions.size(); ++k )
+                                for ( unsigned long nc = 0; nc != filters; ++nc )
+                                    for ( unsigned long ch = 0; ch != channels; ++ch )
+                                        kernels[(k*filters+nc)*channels+ch] = weight[((group*filters+nc)*channels+ch)*kernel_size+positions[k]];
+
+                            gradient_fields<T> const lhs{ grad + group * filters, g, output_rows, output_cols, row_first, col_first, phase_rows, phase_cols, positions.data() };
+                            strided_matrix<T> const rhs{ kernels.data(), channels, 1UL };
+                            with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel )
+                            {
+                                packed_gemm<Kernel>( lhs, rhs, phase_pixels, positions.size() * filters, channels, phase_output + group * channels, g.channels );
+                            } );
+                        }
+                    }
+
+                    if ( !in_place )
+                    {
+                        for ( unsigned long p = 0; p != phase_pixels; ++p )
+                        {
+                            unsigned long const x = col_first + ( p % phase_cols ) * g.col_stride;
+                            unsigned long const y = row_first + ( ( p / phase_cols ) % phase_rows ) * g.row_stride;
+                            unsigned long const b = p / ( phase_cols * phase_rows );
+                            std::copy_n( phase_output + p * g.channels, g.channels, input_grad + ( ( b * g.rows + y ) * g.cols + x ) * g.channels );
+                        }
+                    }
+                }
+        }
+
+        // weight_grad[filters x depth] <= grad'[filters x pixels] * receptive fields[pixels x depth], group by group
+        template< typename T >
+        void implicit_gemm_conv2d_weight_gradient( T const* input, T const* grad, conv2d_geometry const& g, T* weight_grad )
+        {
+            auto_tune_cpu_gemm();
+            unsigned long const depth = g.depth();
+            unsigned long const channels = g.channels / g.groups;
+            unsigned long const filters = g.filters / g.groups;
+            for ( unsigned long group = 0; group != g.groups; ++group )
+            {
+                strided_matrix<T> const lhs{ grad + group * filters, 1UL, g.filters };
+                receptive_fields<T> const rhs{ input + group * channels, g };
+                with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, filters, g.pixels(), depth, weight_grad + group * filters * depth, depth ); } );
+            }
+        }
+
+        //
+        // The [pixels x channels] input of a 1x1 convolution without padding, strided: each row is the contiguous channels of an input pixel,
+        // copied while packed into the panels of `packed_gemm` by the overloads of `pack_lhs` and `pack_rhs` below.
+        //
+        template< typename T >
+        struct pointwise_fields
+        {
+            T const* input_;
+            conv2d_geometry g_;
+            unsigned long output_rows_;
+            unsigned long output_cols_;
+
+            pointwise_fields( T const* input, conv2d_geometry const& g ) noexcept : input_{ input }, g_{ g }, output_rows_{ g.output_rows() }, output_cols_{ g.output_cols() } {}
+
+            // the channels of the input pixel seen by the output pixel p
+            T const* pixel( unsigned long p ) const noexcept
+            {
+                unsigned long const x = p % output_cols_;
+                unsigned long const y = ( p / output_cols_ ) % output_rows_;
+                unsigned long const b = p / ( output_cols_ * output_rows_ );
+                return input_ + ( ( b * g_.rows + y * g_.row_stride ) * g_.cols + x * g_.col_stride ) * g_.channels;
+            }
+        };
+
+        template< unsigned long MR, typename T >
+        void pack_lhs( pointwise_fields<T> const& lhs, unsigned long row_first, unsigned long rows, unsigned long depth_first, unsigned long depth, T* __restrict__ buffer )
+        {
+            for ( unsigned long r = 0; r < rows; r += MR )
+            {
+                unsigned long const mr = std::min( MR, rows - r );
+                for ( unsigned long i = 0; i != mr; ++i )
+                {
+                    T const* src = lhs.pixel( row_first + r + i ) + depth_first;
+                    for ( unsigned long d = 0; d != depth; ++d )
+                        buffer[d*MR+i] = src[d];
+                }
+                for ( unsigned long i = mr; i != MR; ++i )
+                    for ( unsigned long d = 0; d != depth; ++d )
+                        buffer[d*MR+i] = T{0};
+                buffer += MR * depth;
+            }
+        }
+
+        template< unsigned long NR, typename T >
+        void pack_rhs( pointwise_fields<T> const& rhs, unsigned long depth_first, unsigned long depth, unsigned long col_first, unsigned long cols, T* __restrict__ buffer )
+        {
+            for ( unsigned long c = 0; c < cols; c += NR )
+            {
+                unsigned long const nr = std::min( NR, cols - c );
+                for ( unsigned long d = 0; d != depth; ++d )
+                {
+                    T const* src = rhs.pixel( depth_first + d ) + col_first + c;
+                    std::copy_n( src, nr, buffer );
+                    std::fill_n( buffer + nr, NR - nr, T{0} );
+                    buffer += NR;
+                }
+            }
+        }
+
+        // output[pixels x filters] <= input pixels[pixels x channels] * kernels'[channels x filters], for a strided 1x1 convolution
+        template< typename T >
+        void pointwise_conv2d( T const* input, T const* weight, packed_matrix<T> const* packed_weight, conv2d_geometry const& g, T* output )
+        {
+            auto_tune_cpu_gemm();
+            pointwise_fields<T> const lhs{ input, g };
+            if ( packed_weight )
+            {
+                prepacked_panels<T> const rhs{ packed_weight->data_.get(), g.channels, packed_weight->panel_ };
+                with_gemm_kernel<T>( packed_weight->isa_, [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, g.pixels(), g.channels, g.filters, output, g.filters ); } );
+                return;
+            }
+            strided_matrix<T> const rhs{ weight, 1UL, g.channels };
+            with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, g.pixels(), g.channels, g.filters, output, g.filters ); } );
+        }
+
+        // weight_grad[filters x channels] <= grad'[filters x pixels] * input pixels[pixels x channels], for a strided 1x1 convolution
+        template< typename T >
+        void pointwise_conv2d_weight_gradient( T const* input, T const* grad, conv2d_geometry const& g, T* weight_grad )
+        {
+            auto_tune_cpu_gemm();
+            strided_matrix<T> const lhs{ grad, 1UL, g.filters };
+            pointwise_fields<T> const rhs{ input, g };
+            with_gemm_kernel<T>( current_isa(), [&]<typename Kernel>( Kernel ){ packed_gemm<Kernel>( lhs, rhs, g.filters, g.pixels(), g.channels, weight_grad, g.channels ); } );
+        }
+
+        // the accumulator of a depthwise convolution of T, float for 16-bit floats
+        template< typename T >
+        using depthwise_accumulator = std::conditional_t<is_half_precision_v<T>, float, T>;
+
+        // the kernels [filters, kernel_rows, kernel_cols, 1] as [kernel_rows*kernel_cols, filters], contiguous along the filters as the pixels are
+        template< typename T >
+        std::vector<T> depthwise_kernels( T const* weight, conv2d_geometry const& g )
+        {
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            std::vector<T> ans( kernel_size * g.filters );
+            for ( unsigned long f = 0; f != g.filters; ++f )
+                for ( unsigned long position = 0; position != kernel_size; ++position )
+                    ans[position*g.filters+f] = weight[f*kernel_size+position];
+            return ans;
+        }
+
+        //
+        // output[b][y][x][f] <= the sum of input[b][..][..][f/multiplier] * weight[f][r][c] over the kernel, the multiplier being filters/channels.
+        // A direct kernel, vectorized along the filters of an output pixel, one task per output row.
+        //
+        template< typename T >
+        void depthwise_conv2d( T const* input, T const* weight, conv2d_geometry const& g, T* output )
+        {
+            typedef depthwise_accumulator<T> accumulator_type;
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const multiplier = g.filters / g.channels;
+            std::vector<T> const kernels = depthwise_kernels( weight, g );
+            parallel( [&]( unsigned long output_row )
+            {
+                unsigned long const b = output_row / output_rows;
+                unsigned long const y = output_row % output_rows;
+                std::vector<accumulator_type> accumulators( g.filters );
+                isa_dispatch( [&]()
+                {
+                    accumulator_type* __restrict__ acc = accumulators.data();
+                    for ( unsigned long x = 0; x != output_cols; ++x )
+                    {
+                        std::fill_n( acc, g.filters, accumulator_type{0} );
+                        for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                        {
+                            std::int64_t const row = static_cast<std::int64_t>( y * g.row_stride + r * g.row_dilation ) - static_cast<std::int64_t>( g.row_padding );
+                            if ( row < 0 || row >= static_cast<std::int64_t>( g.rows ) )
+                                continue;
+                            for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                            {
+                                std::int64_t const column = static_cast<std::int64_t>( x * g.col_stride + c * g.col_dilation ) - static_cast<std::int64_t>( g.col_padding );
+                                if ( column < 0 || column >= static_cast<std::int64_t>( g.cols ) )
+                                    continue;
+                                T const* __restrict__ src = input + ( ( b * g.rows + row ) * g.cols + column ) * g.channels;
+                                T const* __restrict__ k = kernels.data() + ( r * g.kernel_cols + c ) * g.filters;
+                                if ( multiplier == 1 )
+                                {
+                                    for ( unsigned long f = 0; f != g.filters; ++f )
+                                        acc[f] += static_cast<accumulator_type>( src[f] ) * static_cast<accumulator_type>( k[f] );
+                                }
+                                else
+                                {
+                                    for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                        for ( unsigned long m = 0; m != multiplier; ++m )
+                                            acc[ch*multiplier+m] += static_cast<accumulator_type>( src[ch] ) * static_cast<accumulator_type>( k[ch*multiplier+m] );
+                                }
+                            }
+                        }
+                        T* dst = output + ( output_row * output_cols + x ) * g.filters;
+                        for ( unsigned long f = 0; f != g.filters; ++f )
+                            dst[f] = static_cast<T>( acc[f] );
+                    }
+                } );
+            }, 0UL, g.batch * output_rows );
+        }
+
+        // input_grad[b][y][x][ch] <= the sum of the output gradient of the filters of ch times their kernels, gathered over the output pixels seeing (y, x)
+        template< typename T >
+        void depthwise_conv2d_input_gradient( T const* grad, T const* weight, conv2d_geometry const& g, T* input_grad )
+        {
+            typedef depthwise_accumulator<T> accumulator_type;
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const multiplier = g.filters / g.channels;
+            std::vector<T> const kernels = depthwise_kernels( weight, g );
+            parallel( [&]( unsigned long input_row )
+            {
+                unsigned long const b = input_row / g.rows;
+                unsigned long const y = input_row % g.rows + g.row_padding;
+                std::vector<accumulator_type> accumulators( g.channels );
+                isa_dispatch( [&]()
+                {
+                    accumulator_type* __restrict__ acc = accumulators.data();
+                    for ( unsigned long x = 0; x != g.cols; ++x )
+                    {
+                        std::fill_n( acc, g.channels, accumulator_type{0} );
+                        for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                        {
+                            long const output_row = output_index( y, r * g.row_dilation, g.row_stride, output_rows );
+                            if ( output_row < 0 )
+                                continue;
+                            for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                            {
+                                long const output_col = output_index( x + g.col_padding, c * g.col_dilation, g.col_stride, output_cols );
+                                if ( output_col < 0 )
+                                    continue;
+                                T const* __restrict__ src = grad + ( ( b * output_rows + output_row ) * output_cols + output_col ) * g.filters;
+                                T const* __restrict__ k = kernels.data() + ( r * g.kernel_cols + c ) * g.filters;
+                                if ( multiplier == 1 )
+                                {
+                                    for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                        acc[ch] += static_cast<accumulator_type>( src[ch] ) * static_cast<accumulator_type>( k[ch] );
+                                }
+                                else
+                                {
+                                    for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                        for ( unsigned long m = 0; m != multiplier; ++m )
+                                            acc[ch] += static_cast<accumulator_type>( src[ch*multiplier+m] ) * static_cast<accumulator_type>( k[ch*multiplier+m] );
+                                }
+                            }
+                        }
+                        T* dst = input_grad + ( input_row * g.cols + x ) * g.channels;
+                        for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                            dst[ch] = static_cast<T>( acc[ch] );
+                    }
+                } );
+            }, 0UL, g.batch * g.rows, 1UL );
+        }
+
+        //
+        // weight_grad[f][r][c] <= the sum of grad[..][f] * input[..][f/multiplier] over the output pixels, a reduction:
+        // each task accumulates its output rows in its own [kernel_rows*kernel_cols, filters] partial sums, added up once all are done.
+        //
+        template< typename T >
+        void depthwise_conv2d_weight_gradient( T const* input, T const* grad, conv2d_geometry const& g, T* weight_grad )
+        {
+            typedef depthwise_accumulator<T> accumulator_type;
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const multiplier = g.filters / g.channels;
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            unsigned long const rows = g.batch * output_rows;
+            unsigned long const tasks = std::max( 1UL, std::min( rows, parallel_threads() ) );
+            std::vector<accumulator_type> partial_sums( tasks * kernel_size * g.filters, accumulator_type{0} );
+            parallel( [&]( unsigned long task )
+            {
+                isa_dispatch( [&]()
+                {
+                    accumulator_type* __restrict__ acc = partial_sums.data() + task * kernel_size * g.filters;
+                    for ( unsigned long output_row = task * rows / tasks; output_row != ( task + 1 ) * rows / tasks; ++output_row )
+                    {
+                        unsigned long const b = output_row / output_rows;
+                        unsigned long const y = output_row % output_rows;
+                        for ( unsigned long x = 0; x != output_cols; ++x )
+                        {
+                            T const* __restrict__ src_grad = grad + ( output_row * output_cols + x ) * g.filters;
+                            for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                            {
+                                std::int64_t const row = static_cast<std::int64_t>( y * g.row_stride + r * g.row_dilation ) - static_cast<std::int64_t>( g.row_padding );
+                                if ( row < 0 || row >= static_cast<std::int64_t>( g.rows ) )
+                                    continue;
+                                for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                                {
+                                    std::int64_t const column = static_cast<std::int64_t>( x * g.col_stride + c * g.col_dilation ) - static_cast<std::int64_t>( g.col_padding );
+                                    if ( column < 0 || column >= static_cast<std::int64_t>( g.cols ) )
+                                        continue;
+                                    T const* __restrict__ src = input + ( ( b * g.rows + row ) * g.cols + column ) * g.channels;
+                                    accumulator_type* __restrict__ dst = acc + ( r * g.kernel_cols + c ) * g.filters;
+                                    if ( multiplier == 1 )
+                                    {
+                                        for ( unsigned long f = 0; f != g.filters; ++f )
+                                            dst[f] += static_cast<accumulator_type>( src_grad[f] ) * static_cast<accumulator_type>( src[f] );
+                                    }
+                                    else
+                                    {
+                                        for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                                            for ( unsigned long m = 0; m != multiplier; ++m )
+                                                dst[ch*multiplier+m] += static_cast<accumulator_type>( src_grad[ch*multiplier+m] ) * static_cast<accumulator_type>( src[ch] );
+                                    }
+                                }
+                            }
+                        }
+                    }
+                } );
+            }, 0UL, tasks, 1UL );
+
+            for ( unsigned long f = 0; f != g.filters; ++f )
+                for ( unsigned long position = 0; position != kernel_size; ++position )
+                {
+                    accumulator_type sum{0};
+                    for ( unsigned long task = 0; task != tasks; ++task )
+                        sum += partial_sums[( task * kernel_size + position ) * g.filters + f];
+                    weight_grad[f*kernel_size+position] = static_cast<T>( sum );
+                }
+        }
+
+        //
+        // The geometry of the convolution whose adjoint is the transposed convolution of a [batch, rows, cols, channels] input into `filters` channels:
+        // its input is the output of the transposed convolution, of (rows-1)*stride + dilation*(kernel-1) + 1 rows for the valid padding or rows*stride for the same padding,
+        // its filters are the channels of the transposed convolution, and its output is the input of the transposed convolution.
+        // An odd total padding puts the larger half before the output, which a symmetric padding cannot do: the geometry then has the smaller half,
+        // and an extra first row or column, cropped from the output.
+        //
+        inline conv2d_geometry transposed_conv2d_geometry( unsigned long batch, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters,
+                                                           unsigned long kernel_rows, unsigned long kernel_cols, unsigned long row_stride, unsigned long col_stride,
+                                                           unsigned long row_dilation, unsigned long col_dilation, bool same ) noexcept
+        {
+            unsigned long const row_span = row_dilation * ( kernel_rows - 1 ) + 1;
+            unsigned long const col_span = col_dilation * ( kernel_cols - 1 ) + 1;
+            if ( !same )
+                return conv2d_geometry{ batch, ( rows - 1 ) * row_stride + row_span, ( cols - 1 ) * col_stride + col_span, filters, channels,
+                                        kernel_rows, kernel_cols, 0, 0, row_stride, col_stride, row_dilation, col_dilation };
+            unsigned long const row_padding = ( row_span > row_stride ) ? ( row_span - row_stride ) : 0;
+            unsigned long const col_padding = ( col_span > col_stride ) ? ( col_span - col_stride ) : 0;
+            return conv2d_geometry{ batch, rows * row_stride + ( row_padding & 1 ), cols * col_stride + ( col_padding & 1 ), filters, channels,
+                                    kernel_rows, kernel_cols, row_padding / 2, col_padding / 2, row_stride, col_stride, row_dilation, col_dilation };
+        }
+
+        //
+        // The offset in the [filters, kernel_rows, kernel_cols, channels] kernels of `conv2d_transpose` of the entry (ch, nc, r, c) of the kernels of the
+        // convolution of geometry g it is the adjoint of, read as [channels, filters, kernel_rows, kernel_cols].
+        // The kernels of the transposed convolution used to be flipped along their rows and columns as stored, then read as the kernels of a convolution
+        // of the zero-inserted input; the same entries are kept, so that trained kernels compute the same.
+        //
+        inline unsigned long transposed_conv2d_kernel_offset( conv2d_geometry const& g, unsigned long ch, unsigned long nc, unsigned long r, unsigned long c ) noexcept
+        {
+            unsigned long const channels = g.filters;
+            unsigned long const kernel_size = g.kernel_rows * g.kernel_cols;
+            unsigned long const flipped = ch * kernel_size + ( g.kernel_rows - 1 - r ) * g.kernel_cols + ( g.kernel_cols - 1 - c );
+            unsigned long const row = flipped / ( g.kernel_cols * channels );
+            unsigned long const col = ( flipped / channels ) % g.kernel_cols;
+            return ( ( nc * g.kernel_rows + g.kernel_rows - 1 - row ) * g.kernel_cols + g.kernel_cols - 1 - col ) * channels + flipped % channels;
+        }
+
+        template< unsigned long Rows, unsigned long Cols >
+        using small_matrix = std::array<std::array<double, Cols>, Rows>;
+
+        template< unsigned long Rows, unsigned long Cols >
+        constexpr small_matrix<Cols, Rows> transposed( small_matrix<Rows, Cols> const& m ) noexcept
+        {
+            small_matrix<Cols, Rows> ans{};
+            for ( unsigned long r = 0; r != Rows; ++r )
+                for ( unsigned long c = 0; c != Cols; ++c )
+                    ans[c][r] = m[r][c];
+            return ans;
+        }
+
+        //
+        // Winograd F(m x m, 3 x 3), after Lavin and Gray, "Fast Algorithms for Convolutional Neural Networks":
+        // an m x m output tile is At [ (G g Gt) .* (Bt d B) ] A, for the 3 x 3 kernel g and the (m+2) x (m+2) input tile d.
+        //
+        template< unsigned long M >
+        struct winograd_transforms;
+
+        template<>
+        struct winograd_transforms<2>
+        {
+            static constexpr unsigned long alpha = 4;
+            static constexpr small_matrix<4, 4> bt{ { { 1.0,  0.0, -1.0,  0.0 },
+                                                      { 0.0,  1.0,  1.0,  0.0 },
+                                                      { 0.0, -1.0,  1.0,  0.0 },
+                                                      { 0.0,  1.0,  0.0, -1.0 } } };
+            static constexpr small_matrix<4, 3> g{ { { 1.0,  0.0, 0.0 },
+                                                     { 0.5,  0.5, 0.5 },
+                                                     { 0.5, -0.5, 0.5 },
+                                                     { 0.0,  0.0, 1.0 } } };
+            static constexpr small_matrix<2, 4> at{ { { 1.0, 1.0,  1.0,  0.0 },
+                                                      { 0.0, 1.0, -1.0, -1.0 } } };
+        };
+
+        template<>
+        struct winograd_transforms<4>
+        {
+            static constexpr unsigned long alpha = 6;
+            static constexpr small_matrix<6, 6> bt{ { { 4.0,  0.0, -5.0,  0.0, 1.0, 0.0 },
+                                                      { 0.0, -4.0, -4.0,  1.0, 1.0, 0.0 },
+                                                      { 0.0,  4.0, -4.0, -1.0, 1.0, 0.0 },
+                                                      { 0.0, -2.0, -1.0,  2.0, 1.0, 0.0 },
+                                                      { 0.0,  2.0, -1.0, -2.0, 1.0, 0.0 },
+                                                      { 0.0,  4.0,  0.0, -5.0, 0.0, 1.0 } } };
+            static constexpr small_matrix<6, 3> g{ { {  1.0/4.0,   0.0,       0.0     },
+                                                     { -1.0/6.0,  -1.0/6.0,  -1.0/6.0 },
+                                                     { -1.0/6.0,   1.0/6.0,  -1.0/6.0 },
+                                                     {  1.0/24.0,  1.0/12.0,  1.0/6.0 },
+                                                     {  1.0/24.0, -1.0/12.0,  1.0/6.0 },
+                                                     {  0.0,       0.0,       1.0     } } };
+            static constexpr small_matrix<4, 6> at{ { { 1.0, 1.0,  1.0, 1.0,  1.0, 0.0 },
+                                                      { 0.0, 1.0, -1.0, 2.0, -2.0, 0.0 },
+                                                      { 0.0, 1.0,  1.0, 4.0,  4.0, 0.0 },
+                                                      { 0.0, 1.0, -1.0, 8.0, -8.0, 1.0 } } };
+        };
+
+        //
+        // out[i*out_i + r*out_r + ch] <= sum_s m[r][s] * in[i*in_i + s*in_s + ch], for r in [0, Rows), i in [0, n) and ch in [0, channels):
+        // one side of the product of a transform matrix with a tile whose elements are vectors of channels
+        //
+        template< unsigned long Rows, unsigned long Cols, typename T >
+        void winograd_transform( small_matrix<Rows, Cols> const& m, T const* in, unsigned long in_i, unsigned long in_s,
+                                 T* out, unsigned long out_i, unsigned long out_r, unsigned long n, unsigned long channels ) noexcept
+        {
+            for ( unsigned long i = 0; i != n; ++i )
+                for ( unsigned long r = 0; r != Rows; ++r )
+                {
+                    T* __restrict__ o = out + i * out_i + r * out_r;
+                    std::fill_n( o, channels, T{0} );
+                    for ( unsigned long s = 0; s != Cols; ++s )
+                    {
+                        if ( m[r][s] == 0.0 )
+                            continue;
+                        T const coefficient = static_cast<T>( m[r][s] );
+                        T const* __restrict__ x = in + i * in_i + s * in_s;
+                        for ( unsigned long ch = 0; ch != channels; ++ch )
+                            o[ch] += coefficient * x[ch];
+                    }
+                }
+        }
+
+        // the number of m x m output tiles
+        template< unsigned long M >
+        unsigned long winograd_tiles( conv2d_geometry const& g ) noexcept
+        {
+            return g.batch * ( ( g.output_rows() + M - 1 ) / M ) * ( ( g.output_cols() + M - 1 ) / M );
+        }
+
+        // the size of the transformed input of `winograd_conv2d`
+        template< unsigned long M >
+        unsigned long winograd_workspace( conv2d_geometry const& g ) noexcept
+        {
+            unsigned long const alpha = winograd_transforms<M>::alpha;
+            return alpha * alpha * winograd_tiles<M>( g ) * g.channels;
+        }
+
+        //
+        // Convolution of a 3x3 kernel of unit strides and dilations by Winograd F(M x M, 3 x 3).
+        //
+        // The input tiles are transformed to v[alpha*alpha][tiles][channels], the kernels to u[alpha*alpha][channels][filters],
+        // and each of the alpha*alpha frequencies is a GEMM of [tiles x channels] by [channels x filters], all of them in a batched gemm.
+        // The output transform then writes the tiles of the product to output[batch][output_rows][output_cols][filters].
+        // The transformed input is left in `v`, of `winograd_workspace<M>( g )` elements, for the gradient of the kernels.
+        //
+        template< unsigned long M, typename T >
+        void winograd_conv2d( T const* input, T const* weight, conv2d_geometry const& g, T* output, T* v )
+        {
+            typedef winograd_transforms<M> transforms;
+            constexpr unsigned long alpha = transforms::alpha;
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const tile_rows = ( output_rows + M - 1 ) / M;
+            unsigned long const tile_cols = ( output_cols + M - 1 ) / M;
+            unsigned long const tiles = g.batch * tile_rows * tile_cols;
+            unsigned long const channels = g.channels;
+            unsigned long const filters = g.filters;
+
+            // u[xi][ch][nc] <= G g[nc][ch] Gt, with the filters as vectors
+            tensor<T> u{ {alpha * alpha, channels, filters} };
+            parallel( [&]( unsigned long ch )
+            {
+                std::vector<T> kernel( 9 * filters );
+                std::vector<T> half( alpha * 3 * filters );
+                for ( unsigned long nc = 0; nc != filters; ++nc )
+                    for ( unsigned long idx = 0; idx != 9; ++idx )
+                        kernel[idx*filters+nc] = weight[(nc*channels+ch)*9+idx];
+                winograd_transform( transforms::g, kernel.data(), filters, 3*filters, half.data(), filters, 3*filters, 3, filters );
+                winograd_transform( transforms::g, half.data(), 3*filters, filters, u.data() + ch*filters, alpha*channels*filters, channels*filters, alpha, filters );
+            }, 0UL, channels );
+
+            // v[xi][t][ch] <= Bt d[t] B, a row of tiles per task
+            parallel( [&]( unsigned long tile_row )
+            {
+                std::vector<T> d( alpha * alpha * channels );
+                std::vector<T> half( alpha * alpha * channels );
+                unsigned long const b = tile_row / tile_rows;
+                std::int64_t const row_first = static_cast<std::int64_t>( ( tile_row % tile_rows ) * M ) - static_cast<std::int64_t>( g.row_padding );
+                isa_dispatch( [&]()
+                {
+                    for ( unsigned long tile_col = 0; tile_col != tile_cols; ++tile_col )
+                    {
+                        std::int64_t const col_first = static_cast<std::int64_t>( tile_col * M ) - static_cast<std::int64_t>( g.col_padding );
+                        for ( unsigned long r = 0; r != alpha; ++r )
+                            for ( unsigned long c = 0; c != alpha; ++c )
+                            {
+                                std::int64_t const row = row_first + r;
+                                std::int64_t const col = col_first + c;
+                                T* dst = d.data() + ( r * alpha + c ) * channels;
+                                if ( row < 0 || row >= static_cast<std::int64_t>( g.rows ) || col < 0 || col >= static_cast<std::int64_t>( g.cols ) )
+                                    std::fill_n( dst, channels, T{0} );
+                                else
+                                    std::copy_n( input + ( ( b * g.rows + row ) * g.cols + col ) * channels, channels, dst );
+                            }
+                        unsigned long const t = tile_row * tile_cols + tile_col;
+                        winograd_transform( transforms::bt, d.data(), channels, alpha*channels, half.data(), channels, alpha*channels, alpha, channels );
+                        winograd_transform( transforms::bt, half.data(), alpha*channels, channels, v + t*channels, alpha*tiles*channels, tiles*channels, alpha, channels );
+                    }
+                } );
+            }, 0UL, g.batch * tile_rows, 1UL );
+
+            tensor<T> product{ {alpha * alpha, tiles, filters} };
+            batched_gemm( v, false, tiles * channels, u.data(), false, channels * filters, alpha * alpha, tiles, channels, filters, product.data() );
+
+            // output tile <= At m[t] A
+            parallel( [&]( unsigned long tile_row )
+            {
+                std::vector<T> half( M * alpha * filters );
+                std::vector<T> y( M * M * filters );
+                unsigned long const b = tile_row / tile_rows;
+                unsigned long const row_first = ( tile_row % tile_rows ) * M;
+                isa_dispatch( [&]()
+                {
+                    for ( unsigned long tile_col = 0; tile_col != tile_cols; ++tile_col )
+                    {
+                        unsigned long const t = tile_row * tile_cols + tile_col;
+                        winograd_transform( transforms::at, product.data() + t*filters, tiles*filters, alpha*tiles*filters, half.data(), filters, alpha*filters, alpha, filters );
+                        winograd_transform( transforms::at, half.data(), alpha*filters, filters, y.data(), M*filters, filters, M, filters );
+                        unsigned long const col_first = tile_col * M;
+                        for ( unsigned long r = 0; r != std::min( M, output_rows - row_first ); ++r )
+                            std::copy_n( y.data() + r * M * filters, std::min( M, output_cols - col_first ) * filters,
+                                         output + ( ( b * output_rows + row_first + r ) * output_cols + col_first ) * filters );
+                    }
+                } );
+            }, 0UL, g.batch * tile_rows, 1UL );
+        }
+
+        //
+        // The gradient of the input of `winograd_conv2d`: the convolution of the output gradient, padded by 2 - padding, with the kernels
+        // rotated by 180 degrees and their channels and filters swapped.
+        //
+        template< unsigned long M, typename T >
+        void winograd_conv2d_input_gradient( T const* grad, T const* weight, conv2d_geometry const& g, T* input_grad )
+        {
+            std::vector<T> rotated( g.filters * g.channels * 9 );
+            for ( unsigned long nc = 0; nc != g.filters; ++nc )
+                for ( unsigned long ch = 0; ch != g.channels; ++ch )
+                    for ( unsigned long idx = 0; idx != 9; ++idx )
+                        rotated[(ch*g.filters+nc)*9+8-idx] = weight[(nc*g.channels+ch)*9+idx];
+
+            conv2d_geometry transposed_geometry = g;
+            transposed_geometry.rows = g.output_rows();
+            transposed_geometry.cols = g.output_cols();
+            transposed_geometry.channels = g.filters;
+            transposed_geometry.filters = g.channels;
+            transposed_geometry.row_padding = 2 - g.row_padding;
+            transposed_geometry.col_padding = 2 - g.col_padding;
+            tensor<T> workspace{ {winograd_workspace<M>( transposed_geometry ),} };
+            winograd_conv2d<M>( grad, rotated.data(), transposed_geometry, input_grad, workspace.data() );
+        }
+
+        //
+        // The gradient of the kernels of `winograd_conv2d`, from its transformed input v: as an output tile is At [ u .* v ] A,
+        // the gradient of u is the sum over the tiles of (A grad Gt) .* v, and that of the kernel is Gt [ that sum ] G.
+        // The sums over the tiles are alpha*alpha GEMMs of [channels x tiles] by [tiles x filters].
+        //
+        template< unsigned long M, typename T >
+        void winograd_conv2d_weight_gradient( T const* v, T const* grad, conv2d_geometry const& g, T* weight_grad )
+        {
+            typedef winograd_transforms<M> transforms;
+            constexpr unsigned long alpha = transforms::alpha;
+            constexpr small_matrix<alpha, M> a = transposed( transforms::at );
+            constexpr small_matrix<3, alpha> gt = transposed( transforms::g );
+            unsigned long const output_rows = g.output_rows();
+            unsigned long const output_cols = g.output_cols();
+            unsigned long const tile_rows = ( output_rows + M - 1 ) / M;
+            unsigned long const tile_cols = ( output_cols + M - 1 ) / M;
+            unsigned long const tiles = g.batch * tile_rows * tile_cols;
+            unsigned long const channels = g.channels;
+            unsigned long const filters = g.filters;
+
+            // q[xi][t][nc] <= A grad[t] At
+            tensor<T> q{ {alpha * alpha, tiles, filters} };
+            parallel( [&]( unsigned long tile_row )
+            {
+                std::vector<T> dy( M * M * filters );
+                std::vector<T> half( alpha * M * filters );
+                unsigned long const b = tile_row / tile_rows;
+                unsigned long const row_first = ( tile_row % tile_rows ) * M;
+                isa_dispatch( [&]()
+                {
+                    for ( unsigned long tile_col = 0; tile_col != tile_cols; ++tile_col )
+                    {
+                        unsigned long const col_first = tile_col * M;
+                        std::fill( dy.begin(), dy.end(), T{0} );
+                        for ( unsigned long r = 0; r != std::min( M, output_rows - row_first ); ++r )
+                            std::copy_n( grad + ( ( b * output_rows + row_first + r ) * output_cols + col_first ) * filters,
+                                         std::min( M, output_cols - col_first ) * filters, dy.data() + r * M * filters );
+                        unsigned long const t = tile_row * tile_cols + tile_col;
+                        winograd_transform( a, dy.data(), filters, M*filters, half.data(), filters, M*filters, M, filters );
+                        winograd_transform( a, half.data(), M*filters, filters, q.data() + t*filters, alpha*tiles*filters, tiles*filters, alpha, filters );
+                    }
+                } );
+            }, 0UL, g.batch * tile_rows, 1UL );
+
+            tensor<T> sum{ {alpha * alpha, channels, filters} };
+            batched_gemm( v, true, tiles * channels, q.data(), false, tiles * filters, alpha * alpha, channels, tiles, filters, sum.data() );
+
+            // weight_grad[nc][ch] <= Gt sum[ch][nc] G
+            parallel( [&]( unsigned long ch )
+            {
+                std::vector<T> half( 3 * alpha * filters );
+                std::vector<T> kernel( 9 * filters );
+                winograd_transform( gt, sum.data() + ch*filters, channels*filters, alpha*channels*filters, half.data(), filters, alpha*filters, alpha, filters );
+                winograd_transform( gt, half.data(), alpha*filters, filters, kernel.data(), 3*filters, filters, 3, filters );
+                for ( unsigned long nc = 0; nc != filters; ++nc )
+                    for ( unsigned long idx = 0; idx != 9; ++idx )
+                        weight_grad[(nc*channels+ch)*9+idx] = kernel[idx*filters+nc];
+            }, 0UL, channels );
+        }
+    }//namespace ceras_private
+
+}//namespace ceras
+
+#endif//CONVOLUTION_HPP_INCLUDED_QXWMZKTRHBNVJLPGYEDCAUSOIFKZQMRXTWHBVNJLPGYEDCAUSOI
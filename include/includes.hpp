@@ -6,11 +6,14 @@
 #include <algorithm>
 #include <any>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <compare>
 #include <concepts>
+#include <condition_variable>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -18,6 +21,7 @@
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
@@ -31,6 +35,8 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <numeric>
 #include <optional>
 #include <ostream>
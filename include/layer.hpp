@@ -85,6 +85,7 @@ namespace ceras
     /// @param kernel_regularizer_l2 L2 regularizer for the kernel. Defaults to `0.0f`.
     /// @param bias_regularizer_l1 L1 regularizer for the bias vector. Defaults to `0.0f`.
     /// @param bias_regularizer_l2 L2 regularizer for the bias vector. Defaults to `0.0f`.
+    /// @param groups The number of groups the input channels and the output channels are split in, each group of output channels seeing the input channels of its group only. Defaults to `1`.
     ///
     /// Example code:
     ///
@@ -98,11 +99,13 @@ namespace ceras
     ///
     inline constexpr auto Conv2D( unsigned long output_channels, std::vector<unsigned long> const& kernel_size, std::string const& padding="valid",
                                   std::vector<unsigned long> const& strides={1,1}, std::vector<unsigned long> const& dilations={1, 1}, bool use_bias=true,
-                                  float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f
+                                  float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f,
+                                  unsigned long groups=1
            ) noexcept
     {
 
         better_assert( output_channels > 0, "Expecting output_channels larger than 0." );
+        better_assert( groups > 0 && output_channels % groups == 0, "Expecting output_channels to be a multiple of groups." );
         better_assert( kernel_size.size() > 0, "Expecting kernel_size at least has 1 elements." );
         better_assert( strides.size() > 0, "Expecting strides at least has 1 elements." );
         return [=]<Expression Ex>( Ex const& ex ) noexcept
@@ -111,13 +114,62 @@ namespace ceras
             unsigned long const kernel_size_y = kernel_size.size() == 2 ? kernel_size[1] : kernel_size[0];
             //unsigned long const input_channels = input_shape[2];
             unsigned long const input_channels = *(ex.shape().rbegin());
+            better_assert( input_channels % groups == 0, "Expecting the input channels to be a multiple of groups." );
             unsigned long const stride_x = strides[0];
             unsigned long const stride_y = strides.size() == 2 ? strides[1] : strides[0];
             unsigned long const dilation_row = dilations[0];
             unsigned long const dilation_col = dilations.size() == 2 ? dilations[1] : dilations[0];
-            auto w = variable<tensor<float>>{ glorot_uniform<float>({output_channels, kernel_size_x, kernel_size_y, input_channels}), kernel_regularizer_l1, kernel_regularizer_l2 };
+            auto w = variable<tensor<float>>{ glorot_uniform<float>({output_channels, kernel_size_x, kernel_size_y, input_channels/groups}), kernel_regularizer_l1, kernel_regularizer_l2 };
+            auto b = variable<tensor<float>>{ zeros<float>({1, 1, output_channels}), bias_regularizer_l1, bias_regularizer_l2, use_bias };
+            return general_conv2d( stride_x, stride_y, dilation_row, dilation_col, padding, groups )( ex, w ) + b;
+        };
+    }
+
+    ///
+    /// @brief Depthwise 2D convolution layer, convolving each input channel with its own `depth_multiplier` kernels.
+    /// @param kernel_size The height and width of the convolutional window.
+    /// @param padding `valid` or `same`. `valid` suggests no padding. `same` suggests zero padding. Defaults to `valid`.
+    /// @param strides The strides along the height and width direction. Defaults to `(1, 1)`.
+    /// @param dilations The dialation along the height and width direction. Defaults to `(1, 1)`.
+    /// @param depth_multiplier The number of output channels of each input channel. Defaults to `1`.
+    /// @param use_bias Wether or not use a bias vector. Defaults to `true`.
+    /// @param kernel_regularizer_l1 L1 regularizer for the kernel. Defaults to `0.0f`.
+    /// @param kernel_regularizer_l2 L2 regularizer for the kernel. Defaults to `0.0f`.
+    /// @param bias_regularizer_l1 L1 regularizer for the bias vector. Defaults to `0.0f`.
+    /// @param bias_regularizer_l2 L2 regularizer for the bias vector. Defaults to `0.0f`.
+    ///
+    /// The output channel `ch*depth_multiplier+m` is the convolution of the input channel `ch` with the m-th of its kernels.
+    ///
+    /// Example code, a depthwise separable convolution:
+    ///
+    /// \code{.cpp}
+    /// auto x = Input{ {28, 28, 32} };
+    /// auto y = DepthwiseConv2D( {3, 3}, "same" )( x );
+    /// auto z = Conv2D( 64, {1, 1} )( y );
+    /// \endcode
+    ///
+    inline constexpr auto DepthwiseConv2D( std::vector<unsigned long> const& kernel_size, std::string const& padding="valid",
+                                           std::vector<unsigned long> const& strides={1,1}, std::vector<unsigned long> const& dilations={1, 1},
+                                           unsigned long depth_multiplier=1, bool use_bias=true,
+                                           float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f
+           ) noexcept
+    {
+        better_assert( depth_multiplier > 0, "Expecting depth_multiplier larger than 0." );
+        better_assert( kernel_size.size() > 0, "Expecting kernel_size at least has 1 elements." );
+        better_assert( strides.size() > 0, "Expecting strides at least has 1 elements." );
+        return [=]<Expression Ex>( Ex const& ex ) noexcept
+        {
+            unsigned long const kernel_size_x = kernel_size[0];
+            unsigned long const kernel_size_y = kernel_size.size() == 2 ? kernel_size[1] : kernel_size[0];
+            unsigned long const input_channels = *(ex.shape().rbegin());
+            unsigned long const output_channels = input_channels * depth_multiplier;
+            unsigned long const stride_x = strides[0];
+            unsigned long const stride_y = strides.size() == 2 ? strides[1] : strides[0];
+            unsigned long const dilation_row = dilations[0];
+            unsigned long const dilation_col = dilations.size() == 2 ? dilations[1] : dilations[0];
+            auto w = variable<tensor<float>>{ glorot_uniform<float>({output_channels, kernel_size_x, kernel_size_y, 1}), kernel_regularizer_l1, kernel_regularizer_l2 };
             auto b = variable<tensor<float>>{ zeros<float>({1, 1, output_channels}), bias_regularizer_l1, bias_regularizer_l2, use_bias };
-            return general_conv2d( stride_x, stride_y, dilation_row, dilation_col, padding )( ex, w ) + b;
+            return general_conv2d( stride_x, stride_y, dilation_row, dilation_col, padding, input_channels )( ex, w ) + b;
         };
     }
 
@@ -215,9 +267,10 @@ namespace ceras
     }
 #endif
     ///
-    /// @brief Densly-connected layer.
+    /// @brief Densly-connected layer, with an activation fused into the same operator.
     ///
     /// @param output_size Dimensionality of output shape. The output shape is `(batch_size, output_size)`.
+    /// @param activation One of `linear`, `relu`, `sigmoid` and `tanh`, applied while the output is computed. See `dense`.
     /// @param use_bias Using a bias vector or not. Defaults to `true`.
     /// @param kernel_regularizer_l1 L1 regularizer for the kernel. Defaults to `0.0f`.
     /// @param kernel_regularizer_l2 L2 regularizer for the kernel. Defaults to `0.0f`.
@@ -228,22 +281,47 @@ namespace ceras
     ///
     /// \code{.cpp}
     /// auto x = Input{ {28*28,} };
-    /// auto y = Dense( 10, )( x );
-    /// auto m = model{ x, y };
+    /// auto y = Dense( 128, "relu" )( x ); // same as relu( Dense( 128 )( x ) ), in a single pass over the output
+    /// auto z = Dense( 10 )( y );
+    /// auto m = model{ x, z };
     /// \endcode
     ///
-    inline auto Dense( unsigned long output_size, bool use_bias=true, float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f )
+    inline auto Dense( unsigned long output_size, char const* activation, bool use_bias=true, float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f )
     {
+        std::string const activation_name{ activation };
         return [=]<Expression Ex>( Ex const& ex )
         {
             better_assert( ex.shape().size() >= 1, fmt::format("Error: expecting shape 2D, but got {}D of {}.", ex.shape().size(), ex.shape()) );
             unsigned long const input_size = *(ex.shape().rbegin());
             auto w = variable<tensor<float>>{ glorot_uniform<float>({input_size, output_size}), kernel_regularizer_l1, kernel_regularizer_l2 };
             auto b = variable<tensor<float>>{ zeros<float>({1, output_size}), bias_regularizer_l1, bias_regularizer_l2, use_bias }; // if use_baias, then b is trainable; otherwise, non-trainable.
-            return ex * w + b;
+            return dense( ex, w, b, activation_name );
         };
     }
 
+    ///
+    /// @brief Densly-connected layer.
+    ///
+    /// @param output_size Dimensionality of output shape. The output shape is `(batch_size, output_size)`.
+    /// @param use_bias Using a bias vector or not. Defaults to `true`.
+    /// @param kernel_regularizer_l1 L1 regularizer for the kernel. Defaults to `0.0f`.
+    /// @param kernel_regularizer_l2 L2 regularizer for the kernel. Defaults to `0.0f`.
+    /// @param bias_regularizer_l1 L1 regularizer for the bias vector. Defaults to `0.0f`.
+    /// @param bias_regularizer_l2 L2 regularizer for the bias vector. Defaults to `0.0f`.
+    ///
+    /// Example code:
+    ///
+    /// \code{.cpp}
+    /// auto x = Input{ {28*28,} };
+    /// auto y = Dense( 10, )( x );
+    /// auto m = model{ x, y };
+    /// \endcode
+    ///
+    inline auto Dense( unsigned long output_size, bool use_bias=true, float kernel_regularizer_l1=0.0f, float kernel_regularizer_l2=0.0f, float bias_regularizer_l1=0.0f, float bias_regularizer_l2=0.0f )
+    {
+        return Dense( output_size, "linear", use_bias, kernel_regularizer_l1, kernel_regularizer_l2, bias_regularizer_l1, bias_regularizer_l2 );
+    }
+
     ///
     /// @brief Applies a transformation that maintains the mean output close to 0 and the output standard deviation close to 1.
     /// @param shape Dimensionality of the input shape.
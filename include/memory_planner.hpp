@@ -0,0 +1,159 @@
+#ifndef QMTZHWRCXOKAUBELVNDYSPGIFJQEWTHRZMVKCBOAUDLNXYSPEGTFWIHZQRJMKCVBNALXEOSUYD
+#define QMTZHWRCXOKAUBELVNDYSPGIFJQEWTHRZMVKCBOAUDLNXYSPEGTFWIHZQRJMKCVBNALXEOSUYD
+
+#include "./includes.hpp"
+#include "./config.hpp"
+#include "./tensor.hpp"
+
+namespace ceras
+{
+
+    ///
+    /// @brief Summary of a memory plan, as returned by `session::plan_memory`.
+    ///
+    struct memory_plan
+    {
+        unsigned long buffers = 0; ///< Number of the buffers placed in the arena.
+        unsigned long unplanned_bytes = 0; ///< Bytes taken by these buffers when each of them owns its storage.
+        unsigned long peak_bytes = 0; ///< The largest number of bytes of these buffers alive at the same time, a lower bound of the arena.
+        unsigned long arena_bytes = 0; ///< Size of the arena holding all of the buffers.
+    };
+
+    inline std::ostream& operator << ( std::ostream& os, memory_plan const& plan )
+    {
+        return os << "memory plan: " << plan.buffers << " buffers, " << plan.unplanned_bytes << " bytes unplanned, " << plan.peak_bytes << " bytes at peak, arena of " << plan.arena_bytes << " bytes";
+    }
+
+    namespace ceras_private
+    {
+
+        // a buffer in use from the `first` to the `last` step of a traced pass, both included
+        struct memory_interval
+        {
+            unsigned long bytes;
+            unsigned long first;
+            unsigned long last;
+        };
+
+        inline unsigned long aligned_bytes( unsigned long bytes, unsigned long alignment = memory_alignment ) noexcept
+        {
+            return ( bytes + alignment - 1 ) / alignment * alignment;
+        }
+
+        // Places the buffers in a single arena, the largest first, each at the lowest offset not taken by a placed buffer alive at the same time.
+        // Returns the offsets of the buffers, aligned, and the size of the arena.
+        inline std::tuple<std::vector<unsigned long>, unsigned long> interval_coloring( std::vector<memory_interval> const& intervals, unsigned long alignment = memory_alignment )
+        {
+            std::vector<unsigned long> order( intervals.size() );
+            std::iota( order.begin(), order.end(), 0UL );
+            std::stable_sort( order.begin(), order.end(), [&intervals]( unsigned long a, unsigned long b ) { return intervals[a].bytes > intervals[b].bytes; } );
+
+            std::vector<unsigned long> offsets( intervals.size(), 0UL );
+            std::vector<unsigned long> placed;
+            std::vector<std::tuple<unsigned long, unsigned long>> taken;
+            unsigned long arena = 0;
+            for ( auto idx : order )
+            {
+                memory_interval const& current = intervals[idx];
+                unsigned long const bytes = aligned_bytes( current.bytes, alignment );
+
+                taken.clear();
+                for ( auto other : placed )
+                    if ( intervals[other].first <= current.last && current.first <= intervals[other].last )
+                        taken.emplace_back( offsets[other], offsets[other] + aligned_bytes( intervals[other].bytes, alignment ) );
+                std::sort( taken.begin(), taken.end() );
+
+                unsigned long offset = 0;
+                for ( auto [begin, end] : taken )
+                {
+                    if ( offset + bytes <= begin )
+                        break;
+                    offset = std::max( offset, end );
+                }
+
+                offsets[idx] = offset;
+                arena = std::max( arena, offset + bytes );
+                placed.push_back( idx );
+            }
+            return std::make_tuple( offsets, arena );
+        }
+
+        // the largest number of bytes alive at the same step
+        inline unsigned long live_bytes_peak( std::vector<memory_interval> const& intervals, unsigned long alignment = memory_alignment )
+        {
+            std::vector<std::tuple<unsigned long, long>> changes; // (step, bytes), the releases after the last step of a buffer
+            for ( auto const& interval : intervals )
+            {
+                long const bytes = static_cast<long>( aligned_bytes( interval.bytes, alignment ) );
+                changes.emplace_back( interval.first, bytes );
+                changes.emplace_back( interval.last + 1, -bytes );
+            }
+            std::sort( changes.begin(), changes.end() ); // releases before acquisitions at the same step
+
+            long live = 0;
+            long peak = 0;
+            for ( auto [step, bytes] : changes )
+            {
+                live += bytes;
+                peak = std::max( peak, live );
+            }
+            return static_cast<unsigned long>( peak );
+        }
+
+        //
+        // Records the tensors read and written by the operators, step by step, in a pass of a session.
+        // A storage first seen being read comes from outside of the traced operators, such as a variable or a place holder, and is never planned.
+        //
+        template< Tensor Tsor >
+        struct memory_tracer
+        {
+            typedef typename Tsor::shared_vector shared_vector;
+
+            struct buffer
+            {
+                shared_vector storage_;
+                unsigned long first_;
+                unsigned long last_;
+                bool external_;
+            };
+
+            std::unordered_map<void const*, unsigned long> indices_; // storage to buffer
+            std::vector<buffer> buffers_;
+            unsigned long step_ = 0;
+
+            // a new step, reading the tensors `reads`, then writing the tensors `writes`
+            void trace( std::initializer_list<Tsor> reads, std::initializer_list<Tsor> writes = {} )
+            {
+                ++step_;
+                for ( auto const& tsor : reads )
+                    touch( tsor, true );
+                for ( auto const& tsor : writes )
+                    touch( tsor, false );
+            }
+
+            // the storage of `tsor` is used after the pass, thus not planned
+            void exclude( Tsor const& tsor )
+            {
+                if ( !tsor.vector_ )
+                    return;
+                if ( auto itor = indices_.find( tsor.vector_.get() ); itor != indices_.end() )
+                    buffers_[(*itor).second].external_ = true;
+            }
+
+            void touch( Tsor const& tsor, bool reading )
+            {
+                if ( tsor.empty() )
+                    return;
+                auto [itor, inserted] = indices_.try_emplace( tsor.vector_.get(), buffers_.size() );
+                if ( inserted )
+                    buffers_.push_back( buffer{ tsor.vector_, step_, step_, reading } );
+                else
+                    buffers_[(*itor).second].last_ = step_;
+            }
+        }; // struct memory_tracer
+
+    }//namespace ceras_private
+
+}//namespace ceras
+
+#endif//QMTZHWRCXOKAUBELVNDYSPGIFJQEWTHRZMVKCBOAUDLNXYSPEGTFWIHZQRJMKCVBNALXEOSUYD
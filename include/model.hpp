@@ -4,6 +4,7 @@
 #include "./includes.hpp"
 #include "./operation.hpp"
 #include "./place_holder.hpp"
+#include "./quantization.hpp"
 #include "./tensor.hpp"
 #include "./utils/better_assert.hpp"
 #include "./utils/context_cast.hpp"
@@ -300,6 +301,7 @@ namespace ceras
 
         output_layer_type expression_;   ///< output layer of the model.
         input_layer_type place_holder_;//< input layer of the model.
+        bool quantized_ = false; ///< predicting with int8 products, see `quantize`.
 
 
         ///
@@ -346,6 +348,7 @@ namespace ceras
         auto predict( Tsor const& input_tensor )
         {
             learning_phase = 0; // for different behaviours in normalization and drop-out layers
+            quantization_phase = quantized_ ? quantization_mode::int8 : quantization_mode::none;
 
             //session<Tsor> s;
             auto& s = get_default_session<Tsor>();//.get();
@@ -354,10 +357,63 @@ namespace ceras
             auto ans = s.run( expression_ );
 
             learning_phase = 1; // restore learning phase
+            quantization_phase = quantization_mode::none;
 
             return ans;
         }
 
+        ///
+        /// @brief Post-training quantization for inference on CPU.
+        ///
+        /// Runs the model on the calibration samples to record the range of the inputs of its Dense and Conv2D layers, and returns a copy
+        /// predicting with int8 products: the weights are quantized with one scale per output channel, the activations with the calibrated scales,
+        /// and the int32 results are requantized to float before the bias and the activation. The other operations stay in float.
+        /// The returned model shares its variables with this one, and this model keeps predicting in float.
+        ///
+        /// @param calibration_inputs Representative input samples, a tensor of shape (samples, input_shape). A few hundred are usually enough.
+        /// @param batch_size Number of samples per forward pass of the calibration.
+        /// @return A model whose `predict` runs in int8.
+        ///
+        /// Example code:
+        /// @code
+        /// auto m = model{ input, output };
+        /// // ... train the model
+        /// auto qm = m.quantize( x_calibration ); // a few hundred training samples
+        /// auto result = qm.predict( x_test ); // in place of m.predict( x_test )
+        /// @endcode
+        ///
+        template< Tensor Tsor >
+        model quantize( Tsor const& calibration_inputs, unsigned long batch_size=32 ) const
+        {
+            unsigned long const samples = *(calibration_inputs.shape().begin());
+            batch_size = std::max( 1UL, std::min( batch_size, samples ) );
+            unsigned long const loops = samples / batch_size;
+
+            std::vector<unsigned long> batch_input_shape = calibration_inputs.shape();
+            batch_input_shape[0] = batch_size;
+            Tsor input_samples{ batch_input_shape };
+            unsigned long const input_size_per_batch = input_samples.size();
+
+            input_layer_type place_holder = place_holder_;
+            output_layer_type expression = expression_;
+            auto& s = get_default_session<Tsor>();
+            s.bind( place_holder, input_samples );
+
+            learning_phase = 0;
+            quantization_phase = quantization_mode::calibration;
+            for ( auto l : range( loops ) )
+            {
+                std::copy_n( calibration_inputs.data() + l * input_size_per_batch, input_size_per_batch, input_samples.data() );
+                s.run( expression );
+            }
+            quantization_phase = quantization_mode::none;
+            learning_phase = 1;
+
+            model ans = *this;
+            ans.quantized_ = true;
+            return ans;
+        }
+
         ///
         /// Generating a new expression by using the current model.
         /// @param ex An expression that represents the input to the model.
@@ -11,6 +11,8 @@
 #include "./utils/debug.hpp"
 #include "./config.hpp"
 #include "./utils/context_cast.hpp"
+#include "./quantization.hpp"
+#include "./convolution.hpp"
 #include "./utils/for_each.hpp"
 #include "./utils/id.hpp"
 #include "./utils/enable_shared.hpp"
@@ -45,6 +47,55 @@ namespace ceras
 
 
 
+    namespace ceras_private
+    {
+        // the forward action of the operators made by `checkpoint`, defined below
+        struct checkpoint_forward;
+
+        // The backward action of an operator whose forward action returns a storage of its own, and whose backward action does not read this output.
+        // The output may then be overwritten by the operator reading it, when no other operator reads it.
+        template< typename Backward_Action >
+        struct overwritable_output : Backward_Action
+        {
+            using Backward_Action::operator();
+        };
+
+        template< typename Backward_Action >
+        overwritable_output( Backward_Action ) -> overwritable_output<Backward_Action>;
+
+        // the output of an input of an operator, already computed if a copy of the operator has been run, as the copies share their inputs
+        template< typename Input >
+        auto forward_input( Input& input, bool has_run )
+        {
+            if constexpr( requires { input.output_data_; } )
+                if ( has_run )
+                    return input.output_data_;
+            return input.forward();
+        }
+
+        // frees the storage of `tsor`, dropped by a checkpoint, unless it is shared with one of the tensors still in use
+        // returns false if the storage is kept
+        template< Tensor Tsor >
+        bool release_dropped( Tsor& tsor, std::initializer_list<Tsor const*> in_use )
+        {
+            for ( auto other : in_use )
+                if ( (*other).vector_ == tsor.vector_ )
+                    return false;
+            (*(tsor.vector_)).clear();
+            return true;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// If T is an operator whose backward action is a `ceras_private::overwritable_output`, the constant value equals to `true`. `false` otherwise.
+    /// Specialized for the unary and the binary operators below.
+    ///
+    template< typename T >
+    struct is_overwritable : std::false_type{};
+
+    template< class T >
+    inline constexpr bool is_overwritable_v = is_overwritable<T>::value;
+
     ///
     /// @brief A unary operator is composed of a.) an input expression, b.) a forward action and c.) a backward action.
     ///                                  plus  d.) an output shape calculator and e.) a serializer
@@ -69,6 +120,8 @@ namespace ceras
 
         tensor_type input_data_;
         tensor_type output_data_;
+        bool dropped_ = false; // set by a checkpoint: the output is recomputed in the backward pass, and released once used
+        bool stale_ = false; // the output has been released, or shares a storage overwritten since, and is to be recomputed
 
         unary_operator( Operator const& op, Forward_Action const& forward_action, Backward_Action const& backward_action, Output_Shape_Calculator const& output_shape_calculator, Serializer const& serializer ) noexcept : state_{ std::make_shared<unary_operator_state>( op, forward_action, backward_action, output_shape_calculator, serializer ) } {}
 
@@ -80,8 +133,50 @@ namespace ceras
             if ( output_data_.empty() )
             {
                 input_data_ = op().forward();
-                output_data_ = forward_action()( input_data_ );
+                if constexpr( is_overwritable_v<Operator> && requires( Forward_Action const& action, tensor_type& tsor ) { action.in_place( tsor ); } )
+                {
+                    if ( in_place_execution && sess.consumers( op().id() ) == 1 ) // no other operator reading the input
+                        output_data_ = forward_action().in_place( input_data_ );
+                    else
+                        output_data_ = forward_action()( input_data_ );
+                }
+                else
+                {
+                    output_data_ = forward_action()( input_data_ );
+                }
                 sess.update_forward_cache( (*this).id(), output_data_ );
+
+                if ( auto tracer = sess.tracer(); tracer )
+                    (*tracer).trace( { input_data_ }, { output_data_ } );
+
+                if constexpr( std::is_same_v<Forward_Action, ceras_private::checkpoint_forward> )
+                    forward_action().drop( op(), output_data_ );
+            }
+            else // run by a copy
+            {
+                input_data_ = ceras_private::forward_input( op(), true );
+            }
+
+            return output_data_;
+        }
+
+        ///
+        /// @brief The output in the backward pass, recomputed from the closest outputs kept if it has been dropped by a checkpoint.
+        ///
+        tensor_type rematerialize()
+        {
+            // tested first, as the input recomputed may revive the storage of an output computed in place; a copy may have released the output
+            bool const recompute = stale_ || output_data_.empty();
+
+            // the input read in the forward pass may be a storage recomputed since for another operator
+            if constexpr( requires( Operator& o ) { o.rematerialize(); } )
+                if ( recompute || op().stale_ || input_data_.empty() )
+                    input_data_ = op().rematerialize();
+
+            if ( recompute ) // out of place
+            {
+                output_data_ = forward_action()( input_data_ );
+                stale_ = false;
             }
 
             return output_data_;
@@ -89,7 +184,15 @@ namespace ceras
 
         void backward( tensor_type const& grad )
         {
+            rematerialize();
             auto const& current_gradient = backward_action()( input_data_, output_data_, grad );
+
+            if ( auto tracer = get_default_session<tensor_type>().tracer(); tracer )
+                (*tracer).trace( { input_data_, output_data_, grad }, { current_gradient } );
+
+            if ( dropped_ )
+                stale_ = ceras_private::release_dropped( output_data_, { &input_data_, &grad, &current_gradient } );
+
             op().backward( current_gradient );
         }
 
@@ -161,6 +264,8 @@ namespace ceras
         tensor_type lhs_input_data_;
         tensor_type rhs_input_data_;
         tensor_type output_data_;
+        bool dropped_ = false; // set by a checkpoint: the output is recomputed in the backward pass, and released once used
+        bool stale_ = false; // the output has been released, or shares a storage overwritten since, and is to be recomputed
 
         binary_operator( Lhs_Operator const& lhs_op, Rhs_Operator const& rhs_op, Forward_Action const& forward_action, Backward_Action const& backward_action, Output_Shape_Calculator const& output_shape_calculator, Serializer const& serializer) noexcept :
             state_{ std::make_shared<binary_operator_state>(lhs_op, rhs_op, forward_action, backward_action, output_shape_calculator, serializer) } {}
@@ -169,30 +274,59 @@ namespace ceras
         {
             auto& sess = get_default_session<tensor_type>();
             output_data_= sess.query_forward_cache( (*this).id() );
-
-            if ( !output_data_.empty() )
-                return output_data_;
+            bool const has_run = !output_data_.empty(); // by a copy
 
             static_assert( !(is_value_v<Lhs_Operator> && is_value_v<Rhs_Operator>), "Not valid for two values" );
 
             if constexpr ( is_value_v<Lhs_Operator> )
             {
-                rhs_input_data_ = rhs_op().forward();
+                rhs_input_data_ = ceras_private::forward_input( rhs_op(), has_run );
                 lhs_input_data_ = lhs_op().forward( rhs_input_data_ );
             }
             else if constexpr ( is_value_v<Rhs_Operator> )
             {
-                lhs_input_data_ = lhs_op().forward();
+                lhs_input_data_ = ceras_private::forward_input( lhs_op(), has_run );
                 rhs_input_data_ = rhs_op().forward( lhs_input_data_ );
             }
             else
             {
-                lhs_input_data_ = lhs_op().forward();
-                rhs_input_data_ = rhs_op().forward();
+                lhs_input_data_ = ceras_private::forward_input( lhs_op(), has_run );
+                rhs_input_data_ = ceras_private::forward_input( rhs_op(), has_run );
             }
 
+            if ( has_run )
+                return output_data_;
+
             output_data_ = forward_action()( lhs_input_data_, rhs_input_data_ );
             sess.update_forward_cache( (*this).id(), output_data_ );
+
+            if ( auto tracer = sess.tracer(); tracer )
+                (*tracer).trace( { lhs_input_data_, rhs_input_data_ }, { output_data_ } );
+
+            return output_data_;
+        }
+
+        ///
+        /// @brief The output in the backward pass, recomputed from the closest outputs kept if it has been dropped by a checkpoint.
+        ///
+        tensor_type rematerialize()
+        {
+            bool const recompute = stale_ || output_data_.empty(); // a copy may have released the output
+
+            if constexpr( requires( Lhs_Operator& o ) { o.rematerialize(); } )
+                if ( recompute || lhs_op().stale_ || lhs_input_data_.empty() )
+                    lhs_input_data_ = lhs_op().rematerialize();
+
+            if constexpr( requires( Rhs_Operator& o ) { o.rematerialize(); } )
+                if ( recompute || rhs_op().stale_ || rhs_input_data_.empty() )
+                    rhs_input_data_ = rhs_op().rematerialize();
+
+            if ( recompute )
+            {
+                output_data_ = forward_action()( lhs_input_data_, rhs_input_data_ );
+                stale_ = false;
+            }
+
             return output_data_;
         }
 
@@ -201,8 +335,21 @@ namespace ceras
         ///
         void backward( tensor_type const& grad )
         {
+            rematerialize();
             auto const& [current_gradient_lhs, current_gradient_rhs] = backward_action()( lhs_input_data_, rhs_input_data_, output_data_, grad );
+
+            auto tracer = get_default_session<tensor_type>().tracer();
+            if ( tracer )
+                (*tracer).trace( { lhs_input_data_, rhs_input_data_, output_data_, grad }, { current_gradient_lhs, current_gradient_rhs } );
+
+            if ( dropped_ )
+                stale_ = ceras_private::release_dropped( output_data_, { &lhs_input_data_, &rhs_input_data_, &grad, &current_gradient_lhs, &current_gradient_rhs } );
+
             lhs_op().backward( current_gradient_lhs );
+
+            if ( tracer ) // the gradient of the right hand side is still in use after the whole left hand side
+                (*tracer).trace( { current_gradient_rhs } );
+
             rhs_op().backward( current_gradient_rhs );
         }
 
@@ -309,6 +456,24 @@ namespace ceras
     template< typename T >
     concept Expression = Operator<T> || Variable<T> || Place_Holder<T> || Constant<T> || Value<T>;
 
+    template< typename T >
+    struct is_checkpoint : std::false_type{};
+
+    template< typename Operator, typename Backward_Action, typename Output_Shape_Calculator, typename Serializer >
+    struct is_checkpoint< unary_operator<Operator, ceras_private::checkpoint_forward, Backward_Action, Output_Shape_Calculator, Serializer> > : std::true_type {};
+
+    template< typename Operator, typename Forward_Action, typename Backward_Action, typename Output_Shape_Calculator, typename Serializer >
+    struct is_overwritable< unary_operator<Operator, Forward_Action, ceras_private::overwritable_output<Backward_Action>, Output_Shape_Calculator, Serializer> > : std::true_type {};
+
+    template< typename Lhs_Operator, typename Rhs_Operator, typename Forward_Action, typename Backward_Action, typename Output_Shape_Calculator, typename Serializer >
+    struct is_overwritable< binary_operator<Lhs_Operator, Rhs_Operator, Forward_Action, ceras_private::overwritable_output<Backward_Action>, Output_Shape_Calculator, Serializer> > : std::true_type {};
+
+    ///
+    /// If T is an operator made by `checkpoint`, the constant value equals to `true`. `false` otherwise.
+    ///
+    template< class T >
+    inline constexpr bool is_checkpoint_v = is_checkpoint<T>::value;
+
     template< Expression Ex >
     std::tuple<std::string, std::vector<std::string>> const serialize( Ex const& ex )
     {
@@ -453,6 +618,156 @@ namespace ceras
     }
 
 
+    namespace ceras_private
+    {
+        struct checkpoint_forward
+        {
+            unsigned long segments_;
+
+            template< Tensor Tsor >
+            Tsor operator()( Tsor const& input ) const noexcept
+            {
+                return input;
+            }
+
+            // Frees the outputs of the operators in `ex`, down to the variables, the place holders, the constants and the other checkpoints.
+            // The outputs of about `segments_ - 1` operators evenly spaced in the order of the forward pass are kept, so that the backward pass recomputes the others segment by segment.
+            template< typename Ex, Tensor Tsor >
+            void drop( Ex& ex, Tsor const& output ) const
+            {
+                if ( learning_phase == 0 ) // no backward pass
+                    return;
+
+                std::unordered_set<void const*> kept{ output.vector_.get() };
+                std::vector<std::tuple<bool*, bool*, Tsor>> outputs; // the operators inside, in the order of the forward pass
+                std::unordered_set<int> visited; // the copies of an operator share its inputs, which are collected once
+
+                auto const& collect = [&kept, &outputs, &visited]<typename Expr>( Expr& expr, auto const& _collect ) -> void
+                {
+                    auto const& collect_input = [&kept, &_collect]<typename Input>( Input& input, Tsor const& input_data )
+                    {
+                        if constexpr( ( is_unary_operator_v<Input> || is_binary_operator_v<Input> ) && !is_checkpoint_v<Input> )
+                            _collect( input, _collect );
+                        else
+                            kept.insert( input_data.vector_.get() );
+                    };
+
+                    if ( visited.insert( expr.id() ).second )
+                    {
+                        if constexpr( is_unary_operator_v<Expr> )
+                        {
+                            collect_input( expr.op(), expr.input_data_ );
+                        }
+                        else
+                        {
+                            collect_input( expr.lhs_op(), expr.lhs_input_data_ );
+                            collect_input( expr.rhs_op(), expr.rhs_input_data_ );
+                        }
+                    }
+                    outputs.emplace_back( &(expr.dropped_), &(expr.stale_), expr.output_data_ );
+                };
+
+                if constexpr( ( is_unary_operator_v<Ex> || is_binary_operator_v<Ex> ) && !is_checkpoint_v<Ex> )
+                    collect( ex, collect );
+
+                std::vector<void const*> storages;
+                {
+                    std::unordered_set<void const*> seen;
+                    for ( auto const& [dropped, stale, tsor] : outputs )
+                        if ( !kept.contains( tsor.vector_.get() ) && seen.insert( tsor.vector_.get() ).second )
+                            storages.push_back( tsor.vector_.get() );
+                }
+                if ( storages.empty() )
+                    return;
+
+                unsigned long const segments = segments_ ? segments_ : static_cast<unsigned long>( std::ceil( std::sqrt( static_cast<double>( storages.size() ) ) ) );
+                unsigned long const length = ( storages.size() + segments - 1 ) / segments;
+                for ( auto idx : range( storages.size() ) )
+                    if ( ( idx + 1 ) % length == 0 && ( idx + 1 ) / length < segments )
+                        kept.insert( storages[idx] );
+
+                auto tracer = get_default_session<Tsor>().tracer();
+                for ( auto& [dropped, stale, tsor] : outputs )
+                {
+                    *dropped = !kept.contains( tsor.vector_.get() );
+                    *stale = *dropped;
+                    if ( !(*dropped) )
+                        continue;
+                    if ( tracer ) // recomputed in a storage of its own
+                        (*tracer).exclude( tsor );
+                    (*(tsor.vector_)).clear();
+                }
+            }
+        }; // struct checkpoint_forward
+
+        //
+        // The forward action of an operator computing each element, or each row, of its output from the same element, or the same row, of its input.
+        // `kernel_( input, output )` writes into `output`, which is either a cached tensor of the shape of `input`, or `input` itself when the operator
+        // reading `input` is the only one, and the backward action reads only the output.
+        //
+        template< typename Kernel >
+        struct elementwise_forward
+        {
+            std::shared_ptr<std::any> forward_cache_;
+            Kernel kernel_;
+
+            template< Tensor Tsor >
+            Tsor operator()( Tsor const& input ) const noexcept
+            {
+                Tsor& ans = context_cast<Tsor>( forward_cache_ );
+                ans.resize( input.shape() );
+                kernel_( input, ans );
+                return ans;
+            }
+
+            template< Tensor Tsor >
+            Tsor in_place( Tsor& input ) const noexcept
+            {
+                kernel_( input, input );
+                return input;
+            }
+        }; // struct elementwise_forward
+
+        template< typename Kernel >
+        elementwise_forward( std::shared_ptr<std::any>, Kernel ) -> elementwise_forward<Kernel>;
+
+    }//namespace ceras_private
+
+    ///
+    /// @brief Checkpoint an expression. The outputs of the operators inside are freed at the end of the forward pass, and recomputed segment by segment in the backward pass.
+    ///
+    /// The operators inside are the ones between the expression and the variables, the place holders, the constants and the other checkpoints.
+    /// The outputs of about `segments - 1` of them are kept as the boundaries of the segments. A backward pass recomputes a segment from its lower boundary
+    /// when it reaches the segment, and frees each of the recomputed outputs once used, thus holding the outputs of a single segment at a time.
+    /// The operators inside should not be read from outside of the checkpoint, and are better free of side effects, as a dropout or a batch normalization
+    /// in the learning phase would be applied once more when recomputed.
+    ///
+    /// @param ex An expression.
+    /// @param segments The number of segments, `0` by default to recompute the operators inside, `N` of them, in about `sqrt(N)` segments of about `sqrt(N)` operators.
+    ///                 With `1`, all of them are recomputed at once from the inputs of the checkpoint, holding them all again.
+    /// @return An instance of a unary_operator that passes the output of `ex` unchanged, and back-propagates the gradient unchanged.
+    ///
+    /// Example code:
+    /// \code{.cpp}
+    /// auto x = place_holder<tensor<float>>{};
+    /// auto y = Dense( 512, "relu" )( x );
+    /// // ... many more layers ...
+    /// auto z = checkpoint( Dense( 10 )( y ) );
+    /// \endcode
+    ///
+    template< Expression Ex >
+    auto checkpoint( Ex const& ex, unsigned long segments = 0 ) noexcept
+    {
+        return make_unary_operator( ceras_private::checkpoint_forward{ segments },
+                                    []<Tensor Tsor>( Tsor const&, Tsor const&, Tsor const& grad ) noexcept
+                                    {
+                                        return grad;
+                                    },
+                                    "checkpoint"
+                )( ex );
+    }
+
+
     ///
     /// @brief Broadcast an expression to produce a new shape.
     ///
@@ -521,38 +836,81 @@ namespace ceras
 
 
 
+    namespace ceras_private
+    {
+        // `grad` summed along the axes `shape` is broadcast along, the leading axes it lacks included, into `ans`, resized to `shape`
+        template< Tensor Tsor >
+        void unbroadcast( Tsor const& grad, std::vector<unsigned long> const& shape, Tsor& ans )
+        {
+            typedef typename Tsor::value_type value_type;
+            ans.resize( shape );
+            if ( shape == grad.shape() )
+            {
+                std::copy( grad.begin(), grad.end(), ans.begin() );
+                return;
+            }
+
+            std::fill( ans.begin(), ans.end(), value_type{0} );
+            unsigned long const ndim = grad.ndim();
+            better_assert( shape.size() <= ndim, "unbroadcast: expecting at most ", ndim, " dimensions, but got ", shape.size() );
+            std::vector<unsigned long> strides( ndim, 0UL ); // the strides of `ans` along the axes of `grad`, 0 along the broadcast ones
+            for ( unsigned long axis = shape.size(), stride = 1; axis-- != 0; stride *= shape[axis] )
+                if ( shape[axis] != 1 )
+                    strides[ndim-shape.size()+axis] = stride;
+
+            // the last axis in the inner loop, the others counted over
+            unsigned long const cols = grad.shape()[ndim-1];
+            unsigned long const col_stride = strides[ndim-1];
+            std::vector<unsigned long> index( ndim, 0UL );
+            value_type const* g = grad.data();
+            value_type* a = ans.data();
+            for ( unsigned long offset = 0; offset != grad.size(); offset += cols )
+            {
+                unsigned long row = 0;
+                for ( unsigned long axis = 0; axis+1 < ndim; ++axis )
+                    row += index[axis] * strides[axis];
+                for ( unsigned long c = 0; c != cols; ++c )
+                    a[row+c*col_stride] += g[offset+c];
+                for ( unsigned long axis = ndim-1; axis-- != 0; index[axis] = 0 )
+                    if ( ++index[axis] != grad.shape()[axis] )
+                        break;
+            }
+        }
+    }//namespace ceras_private
+
     namespace
     {
         struct plus_context
         {
             auto make_forward() const noexcept
             {
-                return []<Tensor Tsor>( Tsor const& lhs_tensor, Tsor const& rhs_tensor ) noexcept
+                return []( std::shared_ptr<std::any> forward_cache ) noexcept
                 {
-                    better_assert( !has_nan( lhs_tensor ), "forward propagation for operator plus: lhs_tensor contains Nan!" );
-                    better_assert( !has_nan( rhs_tensor ), "forward propagation for operator plus: rhs_tensor contains Nan!" );
-                    return add( lhs_tensor, rhs_tensor );
+                    return [forward_cache]<Tensor Tsor>( Tsor const& lhs_tensor, Tsor const& rhs_tensor ) noexcept
+                    {
+                        better_assert( !has_nan( lhs_tensor ), "forward propagation for operator plus: lhs_tensor contains Nan!" );
+                        better_assert( !has_nan( rhs_tensor ), "forward propagation for operator plus: rhs_tensor contains Nan!" );
+                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                        add( lhs_tensor, rhs_tensor, ans );
+                        return ans;
+                    };
                 };
             }
 
+            // the gradients are kept in the storage of `backward_cache_lhs` and `backward_cache_rhs` from a pass to another
             auto make_backward() const noexcept
             {
-                return []<Tensor Tsor>( Tsor const& lhs_input, Tsor const& rhs_input, Tsor const&, Tsor const& grad ) noexcept
+                return []( std::shared_ptr<std::any> backward_cache_lhs, std::shared_ptr<std::any> backward_cache_rhs ) noexcept
                 {
-                   better_assert( !has_nan( grad ), "backprop: upcoming gradient for operator + contains NaN!" );
-
-                   auto const& grad_fun = [&grad]( auto const& input )
-                   {
-                       Tsor ans = grad.deep_copy();
-                       while( input.ndim() < ans.ndim() )
-                           ans = sum( ans, 0 );
-                       auto const& shape = input.shape();
-                       for ( auto axis : range( input.ndim() ) )
-                           if ( shape[axis] == 1 )
-                              ans = sum( ans, axis, true );
-                       return ans;
-                   };
-                   return std::make_tuple( grad_fun( lhs_input), grad_fun( rhs_input ) );
+                    return [=]<Tensor Tsor>( Tsor const& lhs_input, Tsor const& rhs_input, Tsor const&, Tsor const& grad ) noexcept
+                    {
+                        better_assert( !has_nan( grad ), "backprop: upcoming gradient for operator + contains NaN!" );
+                        Tsor& lhs_grad = context_cast<Tsor>( backward_cache_lhs );
+                        Tsor& rhs_grad = context_cast<Tsor>( backward_cache_rhs );
+                        ceras_private::unbroadcast( grad, lhs_input.shape(), lhs_grad );
+                        ceras_private::unbroadcast( grad, rhs_input.shape(), rhs_grad );
+                        return std::make_tuple( lhs_grad, rhs_grad );
+                    };
                 };
             }
         }; // plus_context
@@ -567,7 +925,11 @@ namespace ceras
         };
 
 
-        return make_binary_operator( plus_context{}.make_forward(), plus_context{}.make_backward(), "plus", shape_calculator )( lhs_ex, rhs_ex );
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_lhs = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_rhs = std::make_shared<std::any>();
+        return make_binary_operator( plus_context{}.make_forward()( forward_cache ), ceras_private::overwritable_output{ plus_context{}.make_backward()( backward_cache_lhs, backward_cache_rhs ) },
+                                     "plus", shape_calculator )( lhs_ex, rhs_ex );
     }
 
     template< Expression Lhs_Expression, Expression Rhs_Expression >
@@ -584,13 +946,48 @@ namespace ceras
 
     namespace
     {
+        // stands for an operand of a multiplication which is not read from a variable
+        struct no_weight {};
+
+        // the variable an expression reads its data from: the variable itself, or the variable under a unary operator such as a reshape
+        template< Expression Ex >
+        auto weight_of( Ex const& ex ) noexcept
+        {
+            if constexpr( is_variable_v<Ex> )
+                return ex;
+            else if constexpr( is_unary_operator_v<Ex> )
+            {
+                if constexpr( is_variable_v<std::remove_cvref_t<decltype(ex.op())>> )
+                    return ex.op();
+                else
+                    return no_weight{};
+            }
+            else
+                return no_weight{};
+        }
+
+        // the packed copy of `weight` as a gemm operand, or nullptr if `tsor` does not share the data of `weight`, or if gemm is not done by `cpu_gemm`
+        template< typename Weight, Tensor Tsor >
+        auto packed_weight( Weight const& weight, Tsor const& tsor, bool as_lhs, bool transposed, unsigned long rows, unsigned long cols )
+        {
+            typedef typename Tsor::value_type value_type;
+            packed_matrix<value_type> const* ans = nullptr;
+            if constexpr( is_variable_v<Weight> && !cuda_mode && !cblas_mode )
+            {
+                if constexpr( std::is_same_v<typename Weight::tensor_type, Tsor> )
+                    if ( weight.state_ && weight.state_->data_.data() == tsor.data() && tsor.size() == rows * cols )
+                        ans = &(weight.packed_data( as_lhs, transposed, rows, cols ));
+            }
+            return ans;
+        }
+
         struct multiplication_context
         {
             auto make_forward() const noexcept
             {
-                return []( std::shared_ptr<std::any> forward_cache ) noexcept
+                return []( std::shared_ptr<std::any> forward_cache, std::shared_ptr<ceras_private::quantization_record> quantization, auto lhs_weight, auto rhs_weight ) noexcept
                 {
-                    return [forward_cache]<Tensor Tsor>( Tsor const& lhs_tensor, Tsor const& rhs_tensor ) noexcept
+                    return [forward_cache, quantization, lhs_weight, rhs_weight]<Tensor Tsor>( Tsor const& lhs_tensor, Tsor const& rhs_tensor ) noexcept
                     {
                         better_assert( lhs_tensor.size(), "multiplication::forward: empty lhs tensor." );
                         better_assert( rhs_tensor.size(), "multiplication::forward: empty rhs tensor." );
@@ -599,6 +996,26 @@ namespace ceras
                         better_assert( rhs_tensor.ndim() == 2, "multiplication::forward: rhs_tensor is not 2D." );
 
                         Tsor& ans = context_cast<Tsor>( forward_cache );
+
+                        // reuse the packed copy of a weight operand
+                        auto const [m, n] = std::make_tuple( lhs_tensor.shape()[0], lhs_tensor.shape()[1] );
+                        auto const k = rhs_tensor.shape()[1];
+                        if ( ceras_private::quantized_gemm( quantization, rhs_weight, rhs_tensor, lhs_tensor, false, false, m, n, k, ans ) || ceras_private::quantized_gemm( quantization, lhs_weight, lhs_tensor, rhs_tensor, true, false, m, n, k, ans ) )
+                            return ans;
+
+                        if ( auto const* packed_rhs = packed_weight( rhs_weight, rhs_tensor, false, false, n, k ); packed_rhs )
+                        {
+                            ans.resize( {m, k} );
+                            gemm( lhs_tensor.data(), false, *packed_rhs, m, n, k, ans.data() );
+                            return ans;
+                        }
+                        if ( auto const* packed_lhs = packed_weight( lhs_weight, lhs_tensor, true, false, m, n ); packed_lhs )
+                        {
+                            ans.resize( {m, k} );
+                            gemm( *packed_lhs, rhs_tensor.data(), false, m, n, k, ans.data() );
+                            return ans;
+                        }
+
                         multiply( lhs_tensor, rhs_tensor, ans );
                         return ans;
                     };
@@ -606,9 +1023,9 @@ namespace ceras
             }
             auto make_backward() const noexcept
             {
-                return []( std::shared_ptr<std::any> backward_cache_lhs, std::shared_ptr<std::any> backward_cache_rhs ) noexcept
+                return []( std::shared_ptr<std::any> backward_cache_lhs, std::shared_ptr<std::any> backward_cache_rhs, auto lhs_weight, auto rhs_weight ) noexcept
                 {
-                    return [backward_cache_lhs, backward_cache_rhs]<Tensor Tsor>( Tsor const& lhs_input, Tsor const& rhs_input, [[maybe_unused]] Tsor const& output, Tsor const& grad ) noexcept
+                    return [backward_cache_lhs, backward_cache_rhs, lhs_weight, rhs_weight]<Tensor Tsor>( Tsor const& lhs_input, Tsor const& rhs_input, [[maybe_unused]] Tsor const& output, Tsor const& grad ) noexcept
                     {
                        // left branch <-- grad * rhs^T
                        auto const& g_shape = grad.shape();
@@ -618,12 +1035,18 @@ namespace ceras
                        Tsor& lhs_grad = context_cast<Tsor>( backward_cache_lhs );
                        lhs_grad.resize( lhs_input.shape() );
 
-                       gemm( grad.data(), false, rhs_input.data(), true, m, n, k, lhs_grad.data() );
+                       if ( auto const* packed_rhs = packed_weight( rhs_weight, rhs_input, false, true, n, k ); packed_rhs )
+                           gemm( grad.data(), false, *packed_rhs, m, n, k, lhs_grad.data() );
+                       else
+                           gemm( grad.data(), false, rhs_input.data(), true, m, n, k, lhs_grad.data() );
 
                        // right branch <-- lhs^T * grad
                        Tsor& rhs_grad = context_cast<Tsor>( backward_cache_rhs );
                        rhs_grad.resize( rhs_input.shape() );
-                       gemm( lhs_input.data(), true, grad.data(), false, k, m, n, rhs_grad.data() );
+                       if ( auto const* packed_lhs = packed_weight( lhs_weight, lhs_input, true, true, k, m ); packed_lhs )
+                           gemm( *packed_lhs, grad.data(), false, k, m, n, rhs_grad.data() );
+                       else
+                           gemm( lhs_input.data(), true, grad.data(), false, k, m, n, rhs_grad.data() );
 
                        return std::make_tuple( lhs_grad, rhs_grad );
                     };
@@ -632,6 +1055,12 @@ namespace ceras
         };//multiplication_context
     }//anonymous namespace
 
+    ///
+    /// @brief Matrix multiplication.
+    ///
+    /// If an operand reads the data of a variable, such as the weights of a Dense or a Conv2D layer, gemm uses a packed copy of the variable,
+    /// which is refreshed only after the optimizer updates it. In a model quantized by `model::quantize`, such products are computed in int8.
+    ///
     template< Expression Lhs_Expression, Expression Rhs_Expression >
     auto operator * ( Lhs_Expression const& lhs_ex, Rhs_Expression const& rhs_ex ) noexcept
     {
@@ -652,7 +1081,10 @@ namespace ceras
             std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
             std::shared_ptr<std::any> backward_cache_lhs = std::make_shared<std::any>();
             std::shared_ptr<std::any> backward_cache_rhs = std::make_shared<std::any>();
-            return make_binary_operator( multiplication_context{}.make_forward()(forward_cache), multiplication_context{}.make_backward()(backward_cache_lhs, backward_cache_rhs), "multiply", shape_calculator )( lhs_ex, rhs_ex );
+            auto const& lhs_weight = weight_of( lhs_ex );
+            auto const& rhs_weight = weight_of( rhs_ex );
+            std::shared_ptr<ceras_private::quantization_record> quantization = std::make_shared<ceras_private::quantization_record>();
+            return make_binary_operator( multiplication_context{}.make_forward()(forward_cache, quantization, lhs_weight, rhs_weight), ceras_private::overwritable_output{ multiplication_context{}.make_backward()(backward_cache_lhs, backward_cache_rhs, lhs_weight, rhs_weight) }, "multiply", shape_calculator )( lhs_ex, rhs_ex );
         }
     }
 
@@ -662,6 +1094,374 @@ namespace ceras
         return lhs_ex * rhs_ex;
     }
 
+    ///
+    /// @brief Activations the dense operator can apply in the epilogue of its GEMM.
+    ///
+    /// Their derivatives are computed from the output, so the pre-activation never needs to be stored.
+    ///
+    enum class fused_activation
+    {
+        linear,
+        relu,
+        sigmoid,
+        tanh
+    };
+
+    inline fused_activation make_fused_activation( std::string const& name )
+    {
+        if ( name.empty() || name == "linear" ) return fused_activation::linear;
+        if ( name == "relu" ) return fused_activation::relu;
+        if ( name == "sigmoid" ) return fused_activation::sigmoid;
+        better_assert( name == "tanh", "dense: activation should be one of 'linear', 'relu', 'sigmoid' or 'tanh', but got ", name );
+        return fused_activation::tanh;
+    }
+
+    inline std::string fused_activation_name( fused_activation activation )
+    {
+        switch ( activation )
+        {
+            case fused_activation::relu: return std::string{ "relu" };
+            case fused_activation::sigmoid: return std::string{ "sigmoid" };
+            case fused_activation::tanh: return std::string{ "tanh" };
+            default: return std::string{ "linear" };
+        }
+    }
+
+    namespace
+    {
+        // `activation( c + bias )` on a block of the output of a GEMM, the bias being broadcasted along the rows
+        template< typename T >
+        struct bias_activation_epilogue
+        {
+            T const* bias_;
+            fused_activation activation_;
+
+            template< typename Function >
+            void apply( T* c, unsigned long ldc, unsigned long rows, unsigned long col_first, unsigned long cols, Function const& func ) const noexcept
+            {
+                T const* bias = bias_ + col_first;
+                for ( unsigned long r = 0; r != rows; ++r )
+                {
+                    T* row = c + r * ldc;
+                    for ( unsigned long j = 0; j != cols; ++j )
+                        row[j] = func( row[j] + bias[j] );
+                }
+            }
+
+            void operator()( T* c, unsigned long ldc, unsigned long, unsigned long rows, unsigned long col_first, unsigned long cols ) const noexcept
+            {
+                switch ( activation_ )
+                {
+                    case fused_activation::relu: apply( c, ldc, rows, col_first, cols, []( T x ) noexcept { return std::max( x, T{0} ); } ); return;
+                    case fused_activation::sigmoid: apply( c, ldc, rows, col_first, cols, []( T x ) noexcept { return T{1} / ( T{1} + std::exp( -x ) ); } ); return;
+                    case fused_activation::tanh: apply( c, ldc, rows, col_first, cols, []( T x ) noexcept { return std::tanh( x ); } ); return;
+                    default: apply( c, ldc, rows, col_first, cols, []( T x ) noexcept { return x; } ); return;
+                }
+            }
+        };
+
+        //
+        // The rhs of a dense operator, holding the weight and the bias: its output is the weight, shared but not copied,
+        // and the bias and its gradient are exchanged with the dense operator through shared caches.
+        //
+        struct dense_parameters_context
+        {
+            auto make_forward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> bias_cache ) noexcept
+                {
+                    return [bias_cache]<Tensor Tsor>( Tsor const& weight, Tsor const& bias ) noexcept
+                    {
+                        context_cast<Tsor>( bias_cache ) = bias;
+                        return weight;
+                    };
+                };
+            }
+
+            auto make_backward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> bias_gradient_cache ) noexcept
+                {
+                    return [bias_gradient_cache]<Tensor Tsor>( Tsor const&, Tsor const& bias, Tsor const&, Tsor const& grad ) noexcept
+                    {
+                        Tsor& bias_grad = context_cast<Tsor>( bias_gradient_cache );
+                        bias_grad.reshape( bias.shape() );
+                        return std::make_tuple( grad, bias_grad );
+                    };
+                };
+            }
+        }; // dense_parameters_context
+
+        struct dense_context
+        {
+            auto make_forward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> forward_cache, std::shared_ptr<std::any> bias_cache, std::shared_ptr<ceras_private::quantization_record> quantization, fused_activation activation, auto weight ) noexcept
+                {
+                    return [forward_cache, bias_cache, quantization, activation, weight]<Tensor Tsor>( Tsor const& input, Tsor const& w ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        better_assert( input.ndim() == 2, "dense::forward: input is not 2D." );
+                        better_assert( w.ndim() == 2, "dense::forward: weight is not 2D." );
+                        auto const [m, n] = std::make_tuple( input.shape()[0], input.shape()[1] );
+                        auto const k = w.shape()[1];
+                        better_assert( w.shape()[0] == n, "dense::forward: expecting weight of ", n, " rows, but got ", w.shape()[0] );
+
+                        Tsor const& bias = context_cast<Tsor>( bias_cache );
+                        better_assert( bias.size() == k, "dense::forward: expecting bias of ", k, " elements, but got ", bias.size() );
+
+                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                        ans.resize( {m, k} );
+                        bias_activation_epilogue<value_type> const epilogue{ bias.data(), activation };
+                        if ( ceras_private::quantized_gemm( quantization, weight, w, input, false, false, m, n, k, ans, epilogue ) )
+                            return ans;
+                        if ( auto const* packed_w = packed_weight( weight, w, false, false, n, k ); packed_w )
+                            gemm( input.data(), false, *packed_w, m, n, k, ans.data(), epilogue );
+                        else
+                            gemm( input.data(), false, w.data(), false, m, n, k, ans.data(), epilogue );
+                        return ans;
+                    };
+                };
+            }
+
+            auto make_backward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> backward_cache, std::shared_ptr<std::any> backward_cache_input, std::shared_ptr<std::any> backward_cache_weight,
+                           std::shared_ptr<std::any> bias_gradient_cache, fused_activation activation, auto weight ) noexcept
+                {
+                    return [=]<Tensor Tsor>( Tsor const& input, Tsor const& w, Tsor const& output, Tsor const& grad ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        auto const [m, n] = std::make_tuple( input.shape()[0], input.shape()[1] );
+                        auto const k = w.shape()[1];
+
+                        // gradient of the pre-activation, and of the bias as its column sums, in a single pass over blocks of rows
+                        Tsor& pre_grad = context_cast<Tsor>( backward_cache );
+                        pre_grad.resize( {m, k} );
+                        Tsor& bias_grad = context_cast<Tsor>( bias_gradient_cache );
+                        bias_grad.resize( {1, k} );
+
+                        auto const& backward_pass = [&]( auto const& derivative )
+                        {
+                            value_type const* o = output.data();
+                            value_type const* g = grad.data();
+                            value_type* p = pre_grad.data();
+                            // column sums of the rows of each block, added in order
+                            std::vector<value_type> const sums = parallel_reduce( m, std::vector<value_type>( k, value_type{0} ),
+                            [&]( unsigned long first, unsigned long last, std::vector<value_type> partial )
+                            {
+                                for ( unsigned long r = first; r != last; ++r )
+                                    for ( unsigned long c = 0; c != k; ++c )
+                                    {
+                                        value_type const v = g[r*k+c] * derivative( o[r*k+c] );
+                                        p[r*k+c] = v;
+                                        partial[c] += v;
+                                    }
+                                return partial;
+                            },
+                            []( std::vector<value_type> lhs, std::vector<value_type> const& rhs )
+                            {
+                                for ( unsigned long c = 0; c != lhs.size(); ++c )
+                                    lhs[c] += rhs[c];
+                                return lhs;
+                            }, 4.0 * static_cast<double>( k ) );
+                            std::copy( sums.begin(), sums.end(), bias_grad.begin() );
+                        };
+                        switch ( activation )
+                        {
+                            case fused_activation::relu: backward_pass( []( value_type y ) noexcept { return static_cast<value_type>( y > value_type{0} ); } ); break;
+                            case fused_activation::sigmoid: backward_pass( []( value_type y ) noexcept { return y * ( value_type{1} - y ); } ); break;
+                            case fused_activation::tanh: backward_pass( []( value_type y ) noexcept { return value_type{1} - y * y; } ); break;
+                            default: backward_pass( []( value_type ) noexcept { return value_type{1}; } ); break;
+                        }
+
+                        // input <-- pre_grad * w^T
+                        Tsor& input_grad = context_cast<Tsor>( backward_cache_input );
+                        input_grad.resize( input.shape() );
+                        if ( auto const* packed_w = packed_weight( weight, w, false, true, k, n ); packed_w )
+                            gemm( pre_grad.data(), false, *packed_w, m, k, n, input_grad.data() );
+                        else
+                            gemm( pre_grad.data(), false, w.data(), true, m, k, n, input_grad.data() );
+
+                        // weight <-- input^T * pre_grad
+                        Tsor& weight_grad = context_cast<Tsor>( backward_cache_weight );
+                        weight_grad.resize( w.shape() );
+                        gemm( input.data(), true, pre_grad.data(), false, n, m, k, weight_grad.data() );
+
+                        return std::make_tuple( input_grad, weight_grad );
+                    };
+                };
+            }
+        }; // dense_context
+
+        struct dense_serializer
+        {
+            fused_activation activation_;
+
+            template< typename Binary_Expression, typename Lhs_Expression, typename Rhs_Expression >
+            std::tuple<std::string, std::vector<std::string>> const operator()( Binary_Expression const& dense_expression, Lhs_Expression const& input_expression, Rhs_Expression const& parameters ) const noexcept
+            {
+                auto const& [input_name, input_code] = serialize( input_expression );
+                auto const& [weight_name, weight_code] = serialize( parameters.lhs_op() );
+                auto const& [bias_name, bias_code] = serialize( parameters.rhs_op() );
+
+                std::string const identity = fmt::format( "binary_expression_{}_{}", dense_expression.name(), dense_expression.id() );
+                std::vector<std::string> code = input_code;
+                std::copy( weight_code.begin(), weight_code.end(), std::back_inserter( code ) );
+                std::copy( bias_code.begin(), bias_code.end(), std::back_inserter( code ) );
+                code.emplace_back( fmt::format( "auto {} = dense( {}, {}, {}, \"{}\" );", identity, input_name, weight_name, bias_name, fused_activation_name( activation_ ) ) );
+                return std::make_tuple( identity, code );
+            }
+        }; // dense_serializer
+    }//anonymous namespace
+
+    ///
+    /// @brief Fused densely-connected operator, `activation( ex * w + b )` in a single node.
+    ///
+    /// The bias and the activation are applied to the tiles of the GEMM output while they are still in cache, and the backward pass computes
+    /// the gradient of the pre-activation and of the bias in a single sweep. Only the output is stored, instead of the three tensors of
+    /// `activation( ex * w + b )` built from separated operators. In a model quantized by `model::quantize`, the GEMM runs in int8 and the
+    /// bias and the activation are applied to its requantized tiles.
+    ///
+    /// @param ex Input of shape `[batch_size, input_size]`.
+    /// @param w Weight of shape `[input_size, output_size]`.
+    /// @param b Bias of `output_size` elements.
+    /// @param activation One of `linear`, `relu`, `sigmoid` and `tanh`. Defaults to `linear`.
+    ///
+    /// \code{.cpp}
+    /// auto x = place_holder<tensor<float>>{};
+    /// auto w = variable{ random<float>( {784, 128} ) };
+    /// auto b = variable{ zeros<float>( {1, 128} ) };
+    /// auto y = dense( x, w, b, "relu" ); // same as relu( x * w + b )
+    /// \endcode
+    ///
+    template< Expression Ex, Expression Weight_Expression, Expression Bias_Expression >
+    auto dense( Ex const& ex, Weight_Expression const& w, Bias_Expression const& b, std::string const& activation_name = "linear" ) noexcept
+    {
+        fused_activation const activation = make_fused_activation( activation_name );
+
+        std::shared_ptr<std::any> bias_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> bias_gradient_cache = std::make_shared<std::any>();
+        auto const& parameters_shape_calculator = []( std::vector<unsigned long> const& w_shape, std::vector<unsigned long> const& ) noexcept { return w_shape; };
+        auto const& parameters = make_binary_operator( dense_parameters_context{}.make_forward()( bias_cache ), dense_parameters_context{}.make_backward()( bias_gradient_cache ),
+                                                       "dense_parameters", parameters_shape_calculator )( w, b );
+
+        auto const& shape_calculator = []( std::vector<unsigned long> const& l, std::vector<unsigned long> const& r ) noexcept
+        {
+            better_assert( l.size() == 2, fmt::format( "expecting l size of 2, but got {}", l.size() ) );
+            better_assert( r.size() == 2, fmt::format( "expecting r size of 2, but got {}", r.size() ) );
+            return std::vector<unsigned long>{ {l[0], r[1]} };
+        };
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_input = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_weight = std::make_shared<std::any>();
+        auto const& weight = weight_of( w );
+        std::shared_ptr<ceras_private::quantization_record> quantization = std::make_shared<ceras_private::quantization_record>();
+        return make_binary_operator( dense_context{}.make_forward()( forward_cache, bias_cache, quantization, activation, weight ),
+                                     dense_context{}.make_backward()( backward_cache, backward_cache_input, backward_cache_weight, bias_gradient_cache, activation, weight ),
+                                     "dense", shape_calculator, dense_serializer{ activation } )( ex, parameters );
+    }
+
+    namespace
+    {
+        struct batched_multiplication_context
+        {
+            auto make_forward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> forward_cache ) noexcept
+                {
+                    return [forward_cache]<Tensor Tsor>( Tsor const& lhs_tensor, Tsor const& rhs_tensor ) noexcept
+                    {
+                        better_assert( lhs_tensor.size(), "batched_multiplication::forward: empty lhs tensor." );
+                        better_assert( rhs_tensor.size(), "batched_multiplication::forward: empty rhs tensor." );
+
+                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                        batched_multiply( lhs_tensor, rhs_tensor, ans );
+                        return ans;
+                    };
+                };
+            }
+
+            auto make_backward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> backward_cache_lhs, std::shared_ptr<std::any> backward_cache_rhs ) noexcept
+                {
+                    return [backward_cache_lhs, backward_cache_rhs]<Tensor Tsor>( Tsor const& lhs_input, Tsor const& rhs_input, [[maybe_unused]] Tsor const& output, Tsor const& grad ) noexcept
+                    {
+                        // lhs: [B, m, n], rhs: [B, n, k], grad: [B, m, k], B of lhs or rhs can be 1
+                        unsigned long const m = *(lhs_input.shape().rbegin()+1);
+                        unsigned long const n = *(lhs_input.shape().rbegin());
+                        unsigned long const k = *(rhs_input.shape().rbegin());
+                        unsigned long const lhs_batch = lhs_input.size() / (m*n);
+                        unsigned long const rhs_batch = rhs_input.size() / (n*k);
+                        unsigned long const batch = grad.size() / (m*k);
+
+                        // left branch <-- grad * rhs^T
+                        Tsor& lhs_grad = context_cast<Tsor>( backward_cache_lhs );
+                        lhs_grad.resize( lhs_input.shape() );
+                        if ( lhs_batch == batch )
+                        {
+                            batched_gemm( grad.data(), false, m*k, rhs_input.data(), true, (rhs_batch == 1) ? 0UL : n*k, batch, m, k, n, lhs_grad.data() );
+                        }
+                        else // broadcasted lhs, accumulating the gradients of all the problems
+                        {
+                            Tsor products{ {batch, m, n} };
+                            batched_gemm( grad.data(), false, m*k, rhs_input.data(), true, n*k, batch, m, k, n, products.data() );
+                            std::copy_n( products.data(), m*n, lhs_grad.data() );
+                            for ( auto b : range( 1UL, batch ) )
+                                for_each( lhs_grad.begin(), lhs_grad.end(), products.begin() + b*m*n, []( auto& x, auto y ) noexcept { x += y; } );
+                        }
+
+                        // right branch <-- lhs^T * grad
+                        Tsor& rhs_grad = context_cast<Tsor>( backward_cache_rhs );
+                        rhs_grad.resize( rhs_input.shape() );
+                        if ( rhs_batch == batch )
+                            batched_gemm( lhs_input.data(), true, (lhs_batch == 1) ? 0UL : m*n, grad.data(), false, m*k, batch, n, m, k, rhs_grad.data() );
+                        else // broadcasted rhs, the stacked lhs^T times the stacked grad sums over the batch
+                            gemm( lhs_input.data(), true, grad.data(), false, n, batch*m, k, rhs_grad.data() );
+
+                        return std::make_tuple( lhs_grad, rhs_grad );
+                    };
+                };
+            }
+        };//batched_multiplication_context
+    }//anonymous namespace
+
+    ///
+    /// @brief Batched matrix multiplication, `[..., M, K] x [..., K, N] -> [..., M, N]`.
+    ///
+    /// The batch dimensions of the two operands should be the same, unless one of them is a single matrix, which is then broadcasted to the whole batch.
+    /// All the matrix products in the batch are scheduled together.
+    ///
+    /// @code{.cpp}
+    /// auto q = place_holder<tensor<float>>{};  // [B, T, D]
+    /// auto k = place_holder<tensor<float>>{};  // [B, D, T]
+    /// auto scores = batched_multiply( q, k ); // [B, T, T]
+    /// @endcode
+    ///
+    template< Expression Lhs_Expression, Expression Rhs_Expression >
+    auto batched_multiply( Lhs_Expression const& lhs_ex, Rhs_Expression const& rhs_ex ) noexcept
+    {
+        auto const& shape_calculator = []( std::vector<unsigned long> const& l, std::vector<unsigned long> const& r ) noexcept
+        {
+            return ceras_private::batched_multiply_shape( l, r );
+        };
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_lhs = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache_rhs = std::make_shared<std::any>();
+        return make_binary_operator( batched_multiplication_context{}.make_forward()(forward_cache), batched_multiplication_context{}.make_backward()(backward_cache_lhs, backward_cache_rhs), "batched_multiply", shape_calculator )( lhs_ex, rhs_ex );
+    }
+
+    ///
+    /// @brief An alias name of `batched_multiply`.
+    ///
+    template< Expression Lhs_Expression, Expression Rhs_Expression >
+    auto bmm( Lhs_Expression const& lhs_ex, Rhs_Expression const& rhs_ex ) noexcept
+    {
+        return batched_multiply( lhs_ex, rhs_ex );
+    }
+
     ///
     /// @brief Negative operator, elementwise.
     /// @code{.cpp}
@@ -672,15 +1472,23 @@ namespace ceras
     template <Expression Ex>
     auto constexpr negative( Ex const& ex ) noexcept
     {
-        return make_unary_operator( []<Tensor Tsor>( Tsor const& tensor ) noexcept
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
+        return make_unary_operator( [forward_cache]<Tensor Tsor>( Tsor const& tensor ) noexcept
                                     {
                                         better_assert( !has_nan( tensor ), "forward propagation for operator log: tensor contains Nan!" );
-                                        return -tensor;
+                                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                                        ans.resize( tensor.shape() );
+                                        std::transform( tensor.begin(), tensor.end(), ans.begin(), []( auto v ){ return -v; } );
+                                        return ans;
                                     },
-                                    []<Tensor Tsor>( Tsor const&, Tsor const&, Tsor const& grad ) noexcept
+                                    [backward_cache]<Tensor Tsor>( Tsor const&, Tsor const&, Tsor const& grad ) noexcept
                                     {
                                         better_assert( !has_nan( grad ), "input gradient for operator negative contains NaN!" );
-                                        return -grad;
+                                        Tsor& ans = context_cast<Tsor>( backward_cache );
+                                        ans.resize( grad.shape() );
+                                        std::transform( grad.begin(), grad.end(), ans.begin(), []( auto v ){ return -v; } );
+                                        return ans;
                                     },
                                     "negative"
                 )( ex );
@@ -921,17 +1729,19 @@ namespace ceras
     template <Expression Ex>
     auto constexpr sum_reduce( Ex const& ex ) noexcept
     {
+        std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
         return make_unary_operator( []<Tensor Tsor>( Tsor const& tsor ) noexcept
                                     {
                                         better_assert( !has_nan( tsor ), "forward propagation for operator sum_reduce: tensor contains Nan!" );
                                         return reduce_sum( tsor );
                                     },
-                                    []<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
+                                    [backward_cache]<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
                                     {
                                         better_assert( !has_nan( grad ), "input gradient for operator sum_reduce contains NaN!" );
                                         better_assert( grad.size() == 1, "sum_reduce should only output one value" );
-                                        Tsor ans = ones_like( input );
-                                        ans *= grad[0];
+                                        Tsor& ans = context_cast<Tsor>( backward_cache );
+                                        ans.resize( input.shape() );
+                                        std::fill( ans.begin(), ans.end(), grad[0] );
                                         return ans;
                                     },
                                     "sum_reduce",
@@ -960,17 +1770,19 @@ namespace ceras
     template <Expression Ex>
     auto constexpr mean_reduce( Ex const& ex ) noexcept
     {
+        std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
         return make_unary_operator( []<Tensor Tsor>( Tsor const& tsor ) noexcept
                                     {
                                         better_assert( !has_nan( tsor ), "forward propagation for operator mean: tensor contains Nan!" );
                                         return reduce_mean( tsor );
                                     },
-                                    []<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
+                                    [backward_cache]<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
                                     {
                                         better_assert( !has_nan( grad ), "input gradient for operator mean_reduce contains NaN!" );
                                         better_assert( grad.size() == 1, "mean_reduce should only output one value" );
-                                        Tsor ans = ones_like( input );
-                                        ans *= grad[0];
+                                        Tsor& ans = context_cast<Tsor>( backward_cache );
+                                        ans.resize( input.shape() );
+                                        std::fill( ans.begin(), ans.end(), grad[0] );
                                         unsigned long const batch_size = (input.shape().size() == 1) ? 1 : (*(input.shape().begin()));
                                         ans /= static_cast<typename Tsor::value_type>(batch_size);
                                         return ans;
@@ -1036,19 +1848,23 @@ namespace ceras
     template <Expression Ex>
     auto constexpr square( Ex const& ex ) noexcept
     {
-        return make_unary_operator( []<Tensor Tsor>( Tsor const& tsor ) noexcept
+        std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+        std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
+        return make_unary_operator( [forward_cache]<Tensor Tsor>( Tsor const& tsor ) noexcept
                                     {
                                         better_assert( !has_nan( tsor ), "forward propagation for operator square: tensor contains Nan!" );
-                                        Tsor ans = tsor.deep_copy();
-                                        std::for_each( ans.data(), ans.data() + ans.size(), []( auto & v ){ v *= v; } );
+                                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                                        ans.resize( tsor.shape() );
+                                        std::transform( tsor.begin(), tsor.end(), ans.begin(), []( auto v ){ return v * v; } );
                                         return ans;
                                     },
-                                    []<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
+                                    [backward_cache]<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
                                     {
                                         better_assert( !has_nan( grad ), "input gradient for operator square contains NaN!" );
-                                        Tsor ans = input.deep_copy();
-                                        ans *= grad;
-                                        ans *= typename Tsor::value_type{2};
+                                        typedef typename Tsor::value_type value_type;
+                                        Tsor& ans = context_cast<Tsor>( backward_cache );
+                                        ans.resize( input.shape() );
+                                        std::transform( input.begin(), input.end(), grad.begin(), ans.begin(), []( value_type x, value_type g ){ return value_type{2} * x * g; } );
                                         return ans;
                                     },
                                     "square"
@@ -1522,6 +2338,11 @@ namespace ceras
         )( ex );
     }
 
+    ///
+    /// @brief The receptive fields of a [BS, R, C, CH] input as a [row_kernel*col_kernel*CH, BS*new_row*new_col] matrix.
+    ///
+    /// Both the gathering and its adjoint in the backward pass run in parallel, the latter by input rows, free of races.
+    ///
     auto inline img2col( unsigned long const row_kernel, unsigned long col_kernel=-1,
                          unsigned long const row_padding=0, unsigned long col_padding=0,
                          unsigned long const row_stride=1, unsigned long const col_stride=1,
@@ -1529,140 +2350,365 @@ namespace ceras
     {
         if ( col_kernel == (unsigned long)-1 ) col_kernel = row_kernel;
 
-        std::shared_ptr<std::vector<std::uint32_t>> s_index_record = std::make_shared<std::vector<std::uint32_t>>(); // col_img[idx] = img[index_record[idx]]  -- (-1) for zero padding
-
-        auto img2col_forward = [s_index_record]<Tensor Tsor>
-        (
-            Tsor const& input_img, Tsor& output_col_mat,
-            unsigned long kernel_row, unsigned long kernel_col,
-            unsigned long padding_row, unsigned long padding_col,
-            unsigned long stride_row, unsigned long stride_col,
-            unsigned long dilation_row, unsigned long dilation_col
-        ) noexcept
-        {
-            typedef typename Tsor::value_type value_type;
-            std::vector<std::uint32_t>& index_record = *s_index_record; //32 bit should be enough for memory address offeset
-
-            std::vector<unsigned long> input_shape = input_img.shape();
-            better_assert( input_shape.size() == 4, "Expecting a 4D tensor." );
-            auto const [BS, R, C, CH] = std::make_tuple( input_shape[0], input_shape[1], input_shape[2], input_shape[3] );
-
-            unsigned long const output_row = ( R + 2 * padding_row - ( dilation_row * (kernel_row - 1) + 1 ) ) / stride_row + 1;
-            unsigned long const output_col = ( C + 2 * padding_col - ( dilation_col * (kernel_col - 1) + 1 ) ) / stride_col + 1;
-            unsigned long const output_column_matrix_row = kernel_row * kernel_col * CH;
-            unsigned long const output_column_matrix_col = BS * output_row * output_col;
-
-            output_col_mat.resize( {output_column_matrix_row, output_column_matrix_col} );
-
-            if ( index_record.size() != output_column_matrix_row * output_column_matrix_col ) // first-run?
-            {
-                index_record.resize( output_column_matrix_row * output_column_matrix_col );
-
-                for ( auto bs : range( BS ) )
-                {
-                    std::int64_t const col_offset = bs * output_row * output_col * kernel_row * kernel_col * CH;
-                    std::int64_t const im_offset = bs * R * C * CH;
-                    for ( auto c : range( CH * kernel_row * kernel_col ) )
-                    {
-                        std::int64_t const w_offset = c % kernel_col;
-                        std::int64_t const h_offset = ( c / kernel_col ) % kernel_row;
-                        std::int64_t const c_im = c / ( kernel_col * kernel_row );
-
-                        for ( auto h : range( output_row ) )
-                        {
-                            std::int64_t const im_row_idx = h * stride_row - padding_row + h_offset * dilation_row;
-                            for ( auto w : range( output_col ) )
-                            {
-                                std::int64_t const im_col_idx = w * stride_col - padding_col + w_offset * dilation_col;
-                                std::int64_t const im_idx = im_offset+( im_row_idx * C + im_col_idx ) * CH + c_im;
-                                std::int64_t const col_idx = col_offset+( c * output_row + h ) * output_col + w;
-                                index_record[col_idx] = static_cast<std::uint32_t>((im_row_idx<0 || im_row_idx>=static_cast<std::int64_t>(R) || im_col_idx<0 || im_col_idx>=static_cast<std::int64_t>(C)) ? 0xffffffff : im_idx);
-                            }
-                        }
-                    }
-                }
-                // re-arrange [bs, new_R, new_C] --> [new_R, new_c*bs]
-                {
-                    std::vector<std::uint32_t> re_arranged_index;
-                    re_arranged_index.resize( index_record.size() );
-
-                    view_3d<std::uint32_t> re_arranged_mat{ re_arranged_index.data(), output_column_matrix_row, BS, output_row*output_col };
-                    view_3d<std::uint32_t> index_record_mat{ index_record.data(), BS, output_column_matrix_row, output_row*output_col };
-
-                    for ( auto bs : range( BS ) )
-                        for ( auto r : range( output_column_matrix_row ) )
-                            for ( auto c : range( output_row*output_col ) )
-                                re_arranged_mat[r][bs][c] = index_record_mat[bs][r][c];
-                    // overwrite index record
-                    std::copy( re_arranged_index.begin(), re_arranged_index.end(), index_record.begin() );
-                }
-            }
-
-            // fill-in
-            for ( auto idx : range( output_col_mat.size() ) )
-            {
-                auto const index = index_record[idx];
-                output_col_mat[idx] = (index == 0xffffffff) ? value_type{0} : input_img[index];
-            }
-        };
-
-        auto img2col_backward = [s_index_record]<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad, Tsor& ans ) noexcept
+        // the geometry of a single filter over the input of `shape`
+        auto const& make_geometry = [=]( std::vector<unsigned long> const& shape ) noexcept
         {
-            typedef typename Tsor::value_type value_type;
-            ans.resize( input.shape() );
-            std::fill( ans.begin(), ans.end(), value_type{0} );
-
-            std::vector<std::uint32_t>& index_record = *s_index_record; //32 bit should be enough for memory address offeset
-            for ( auto idx : range( grad.size() ) )
-            {
-                auto const index = index_record[idx];
-                if ( index != 0xffffffff )
-                    ans[index] += grad[idx];
-            }
+            better_assert( shape.size() == 4, fmt::format("Expecting a 4D tensor, but got {}.", shape.size()) );
+            return conv2d_geometry{ shape[0], shape[1], shape[2], shape[3], 1, row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation };
         };
 
         std::shared_ptr<std::any> output_cache = std::make_shared<std::any>();
         std::shared_ptr<std::any> back_grad_cache = std::make_shared<std::any>();
 
-        return [row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation, img2col_forward, img2col_backward, output_cache, back_grad_cache]<Expression Ex>( Ex const& ex ) noexcept
+        return [row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation, make_geometry, output_cache, back_grad_cache]<Expression Ex>( Ex const& ex ) noexcept
         {
             return make_unary_operator
             (
                 [=]<Tensor Tsor>( Tsor const & tsor ) noexcept
                 {
+                    conv2d_geometry const g = make_geometry( tsor.shape() );
                     Tsor& output = context_cast<Tsor>( output_cache );
-                    img2col_forward( tsor, output, row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation );
+                    output.resize( {g.depth(), g.pixels()} );
+                    ceras_private::img2col_matrix( tsor.data(), g, output.data(), true );
                     return Tsor{output};
                 },
-                [=]<Tensor Tsor>( Tsor const& input, Tsor const& output, Tsor const& grad ) noexcept
+                [=]<Tensor Tsor>( Tsor const& input, Tsor const&, Tsor const& grad ) noexcept
                 {
+                    conv2d_geometry const g = make_geometry( input.shape() );
                     Tsor& back_grad = context_cast<Tsor>( back_grad_cache );
-                    img2col_backward( input, output, grad, back_grad );
+                    back_grad.resize( input.shape() );
+                    ceras_private::col2img_matrix( grad.data(), g, back_grad.data(), true );
                     return Tsor{back_grad};
                 },
                 "img2col",
                 [=]( std::vector<unsigned long> const& shape ) noexcept
                 {
-                    better_assert( shape.size() == 4, fmt::format("Expecting a 4D tensor, but got {}.", shape.size()) );
-                    auto const [BS, R, C, CH] = std::make_tuple( shape[0], shape[1], shape[2], shape[3] );
-
-                    unsigned long const output_row = ( R + 2 * row_padding - ( row_dilation * (row_kernel - 1) + 1 ) ) / row_stride + 1;
-                    unsigned long const output_col = ( C + 2 * col_padding - ( col_dilation * (col_kernel - 1) + 1 ) ) / col_stride + 1;
-                    unsigned long const output_column_matrix_row = row_kernel * col_kernel * CH;
-                    unsigned long const output_column_matrix_col = BS * output_row * output_col;
-                    return std::vector<unsigned long>{ {output_column_matrix_row, output_column_matrix_col} };
+                    conv2d_geometry const g = make_geometry( shape );
+                    return std::vector<unsigned long>{ {g.depth(), g.pixels()} };
                 },
                 make_argumented_operator_serializer( row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation )
             )( ex );
         };
     }
 
+    namespace
+    {
+        struct conv2d_context
+        {
+            // the geometry of the convolution of `input` with the kernels `w`, the paddings, strides and dilations being those of `geometry`
+            template< Tensor Tsor >
+            static conv2d_geometry make_geometry( conv2d_geometry geometry, Tsor const& input, Tsor const& w ) noexcept
+            {
+                better_assert( input.ndim() == 4, "conv2d: expecting a 4D input, but got ", input.ndim() );
+                better_assert( w.ndim() == 4, "conv2d: expecting 4D kernels, but got ", w.ndim() );
+                better_assert( input.shape()[3] == w.shape()[3] * geometry.groups, "conv2d: expecting kernels of ", input.shape()[3] / geometry.groups, " channels, but got ", w.shape()[3] );
+                better_assert( w.shape()[0] % geometry.groups == 0, "conv2d: expecting the ", w.shape()[0], " filters to be a multiple of the ", geometry.groups, " groups" );
+                geometry.batch = input.shape()[0];
+                geometry.rows = input.shape()[1];
+                geometry.cols = input.shape()[2];
+                geometry.channels = input.shape()[3];
+                geometry.filters = w.shape()[0];
+                geometry.kernel_rows = w.shape()[1];
+                geometry.kernel_cols = w.shape()[2];
+                return geometry;
+            }
+
+            // the geometry, the setting and the algorithm selected for them at the last convolution
+            typedef std::optional<std::tuple<conv2d_geometry, conv2d_algorithm, conv2d_algorithm>> selection;
+
+            // `forced` is the setting of the convolution, `convolution_algorithm` if none
+            auto make_forward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> forward_cache, std::shared_ptr<std::any> workspace_cache, std::shared_ptr<std::any> chunk_cache, std::shared_ptr<conv2d_algorithm> algorithm,
+                           std::optional<conv2d_algorithm> forced, std::shared_ptr<std::any> selection_cache,
+                           std::shared_ptr<ceras_private::quantization_record> quantization, conv2d_geometry geometry, auto weight ) noexcept
+                {
+                    return [=]<Tensor Tsor>( Tsor const& input, Tsor const& w ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        conv2d_geometry const g = make_geometry( geometry, input, w );
+                        unsigned long const pixels = g.pixels();
+                        unsigned long const depth = g.depth();
+
+                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                        ans.resize( {g.batch, g.output_rows(), g.output_cols(), g.filters} );
+                        Tsor& workspace = context_cast<Tsor>( workspace_cache );
+
+                        // int8 products and their calibration are done on the img2col matrix, for dense convolutions, or on the input of unit strided 1x1 convolutions
+                        bool const quantized = is_variable_v<decltype(weight)> && quantization_phase != quantization_mode::none && g.groups == 1;
+                        bool const unit_strides = g.row_stride == 1 && g.col_stride == 1;
+                        // selected again only for a new geometry or setting, sparing the tuning key and the lock of the tuned algorithms at every convolution
+                        conv2d_algorithm const setting = forced.value_or( convolution_algorithm );
+                        selection& selected = context_cast<selection>( selection_cache );
+                        if ( !selected || std::get<0>( *selected ) != g || std::get<1>( *selected ) != setting )
+                            selected = std::make_tuple( g, setting, select_conv2d_algorithm<value_type>( g, setting ) );
+                        if ( std::get<2>( *selected ) == conv2d_algorithm::autotuned && !quantized )
+                            std::get<2>( *selected ) = tune( g, input, w );
+                        *algorithm = std::get<2>( *selected );
+                        if ( *algorithm == conv2d_algorithm::autotuned )
+                            *algorithm = select_conv2d_algorithm<value_type>( g, conv2d_algorithm::automatic );
+                        if ( quantized && !( *algorithm == conv2d_algorithm::pointwise && unit_strides ) )
+                            *algorithm = conv2d_algorithm::img2col;
+
+                        if ( *algorithm == conv2d_algorithm::depthwise )
+                        {
+                            ceras_private::depthwise_conv2d( input.data(), w.data(), g, ans.data() );
+                            return ans;
+                        }
+
+                        // [BS, R, C, CH] is the [BS*R*C, CH] img2col matrix of a 1x1 convolution of unit strides, multiplied by the transposed [NC, CH] kernels as it is
+                        if ( *algorithm == conv2d_algorithm::pointwise && unit_strides )
+                        {
+                            if ( ceras_private::quantized_gemm( quantization, weight, w, input, false, true, pixels, depth, g.filters, ans ) )
+                                return ans.reshape( {g.batch, g.output_rows(), g.output_cols(), g.filters} );
+                            if ( auto const* packed_w = packed_weight( weight, w, false, true, depth, g.filters ); packed_w )
+                                gemm( input.data(), false, *packed_w, pixels, depth, g.filters, ans.data() );
+                            else
+                                gemm( input.data(), false, w.data(), true, pixels, depth, g.filters, ans.data() );
+                            return ans;
+                        }
+
+                        if constexpr( std::floating_point<value_type> )
+                        {
+                            if ( *algorithm == conv2d_algorithm::winograd_2x2 )
+                            {
+                                workspace.resize( {ceras_private::winograd_workspace<2>( g ),} );
+                                ceras_private::winograd_conv2d<2>( input.data(), w.data(), g, ans.data(), workspace.data() );
+                                return ans;
+                            }
+                            if ( *algorithm == conv2d_algorithm::winograd_4x4 )
+                            {
+                                workspace.resize( {ceras_private::winograd_workspace<4>( g ),} );
+                                ceras_private::winograd_conv2d<4>( input.data(), w.data(), g, ans.data(), workspace.data() );
+                                return ans;
+                            }
+                            if ( *algorithm == conv2d_algorithm::implicit_gemm )
+                            {
+                                ceras_private::implicit_gemm_conv2d( input.data(), w.data(), packed_weight( weight, w, false, true, depth, g.filters ), g, ans.data() );
+                                return ans;
+                            }
+                            if ( *algorithm == conv2d_algorithm::pointwise )
+                            {
+                                ceras_private::pointwise_conv2d( input.data(), w.data(), packed_weight( weight, w, false, true, depth, g.filters ), g, ans.data() );
+                                return ans;
+                            }
+                        }
+
+                        better_assert( g.groups == 1, "conv2d: convolutions of ", g.groups, " groups of ", g.channels / g.groups, " channels need float or double tensors" );
+
+                        // [BS, R, C, CH] ==> [BS*new_row*new_col, CH*r*c], multiplied by the transposed [NC, CH*r*c] kernels, a chunk of images at a time
+                        unsigned long const image_pixels = g.output_rows() * g.output_cols();
+                        unsigned long const images = ceras_private::images_per_chunk<value_type>( g.batch, image_pixels * depth );
+                        Tsor& product = ( images == g.batch ) ? ans : context_cast<Tsor>( chunk_cache );
+                        for ( unsigned long first = 0; first < g.batch; first += images )
+                        {
+                            conv2d_geometry const chunk = ceras_private::chunk_geometry( g, std::min( images, g.batch - first ) );
+                            unsigned long const rows = chunk.pixels();
+                            workspace.resize( {rows, depth} );
+                            ceras_private::img2col_matrix( input.data() + first * g.rows * g.cols * g.channels, chunk, workspace.data() );
+                            product.resize( {rows, g.filters} );
+                            if ( !ceras_private::quantized_gemm( quantization, weight, w, workspace, false, true, rows, depth, g.filters, product ) )
+                            {
+                                if ( auto const* packed_w = packed_weight( weight, w, false, true, depth, g.filters ); packed_w )
+                                    gemm( workspace.data(), false, *packed_w, rows, depth, g.filters, product.data() );
+                                else
+                                    gemm( workspace.data(), false, w.data(), true, rows, depth, g.filters, product.data() );
+                            }
+                            if ( &product != &ans )
+                                std::copy_n( product.data(), rows * g.filters, ans.data() + first * image_pixels * g.filters );
+                        }
+                        return ans.reshape( {g.batch, g.output_rows(), g.output_cols(), g.filters} );
+                    };
+                };
+            }
+
+            auto make_backward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> workspace_cache, std::shared_ptr<std::any> chunk_cache, std::shared_ptr<std::any> backward_cache, std::shared_ptr<std::any> backward_cache_input,
+                           std::shared_ptr<std::any> backward_cache_weight, std::shared_ptr<conv2d_algorithm> algorithm, conv2d_geometry geometry, auto weight ) noexcept
+                {
+                    return [=]<Tensor Tsor>( Tsor const& input, Tsor const& w, [[maybe_unused]] Tsor const& output, Tsor const& grad ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        conv2d_geometry const g = make_geometry( geometry, input, w );
+                        unsigned long const pixels = g.pixels();
+                        unsigned long const depth = g.depth();
+                        Tsor& workspace = context_cast<Tsor>( workspace_cache );
+
+                        Tsor& input_grad = context_cast<Tsor>( backward_cache_input );
+                        input_grad.resize( input.shape() );
+                        Tsor& weight_grad = context_cast<Tsor>( backward_cache_weight );
+                        weight_grad.resize( w.shape() );
+
+                        if ( *algorithm == conv2d_algorithm::depthwise )
+                        {
+                            ceras_private::depthwise_conv2d_input_gradient( grad.data(), w.data(), g, input_grad.data() );
+                            ceras_private::depthwise_conv2d_weight_gradient( input.data(), grad.data(), g, weight_grad.data() );
+                            return std::make_tuple( input_grad, weight_grad );
+                        }
+
+                        // input <-- grad * w, and w <-- grad^T * input, for a 1x1 convolution of unit strides
+                        if ( *algorithm == conv2d_algorithm::pointwise && g.row_stride == 1 && g.col_stride == 1 )
+                        {
+                            if ( auto const* packed_w = packed_weight( weight, w, false, false, g.filters, depth ); packed_w )
+                                gemm( grad.data(), false, *packed_w, pixels, g.filters, depth, input_grad.data() );
+                            else
+                                gemm( grad.data(), false, w.data(), false, pixels, g.filters, depth, input_grad.data() );
+                            gemm( grad.data(), true, input.data(), false, g.filters, pixels, depth, weight_grad.data() );
+                            return std::make_tuple( input_grad, weight_grad );
+                        }
+
+                        if constexpr( std::floating_point<value_type> )
+                        {
+                            if ( *algorithm == conv2d_algorithm::winograd_2x2 )
+                            {
+                                ceras_private::winograd_conv2d_input_gradient<2>( grad.data(), w.data(), g, input_grad.data() );
+                                ceras_private::winograd_conv2d_weight_gradient<2>( workspace.data(), grad.data(), g, weight_grad.data() );
+                                return std::make_tuple( input_grad, weight_grad );
+                            }
+                            if ( *algorithm == conv2d_algorithm::winograd_4x4 )
+                            {
+                                ceras_private::winograd_conv2d_input_gradient<4>( grad.data(), w.data(), g, input_grad.data() );
+                                ceras_private::winograd_conv2d_weight_gradient<4>( workspace.data(), grad.data(), g, weight_grad.data() );
+                                return std::make_tuple( input_grad, weight_grad );
+                            }
+                            if ( *algorithm == conv2d_algorithm::implicit_gemm )
+                            {
+                                ceras_private::implicit_gemm_conv2d_input_gradient( grad.data(), w.data(), g, input_grad.data() );
+                                ceras_private::implicit_gemm_conv2d_weight_gradient( input.data(), grad.data(), g, weight_grad.data() );
+                                return std::make_tuple( input_grad, weight_grad );
+                            }
+                            // the input gradient of a strided 1x1 convolution is that of its single stride phase, the other pixels being zero
+                            if ( *algorithm == conv2d_algorithm::pointwise )
+                            {
+                                ceras_private::implicit_gemm_conv2d_input_gradient( grad.data(), w.data(), g, input_grad.data() );
+                                ceras_private::pointwise_conv2d_weight_gradient( input.data(), grad.data(), g, weight_grad.data() );
+                                return std::make_tuple( input_grad, weight_grad );
+                            }
+                        }
+
+                        // a chunk of images at a time, the img2col matrix of the forward pass being reused if it holds the whole batch, and computed again otherwise
+                        unsigned long const image_pixels = g.output_rows() * g.output_cols();
+                        unsigned long const images = ceras_private::images_per_chunk<value_type>( g.batch, image_pixels * depth );
+                        bool const whole = images == g.batch && workspace.size() == pixels * depth;
+                        Tsor& col_grad = context_cast<Tsor>( backward_cache );
+                        Tsor& partial_weight_grad = context_cast<Tsor>( chunk_cache );
+                        for ( unsigned long first = 0; first < g.batch; first += images )
+                        {
+                            conv2d_geometry const chunk = ceras_private::chunk_geometry( g, std::min( images, g.batch - first ) );
+                            unsigned long const rows = chunk.pixels();
+                            value_type const* chunk_grad = grad.data() + first * image_pixels * g.filters;
+
+                            // img2col matrix <-- grad * w, scattered back to the input
+                            col_grad.resize( {rows, depth} );
+                            if ( auto const* packed_w = packed_weight( weight, w, false, false, g.filters, depth ); packed_w )
+                                gemm( chunk_grad, false, *packed_w, rows, g.filters, depth, col_grad.data() );
+                            else
+                                gemm( chunk_grad, false, w.data(), false, rows, g.filters, depth, col_grad.data() );
+                            ceras_private::col2img_matrix( col_grad.data(), chunk, input_grad.data() + first * g.rows * g.cols * g.channels );
+
+                            // w <-- grad^T * img2col matrix, summed over the chunks
+                            if ( !whole )
+                            {
+                                workspace.resize( {rows, depth} );
+                                ceras_private::img2col_matrix( input.data() + first * g.rows * g.cols * g.channels, chunk, workspace.data() );
+                            }
+                            if ( first == 0 )
+                            {
+                                gemm( chunk_grad, true, workspace.data(), false, g.filters, rows, depth, weight_grad.data() );
+                                continue;
+                            }
+                            partial_weight_grad.resize( w.shape() );
+                            gemm( chunk_grad, true, workspace.data(), false, g.filters, rows, depth, partial_weight_grad.data() );
+                            for ( unsigned long idx = 0; idx != weight_grad.size(); ++idx )
+                                weight_grad[idx] += partial_weight_grad[idx];
+                        }
+                        return std::make_tuple( input_grad, weight_grad );
+                    };
+                };
+            }
+
+            //
+            // The fastest algorithm of the convolution of `input` with the kernels `w`, forward and backward, saved for the next convolutions of the geometry.
+            // Each candidate runs on the tensors of the convolution, with a gradient of ones, through the forward and backward passes of the operator.
+            //
+            template< Tensor Tsor >
+            static conv2d_algorithm tune( conv2d_geometry const& g, Tsor const& input, Tsor const& w )
+            {
+                typedef typename Tsor::value_type value_type;
+                Tsor grad{ {g.batch, g.output_rows(), g.output_cols(), g.filters} };
+                std::fill( grad.begin(), grad.end(), value_type{1} );
+
+                conv2d_algorithm ans = conv2d_algorithm::automatic;
+                double fastest = std::numeric_limits<double>::max();
+                for ( auto candidate : ceras_private::conv2d_algorithm_candidates<value_type>( g ) )
+                {
+                    std::shared_ptr<std::any> workspace_cache = std::make_shared<std::any>();
+                    std::shared_ptr<std::any> chunk_cache = std::make_shared<std::any>();
+                    std::shared_ptr<conv2d_algorithm> algorithm = std::make_shared<conv2d_algorithm>( candidate );
+                    auto const& forward = conv2d_context{}.make_forward()( std::make_shared<std::any>(), workspace_cache, chunk_cache, algorithm, candidate, std::make_shared<std::any>(),
+                                                                          std::make_shared<ceras_private::quantization_record>(), g, no_weight{} );
+                    auto const& backward = conv2d_context{}.make_backward()( workspace_cache, chunk_cache, std::make_shared<std::any>(), std::make_shared<std::any>(),
+                                                                            std::make_shared<std::any>(), algorithm, g, no_weight{} );
+                    double const elapsed = ceras_private::shortest_time( [&](){ backward( input, w, forward( input, w ), grad ); }, 1 );
+                    if ( elapsed < fastest )
+                    {
+                        fastest = elapsed;
+                        ans = candidate;
+                    }
+                }
+                save_conv2d_algorithm( conv2d_tuning_key<value_type>( g ), ans );
+                return ans;
+            }
+        }; // conv2d_context
+
+        // the convolution of `lhs_ex` with the kernels `rhs_ex`, with the paddings, strides and dilations of `geometry`
+        template< Expression Ex, Expression Ey, typename Serializer >
+        auto make_conv2d( Ex const& lhs_ex, Ey const& rhs_ex, conv2d_geometry const& geometry, std::string const& name, Serializer const& serializer ) noexcept
+        {
+            auto const& shape_calculator = [geometry]( std::vector<unsigned long> const& l, std::vector<unsigned long> const& r ) noexcept
+            {
+                better_assert( l.size() == 4, fmt::format( "expecting l size of 4, but got {}", l.size() ) );
+                better_assert( r.size() == 4, fmt::format( "expecting r size of 4, but got {}", r.size() ) );
+                conv2d_geometry g = geometry;
+                g.rows = l[1];
+                g.cols = l[2];
+                g.kernel_rows = r[1];
+                g.kernel_cols = r[2];
+                return std::vector<unsigned long>{ {l[0], g.output_rows(), g.output_cols(), r[0]} };
+            };
+            std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> workspace_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> chunk_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> backward_cache_input = std::make_shared<std::any>();
+            std::shared_ptr<std::any> backward_cache_weight = std::make_shared<std::any>();
+            std::shared_ptr<conv2d_algorithm> algorithm = std::make_shared<conv2d_algorithm>( conv2d_algorithm::img2col );
+            std::shared_ptr<std::any> selection_cache = std::make_shared<std::any>();
+            auto const& weight = weight_of( rhs_ex );
+            std::shared_ptr<ceras_private::quantization_record> quantization = std::make_shared<ceras_private::quantization_record>();
+            return make_binary_operator( conv2d_context{}.make_forward()( forward_cache, workspace_cache, chunk_cache, algorithm, std::nullopt, selection_cache, quantization, geometry, weight ),
+                                         conv2d_context{}.make_backward()( workspace_cache, chunk_cache, backward_cache, backward_cache_input, backward_cache_weight, algorithm, geometry, weight ),
+                                         name, shape_calculator, serializer )( lhs_ex, rhs_ex );
+        }
+    }//anonymous namespace
+
+    ///
+    /// @brief 2D convolution of an input of fixed shape.
+    ///
+    /// The convolution is a single operator, computed by the algorithm `select_conv2d_algorithm` returns: Winograd for 3x3 kernels of
+    /// unit strides and dilations, a GEMM on the input itself for 1x1 kernels, an implicit GEMM gathering the receptive fields while packing otherwise.
+    /// With `groups` larger than 1, the channels and the filters are split in as many groups, the kernels being of shape [NC, r, c, CH/groups];
+    /// `groups` equal to CH makes a depthwise convolution, computed by a direct kernel per channel.
+    /// With `convolution_algorithm` set to `conv2d_algorithm::autotuned`, the algorithms which apply are timed at the first convolution of each geometry,
+    /// and the fastest is kept for the process and saved to `conv2d_tuning_cache()`, so that later runs start with it.
+    ///
     auto inline conv2d
     (
         unsigned long row_input, unsigned long col_input,
         unsigned long const row_stride=1, unsigned long const col_stride=1,
         unsigned long const row_dilation=1, unsigned long const col_dilation=1,
-        std::string const& padding="valid"
+        std::string const& padding="valid", unsigned long const groups=1
     ) noexcept
     {
         // lhs_ex is for one 4D tensor of [BS, R, C, CH]
@@ -1671,12 +2717,11 @@ namespace ceras
         //
         // Note: the rhs expression is fixed as a variable, as we need to extract the kernel shape from it
         //
-        return [row_input, col_input, row_stride, col_stride, row_dilation, col_dilation, padding ]<Expression Ex, Expression Ey>( Ex const& lhs_ex, Ey const& rhs_ex ) noexcept
+        return [row_input, col_input, row_stride, col_stride, row_dilation, col_dilation, padding, groups ]<Expression Ex, Expression Ey>( Ex const& lhs_ex, Ey const& rhs_ex ) noexcept
         {
             std::vector<unsigned long> const& shape = rhs_ex.shape();
             better_assert( shape.size() == 4 );
             auto const[new_channel, row_kernel, col_kernel, channel] = std::make_tuple( shape[0], shape[1], shape[2], shape[3] );
-            //TODO: optimization in case of small kernels of (1, 1), (3, 3)
             unsigned long row_padding = 0;
             unsigned long col_padding = 0;
             if ( padding == "same" )
@@ -1689,20 +2734,9 @@ namespace ceras
                 col_padding = ((col_kernel&1)+col_padding_total) >> 1;
             }
 
-            unsigned long const row_output = ( row_input + 2 * row_padding - ( row_dilation * (row_kernel - 1) + 1 ) ) / row_stride + 1;
-            unsigned long const col_output = ( col_input + 2 * row_padding - ( col_dilation * (col_kernel - 1) + 1 ) ) / col_stride + 1;
-
-            auto lhs_ex_as_col = img2col(row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation)( lhs_ex ); // [BS, R, C, CH] ==> [r*c*CH, BS*new_row*new_col]
-
-            auto rhs_ex_flatten = reshape({row_kernel*col_kernel*channel,})( rhs_ex ); // [NC, r, c, CH] ==> [NC, r*c*CH]
-
-            auto flatten_output = rhs_ex_flatten * lhs_ex_as_col; // [NC, BS * new_row * new_col]
-
-            auto tr_output = transpose( flatten_output ); // [BS*new_row*new_col, NC]
-
-            auto ans = reshape({row_output, col_output, new_channel})( tr_output );
-
-            return ans;
+            conv2d_geometry const geometry{ 0, row_input, col_input, channel * groups, new_channel, row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation, groups };
+            return make_conv2d( lhs_ex, rhs_ex, geometry, "conv2d",
+                                make_argumented_operator_serializer( row_input, col_input, row_stride, col_stride, row_dilation, col_dilation, fmt::format( "\"{}\"", padding ), groups ) );
         };
     }
 
@@ -1710,11 +2744,15 @@ namespace ceras
     ///
     /// @brief Conv2D not constrained by the input shape.
     ///
+    /// The convolution is a single operator, computed by the algorithm `select_conv2d_algorithm` returns: Winograd for 3x3 kernels of
+    /// unit strides and dilations, a GEMM on the input itself for 1x1 kernels, an implicit GEMM gathering the receptive fields while packing otherwise.
+    /// The kernels are of shape [NC, r, c, CH/groups], see `conv2d` for the grouped and depthwise convolutions.
+    ///
     auto constexpr inline general_conv2d
     (
         unsigned long const row_stride=1, unsigned long const col_stride=1,
         unsigned long const row_dilation=1, unsigned long const col_dilation=1,
-        std::string const& padding="valid"
+        std::string const& padding="valid", unsigned long const groups=1
     ) noexcept
     {
         // lhs_ex is for one 4D tensor of [BS, R, C, CH]
@@ -1723,7 +2761,7 @@ namespace ceras
         //
         // Note: the rhs expression is fixed as a variable, as we need to extract the kernel shape from it
         //
-        return [ row_stride, col_stride, row_dilation, col_dilation, padding ]<Expression Ex, Expression Ey>( Ex const& lhs_ex, Ey const& rhs_ex ) noexcept
+        return [ row_stride, col_stride, row_dilation, col_dilation, padding, groups ]<Expression Ex, Expression Ey>( Ex const& lhs_ex, Ey const& rhs_ex ) noexcept
         {
             auto const& lhs_shape = lhs_ex.shape();
             better_assert( lhs_shape.size() == 4, fmt::format( "expecting lhs_shape size of 4, but got {}", lhs_shape.size() ) );
@@ -1742,20 +2780,9 @@ namespace ceras
                 col_padding = ((col_kernel&1)+col_padding_total) >> 1;
             }
 
-            unsigned long const row_output = ( row_input + 2 * row_padding - ( row_dilation * (row_kernel - 1) + 1 ) ) / row_stride + 1;
-            unsigned long const col_output = ( col_input + 2 * row_padding - ( col_dilation * (col_kernel - 1) + 1 ) ) / col_stride + 1;
-
-            auto lhs_ex_as_col = img2col(row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation)( lhs_ex ); // [BS, R, C, CH] ==> [r*c*CH, BS*new_row*new_col]
-
-            auto rhs_ex_flatten = reshape({row_kernel*col_kernel*channel,})( rhs_ex ); // [NC, r, c, CH] ==> [NC, r*c*CH]
-
-            auto flatten_output = rhs_ex_flatten * lhs_ex_as_col; // [NC, BS * new_row * new_col]
-
-            auto tr_output = transpose( flatten_output ); // [BS*new_row*new_col, NC]
-
-            auto ans = reshape({row_output, col_output, new_channel})( tr_output );
-
-            return ans;
+            conv2d_geometry const geometry{ 0, row_input, col_input, channel * groups, new_channel, row_kernel, col_kernel, row_padding, col_padding, row_stride, col_stride, row_dilation, col_dilation, groups };
+            return make_conv2d( lhs_ex, rhs_ex, geometry, "general_conv2d",
+                                make_argumented_operator_serializer( row_stride, col_stride, row_dilation, col_dilation, fmt::format( "\"{}\"", padding ), groups ) );
         };
     }
 
@@ -1827,7 +2854,7 @@ namespace ceras
 
                     std::vector<unsigned long> const& output_shape = grad.shape();
                     auto [_bs, o_row, o_col, _ch] = std::make_tuple( output_shape[0], output_shape[1], output_shape[2], output_shape[3] );
-                    view_4d<value_type> g_4d{ grad.data(), bs, o_row, o_col, ch };
+                    view_4d<value_type const> g_4d{ grad.data(), bs, o_row, o_col, ch };
 
                     unsigned long row_offset = (padding == std::string{"valid"}) ? (row_kernel-1) : 0;
                     unsigned long col_offset = (padding == std::string{"valid"}) ? (col_kernel-1) : 0;
@@ -1848,9 +2875,168 @@ namespace ceras
         };
     }
 
+    namespace
+    {
+        //
+        // The transposed convolution is the adjoint of the convolution of geometry `transposed_conv2d_geometry`: its forward pass computes the input
+        // gradient of that convolution, and its backward pass the convolution itself and its kernel gradient, on the compact input.
+        //
+        struct conv2d_transpose_context
+        {
+            // the adjoint geometry of the transposed convolution of `input` with the kernels `w`
+            template< Tensor Tsor >
+            static conv2d_geometry make_geometry( conv2d_geometry const& geometry, bool same, Tsor const& input, Tsor const& w ) noexcept
+            {
+                better_assert( input.ndim() == 4, "conv2d_transpose: expecting a 4D input, but got ", input.ndim() );
+                better_assert( w.ndim() == 4, "conv2d_transpose: expecting 4D kernels, but got ", w.ndim() );
+                better_assert( input.shape()[3] == w.shape()[3], "conv2d_transpose: expecting kernels of ", input.shape()[3], " channels, but got ", w.shape()[3] );
+                return ceras_private::transposed_conv2d_geometry( input.shape()[0], input.shape()[1], input.shape()[2], input.shape()[3], w.shape()[0], w.shape()[1], w.shape()[2],
+                                                                  geometry.row_stride, geometry.col_stride, geometry.row_dilation, geometry.col_dilation, same );
+            }
+
+            // the first row and column of the output of geometry g kept by the transposed convolution of `input`, 1 where the output is cropped
+            template< Tensor Tsor >
+            static std::tuple<unsigned long, unsigned long> make_crop( conv2d_geometry const& g, bool same, Tsor const& input ) noexcept
+            {
+                if ( !same )
+                    return std::make_tuple( 0UL, 0UL );
+                return std::make_tuple( g.rows - input.shape()[1] * g.row_stride, g.cols - input.shape()[2] * g.col_stride );
+            }
+
+            // true for the implicit GEMM, false for a GEMM followed by col2img; not tuned
+            template< typename T >
+            static bool implicit( conv2d_geometry const& g ) noexcept
+            {
+                conv2d_algorithm const setting = ( convolution_algorithm == conv2d_algorithm::autotuned ) ? conv2d_algorithm::automatic : convolution_algorithm;
+                return std::floating_point<T> && select_conv2d_algorithm<T>( g, setting ) != conv2d_algorithm::img2col;
+            }
+
+            auto make_forward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> forward_cache, std::shared_ptr<std::any> kernels_cache, std::shared_ptr<std::any> workspace_cache,
+                           std::shared_ptr<std::any> uncropped_cache, conv2d_geometry geometry, bool same ) noexcept
+                {
+                    return [=]<Tensor Tsor>( Tsor const& input, Tsor const& w ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        conv2d_geometry const g = make_geometry( geometry, same, input, w );
+                        unsigned long const depth = g.depth();
+                        auto const [row_crop, col_crop] = make_crop( g, same, input );
+
+                        // [CH, NC*r*c] kernels of the adjoint convolution
+                        Tsor& kernels = context_cast<Tsor>( kernels_cache );
+                        kernels.resize( {g.filters, depth} );
+                        for ( unsigned long ch = 0; ch != g.filters; ++ch )
+                            for ( unsigned long nc = 0; nc != g.channels; ++nc )
+                                for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                                    for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                                        kernels[ch*depth+(nc*g.kernel_rows+r)*g.kernel_cols+c] = w[ceras_private::transposed_conv2d_kernel_offset( g, ch, nc, r, c )];
+
+                        Tsor& ans = context_cast<Tsor>( forward_cache );
+                        ans.resize( {g.batch, g.rows - row_crop, g.cols - col_crop, g.channels} );
+                        Tsor& output = ( row_crop || col_crop ) ? context_cast<Tsor>( uncropped_cache ) : ans;
+                        output.resize( {g.batch, g.rows, g.cols, g.channels} );
+
+                        bool done = false;
+                        if constexpr( std::floating_point<value_type> )
+                        {
+                            if ( implicit<value_type>( g ) )
+                            {
+                                ceras_private::implicit_gemm_conv2d_input_gradient( input.data(), kernels.data(), g, output.data() );
+                                done = true;
+                            }
+                        }
+                        if ( !done )
+                        {
+                            // img2col matrix <-- input * kernels, scattered to the output
+                            Tsor& workspace = context_cast<Tsor>( workspace_cache );
+                            workspace.resize( {g.pixels(), depth} );
+                            gemm( input.data(), false, kernels.data(), false, g.pixels(), g.filters, depth, workspace.data() );
+                            ceras_private::col2img_matrix( workspace.data(), g, output.data() );
+                        }
+
+                        if ( row_crop || col_crop )
+                            for ( unsigned long b = 0; b != g.batch; ++b )
+                                for ( unsigned long r = row_crop; r != g.rows; ++r )
+                                    std::copy_n( output.data() + ( ( b * g.rows + r ) * g.cols + col_crop ) * g.channels, ( g.cols - col_crop ) * g.channels,
+                                                 ans.data() + ( b * ( g.rows - row_crop ) + r - row_crop ) * ( g.cols - col_crop ) * g.channels );
+                        return ans;
+                    };
+                };
+            }
+
+            auto make_backward() const noexcept
+            {
+                return []( std::shared_ptr<std::any> kernels_cache, std::shared_ptr<std::any> workspace_cache, std::shared_ptr<std::any> uncropped_cache,
+                           std::shared_ptr<std::any> backward_cache_input, std::shared_ptr<std::any> backward_cache_weight, conv2d_geometry geometry, bool same ) noexcept
+                {
+                    return [=]<Tensor Tsor>( Tsor const& input, Tsor const& w, [[maybe_unused]] Tsor const& output, Tsor const& cropped_grad ) noexcept
+                    {
+                        typedef typename Tsor::value_type value_type;
+                        conv2d_geometry const g = make_geometry( geometry, same, input, w );
+                        unsigned long const depth = g.depth();
+                        auto const [row_crop, col_crop] = make_crop( g, same, input );
+                        Tsor const& kernels = context_cast<Tsor>( kernels_cache );
+
+                        // the gradient of the cropped rows and columns is zero
+                        Tsor const* grad_pointer = &cropped_grad;
+                        if ( row_crop || col_crop )
+                        {
+                            Tsor& uncropped = context_cast<Tsor>( uncropped_cache );
+                            uncropped.resize( {g.batch, g.rows, g.cols, g.channels} );
+                            std::fill( uncropped.begin(), uncropped.end(), value_type{0} );
+                            for ( unsigned long b = 0; b != g.batch; ++b )
+                                for ( unsigned long r = row_crop; r != g.rows; ++r )
+                                    std::copy_n( cropped_grad.data() + ( b * ( g.rows - row_crop ) + r - row_crop ) * ( g.cols - col_crop ) * g.channels, ( g.cols - col_crop ) * g.channels,
+                                                 uncropped.data() + ( ( b * g.rows + r ) * g.cols + col_crop ) * g.channels );
+                            grad_pointer = &uncropped;
+                        }
+                        Tsor const& grad = *grad_pointer;
+
+                        Tsor& input_grad = context_cast<Tsor>( backward_cache_input );
+                        input_grad.resize( input.shape() );
+                        Tsor& weight_grad = context_cast<Tsor>( backward_cache_weight );
+                        weight_grad.resize( w.shape() );
+
+                        // [CH, NC*r*c] gradient of the kernels of the adjoint convolution, in the workspace
+                        Tsor& workspace = context_cast<Tsor>( workspace_cache );
+                        bool done = false;
+                        if constexpr( std::floating_point<value_type> )
+                        {
+                            if ( implicit<value_type>( g ) )
+                            {
+                                ceras_private::implicit_gemm_conv2d( grad.data(), kernels.data(), static_cast<packed_matrix<value_type> const*>( nullptr ), g, input_grad.data() );
+                                workspace.resize( {g.filters, depth} );
+                                ceras_private::implicit_gemm_conv2d_weight_gradient( grad.data(), input.data(), g, workspace.data() );
+                                done = true;
+                            }
+                        }
+                        if ( !done )
+                        {
+                            Tsor col{ {g.pixels(), depth} };
+                            ceras_private::img2col_matrix( grad.data(), g, col.data() );
+                            gemm( col.data(), false, kernels.data(), true, g.pixels(), depth, g.filters, input_grad.data() );
+                            workspace.resize( {g.filters, depth} );
+                            gemm( input.data(), true, col.data(), false, g.filters, g.pixels(), depth, workspace.data() );
+                        }
+
+                        for ( unsigned long ch = 0; ch != g.filters; ++ch )
+                            for ( unsigned long nc = 0; nc != g.channels; ++nc )
+                                for ( unsigned long r = 0; r != g.kernel_rows; ++r )
+                                    for ( unsigned long c = 0; c != g.kernel_cols; ++c )
+                                        weight_grad[ceras_private::transposed_conv2d_kernel_offset( g, ch, nc, r, c )] = workspace[ch*depth+(nc*g.kernel_rows+r)*g.kernel_cols+c];
+                        return std::make_tuple( input_grad, weight_grad );
+                    };
+                };
+            }
+        }; // conv2d_transpose_context
+    }//anonymous namespace
 
     ///
-    /// @brief Conv2D Transpose
+    /// @brief Transposed 2D convolution, the adjoint of `conv2d`, computed on the input directly.
+    ///
+    /// The output is of (R-1)*row_stride + row_dilation*(row_kernel-1) + 1 rows for the `valid` padding, and of R*row_stride rows for the `same` padding.
+    /// No zero-inserted input is built: the output is gathered by an implicit GEMM, or scattered from the product of the input with the kernels by col2img.
     ///
     auto inline conv2d_transpose
     (
@@ -1869,9 +3055,31 @@ namespace ceras
         //
         return [ row_kernel, col_kernel, row_stride, col_stride, row_dilation, col_dilation, padding ]<Expression Ex, Expression Ey>( Ex const& lhs_ex, Ey const& rhs_ex ) noexcept
         {
-            //auto new_lhs_ex = conv2d_tranpose_intermediate( row_kernel, col_kernel, row_stride, col_stride, padding )( lhs_ex );
-            auto new_lhs_ex = conv2d_tranpose_intermediate( row_kernel, col_kernel, row_stride, col_stride, padding )( lhs_ex );
-            return general_conv2d( row_stride, col_stride, row_dilation, col_dilation, padding )( new_lhs_ex, flip(1)(flip(2)(rhs_ex)) );
+            std::vector<unsigned long> const& shape = rhs_ex.shape();
+            better_assert( shape.size() == 4 );
+            better_assert( shape[1] == row_kernel && shape[2] == col_kernel, "conv2d_transpose: expecting kernels of ", row_kernel, "x", col_kernel, ", but got ", shape[1], "x", shape[2] );
+            bool const same = ( padding == "same" );
+            conv2d_geometry const geometry{ 0, 0, 0, 0, 0, row_kernel, col_kernel, 0, 0, row_stride, col_stride, row_dilation, col_dilation };
+            auto const& shape_calculator = [geometry, same]( std::vector<unsigned long> const& l, std::vector<unsigned long> const& r ) noexcept
+            {
+                better_assert( l.size() == 4, fmt::format( "expecting l size of 4, but got {}", l.size() ) );
+                better_assert( r.size() == 4, fmt::format( "expecting r size of 4, but got {}", r.size() ) );
+                if ( same )
+                    return std::vector<unsigned long>{ {l[0], l[1] * geometry.row_stride, l[2] * geometry.col_stride, r[0]} };
+                conv2d_geometry const g = ceras_private::transposed_conv2d_geometry( l[0], l[1], l[2], l[3], r[0], r[1], r[2], geometry.row_stride, geometry.col_stride,
+                                                                                     geometry.row_dilation, geometry.col_dilation, same );
+                return std::vector<unsigned long>{ {l[0], g.rows, g.cols, r[0]} };
+            };
+            std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> kernels_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> workspace_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> uncropped_cache = std::make_shared<std::any>();
+            std::shared_ptr<std::any> backward_cache_input = std::make_shared<std::any>();
+            std::shared_ptr<std::any> backward_cache_weight = std::make_shared<std::any>();
+            return make_binary_operator( conv2d_transpose_context{}.make_forward()( forward_cache, kernels_cache, workspace_cache, uncropped_cache, geometry, same ),
+                                         conv2d_transpose_context{}.make_backward()( kernels_cache, workspace_cache, uncropped_cache, backward_cache_input, backward_cache_weight, geometry, same ),
+                                         "conv2d_transpose", shape_calculator,
+                                         make_argumented_operator_serializer( row_kernel, col_kernel, row_stride, col_stride, row_dilation, col_dilation, fmt::format( "\"{}\"", padding ) ) )( lhs_ex, rhs_ex );
         };
     }
 
@@ -2296,11 +3504,22 @@ namespace ceras
                     Tsor& average = context_cast<Tsor>( average_cache );
                     {
                         average.resize( {channels, } );
-                        std::fill( average.begin(), average.end(), value_type{0} );
-
-                        for ( auto idx : range( rest_dims ) )
-                            for ( auto jdx : range( channels ) )
-                                average[jdx] += input_[idx][jdx];
+                        // partial sums of consecutive rows, added in order
+                        std::vector<value_type> const sums = parallel_reduce( rest_dims, std::vector<value_type>( channels, value_type{0} ),
+                        [&]( unsigned long first, unsigned long last, std::vector<value_type> partial )
+                        {
+                            for ( auto idx : range( first, last ) )
+                                for ( auto jdx : range( channels ) )
+                                    partial[jdx] += input_[idx][jdx];
+                            return partial;
+                        },
+                        []( std::vector<value_type> lhs, std::vector<value_type> const& rhs )
+                        {
+                            for ( auto jdx : range( lhs.size() ) )
+                                lhs[jdx] += rhs[jdx];
+                            return lhs;
+                        }, static_cast<double>( channels ) );
+                        std::copy( sums.begin(), sums.end(), average.begin() );
 
                         average /= static_cast<value_type>(rest_dims);
                     }
@@ -2309,10 +3528,21 @@ namespace ceras
                     Tsor& variance = context_cast<Tsor>( variance_cache );
                     {
                         variance.resize( {channels,} );
-                        std::fill( variance.begin(), variance.end(), value_type{0} );
-                        for ( auto idx : range( rest_dims ) )
-                            for ( auto jdx : range( channels ) )
-                                variance[jdx] += std::pow( input_[idx][jdx] - average[jdx], 2 );
+                        std::vector<value_type> const squares = parallel_reduce( rest_dims, std::vector<value_type>( channels, value_type{0} ),
+                        [&]( unsigned long first, unsigned long last, std::vector<value_type> partial )
+                        {
+                            for ( auto idx : range( first, last ) )
+                                for ( auto jdx : range( channels ) )
+                                    partial[jdx] += std::pow( input_[idx][jdx] - average[jdx], 2 );
+                            return partial;
+                        },
+                        []( std::vector<value_type> lhs, std::vector<value_type> const& rhs )
+                        {
+                            for ( auto jdx : range( lhs.size() ) )
+                                lhs[jdx] += rhs[jdx];
+                            return lhs;
+                        }, 3.0 * static_cast<double>( channels ) );
+                        std::copy( squares.begin(), squares.end(), variance.begin() );
 
                         variance /= static_cast<value_type>( rest_dims );
                     }
@@ -2321,11 +3551,11 @@ namespace ceras
                     Tsor& ans = context_cast<Tsor>( forward_cache );
                     ans.resize( input.shape() ); // the batch sizes for training and for prediction are not necessarily same
                     view_2d<value_type> ans_{ ans.data(), rest_dims, channels };
+                    parallel_for( [&]( unsigned long idx )
                     {
-                        for ( auto idx : range( rest_dims ) )
-                            for ( auto jdx : range( channels ) )
-                                ans_[idx][jdx] = ( input_[idx][jdx] - average[jdx] ) / std::sqrt( variance[jdx] + eps );
-                    }
+                        for ( auto jdx : range( channels ) )
+                            ans_[idx][jdx] = ( input_[idx][jdx] - average[jdx] ) / std::sqrt( variance[jdx] + eps );
+                    }, rest_dims, 20.0 * static_cast<double>( channels ) );
 
                     // update global average and global variance
                     {
@@ -3513,9 +4743,10 @@ namespace ceras
                         view_3d v3{ input.data(), iterations, scales, stride }; // example: viewing as a tube of ( 2, 3, 20 )
 
                         // reduce sum along the selected axis
-                        for ( auto it : range( iterations ) ) // example: range (2)
-                            for ( auto st : range( stride ) ) // example: range (20)
-                                v2[it][st] = std::accumulate( v3[it].col_begin(st), v3[it].col_end(st), value_type{0} );
+                        parallel_for( [&]( unsigned long it, unsigned long st ) // example: ranges (2) and (20)
+                        {
+                            v2[it][st] = std::accumulate( v3[it].col_begin(st), v3[it].col_end(st), value_type{0} );
+                        }, iterations, stride, static_cast<double>( scales ) );
 
                         return ans;
                     };
@@ -3543,9 +4774,10 @@ namespace ceras
                         view_3d v3{ ans.data(), iterations, scales, stride }; // example: view as a cube of ( 2, 3, 20 )
                         view_2d v2{ grad.data(), iterations, stride }; // example: viewing as a matrix of ( 2, 20 )
 
-                        for ( auto it : range( iterations ) ) // example: range( 2 )
-                            for ( auto st : range( stride ) ) // example: range( 20 )
-                                std::fill( v3[it].col_begin( st ), v3[it].col_end( st ), v2[it][st] );
+                        parallel_for( [&]( unsigned long it, unsigned long st ) // example: ranges (2) and (20)
+                        {
+                            std::fill( v3[it].col_begin( st ), v3[it].col_end( st ), v2[it][st] );
+                        }, iterations, stride, static_cast<double>( scales ) );
 
                         return ans;
                     };
@@ -4783,18 +6015,15 @@ namespace ceras
     {
         std::shared_ptr<std::any> forward_cache = std::make_shared<std::any>();
         std::shared_ptr<std::any> backward_cache = std::make_shared<std::any>();
-        return make_unary_operator( [forward_cache]<Tensor Tsor>( Tsor const& input ) noexcept
+        return make_unary_operator( ceras_private::elementwise_forward{ forward_cache, []<Tensor Tsor>( Tsor const& input, Tsor& output ) noexcept
                                     {
-                                        Tsor& ans = context_cast<Tsor>( forward_cache );
-                                        ans.resize( input.shape() );
-                                        for_each( input.begin(), input.end(), ans.begin(), []( auto x, auto& v ) noexcept { v = std::tanh(x); } );
-                                        return ans;
-                                    },
-                                    [backward_cache]<Tensor Tsor>( Tsor const& input, Tsor const& output, Tsor const& grad ) noexcept
+                                        for_each( input.begin(), input.end(), output.begin(), []( auto x, auto& v ) noexcept { v = std::tanh(x); } );
+                                    } },
+                                    [backward_cache]<Tensor Tsor>( Tsor const&, Tsor const& output, Tsor const& grad ) noexcept // not reading the input, which may be overwritten by the output
                                     {
                                         Tsor& ans = context_cast<Tsor>( backward_cache );
-                                        ans.resize( input.shape() );
-                                        for_each( input.begin(), input.end(), output.begin(), grad.begin(), ans.begin(), []( auto, auto o, auto g, auto& v ) noexcept { v = g * (1.0-o*o); } );
+                                        ans.resize( output.shape() );
+                                        for_each( output.begin(), output.end(), grad.begin(), ans.begin(), []( auto o, auto g, auto& v ) noexcept { v = g * (1.0-o*o); } );
                                         return ans;
                                     },
                                     "tanh"
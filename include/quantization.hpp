@@ -0,0 +1,96 @@
+#ifndef QUANTIZATION_HPP_INCLUDED_HTKWMZQBXNRJVLPEYDGOCSAUIFQKMZRTXWHVNLJBPYEGDOCSAU
+#define QUANTIZATION_HPP_INCLUDED_HTKWMZQBXNRJVLPEYDGOCSAUIFQKMZRTXWHVNLJBPYEGDOCSAU
+
+#include "./includes.hpp"
+#include "./config.hpp"
+#include "./tensor.hpp"
+#include "./variable.hpp"
+#include "./backend/cpu_int8.hpp"
+
+namespace ceras
+{
+
+    ///
+    /// @brief How the products between the activations and the weights are computed.
+    ///
+    enum class quantization_mode
+    {
+        none,           ///< in float
+        calibration,    ///< in float, recording the range of the activations
+        int8            ///< in int8, for the products calibrated before
+    };
+
+    ///
+    /// @brief Quantization phase flag, set by `model::quantize` and `model::predict`.
+    ///
+    /// Setting it to `quantization_mode::int8` runs the matrix multiplications of Dense and Conv2D layers whose activations have been calibrated
+    /// with int8 weights and activations, as a model returned by `model::quantize` does in `predict`.
+    ///
+    inline quantization_mode quantization_phase = quantization_mode::none;
+
+    namespace ceras_private
+    {
+        //
+        // The quantization state of a product between an activation and a weight variable:
+        // the largest magnitude of the activation seen during calibration, and the int8 copy of the weight, refreshed when the variable is written.
+        //
+        struct quantization_record
+        {
+            float activation_range_ = 0.0f;
+            quantized_matrix weight_;
+            bool as_lhs_ = false;
+            bool transposed_ = false;
+            unsigned long weight_version_ = -1UL;
+        };
+
+        //
+        // Compute output <= epilogue( activation * weight ), or epilogue( weight * activation ) if `weight_is_lhs`, according to `quantization_phase`,
+        // the weight being read transposed if `weight_transposed`:
+        // recording the range of the activation and returning false during calibration, multiplying in int8 and returning true if calibrated,
+        // and returning false otherwise, leaving the product to the caller.
+        //
+        template< typename Weight, Tensor Tsor, typename Epilogue = no_epilogue >
+        bool quantized_gemm( std::shared_ptr<quantization_record> record, Weight const& weight, Tsor const& weight_tensor, Tsor const& activation, bool weight_is_lhs, bool weight_transposed,
+                             unsigned long m, unsigned long n, unsigned long k, Tsor& output, Epilogue const& epilogue = Epilogue{} )
+        {
+            if constexpr( is_variable_v<Weight> && std::is_same_v<typename Tsor::value_type, float> && !cuda_mode )
+            {
+                if ( quantization_phase == quantization_mode::none || !weight.state_ || weight.state_->data_.data() != weight_tensor.data() || weight_tensor.size() != n * ( weight_is_lhs ? m : k ) )
+                    return false;
+
+                if ( quantization_phase == quantization_mode::calibration )
+                {
+                    record->activation_range_ = std::max( record->activation_range_, max_magnitude( activation.data(), activation.size() ) );
+                    return false;
+                }
+
+                if ( record->activation_range_ <= 0.0f )
+                    return false;
+
+                auto const& state = *(weight.state_);
+                if ( record->weight_.empty() || record->weight_version_ != state.version_ || record->as_lhs_ != weight_is_lhs || record->transposed_ != weight_transposed || record->weight_.panels_.isa_ != current_isa()
+                     || record->weight_.rows_ != ( weight_is_lhs ? m : n ) || record->weight_.cols_ != ( weight_is_lhs ? n : k ) )
+                {
+                    record->weight_ = weight_is_lhs ? cpu_quantize_lhs( weight_tensor.data(), weight_transposed, m, n ) : cpu_quantize_rhs( weight_tensor.data(), weight_transposed, n, k );
+                    record->as_lhs_ = weight_is_lhs;
+                    record->transposed_ = weight_transposed;
+                    record->weight_version_ = state.version_;
+                }
+
+                output.resize( {m, k} );
+                if ( weight_is_lhs )
+                    cpu_gemm_int8( record->weight_, activation.data(), false, record->activation_range_, m, n, k, output.data(), epilogue );
+                else
+                    cpu_gemm_int8( activation.data(), false, record->activation_range_, record->weight_, m, n, k, output.data(), epilogue );
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }//namespace ceras_private
+
+}//namespace ceras
+
+#endif//QUANTIZATION_HPP_INCLUDED_HTKWMZQBXNRJVLPEYDGOCSAUIFQKMZRTXWHVNLJBPYEGDOCSAU
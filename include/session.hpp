@@ -5,6 +5,7 @@
 #include "./tensor.hpp"
 #include "./place_holder.hpp"
 #include "./variable.hpp"
+#include "./memory_planner.hpp"
 #include "./utils/singleton.hpp"
 #include "./utils/debug.hpp"
 #include "./utils/lzw.hpp"
@@ -27,6 +28,12 @@ namespace ceras
         std::vector<place_holder_type> place_holders_;
         std::unordered_map<int, variable_type> variables_;
         std::unordered_map<int, tensor_type> forward_cache_;
+        std::unordered_map<int, unsigned long> consumers_; // the number of the operators reading each operator in the graph last run
+
+        std::unique_ptr<memory_tracer<tensor_type>> tracer_; // only while tracing a pass for the memory planner
+        std::shared_ptr<typename tensor_type::vector_type> memory_arena_;
+        std::vector<std::weak_ptr<typename tensor_type::vector_type>> planned_buffers_;
+        int planned_learning_phase_ = 0;
 
         session() { }
 
@@ -58,10 +65,135 @@ namespace ceras
         template< typename Operation >
         auto run( Operation& op )
         {
+            if ( memory_arena_ && planned_learning_phase_ != learning_phase )
+                release_memory_plan();
+
             clear_forward_cache();
+            count_consumers( op );
             return op.forward();
         }
 
+        ///
+        /// @brief Plan the memory of the buffers of an expression, placing them in a single arena.
+        ///
+        /// Runs the expression once, and its backward pass as well in the learning phase, tracing when each output and each gradient is used.
+        /// The buffers whose lifetimes do not overlap then share the same bytes of the arena, as long as their sizes do not change.
+        /// The result of `op`, the tensors of the variables and the place holders, and the temporaries released in the pass are not planned.
+        /// The plan is released when the learning phase changes, or by `release_memory_plan`.
+        ///
+        /// @param op The expression. In the learning phase, it should be the loss, from which the backward pass starts.
+        /// @return A summary of the plan.
+        ///
+        /// Example code:
+        /// \code{.cpp}
+        /// auto& s = get_default_session<tensor<float>>();
+        /// s.bind( x, x_batch );
+        /// s.bind( y, y_batch );
+        /// auto const& plan = s.plan_memory( loss );
+        /// std::cout << plan << std::endl;
+        /// \endcode
+        ///
+        template< typename Operation >
+        memory_plan plan_memory( Operation& op )
+        {
+            typedef typename tensor_type::value_type value_type;
+            release_memory_plan();
+
+            tracer_ = std::make_unique<memory_tracer<tensor_type>>();
+            clear_forward_cache();
+            count_consumers( op );
+            tensor_type const output = op.forward();
+            if ( learning_phase == 1 )
+                op.backward( ones<value_type>( {1, } ) );
+            tracer_->exclude( output );
+            auto buffers = std::move( (*tracer_).buffers_ );
+            tracer_.reset();
+
+            // the storage of a temporary is released in the pass, and a new one is allocated at the next
+            std::erase_if( buffers, []( auto const& buffer ) { return buffer.external_ || buffer.storage_.use_count() == 1; } );
+            std::vector<memory_interval> intervals;
+            for ( auto const& buffer : buffers )
+                intervals.push_back( memory_interval{ (*(buffer.storage_)).size() * sizeof(value_type), buffer.first_, buffer.last_ } );
+            auto const& [offsets, arena_bytes] = interval_coloring( intervals );
+
+            memory_plan ans;
+            ans.buffers = buffers.size();
+            ans.peak_bytes = live_bytes_peak( intervals );
+            ans.arena_bytes = arena_bytes;
+            for ( auto const& interval : intervals )
+                ans.unplanned_bytes += interval.bytes;
+
+            static_assert( memory_alignment % sizeof(value_type) == 0, "The elements should not straddle the alignment." );
+            memory_arena_ = std::make_shared<typename tensor_type::vector_type>( arena_bytes / sizeof(value_type) );
+            for ( auto idx : range( buffers.size() ) )
+            {
+                auto& storage = *(buffers[idx].storage_);
+                storage.borrow( (*memory_arena_).data() + offsets[idx] / sizeof(value_type), storage.size() );
+                planned_buffers_.emplace_back( buffers[idx].storage_ );
+            }
+            planned_learning_phase_ = learning_phase;
+            return ans;
+        }
+
+        ///
+        /// @brief Give back to the planned buffers their own storage, copying their current values, and free the arena.
+        ///
+        void release_memory_plan()
+        {
+            for ( auto const& planned : planned_buffers_ )
+            {
+                auto storage = planned.lock();
+                if ( !storage || !(*storage).borrowed() )
+                    continue;
+                typename tensor_type::vector_type owned( (*storage).size() );
+                std::copy_n( (*storage).data(), (*storage).size(), owned.data() );
+                *storage = std::move( owned );
+            }
+            planned_buffers_.clear();
+            memory_arena_.reset();
+        }
+
+        // counts the operators reading each operator in the graph of `op`, walking the operators read by several ones only once
+        template< typename Operation >
+        void count_consumers( Operation const& op )
+        {
+            consumers_.clear();
+            auto const& walk = [this]<typename Ex>( Ex const& ex, auto const& _walk ) -> void
+            {
+                auto const& read = [this, &_walk]<typename Input>( Input const& input )
+                {
+                    if constexpr( requires { input.op(); } || requires { input.lhs_op(); } )
+                        if ( ++consumers_[input.id()] == 1 )
+                            _walk( input, _walk );
+                };
+                if constexpr( requires { ex.op(); } )
+                    read( ex.op() );
+                if constexpr( requires { ex.lhs_op(); ex.rhs_op(); } )
+                {
+                    read( ex.lhs_op() );
+                    read( ex.rhs_op() );
+                }
+            };
+            walk( op, walk );
+        }
+
+        ///
+        /// @brief The number of the operators reading the output of an operator in the graph last run, `0` if not in this graph.
+        ///
+        /// An elementwise operator, such as `relu`, `sigmoid`, `tanh` or `softmax`, overwrites its input with its output when it is the only one reading it.
+        ///
+        unsigned long consumers( int operation_id ) const
+        {
+            auto itor = consumers_.find( operation_id );
+            return itor == consumers_.end() ? 0UL : (*itor).second;
+        }
+
+        // the tracer of the memory planner, or a nullptr when no pass is being traced
+        memory_tracer<tensor_type>* tracer() noexcept
+        {
+            return tracer_.get();
+        }
+
         // register variables associated to the op to this session
         // usually being called before restoring a session from a file
         template< typename Operation >
@@ -169,6 +301,8 @@ namespace ceras
 
         ~session()
         {
+            release_memory_plan();
+
             for ( auto& p_holder : place_holders_ )
                 p_holder.reset();
 
@@ -2,6 +2,9 @@
 #define HQKGLAXWWVFBFHQNHBVTQJKGUFTPCQPTPXDVNOSBDJIBHITCEKDISJYNAMCPLJDURURDAISFV
 
 #include "./backend/cblas.hpp"
+#include "./backend/cpu.hpp"
+#include "./backend/cpu_float16.hpp"
+#include "./backend/cpu_tuner.hpp"
 #include "./backend/cuda.hpp"
 #include "./config.hpp"
 #include "./includes.hpp"
@@ -474,7 +477,10 @@ namespace ceras
         constexpr auto as_type() const noexcept
         {
             tensor<U, typename std::allocator_traits<Allocator>:: template rebind_alloc<U>> ans{ (*this).shape() };
-            std::copy( (*this).begin(), (*this).end(), ans.begin() );
+            if constexpr( ( half_precision<T> && std::is_same_v<U, float> ) || ( std::is_same_v<T, float> && half_precision<U> ) )
+                convert( (*this).data(), (*this).size(), ans.data() ); // vectorized rounding and widening
+            else
+                std::copy( (*this).begin(), (*this).end(), ans.begin() );
             return ans;
         }
     }; // struct tensor
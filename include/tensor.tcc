@@ -425,8 +425,9 @@ namespace ceras
 
     // C <= A * B
     // where A or A' is [m x n], B or B' is [n x k] and C is [m x k]
+    // reference implementation, kept for testing and benchmarking `gemm_cpu`
     template< typename T > requires std::floating_point<T>
-    void gemm_cpu( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    void gemm_cpu_naive( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
     {
         auto a_view = view_2d{ A, m, n, a_transposed };
         auto b_view = view_2d{ B, n, k, b_transposed };
@@ -456,6 +457,14 @@ namespace ceras
                         c_view[r][c] += a_view[idx][r] * b_view[c][idx];
     }
 
+    // C <= A * B
+    // where A or A' is [m x n], B or B' is [n x k] and C is [m x k]
+    template< typename T > requires std::floating_point<T>
+    void gemm_cpu( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        cpu_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+    }
+
     // this function is used to update the threshod 'cuda_gemm_threshold' defined in '../config.hpp', only considering float case
     inline void update_cuda_gemm_threshold()
     {
@@ -528,6 +537,8 @@ namespace ceras
         if ( cuda_gemm_threshold == 0 ) // global variable defined in config.h
             update_cuda_gemm_threshold();
 
+        auto_tune_cpu_gemm();
+
         if constexpr( cuda_mode )
         {
             unsigned long const operations = m * n * k;
@@ -537,7 +548,12 @@ namespace ceras
             else
             {
                 if constexpr( cblas_mode )
-                    cblas_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+                {
+                    if ( operations >= get_cpu_gemm_config().cblas_threshold )
+                        cblas_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+                    else
+                        gemm_cpu( A, a_transposed, B, b_transposed, m, n, k, C );
+                }
                 else
                     gemm_cpu( A, a_transposed, B, b_transposed, m, n, k, C );
             }
@@ -545,13 +561,73 @@ namespace ceras
         else
         {
             if constexpr( cblas_mode )
-                cblas_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+            {
+                if ( m * n * k >= get_cpu_gemm_config().cblas_threshold ) // crossover measured by `tune_cpu_gemm`
+                    cblas_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+                else
+                    gemm_cpu( A, a_transposed, B, b_transposed, m, n, k, C );
+            }
             else
                 gemm_cpu( A, a_transposed, B, b_transposed, m, n, k, C );
         }
     }
 
-    template< typename T >  requires std::floating_point<T> // this one only for non-transposed 2d View
+    // C <= A * B for 16-bit floats, widened while packed and accumulated in float by `cpu_gemm`, whichever backend handles float
+    template< half_precision T >
+    void gemm( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        auto_tune_cpu_gemm();
+        cpu_gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+    }
+
+    // C <= epilogue( A * B ) for 16-bit floats, the epilogue working on the float accumulators
+    template< half_precision T, typename Epilogue >
+    void gemm( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C, Epilogue const& epilogue )
+    {
+        auto_tune_cpu_gemm();
+        cpu_gemm( A, a_transposed, B, b_transposed, m, n, k, C, epilogue );
+    }
+
+    // C <= A * B, with A packed in advance by `cpu_pack_lhs`
+    // packed operands are only produced and consumed when neither CUDA nor CBLAS is enabled
+    template< typename T > requires std::floating_point<T>
+    void gemm( packed_matrix<T> const& A, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        cpu_gemm( A, B, b_transposed, m, n, k, C );
+    }
+
+    // C <= A * B, with B packed in advance by `cpu_pack_rhs`
+    template< typename T > requires std::floating_point<T>
+    void gemm( T const* A, bool a_transposed, packed_matrix<T> const& B, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        cpu_gemm( A, a_transposed, B, m, n, k, C );
+    }
+
+    // C <= epilogue( A * B ), with the epilogue of `cpu_gemm` applied to the blocks of C while in cache,
+    // or to the whole C after the product if gemm is done by CUDA or CBLAS
+    template< typename T, typename Epilogue > requires std::floating_point<T>
+    void gemm( T const* A, bool a_transposed, T const* B, bool b_transposed, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C, Epilogue const& epilogue )
+    {
+        if constexpr( cuda_mode || cblas_mode )
+        {
+            gemm( A, a_transposed, B, b_transposed, m, n, k, C );
+            epilogue( C, k, 0UL, m, 0UL, k );
+        }
+        else
+        {
+            auto_tune_cpu_gemm();
+            cpu_gemm( A, a_transposed, B, b_transposed, m, n, k, C, epilogue );
+        }
+    }
+
+    // C <= epilogue( A * B ), with B packed in advance by `cpu_pack_rhs`
+    template< typename T, typename Epilogue > requires std::floating_point<T>
+    void gemm( T const* A, bool a_transposed, packed_matrix<T> const& B, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C, Epilogue const& epilogue )
+    {
+        cpu_gemm( A, a_transposed, B, m, n, k, C, epilogue );
+    }
+
+    template< typename T >  requires std::floating_point<T> || half_precision<T> // this one only for non-transposed 2d View
     void gemm( view_2d<T> const& x, view_2d<T> const& y, view_2d<T>& ans ) //note: direct copy of x and y
     {
         auto const [x_row, x_col] = x.shape();
@@ -565,6 +641,34 @@ namespace ceras
         gemm( x.data(), x.transposed_, y.data(), y.transposed_, x_row, x_col, y_col, ans.data() );
     }
 
+    // C[b] <= A[b] * B[b] for b in [0, batch)
+    // where A[b] or A[b]' is [m x n], B[b] or B[b]' is [n x k] and C[b] is [m x k]
+    // a zero stride broadcasts the same matrix to all the problems
+    template< typename T > requires std::floating_point<T>
+    void batched_gemm( T const* A, bool a_transposed, unsigned long a_stride, T const* B, bool b_transposed, unsigned long b_stride,
+                       unsigned long batch, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        if constexpr( cuda_mode || cblas_mode )
+        {
+            for ( auto b : range( batch ) )
+                gemm( A + b*a_stride, a_transposed, B + b*b_stride, b_transposed, m, n, k, C + b*m*k );
+        }
+        else
+        {
+            auto_tune_cpu_gemm();
+            cpu_batched_gemm( A, a_transposed, a_stride, B, b_transposed, b_stride, batch, m, n, k, C );
+        }
+    }
+
+    // C[b] <= A[b] * B[b] for 16-bit floats, accumulated in float
+    template< half_precision T >
+    void batched_gemm( T const* A, bool a_transposed, unsigned long a_stride, T const* B, bool b_transposed, unsigned long b_stride,
+                       unsigned long batch, unsigned long m, unsigned long n, unsigned long k, T* __restrict__ C )
+    {
+        auto_tune_cpu_gemm();
+        cpu_batched_gemm( A, a_transposed, a_stride, B, b_transposed, b_stride, batch, m, n, k, C );
+    }
+
     // always prefer channel-last data format
     // Example:
     //
@@ -574,15 +678,23 @@ namespace ceras
     // [ 3, 4 ] + [  -1, 1 ] = [ 2, 5 ]
     // [ 5, 6 ]                [ 4, 7 ]
     //
+    // ans <= lhs + rhs, broadcasted, `ans` being resized
     template< Tensor Tsor >
-    Tsor add( Tsor const& lhs, Tsor const& rhs ) noexcept
+    void add( Tsor const& lhs, Tsor const& rhs, Tsor& ans ) noexcept
     {
         auto const& broadcasted_shape = broadcast_shape( lhs.shape(), rhs.shape() );
-        auto llhs = broadcast_tensor( lhs, broadcasted_shape );
+        auto const& llhs = broadcast_tensor( lhs, broadcasted_shape );
         auto const& rrhs = broadcast_tensor( rhs, broadcasted_shape );
+        ans.resize( broadcasted_shape );
+        for_each( ans.begin(), ans.end(), llhs.begin(), rrhs.begin(), []( auto& z, auto x, auto y ) noexcept { z = x + y; } );
+    }
 
-        for_each( llhs.begin(), llhs.end(), rrhs.begin(), []( auto& x, auto const& y ) noexcept { x += y; } );
-        return llhs;
+    template< Tensor Tsor >
+    Tsor add( Tsor const& lhs, Tsor const& rhs ) noexcept
+    {
+        Tsor ans;
+        add( lhs, rhs, ans );
+        return ans;
     }
 
     template< Tensor Tsor >
@@ -605,16 +717,23 @@ namespace ceras
         return rhs + lhs;
     }
 
+    // ans <= lhs - rhs, broadcasted, `ans` being resized
     template< Tensor Tsor >
-    Tsor minus( Tsor const& lhs, Tsor const& rhs ) noexcept
+    void minus( Tsor const& lhs, Tsor const& rhs, Tsor& ans ) noexcept
     {
         auto const& broadcasted_shape = broadcast_shape( lhs.shape(), rhs.shape() );
-        auto llhs = broadcast_tensor( lhs, broadcasted_shape );
+        auto const& llhs = broadcast_tensor( lhs, broadcasted_shape );
         auto const& rrhs = broadcast_tensor( rhs, broadcasted_shape );
+        ans.resize( broadcasted_shape );
+        for_each( ans.begin(), ans.end(), llhs.begin(), rrhs.begin(), []( auto& z, auto x, auto y ) noexcept { z = x - y; } );
+    }
 
-        for_each( llhs.begin(), llhs.end(), rrhs.begin(), []( auto& x, auto const& y ) noexcept { x -= y; } );
-        return llhs;
-        //return add( lhs, -rhs );
+    template< Tensor Tsor >
+    Tsor minus( Tsor const& lhs, Tsor const& rhs ) noexcept
+    {
+        Tsor ans;
+        minus( lhs, rhs, ans );
+        return ans;
     }
 
     template< Tensor Tsor >
@@ -710,6 +829,81 @@ namespace ceras
         return multiply( lhs, rhs );
     }
 
+    namespace ceras_private
+    {
+        // split the shape of a batched matrix, [b0, b1, ..., rows, cols], into the batch dimensions and the number of matrices
+        inline std::tuple<std::vector<unsigned long>, unsigned long> batch_dimensions( std::vector<unsigned long> const& shape ) noexcept
+        {
+            std::vector<unsigned long> dims{ shape.begin(), shape.end()-2 };
+            unsigned long const batch = std::accumulate( dims.begin(), dims.end(), 1UL, []( unsigned long a, unsigned long b ){ return a*b; } );
+            return std::make_tuple( dims, batch );
+        }
+
+        // batch dimensions of the product of two batched matrices, one side may be a single matrix broadcasted to the other
+        inline std::vector<unsigned long> batched_multiply_shape( std::vector<unsigned long> const& lhs_shape, std::vector<unsigned long> const& rhs_shape ) noexcept
+        {
+            better_assert( lhs_shape.size() >= 2, "batched_multiply: expecting lhs of at least 2 dimensions, but got ", lhs_shape.size() );
+            better_assert( rhs_shape.size() >= 2, "batched_multiply: expecting rhs of at least 2 dimensions, but got ", rhs_shape.size() );
+            better_assert( *(lhs_shape.rbegin()) == *(rhs_shape.rbegin()+1), fmt::format( "batched_multiply: dimension not match, lhs {} and rhs {}", lhs_shape, rhs_shape ) );
+
+            auto const& [lhs_dims, lhs_batch] = batch_dimensions( lhs_shape );
+            auto const& [rhs_dims, rhs_batch] = batch_dimensions( rhs_shape );
+            better_assert( lhs_batch == 1 || rhs_batch == 1 || lhs_dims == rhs_dims, fmt::format( "batched_multiply: cannot broadcast batch dimensions of lhs {} and rhs {}", lhs_shape, rhs_shape ) );
+
+            std::vector<unsigned long> ans = ( lhs_batch == 1 && ( rhs_batch > 1 || rhs_dims.size() > lhs_dims.size() ) ) ? rhs_dims : lhs_dims;
+            ans.push_back( *(lhs_shape.rbegin()+1) );
+            ans.push_back( *(rhs_shape.rbegin()) );
+            return ans;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Batched matrix multiplication, `ans[b] = lhs[b] * rhs[b]`.
+    ///
+    /// @param lhs A tensor of shape [..., M, K].
+    /// @param rhs A tensor of shape [..., K, N]. The batch dimensions should be the same as lhs, unless one of the two holds a single matrix, which is broadcasted.
+    /// @param ans A tensor of shape [..., M, N].
+    ///
+    /// \code{.cpp}
+    /// auto a = random<float>( {16, 3, 5} );
+    /// auto b = random<float>( {16, 5, 7} );
+    /// auto c = batched_multiply( a, b ); // <- [16, 3, 7]
+    /// \endcode
+    ///
+    template< Tensor Tsor >
+    void batched_multiply( Tsor const& lhs, Tsor const& rhs, Tsor& ans ) noexcept
+    {
+        auto const& lhs_shape = lhs.shape();
+        auto const& rhs_shape = rhs.shape();
+        auto const& ans_shape = ceras_private::batched_multiply_shape( lhs_shape, rhs_shape );
+        unsigned long const m = *(lhs_shape.rbegin()+1);
+        unsigned long const n = *(lhs_shape.rbegin());
+        unsigned long const k = *(rhs_shape.rbegin());
+        unsigned long const lhs_batch = lhs.size() / (m*n);
+        unsigned long const rhs_batch = rhs.size() / (n*k);
+        unsigned long const batch = std::max( lhs_batch, rhs_batch );
+
+        ans.resize( ans_shape );
+        if ( rhs_batch == 1 ) // the same rhs for all the matrices, a single gemm over the stacked lhs
+            gemm( lhs.data(), false, rhs.data(), false, lhs_batch*m, n, k, ans.data() );
+        else
+            batched_gemm( lhs.data(), false, (lhs_batch == 1) ? 0UL : m*n, rhs.data(), false, n*k, batch, m, n, k, ans.data() );
+    }
+
+    template< Tensor Tsor >
+    Tsor batched_multiply( Tsor const& lhs, Tsor const& rhs ) noexcept
+    {
+        Tsor ans;
+        batched_multiply( lhs, rhs, ans );
+        return ans;
+    }
+
+    template< Tensor Tsor >
+    Tsor bmm( Tsor const& lhs, Tsor const& rhs ) noexcept
+    {
+        return batched_multiply( lhs, rhs );
+    }
+
     // caution: only valid for channel last case
     template< Tensor Tsor >
     Tsor elementwise_product( Tsor const& lhs, Tsor const& rhs ) noexcept
@@ -767,7 +961,12 @@ namespace ceras
     template< Tensor Tsor >
     Tsor reduce_sum( Tsor const& tsor )
     {
-        auto result = std::reduce( tsor.data(), tsor.data()+tsor.size(), typename Tsor::value_type{0} );
+        typedef typename Tsor::value_type value_type;
+        value_type const result = parallel_reduce( tsor.size(), value_type{0}, [&]( unsigned long first, unsigned long last, value_type init )
+        {
+            isa_dispatch( [&](){ init = std::reduce( tsor.data()+first, tsor.data()+last, init ); } );
+            return init;
+        }, std::plus<value_type>{} );
         return Tsor{ std::vector<unsigned long>{1}, {result,} };
     }
 
@@ -1040,7 +1239,11 @@ namespace ceras
     {
         typedef typename Tsor::value_type value_type;
         better_assert( tsor.size() != 0, "tensor::sum error: input tensor should not be empty!" );
-        return std::accumulate( tsor.data(), tsor.data()+tsor.size(), value_type{0} );
+        return parallel_reduce( tsor.size(), value_type{0}, [&]( unsigned long first, unsigned long last, value_type init )
+        {
+            isa_dispatch( [&](){ init = std::accumulate( tsor.data()+first, tsor.data()+last, init ); } );
+            return init;
+        }, std::plus<value_type>{} );
     }
 
     template< Tensor Tsor >
@@ -1056,7 +1259,12 @@ namespace ceras
     {
         typedef typename Tsor::value_type value_type;
         better_assert( tsor.size() != 0, "tensor::sum error: input tensor should not be empty!" );
-        return std::sqrt( std::accumulate( tsor.data(), tsor.data()+tsor.size(), value_type{0}, []( value_type x, value_type y ){ return x + y*y; }  ) ) / static_cast<value_type>( tsor.size() );
+        value_type const squares = parallel_reduce( tsor.size(), value_type{0}, [&]( unsigned long first, unsigned long last, value_type init )
+        {
+            isa_dispatch( [&](){ init = std::accumulate( tsor.data()+first, tsor.data()+last, init, []( value_type x, value_type y ){ return x + y*y; } ); } );
+            return init;
+        }, std::plus<value_type>{}, 2.0 );
+        return std::sqrt( squares ) / static_cast<value_type>( tsor.size() );
     }
 
     template< Tensor Tsor >
@@ -1076,13 +1284,14 @@ namespace ceras
         unsigned long const last_dim = *(tsor.shape().rbegin());
         unsigned long const rem_dim = tsor.size() / last_dim;
         view_2d<value_type> mat{ ans.data(), rem_dim, last_dim };
-        for ( auto idx : range( rem_dim ) )
+        // rows in parallel, the loops within a row being parallel only for a single row, about 40 operations per element for the two exponentials
+        parallel_for( [&]( unsigned long idx )
         {
             value_type const mx = *std::max_element( mat[idx], mat[idx+1] );
             for_each( mat[idx], mat[idx+1], [mx]( auto& v ){ v -= mx; } );
             value_type const ac = std::accumulate( mat[idx], mat[idx+1], value_type{0}, []( value_type init, value_type val ){ return init + std::exp(val); } );
             for_each( mat[idx], mat[idx+1], [ac]( auto& v ){ v = std::exp(v) / (ac+eps); } );
-        }
+        }, rem_dim, 40.0 * static_cast<double>( last_dim ) );
         return ans;
     }
 
@@ -1121,13 +1330,12 @@ namespace ceras
 
         Tsor ans{ _shape };
         auto itor = ans.begin();
-        for ( auto idx : range( pres ) )
-            for ( auto jdx : range( post ) )
-            {
-                auto start = ts.begin() + idx * post * n + jdx;
-                stride_iterator si{ start, static_cast<std::int64_t>(post) };
-                *itor++ = std::reduce( si, si+n, init, func );
-            }
+        parallel_for( [&]( unsigned long idx, unsigned long jdx )
+        {
+            auto start = ts.begin() + idx * post * n + jdx;
+            stride_iterator si{ start, static_cast<std::int64_t>(post) };
+            itor[idx * post + jdx] = std::reduce( si, si+n, init, func );
+        }, pres, post, static_cast<double>( n ) );
 
         if ( !keepdims )
         {
@@ -1174,8 +1382,12 @@ namespace ceras
     template <Tensor Tsor> requires std::floating_point<typename Tsor::value_type>
     typename Tsor::value_type var( Tsor const& ts ) noexcept
     {
+        typedef typename Tsor::value_type value_type;
         auto x = ts - mean(ts);
-        return std::inner_product( x.begin(), x.end(), x.begin(), typename Tsor::value_type{0} );
+        return parallel_reduce( x.size(), value_type{0}, [&]( unsigned long first, unsigned long last, value_type init )
+        {
+            return std::inner_product( x.begin()+first, x.begin()+last, x.begin()+first, init );
+        }, std::plus<value_type>{}, 2.0 );
     }
 
     template <Tensor Tsor> requires std::floating_point<typename Tsor::value_type>
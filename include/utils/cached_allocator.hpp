@@ -6,6 +6,7 @@
 #include "../backend/cuda.hpp"
 #include "./singleton.hpp"
 #include "./better_assert.hpp"
+#include "./parallel.hpp"
 
 namespace ceras
 {
@@ -17,104 +18,429 @@ namespace ceras
     //---------------------------------------------------------
 
 
-    namespace
+    namespace ceras_private
     {
-        struct memory
+        //
+        // The blocks are rounded up to size classes: 64 bytes, then 4 classes per power of two, 80, 96, 112, 128, 160, 192, ...,
+        // so that a freed block serves any later request of its class, wasting at most a fifth of it.
+        //
+        inline constexpr unsigned long memory_classes = 4 * ( 64 - 6 ) + 1;
+
+        inline constexpr unsigned long memory_class( unsigned long size ) noexcept
         {
-            unsigned long size_;
-            std::byte* address_;
-            friend constexpr auto operator <=> ( memory const&, memory const& ) noexcept = default;
-        }; // struct memory
+            if ( size <= 64 )
+                return 0;
+            unsigned long const exponent = 63 - std::countl_zero( size - 1 ); // size in ( 2^exponent, 2^(exponent+1) ]
+            return ( exponent - 6 ) * 4 + ( ( size - 1 ) >> ( exponent - 2 ) ) - 3;
+        }
 
+        inline constexpr unsigned long memory_class_size( unsigned long memory_class ) noexcept
+        {
+            if ( memory_class == 0 )
+                return 64;
+            unsigned long const exponent = ( memory_class - 1 ) / 4 + 6;
+            return ( ( memory_class - 1 ) % 4 + 5 ) << ( exponent - 2 );
+        }
 
-        struct memory_hash
+        // parse a byte count such as "4096", "512M" or "2G", 0 if malformed
+        inline unsigned long parse_bytes( char const* text ) noexcept
         {
-            unsigned long operator()( memory const& mem ) const noexcept
+            if ( !text )
+                return 0;
+            char* end = nullptr;
+            unsigned long const ans = std::strtoul( text, &end, 10 );
+            if ( end == text )
+                return 0;
+            switch ( *end )
             {
-                return ( std::hash<unsigned long>()( mem.size_ ) << 1 ) ^ std::hash<std::byte*>()( mem.address_ );
+                case 'k': case 'K': return ans << 10;
+                case 'm': case 'M': return ans << 20;
+                case 'g': case 'G': return ans << 30;
+                case 't': case 'T': return ans << 40;
+                default: return ans;
             }
-        }; // struct memory_hash
+        }
 
-        struct memory_cache
+        //
+        // The counters of the cache, per size class: the bytes handed out, those kept free, and the allocations served from the free blocks or not.
+        //
+        struct memory_counters
         {
-            std::unordered_set<memory, memory_hash> allocated_memory;
-            std::unordered_multimap<unsigned long, std::byte*> reserved_memory;
+            std::atomic<unsigned long> in_use_{ 0 };
+            std::atomic<unsigned long> peak_{ 0 };
+            std::atomic<unsigned long> reserved_{ 0 };
+            std::atomic<unsigned long> hits_{ 0 };
+            std::atomic<unsigned long> misses_{ 0 };
+            std::array<std::atomic<unsigned long>, memory_classes> class_in_use_{};
+            std::array<std::atomic<unsigned long>, memory_classes> class_reserved_{};
+
+            void hand_out( unsigned long memory_class, unsigned long bytes ) noexcept
+            {
+                unsigned long const in_use = in_use_.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+                for ( unsigned long peak = peak_.load( std::memory_order_relaxed ); peak < in_use && !peak_.compare_exchange_weak( peak, in_use, std::memory_order_relaxed ); );
+                class_in_use_[memory_class].fetch_add( bytes, std::memory_order_relaxed );
+            }
 
-            std::byte* allocate( unsigned long size )
+            void take_back( unsigned long memory_class, unsigned long bytes ) noexcept
             {
-                // search reserved_memory, return if found one matches
-                auto search = reserved_memory.find( size );
-                if ( search != reserved_memory.end() )
-                {
-                    std::byte* ans = search->second;
-                    allocated_memory.emplace( size, ans );
-                    reserved_memory.erase( search );
-                    return ans;
-                }
+                in_use_.fetch_sub( bytes, std::memory_order_relaxed );
+                class_in_use_[memory_class].fetch_sub( bytes, std::memory_order_relaxed );
+            }
 
-                // create a fresh new memory
-                std::allocator<std::byte> alloc;
-                //std::byte* ans = alloc.allocate( size );
+            void reserve( unsigned long memory_class, unsigned long bytes ) noexcept
+            {
+                reserved_.fetch_add( bytes, std::memory_order_relaxed );
+                class_reserved_[memory_class].fetch_add( bytes, std::memory_order_relaxed );
+            }
 
-                std::byte* ans = nullptr;
-                try
-                {
-                    ans = alloc.allocate( size );
-                }
-                catch (const std::bad_alloc& e)
-                {
-                    if ( gc() ) // another attempt to allocate memory
-                        ans = alloc.allocate( size );
-                    else
-                        better_assert( false, "OOM...." );
-                }
+            void unreserve( unsigned long memory_class, unsigned long bytes ) noexcept
+            {
+                reserved_.fetch_sub( bytes, std::memory_order_relaxed );
+                class_reserved_[memory_class].fetch_sub( bytes, std::memory_order_relaxed );
+            }
+        }; // struct memory_counters
 
-                allocated_memory.emplace( size, ans );
+        //
+        // The free blocks shared by all the threads, a list per size class, each behind its own lock.
+        // Every block is stamped when freed: the lists are reused from their newest block, and trimmed from the oldest block of all the lists.
+        //
+        struct shared_memory_cache
+        {
+            struct free_list
+            {
+                std::mutex mutex_;
+                std::deque<std::pair<std::byte*, unsigned long>> blocks_; // the blocks, and when they were freed, the newest at the back
+            };
+            std::array<free_list, memory_classes> lists_;
+            std::atomic<unsigned long> clock_{ 0 };
+            std::mutex trim_mutex_;
+            memory_counters counters_;
+
+            std::byte* pop( unsigned long memory_class )
+            {
+                free_list& list = lists_[memory_class];
+                std::lock_guard<std::mutex> const lock{ list.mutex_ };
+                if ( list.blocks_.empty() )
+                    return nullptr;
+                std::byte* ans = list.blocks_.back().first;
+                list.blocks_.pop_back();
                 return ans;
             }
 
-            void deallocate( std::byte* ptr, unsigned long size )
+            void push( unsigned long memory_class, std::byte* block )
             {
-                allocated_memory.erase( memory{size, ptr} );
-                reserved_memory.emplace( size, ptr );
+                free_list& list = lists_[memory_class];
+                std::lock_guard<std::mutex> const lock{ list.mutex_ };
+                list.blocks_.emplace_back( block, clock_.fetch_add( 1, std::memory_order_relaxed ) );
             }
 
-            ~memory_cache()
+            // release the least recently freed blocks to the system, until the reserved bytes are at most `keep`, or no shared block is left
+            void trim( unsigned long keep )
             {
-                std::allocator<std::byte> alloc;
-
-                for ( auto& mem : allocated_memory )
+                std::lock_guard<std::mutex> const trimming{ trim_mutex_ };
+                while ( counters_.reserved_.load( std::memory_order_relaxed ) > keep )
                 {
-                    auto& [size, address] = mem;
-                    alloc.deallocate( address, size );
+                    unsigned long oldest_class = memory_classes;
+                    unsigned long oldest = -1UL;
+                    for ( unsigned long memory_class = 0; memory_class != memory_classes; ++memory_class )
+                    {
+                        free_list& list = lists_[memory_class];
+                        std::lock_guard<std::mutex> const lock{ list.mutex_ };
+                        if ( !list.blocks_.empty() && list.blocks_.front().second < oldest )
+                        {
+                            oldest = list.blocks_.front().second;
+                            oldest_class = memory_class;
+                        }
+                    }
+                    if ( oldest_class == memory_classes )
+                        return;
+
+                    std::byte* block = nullptr;
+                    {
+                        free_list& list = lists_[oldest_class];
+                        std::lock_guard<std::mutex> const lock{ list.mutex_ };
+                        if ( list.blocks_.empty() ) // taken meanwhile
+                            continue;
+                        block = list.blocks_.front().first;
+                        list.blocks_.pop_front();
+                    }
+                    ::operator delete( block, std::align_val_t{ memory_alignment } );
+                    counters_.unreserve( oldest_class, memory_class_size( oldest_class ) );
                 }
+            }
+        }; // struct shared_memory_cache
 
-                for ( auto& [size, address] : reserved_memory )
-                {
-                    alloc.deallocate( address, size );
-                }
+        // never destroyed, as the threads of the static thread pool may still return their blocks at exit
+        inline shared_memory_cache& get_shared_memory_cache()
+        {
+            static shared_memory_cache* ans = new shared_memory_cache{};
+            return *ans;
+        }
+
+        //
+        // The free blocks of a thread, up to `depth` per class of at most 1 MB and `capacity` bytes in all, reused without any lock.
+        // The blocks of the other classes, the blocks over these bounds, and those left when the thread exits go to the shared cache.
+        //
+        struct thread_memory_cache
+        {
+            static constexpr unsigned long classes = memory_class( 1UL << 20 ) + 1;
+            static constexpr unsigned long depth = 8;
+            static constexpr unsigned long capacity = 1UL << 22;
+            std::array<std::array<std::byte*, depth>, classes> blocks_;
+            std::array<unsigned long, classes> counts_{};
+            unsigned long bytes_ = 0;
+
+            std::byte* pop( unsigned long memory_class ) noexcept
+            {
+                if ( memory_class >= classes || counts_[memory_class] == 0 )
+                    return nullptr;
+                bytes_ -= memory_class_size( memory_class );
+                return blocks_[memory_class][--counts_[memory_class]];
             }
 
-            // garbage collection, true for success, false for failure.
-            bool gc()
+            bool push( unsigned long memory_class, std::byte* block ) noexcept
             {
-                if (reserved_memory.size()==0)
+                if ( memory_class >= classes || counts_[memory_class] == depth || bytes_ + memory_class_size( memory_class ) > capacity )
                     return false;
+                bytes_ += memory_class_size( memory_class );
+                blocks_[memory_class][counts_[memory_class]++] = block;
+                return true;
+            }
+
+            void flush()
+            {
+                for ( unsigned long memory_class = 0; memory_class != classes; ++memory_class )
+                    for ( ; counts_[memory_class]; --counts_[memory_class] )
+                        get_shared_memory_cache().push( memory_class, blocks_[memory_class][counts_[memory_class]-1] );
+                bytes_ = 0;
+            }
 
-                std::allocator<std::byte> alloc;
-                for ( auto& [size, address] : reserved_memory )
-                    alloc.deallocate( address, size );
+            ~thread_memory_cache()
+            {
+                flush();
+            }
+        }; // struct thread_memory_cache
 
-                return true;
+        inline thread_memory_cache& get_thread_memory_cache()
+        {
+            thread_local thread_memory_cache ans;
+            return ans;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Soft limit of the bytes held by the tensor cache, in use or kept free, 0 for none; CERAS_MEMORY_SOFT_LIMIT, such as "8G", by default.
+    ///
+    /// Above it, the least recently freed blocks are returned to the system, down to a sixteenth of the limit below it, once they exceed that sixteenth,
+    /// so that the blocks freed while the live tensors alone are about the limit still serve the next allocations.
+    ///
+    inline unsigned long memory_soft_limit = ceras_private::parse_bytes( std::getenv( "CERAS_MEMORY_SOFT_LIMIT" ) );
+
+    ///
+    /// @brief Hard limit of the bytes held by the tensor cache, 0 for none; CERAS_MEMORY_HARD_LIMIT, such as "12G", by default.
+    ///
+    /// An allocation that would exceed it once the free blocks are returned to the system throws `std::bad_alloc`.
+    /// The few MB of free blocks kept by each thread other than the allocating one are not returned, and may exceed it.
+    ///
+    inline unsigned long memory_hard_limit = ceras_private::parse_bytes( std::getenv( "CERAS_MEMORY_HARD_LIMIT" ) );
+
+    ///
+    /// @brief Return the free blocks of the tensor cache to the system, the least recently freed first, keeping at most `keep` bytes of them.
+    ///
+    /// The free blocks kept by the other threads, a few MB each, stay with them.
+    ///
+    /// \code{.cpp}
+    /// auto output = m.predict( input );
+    /// trim_memory(); // back to the resident size of the live tensors
+    /// \endcode
+    ///
+    inline void trim_memory( unsigned long keep = 0 )
+    {
+        ceras_private::get_thread_memory_cache().flush();
+        ceras_private::get_shared_memory_cache().trim( keep );
+    }
+
+    ///
+    /// @brief The bytes of a size class of the tensor cache.
+    ///
+    struct memory_class_statistics
+    {
+        unsigned long size;     ///< the size of the blocks of the class
+        unsigned long in_use;   ///< the bytes of the blocks handed out
+        unsigned long reserved; ///< the bytes of the free blocks
+    };
+
+    ///
+    /// @brief Statistics of the tensor cache, in bytes of the size classes, requests being rounded up to them.
+    ///
+    struct memory_statistics
+    {
+        unsigned long in_use;   ///< the bytes handed out to the tensors
+        unsigned long peak;     ///< the highest `in_use` since the start, or `reset_memory_peak`
+        unsigned long reserved; ///< the bytes of the free blocks kept for later allocations
+        unsigned long hits;     ///< the allocations served from the free blocks
+        unsigned long misses;   ///< the allocations served by the system
+        std::vector<memory_class_statistics> classes; ///< the classes in use or reserved
+
+        double hit_ratio() const noexcept
+        {
+            return ( hits + misses ) ? static_cast<double>( hits ) / static_cast<double>( hits + misses ) : 0.0;
+        }
+    };
+
+    ///
+    /// @brief Print the statistics as `name value` lines, the size classes labelled by their size, for a metrics scraper.
+    ///
+    inline std::ostream& operator << ( std::ostream& os, memory_statistics const& stats )
+    {
+        os << "ceras_memory_in_use_bytes " << stats.in_use << "\n";
+        os << "ceras_memory_peak_bytes " << stats.peak << "\n";
+        os << "ceras_memory_reserved_bytes " << stats.reserved << "\n";
+        os << "ceras_memory_hits " << stats.hits << "\n";
+        os << "ceras_memory_misses " << stats.misses << "\n";
+        os << "ceras_memory_hit_ratio " << stats.hit_ratio() << "\n";
+        for ( auto const& c : stats.classes )
+        {
+            os << "ceras_memory_class_in_use_bytes{size=\"" << c.size << "\"} " << c.in_use << "\n";
+            os << "ceras_memory_class_reserved_bytes{size=\"" << c.size << "\"} " << c.reserved << "\n";
+        }
+        return os;
+    }
+
+    ///
+    /// @brief The statistics of the tensor cache, counted by all the threads.
+    ///
+    inline memory_statistics memory_stats()
+    {
+        auto const& counters = ceras_private::get_shared_memory_cache().counters_;
+        memory_statistics ans{ counters.in_use_.load(), counters.peak_.load(), counters.reserved_.load(), counters.hits_.load(), counters.misses_.load(), {} };
+        for ( unsigned long memory_class = 0; memory_class != ceras_private::memory_classes; ++memory_class )
+        {
+            unsigned long const in_use = counters.class_in_use_[memory_class].load();
+            unsigned long const reserved = counters.class_reserved_[memory_class].load();
+            if ( in_use || reserved )
+                ans.classes.push_back( { ceras_private::memory_class_size( memory_class ), in_use, reserved } );
+        }
+        return ans;
+    }
+
+    ///
+    /// @brief Restart the peak of `memory_stats` from the bytes in use.
+    ///
+    inline void reset_memory_peak()
+    {
+        auto& counters = ceras_private::get_shared_memory_cache().counters_;
+        counters.peak_.store( counters.in_use_.load() );
+    }
+
+    namespace ceras_private
+    {
+        // the free bytes kept above the soft limit before trimming, and left below it by a trim
+        inline unsigned long soft_limit_slack() noexcept
+        {
+            return std::max( memory_soft_limit / 16, 1UL << 20 );
+        }
+
+        // return the least recently freed blocks to the system, down to the slack below the soft limit, or to none if the live blocks are above it
+        [[gnu::noinline]] inline void trim_to_soft_limit()
+        {
+            memory_counters const& counters = get_shared_memory_cache().counters_;
+            unsigned long const in_use = counters.in_use_.load( std::memory_order_relaxed );
+            if ( in_use + counters.reserved_.load( std::memory_order_relaxed ) <= memory_soft_limit )
+                return;
+            unsigned long const low_water = memory_soft_limit - std::min( memory_soft_limit, soft_limit_slack() );
+            trim_memory( in_use < low_water ? low_water - in_use : 0 );
+        }
+
+        // a block of at least `size` bytes, aligned to `memory_alignment`, from the cache of the thread, the shared cache, or the system
+        inline std::byte* allocate_memory( unsigned long size )
+        {
+            unsigned long const memory_class = ceras_private::memory_class( size );
+            unsigned long const bytes = memory_class_size( memory_class );
+            shared_memory_cache& shared = get_shared_memory_cache();
+            memory_counters& counters = shared.counters_;
+
+            std::byte* ans = get_thread_memory_cache().pop( memory_class );
+            if ( !ans )
+                ans = shared.pop( memory_class );
+            if ( ans )
+            {
+                counters.hits_.fetch_add( 1, std::memory_order_relaxed );
+                counters.unreserve( memory_class, bytes );
+                counters.hand_out( memory_class, bytes );
+                return ans;
+            }
+
+            counters.misses_.fetch_add( 1, std::memory_order_relaxed );
+            unsigned long const limit = std::min( memory_soft_limit ? memory_soft_limit : -1UL, memory_hard_limit ? memory_hard_limit : -1UL );
+            if ( limit != -1UL && counters.reserved_.load( std::memory_order_relaxed ) && counters.in_use_.load( std::memory_order_relaxed ) + counters.reserved_.load( std::memory_order_relaxed ) + bytes > limit )
+            {
+                unsigned long const in_use = counters.in_use_.load( std::memory_order_relaxed ) + bytes;
+                trim_memory( in_use < limit ? limit - in_use : 0 );
             }
+            if ( memory_hard_limit && counters.in_use_.load( std::memory_order_relaxed ) + bytes > memory_hard_limit )
+                throw std::bad_alloc{};
 
-        }; // struct memory_cache
+            try
+            {
+                ans = static_cast<std::byte*>( ::operator new( bytes, std::align_val_t{ memory_alignment } ) );
+            }
+            catch ( std::bad_alloc const& )
+            {
+                // another attempt, once the free blocks are released
+                trim_memory();
+                ans = static_cast<std::byte*>( ::operator new( bytes, std::align_val_t{ memory_alignment } ) );
+            }
+            counters.hand_out( memory_class, bytes );
+            return ans;
+        }
 
-        memory_cache& get_memory_cache()
+        // keep a block returned by `allocate_memory( size )` for a later allocation
+        inline void deallocate_memory( std::byte* block, unsigned long size )
         {
-            return singleton<memory_cache>::instance();
+            unsigned long const memory_class = ceras_private::memory_class( size );
+            unsigned long const bytes = memory_class_size( memory_class );
+            shared_memory_cache& shared = get_shared_memory_cache();
+            memory_counters& counters = shared.counters_;
+            counters.take_back( memory_class, bytes );
+            counters.reserve( memory_class, bytes );
+            if ( !get_thread_memory_cache().push( memory_class, block ) )
+                shared.push( memory_class, block );
+
+            // each trim returns more than the slack, so that most of the frees only read a counter
+            if ( memory_soft_limit && counters.reserved_.load( std::memory_order_relaxed ) > soft_limit_slack() )
+                trim_to_soft_limit();
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief NUMA first-touch placement of the tensors allocated by `cached_allocator`, set by the environment variable CERAS_NUMA_FIRST_TOUCH.
+    ///
+    /// A page lands on the NUMA node of the thread writing it first. When set, the blocks of 1 MB or more are zeroed by the threads of the parallel loops,
+    /// each thread a contiguous slice, as the parallel loops later split them, so that the pages of a tensor lie with the threads using them.
+    /// Useful with threads spread over several sockets; with threads on one socket (see `set_parallel_affinity`), this places the tensors on that socket.
+    ///
+    inline bool numa_first_touch = std::getenv( "CERAS_NUMA_FIRST_TOUCH" ) != nullptr;
+
+    namespace ceras_private
+    {
+        // zero a fresh block, from the threads of the parallel loops if `numa_first_touch`
+        inline void zero_memory( std::byte* address, unsigned long size )
+        {
+            unsigned long constexpr page = 4096UL;
+            unsigned long const threads = parallel_threads();
+            if ( !numa_first_touch || size < ( 1UL << 20 ) || threads < 2 )
+            {
+                std::memset( address, 0, size );
+                return;
+            }
+            unsigned long const pages = ( size + page - 1 ) / page;
+            parallel_ranges( [=]( unsigned long first, unsigned long last )
+            {
+                std::memset( address + first * page, 0, std::min( size, last * page ) - first * page );
+            }, pages, ( pages + threads - 1 ) / threads );
         }
-    }//anonymous namespace
+    }//namespace ceras_private
 
     //
     // Warning: only for tensor
@@ -140,15 +466,15 @@ namespace ceras
 
         [[nodiscard]] T* allocate( unsigned long const n )
         {
-            std::byte* ans = get_memory_cache().allocate( n*sizeof(T) );
-            std::memset( ans, 0, n*sizeof(T) );
+            std::byte* ans = ceras_private::allocate_memory( n*sizeof(T) );
+            ceras_private::zero_memory( ans, n*sizeof(T) );
             return reinterpret_cast<T*>( ans );
             //return reinterpret_cast<T*>( get_memory_cache().allocate( n*sizeof(T) ));
         }
 
         void deallocate( T* p, unsigned long const n )
         {
-            get_memory_cache().deallocate( reinterpret_cast<std::byte*>(p), n * sizeof(T) );
+            ceras_private::deallocate_memory( reinterpret_cast<std::byte*>(p), n * sizeof(T) );
         }
 
         // empty construct for performance reasons.
@@ -0,0 +1,226 @@
+#ifndef CPU_FEATURES_HPP_INCLUDED_MWJZKQXTRAVHLBNEOYDCUGPSFIRQMZTXWKLVNHBYAOECDJGUSP
+#define CPU_FEATURES_HPP_INCLUDED_MWJZKQXTRAVHLBNEOYDCUGPSFIRQMZTXWKLVNHBYAOECDJGUSP
+
+#include "../includes.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+//
+// Kernels are compiled for several instruction sets in the same binary and selected at runtime.
+// Functions defined between CERAS_BEGIN_TARGET( "..." ) and CERAS_END_TARGET are generated for the given instruction set,
+// including the function templates and the lambdas inlined into them.
+//
+#define CERAS_PRAGMA(x) _Pragma(#x)
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define CERAS_X86 1
+    #if defined(__clang__)
+        #define CERAS_BEGIN_TARGET(isa_options) CERAS_PRAGMA(clang attribute push( __attribute__((target(isa_options))), apply_to = function ))
+        #define CERAS_END_TARGET CERAS_PRAGMA(clang attribute pop)
+    #else
+        #define CERAS_BEGIN_TARGET(isa_options) CERAS_PRAGMA(GCC push_options) CERAS_PRAGMA(GCC target(isa_options))
+        #define CERAS_END_TARGET CERAS_PRAGMA(GCC pop_options)
+    #endif
+#else
+    #define CERAS_X86 0
+    #define CERAS_BEGIN_TARGET(isa_options)
+    #define CERAS_END_TARGET
+#endif
+
+#define CERAS_TARGET_SSE42 "sse4.2"
+#define CERAS_TARGET_AVX2 "avx2,fma"
+#define CERAS_TARGET_AVX512 "avx512f,avx2,fma"
+#define CERAS_TARGET_AVX512BW "avx512f,avx512bw,avx2,fma"
+#define CERAS_TARGET_AVX512VNNI "avx512f,avx512bw,avx512vnni,avx2,fma"
+#define CERAS_TARGET_F16C "f16c,avx2,fma"
+#define CERAS_TARGET_AVX512BF16 "avx512f,avx512bw,avx512vl,avx512bf16,avx2,fma"
+
+namespace ceras
+{
+
+    ///
+    /// @brief Instruction sets the kernels are compiled for, in increasing order.
+    ///
+    enum class isa : unsigned long
+    {
+        generic = 0,
+        sse42 = 1,
+        avx2 = 2,
+        avx512 = 3
+    };
+
+    inline std::string isa_name( isa instruction_set )
+    {
+        switch ( instruction_set )
+        {
+            case isa::sse42: return std::string{ "sse4.2" };
+            case isa::avx2: return std::string{ "avx2" };
+            case isa::avx512: return std::string{ "avx512" };
+            default: return std::string{ "generic" };
+        }
+    }
+
+    ///
+    /// @brief The best instruction set supported by the CPU and the operating system.
+    ///
+    inline isa detected_isa() noexcept
+    {
+#if CERAS_X86
+        static isa const ans = []()
+        {
+            __builtin_cpu_init();
+            if ( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+                return isa::avx512;
+            if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+                return isa::avx2;
+            if ( __builtin_cpu_supports( "sse4.2" ) )
+                return isa::sse42;
+            return isa::generic;
+        }();
+        return ans;
+#else
+        return isa::generic;
+#endif
+    }
+
+    ///
+    /// @brief The model name of the CPU, such as "Intel(R) Core(TM) i7-7700HQ CPU @ 2.80GHz", or "unknown".
+    ///
+    inline std::string cpu_model()
+    {
+        static std::string const ans = []()
+        {
+            std::string name;
+#if CERAS_X86
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if ( __get_cpuid( 0x80000000U, &eax, &ebx, &ecx, &edx ) && eax >= 0x80000004U )
+                for ( unsigned int leaf : { 0x80000002U, 0x80000003U, 0x80000004U } )
+                {
+                    __get_cpuid( leaf, &eax, &ebx, &ecx, &edx );
+                    for ( unsigned int reg : { eax, ebx, ecx, edx } )
+                        for ( unsigned int byte = 0; byte != 4; ++byte )
+                            if ( char const c = static_cast<char>( ( reg >> ( 8 * byte ) ) & 0xffU ); c != '\0' )
+                                name.push_back( c );
+                }
+#else
+            std::ifstream cpuinfo{ "/proc/cpuinfo" };
+            for ( std::string line; name.empty() && std::getline( cpuinfo, line ); )
+                if ( auto const colon = line.find( ':' ); ( line.starts_with( "model name" ) || line.starts_with( "Model" ) ) && colon != std::string::npos )
+                    name = line.substr( colon + 1 );
+#endif
+            auto const first = name.find_first_not_of( ' ' );
+            auto const last = name.find_last_not_of( ' ' );
+            return first == std::string::npos ? std::string{ "unknown" } : name.substr( first, last - first + 1 );
+        }();
+        return ans;
+    }
+
+    namespace ceras_private
+    {
+        // the instruction set in use, initialized from the detected one, capped by the environment variable CERAS_ISA
+        inline isa& active_isa() noexcept
+        {
+            static isa ans = []()
+            {
+                isa selected = detected_isa();
+                if ( char const* env = std::getenv( "CERAS_ISA" ); env )
+                {
+                    std::string const name{ env };
+                    for ( auto candidate : { isa::generic, isa::sse42, isa::avx2, isa::avx512 } )
+                        if ( name == isa_name( candidate ) )
+                            selected = std::min( selected, candidate );
+                }
+                return selected;
+            }();
+            return ans;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief The instruction set selected for the kernels.
+    ///
+    /// It is the detected one, unless lowered by the environment variable `CERAS_ISA` (one of `generic`, `sse4.2`, `avx2` or `avx512`) or by `set_isa`.
+    ///
+    inline isa current_isa() noexcept
+    {
+        return ceras_private::active_isa();
+    }
+
+    ///
+    /// @brief Select the instruction set of the kernels, for benchmarking or debugging.
+    ///
+    /// An instruction set not supported by the CPU is capped to the detected one.
+    /// @return The instruction set actually selected.
+    ///
+    /// \code{.cpp}
+    /// set_isa( isa::avx2 );
+    /// auto c = a * b; // using the AVX2 kernels, even on AVX-512 machines
+    /// \endcode
+    ///
+    inline isa set_isa( isa instruction_set ) noexcept
+    {
+        ceras_private::active_isa() = std::min( instruction_set, detected_isa() );
+        return current_isa();
+    }
+
+    namespace ceras_private
+    {
+        // trampolines compiling `func`, inlined with all its callees, for each instruction set
+        template< typename Function >
+        [[gnu::flatten]] void invoke_generic( Function const& func )
+        {
+            func();
+        }
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_SSE42 )
+        template< typename Function >
+        [[gnu::flatten]] void invoke_sse42( Function const& func )
+        {
+            func();
+        }
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX2 )
+        template< typename Function >
+        [[gnu::flatten]] void invoke_avx2( Function const& func )
+        {
+            func();
+        }
+CERAS_END_TARGET
+
+CERAS_BEGIN_TARGET( CERAS_TARGET_AVX512 )
+        template< typename Function >
+        [[gnu::flatten]] void invoke_avx512( Function const& func )
+        {
+            func();
+        }
+CERAS_END_TARGET
+    }//namespace ceras_private
+
+    ///
+    /// @brief Run a loop compiled for the current instruction set.
+    ///
+    /// The function, usually a lambda holding a whole loop, is generated once per instruction set and the version matching `current_isa()` is called.
+    ///
+    /// \code{.cpp}
+    /// isa_dispatch( [&](){ for ( auto idx : range( n ) ) x[idx] *= y[idx]; } );
+    /// \endcode
+    ///
+    template< typename Function >
+    void isa_dispatch( Function const& func )
+    {
+        using namespace ceras_private;
+        switch ( current_isa() )
+        {
+            case isa::avx512: invoke_avx512( func ); return;
+            case isa::avx2: invoke_avx2( func ); return;
+            case isa::sse42: invoke_sse42( func ); return;
+            default: invoke_generic( func ); return;
+        }
+    }
+
+}//namespace ceras
+
+#endif//CPU_FEATURES_HPP_INCLUDED_MWJZKQXTRAVHLBNEOYDCUGPSFIRQMZTXWKLVNHBYAOECDJGUSP
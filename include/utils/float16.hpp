@@ -0,0 +1,186 @@
+#ifndef FLOAT16_HPP_INCLUDED_RBXMTQZWKNVHJLPGYDECASOIUFRMKZQTXWBNVJHLPGYDECASOIUF
+#define FLOAT16_HPP_INCLUDED_RBXMTQZWKNVHJLPGYDECASOIUFRMKZQTXWBNVJHLPGYDECASOIUF
+
+#include "../includes.hpp"
+#include <bit>
+
+namespace ceras
+{
+
+    namespace ceras_private
+    {
+        // float to bfloat16 bits, rounding to the nearest even, keeping NaNs quiet
+        constexpr std::uint16_t float_to_bfloat16_bits( float x ) noexcept
+        {
+            std::uint32_t const bits = std::bit_cast<std::uint32_t>( x );
+            if ( ( bits & 0x7fffffffU ) > 0x7f800000U )
+                return static_cast<std::uint16_t>( ( bits >> 16 ) | 0x40U );
+            return static_cast<std::uint16_t>( ( bits + 0x7fffU + ( ( bits >> 16 ) & 1U ) ) >> 16 );
+        }
+
+        constexpr float bfloat16_bits_to_float( std::uint16_t bits ) noexcept
+        {
+            return std::bit_cast<float>( static_cast<std::uint32_t>( bits ) << 16 );
+        }
+
+        // float to IEEE half bits, rounding to the nearest even, overflowing to infinity
+        constexpr std::uint16_t float_to_float16_bits( float x ) noexcept
+        {
+            constexpr std::uint32_t infinity = 255U << 23;
+            constexpr std::uint32_t overflow = ( 127U + 16U ) << 23; // 65536
+            constexpr std::uint32_t subnormal = 113U << 23; // 2^-14, the smallest normal half
+            constexpr std::uint32_t subnormal_magic = ( ( 127U - 15U ) + ( 23U - 10U ) + 1U ) << 23;
+
+            std::uint32_t bits = std::bit_cast<std::uint32_t>( x );
+            std::uint32_t const sign = bits & 0x80000000U;
+            bits ^= sign;
+
+            std::uint32_t ans = 0;
+            if ( bits >= overflow )
+                ans = ( bits > infinity ) ? 0x7e00U : 0x7c00U;
+            else if ( bits < subnormal ) // the addition aligns the mantissa and rounds it
+                ans = std::bit_cast<std::uint32_t>( std::bit_cast<float>( bits ) + std::bit_cast<float>( subnormal_magic ) ) - subnormal_magic;
+            else
+                ans = ( bits + ( ( 15U - 127U ) << 23 ) + 0xfffU + ( ( bits >> 13 ) & 1U ) ) >> 13;
+            return static_cast<std::uint16_t>( ans | ( sign >> 16 ) );
+        }
+
+        // branch-free, as it runs in the packing loops of the GEMM
+        constexpr float float16_bits_to_float( std::uint16_t half ) noexcept
+        {
+            constexpr std::uint32_t exponent_mask = 0x7c00U << 13;
+            constexpr std::uint32_t magic = 113U << 23;
+
+            std::uint32_t const shifted = ( static_cast<std::uint32_t>( half ) & 0x7fffU ) << 13;
+            std::uint32_t const exponent = shifted & exponent_mask;
+            std::uint32_t const normal = shifted + ( ( 127U - 15U ) << 23 );
+            // infinity or NaN, quieted as by vcvtph2ps
+            std::uint32_t const special = ( normal + ( ( 128U - 16U ) << 23 ) ) | ( ( shifted & 0x7fffffU ) ? 0x400000U : 0U );
+            // zero or subnormal, normalized by a subtraction
+            std::uint32_t const subnormal = std::bit_cast<std::uint32_t>( std::bit_cast<float>( normal + ( 1U << 23 ) ) - std::bit_cast<float>( magic ) );
+            std::uint32_t const bits = ( exponent == exponent_mask ) ? special : ( ( exponent == 0 ) ? subnormal : normal );
+            return std::bit_cast<float>( bits | ( ( static_cast<std::uint32_t>( half ) & 0x8000U ) << 16 ) );
+        }
+
+        //
+        // A 16-bit floating point storage type: values are converted to float for arithmetic, and rounded back to 16 bits when stored.
+        //
+        template< std::uint16_t (*Narrow)( float ), float (*Widen)( std::uint16_t ) >
+        struct float16_storage
+        {
+            std::uint16_t bits_;
+
+            constexpr float16_storage() noexcept : bits_{ 0 } {}
+
+            constexpr float16_storage( float x ) noexcept : bits_{ Narrow( x ) } {}
+
+            template< typename T > requires std::is_arithmetic_v<T>
+            constexpr float16_storage( T x ) noexcept : bits_{ Narrow( static_cast<float>( x ) ) } {}
+
+            constexpr operator float() const noexcept
+            {
+                return Widen( bits_ );
+            }
+
+            static constexpr float16_storage from_bits( std::uint16_t bits ) noexcept
+            {
+                float16_storage ans;
+                ans.bits_ = bits;
+                return ans;
+            }
+
+            constexpr float16_storage operator - () const noexcept
+            {
+                return from_bits( bits_ ^ 0x8000U );
+            }
+
+            constexpr float16_storage& operator += ( float x ) noexcept { return *this = float16_storage{ static_cast<float>( *this ) + x }; }
+            constexpr float16_storage& operator -= ( float x ) noexcept { return *this = float16_storage{ static_cast<float>( *this ) - x }; }
+            constexpr float16_storage& operator *= ( float x ) noexcept { return *this = float16_storage{ static_cast<float>( *this ) * x }; }
+            constexpr float16_storage& operator /= ( float x ) noexcept { return *this = float16_storage{ static_cast<float>( *this ) / x }; }
+        };
+    }//namespace ceras_private
+
+    ///
+    /// @brief Brain floating point: the sign, the 8-bit exponent and the 7 leading bits of the mantissa of a float.
+    ///
+    /// It has the range of float with 2 to 3 significant decimal digits, and is converted to float for arithmetic.
+    /// Tensors of bfloat16 take half the memory of float tensors, and their products accumulate in float (see `cpu_gemm`).
+    ///
+    /// \code{.cpp}
+    /// auto a = random<float>( {64, 128} ).as_type<bfloat16>();
+    /// auto b = random<float>( {128, 32} ).as_type<bfloat16>();
+    /// auto c = a * b; // tensor<bfloat16>, accumulated in float
+    /// \endcode
+    ///
+    typedef ceras_private::float16_storage<ceras_private::float_to_bfloat16_bits, ceras_private::bfloat16_bits_to_float> bfloat16;
+
+    ///
+    /// @brief IEEE 754 half precision: 5-bit exponent and 10-bit mantissa, for values of magnitude up to 65504.
+    ///
+    /// More precise than `bfloat16`, with a narrower range. Converted to float for arithmetic.
+    ///
+    typedef ceras_private::float16_storage<ceras_private::float_to_float16_bits, ceras_private::float16_bits_to_float> float16;
+
+    template< typename T >
+    struct is_half_precision : std::false_type {};
+
+    template<>
+    struct is_half_precision<bfloat16> : std::true_type {};
+
+    template<>
+    struct is_half_precision<float16> : std::true_type {};
+
+    template< typename T >
+    inline constexpr bool is_half_precision_v = is_half_precision<T>::value;
+
+    ///
+    /// @brief 16-bit floating point storage types, `bfloat16` and `float16`.
+    ///
+    template< typename T >
+    concept half_precision = is_half_precision_v<T>;
+
+}//namespace ceras
+
+namespace std
+{
+    template<>
+    struct numeric_limits<ceras::bfloat16>
+    {
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr bool has_infinity = true;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr int digits = 8;
+        static constexpr int radix = 2;
+        static constexpr ceras::bfloat16 min() noexcept { return ceras::bfloat16::from_bits( 0x0080U ); }
+        static constexpr ceras::bfloat16 max() noexcept { return ceras::bfloat16::from_bits( 0x7f7fU ); }
+        static constexpr ceras::bfloat16 lowest() noexcept { return ceras::bfloat16::from_bits( 0xff7fU ); }
+        static constexpr ceras::bfloat16 epsilon() noexcept { return ceras::bfloat16::from_bits( 0x3c00U ); }
+        static constexpr ceras::bfloat16 infinity() noexcept { return ceras::bfloat16::from_bits( 0x7f80U ); }
+        static constexpr ceras::bfloat16 quiet_NaN() noexcept { return ceras::bfloat16::from_bits( 0x7fc0U ); }
+    };
+
+    template<>
+    struct numeric_limits<ceras::float16>
+    {
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr bool has_infinity = true;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr int digits = 11;
+        static constexpr int radix = 2;
+        static constexpr ceras::float16 min() noexcept { return ceras::float16::from_bits( 0x0400U ); }
+        static constexpr ceras::float16 max() noexcept { return ceras::float16::from_bits( 0x7bffU ); }
+        static constexpr ceras::float16 lowest() noexcept { return ceras::float16::from_bits( 0xfbffU ); }
+        static constexpr ceras::float16 epsilon() noexcept { return ceras::float16::from_bits( 0x1400U ); }
+        static constexpr ceras::float16 infinity() noexcept { return ceras::float16::from_bits( 0x7c00U ); }
+        static constexpr ceras::float16 quiet_NaN() noexcept { return ceras::float16::from_bits( 0x7e00U ); }
+    };
+}//namespace std
+
+#endif//FLOAT16_HPP_INCLUDED_RBXMTQZWKNVHJLPGYDECASOIUFRMKZQTXWBNVJHLPGYDECASOIUF
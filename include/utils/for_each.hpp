@@ -4,6 +4,7 @@
 #include "../includes.hpp"
 #include "./range.hpp"
 #include "./parallel.hpp"
+#include "./cpu_features.hpp"
 
 namespace ceras
 {
@@ -45,11 +46,20 @@ namespace ceras
         constexpr Function _for_each_n( Function f, std::size_t n, InputIterator1 begin1, InputIteratorn... beginn )
         {
             //for ( auto idx : range( n ) ) f( *(begin1+idx), *(beginn+idx)... );
-            auto const& func = [&]( std::uint_least64_t idx )
+            // contiguous chunks of at least 1024 elements per thread, each loop compiled for the current instruction set
+            std::uint_least64_t const chunks = std::max( 1UL, std::min( static_cast<std::uint_least64_t>( parallel_threads() ), n / 1024UL ) );
+            std::uint_least64_t const chunk_size = ( n + chunks - 1 ) / chunks;
+            auto const& func = [&]( std::uint_least64_t chunk )
             {
-                f( *(begin1+idx), *(beginn+idx)... );
+                std::uint_least64_t const first = std::min( n, chunk * chunk_size );
+                std::uint_least64_t const last = std::min( n, first + chunk_size );
+                isa_dispatch( [&]()
+                {
+                    for ( auto idx = first; idx != last; ++idx )
+                        f( *(begin1+idx), *(beginn+idx)... );
+                } );
             };
-            parallel( func, 0UL, n );
+            parallel( func, 0UL, chunks, 1UL );
             return f;
         }
 
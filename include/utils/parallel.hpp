@@ -4,12 +4,19 @@
 #include "../includes.hpp"
 #include "../config.hpp"
 #include "./range.hpp"
+#include "./thread_pool.hpp"
 
 namespace ceras
 {
 
 #if 1
 
+    ///
+    /// @brief Call func( index ) for index in [dim_first, dim_last), on the threads of the pool shared by all the parallel loops.
+    ///
+    /// The indices are split between the threads of `parallel_threads()`, which steal from each other once done with their own; no thread is created per call.
+    /// Ranges of `threshold` indices or fewer, and loops nested in a parallel loop, run on the calling thread.
+    ///
     template< typename Function, std::unsigned_integral Integer_Type >
     void parallel( Function const& func, Integer_Type dim_first, Integer_Type dim_last, unsigned long threshold = 8 ) // 1d parallel
     {
@@ -21,51 +28,18 @@ namespace ceras
         }
         else // <- this is constexpr-if, `else` is a must
         {
-            unsigned int const total_cores = std::thread::hardware_concurrency();
-
             // case of non-parallel or small jobs
-            if ( (total_cores <= 1) || ((dim_last - dim_first) <= threshold) )
-            {
-                for ( auto a : range( dim_first, dim_last ) )
-                    func( a );
-                return;
-            }
-
-            // case of small job numbers
-            std::vector<std::thread> threads;
-            if ( dim_last - dim_first <= total_cores )
+            auto const& tasks = [&func, dim_first]( unsigned long first, unsigned long last )
             {
-                for ( auto index = dim_first; index != dim_last; ++index )
-                    threads.emplace_back( std::thread{[&func, index](){ func( index ); }} );
-                for ( auto& th : threads )
-                    th.join();
-                return;
-            }
-
-            // case of more jobs than CPU cores
-            auto const& job_slice = [&func]( Integer_Type a, Integer_Type b )
-            {
-                if ( a >= b ) return;
-                while ( a != b )
-                    func(a++);
+                for ( unsigned long index = first; index != last; ++index )
+                    func( static_cast<Integer_Type>( dim_first + index ) );
             };
-
-            threads.reserve( total_cores-1 );
-            std::uint_least64_t tasks_per_thread = ( dim_last - dim_first + total_cores - 1 ) / total_cores;
-
-            for ( auto index : range( total_cores-1 ) )
+            if ( dim_last <= dim_first || ( dim_last - dim_first ) <= threshold ||
+                 !ceras_private::default_thread_pool()->run( tasks, static_cast<unsigned long>( dim_last - dim_first ) ) )
             {
-                Integer_Type first = tasks_per_thread * index + dim_first;
-                first = std::min( first, dim_last );
-                Integer_Type last =  first + tasks_per_thread;
-                last = std::min( last, dim_last );
-                threads.emplace_back( std::thread{ job_slice, first, last } );
+                for ( auto a : range( dim_first, dim_last ) )
+                    func( a );
             }
-
-            job_slice( tasks_per_thread*(total_cores-1), dim_last );
-
-            for ( auto& th : threads )
-                th.join();
         }
     }//parallel
 
@@ -94,6 +68,126 @@ namespace ceras
         parallel( func, Integer_Type{0}, dim_last );
     }//parallel
 
+    ///
+    /// @brief The work a task of a parallel loop should carry at least to pay for its scheduling, in units of `cost`, about an arithmetic operation each.
+    ///
+    inline unsigned long parallel_grain_cost = 16384UL;
+
+    namespace ceras_private
+    {
+        // the indices per task of a loop of n indices costing `cost` each, or n if the loop is better run on the calling thread
+        inline unsigned long parallel_grain( unsigned long n, double cost ) noexcept
+        {
+            double const work = static_cast<double>( n ) * std::max( cost, 0.0 );
+            if ( parallel_mode == 0 || n < 2 || parallel_threads() < 2 || work < 2.0 * static_cast<double>( parallel_grain_cost ) )
+                return std::max( n, 1UL );
+            unsigned long const tasks = std::min( parallel_threads() * 16UL, static_cast<unsigned long>( work / static_cast<double>( parallel_grain_cost ) ) );
+            return ( n + tasks - 1 ) / tasks;
+        }
+
+        // call func( first, last ) on [0, n) split in ranges of `grain` indices, on the thread pool if there are several ranges
+        template< typename Function >
+        void parallel_ranges( Function const& func, unsigned long n, unsigned long grain )
+        {
+            if ( n <= grain || !default_thread_pool()->run( func, n, grain ) )
+                for ( unsigned long first = 0; first < n; first += grain )
+                    func( first, std::min( n, first + grain ) );
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief Call func( index ) for index in [0, n), in parallel if the loop is worth it.
+    ///
+    /// @param func The body of the loop.
+    /// @param n The number of indices.
+    /// @param cost The cost of one call of func, about the number of arithmetic operations it does.
+    ///
+    /// The indices are grouped in tasks of about `parallel_grain_cost`, so that cheap loops stay on the calling thread,
+    /// and expensive ones are split in a few tasks per thread.
+    ///
+    /// \code{.cpp}
+    /// parallel_for( [&]( unsigned long idx ){ y[idx] = std::exp( x[idx] ); }, x.size(), 20.0 );
+    /// \endcode
+    ///
+    template< typename Function > requires std::invocable<Function const&, unsigned long>
+    void parallel_for( Function const& func, unsigned long n, double cost = 1.0 )
+    {
+        ceras_private::parallel_ranges( [&func]( unsigned long first, unsigned long last )
+        {
+            for ( unsigned long index = first; index != last; ++index )
+                func( index );
+        }, n, ceras_private::parallel_grain( n, cost ) );
+    }
+
+    ///
+    /// @brief Call func( row, col ) for row in [0, rows) and col in [0, cols), in parallel if the loop is worth it.
+    ///
+    /// The tasks are contiguous in the row-major order of the indices.
+    ///
+    template< typename Function > requires std::invocable<Function const&, unsigned long, unsigned long>
+    void parallel_for( Function const& func, unsigned long rows, unsigned long cols, double cost = 1.0 )
+    {
+        if ( cols == 0 )
+            return;
+        ceras_private::parallel_ranges( [&func, cols]( unsigned long first, unsigned long last )
+        {
+            unsigned long row = first / cols;
+            unsigned long col = first % cols;
+            for ( unsigned long index = first; index != last; ++index )
+            {
+                func( row, col );
+                if ( ++col == cols )
+                {
+                    col = 0;
+                    ++row;
+                }
+            }
+        }, rows * cols, ceras_private::parallel_grain( rows * cols, cost ) );
+    }
+
+    ///
+    /// @brief Call func( i, j, k ) for i in [0, dim_0), j in [0, dim_1) and k in [0, dim_2), in parallel if the loop is worth it.
+    ///
+    /// The tasks are contiguous in the row-major order of the indices.
+    ///
+    template< typename Function > requires std::invocable<Function const&, unsigned long, unsigned long, unsigned long>
+    void parallel_for( Function const& func, unsigned long dim_0, unsigned long dim_1, unsigned long dim_2, double cost = 1.0 )
+    {
+        if ( dim_1 == 0 || dim_2 == 0 )
+            return;
+        parallel_for( [&func, dim_2]( unsigned long i, unsigned long jk ){ func( i, jk / dim_2, jk % dim_2 ); }, dim_0, dim_1 * dim_2, cost );
+    }
+
+    ///
+    /// @brief Reduce [0, n) in parallel: `combine` folds, in order, the values `func( first, last, identity )` of consecutive ranges covering [0, n).
+    ///
+    /// @param n The number of indices.
+    /// @param identity The identity of `combine`, given to each range.
+    /// @param func Reduces the indices [first, last) into its last argument, and returns it.
+    /// @param combine Combines two partial results.
+    /// @param cost The cost of one index, about the number of arithmetic operations it takes.
+    ///
+    /// The ranges only depend on n, cost and `parallel_threads()`, so the result does not change from a call to another.
+    ///
+    /// \code{.cpp}
+    /// double const sum = parallel_reduce( x.size(), 0.0, [&]( unsigned long first, unsigned long last, double init ){ return std::accumulate( x.begin()+first, x.begin()+last, init ); }, std::plus<double>{} );
+    /// \endcode
+    ///
+    template< typename T, typename Function, typename Combine >
+    T parallel_reduce( unsigned long n, T const& identity, Function const& func, Combine const& combine, double cost = 1.0 )
+    {
+        unsigned long const grain = ceras_private::parallel_grain( n, cost );
+        if ( n <= grain )
+            return func( 0UL, n, identity );
+
+        std::vector<T> partials( ( n + grain - 1 ) / grain, identity );
+        ceras_private::parallel_ranges( [&]( unsigned long first, unsigned long last ){ partials[first/grain] = func( first, last, identity ); }, n, grain );
+        T ans = partials[0];
+        for ( unsigned long idx = 1; idx != partials.size(); ++idx )
+            ans = combine( ans, partials[idx] );
+        return ans;
+    }
+
 }//namespace ceras
 
 #endif//DVAOHBLMHGJXDTYKVKKSMCBAWCSHIBSLFWQARMEWBWMLKQGWFMOSTQFRQDXHJYHJELKQIHEXF
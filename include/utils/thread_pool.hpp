@@ -0,0 +1,453 @@
+#ifndef THREAD_POOL_HPP_INCLUDED_RMXQZKWTNBHVJLPGYDECAUSOIFRZMQKXTWNHBJVLPGYDCEAUSOIF
+#define THREAD_POOL_HPP_INCLUDED_RMXQZKWTNBHVJLPGYDECAUSOIFRZMQKXTWNHBJVLPGYDCEAUSOIF
+
+#include "../includes.hpp"
+#include "../config.hpp"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ceras
+{
+
+    namespace ceras_private
+    {
+        //
+        // A range of task indices [first, last) packed in 64 bits: its owner pops tasks from the front, thieves take the back half, both by compare-and-swap.
+        // Within a job, a slot is only stored to by its owner while empty, with indices it has never held before, so that a stale value is never taken for a fresh one.
+        // Between two jobs, the slots are reset by the calling thread alone, once no participant is left in the previous job.
+        //
+        struct alignas(64) task_range
+        {
+            std::atomic<std::uint64_t> bits_{ 0 };
+
+            static constexpr std::uint64_t pack( std::uint64_t first, std::uint64_t last ) noexcept
+            {
+                return ( first << 32 ) | last;
+            }
+
+            void reset( std::uint64_t first, std::uint64_t last ) noexcept
+            {
+                bits_.store( pack( first, last ), std::memory_order_release );
+            }
+
+            bool pop( std::uint64_t& task ) noexcept
+            {
+                std::uint64_t bits = bits_.load( std::memory_order_acquire );
+                for ( ;; )
+                {
+                    std::uint64_t const first = bits >> 32;
+                    std::uint64_t const last = bits & 0xffffffffULL;
+                    if ( first >= last )
+                        return false;
+                    if ( bits_.compare_exchange_weak( bits, pack( first + 1, last ), std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    {
+                        task = first;
+                        return true;
+                    }
+                }
+            }
+
+            bool steal( std::uint64_t& first, std::uint64_t& last ) noexcept
+            {
+                std::uint64_t bits = bits_.load( std::memory_order_acquire );
+                for ( ;; )
+                {
+                    std::uint64_t const begin = bits >> 32;
+                    std::uint64_t const end = bits & 0xffffffffULL;
+                    if ( begin >= end )
+                        return false;
+                    std::uint64_t const half = ( end - begin + 1 ) / 2;
+                    if ( bits_.compare_exchange_weak( bits, pack( begin, end - half ), std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    {
+                        first = end - half;
+                        last = end;
+                        return true;
+                    }
+                }
+            }
+        };
+
+        // the cpus the process may run on, read before the pool pins any thread
+        inline std::vector<unsigned long> const& available_cpus()
+        {
+            static std::vector<unsigned long> const ans = []()
+            {
+                std::vector<unsigned long> cpus;
+#if defined(__linux__)
+                cpu_set_t available;
+                if ( 0 == sched_getaffinity( 0, sizeof( available ), &available ) )
+                    for ( unsigned long cpu = 0; cpu != CPU_SETSIZE; ++cpu )
+                        if ( CPU_ISSET( cpu, &available ) )
+                            cpus.push_back( cpu );
+#endif
+                return cpus;
+            }();
+            return ans;
+        }
+
+        // restrict the calling thread to some of the available cpus, false if the platform or the cpus do not allow it
+        inline bool set_current_thread_cpus( std::vector<unsigned long> const& cpus ) noexcept
+        {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO( &set );
+            for ( auto cpu : cpus )
+            {
+                if ( cpu >= CPU_SETSIZE )
+                    return false;
+                CPU_SET( cpu, &set );
+            }
+            return !cpus.empty() && 0 == pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+#else
+            return false;
+#endif
+        }
+
+        inline bool pin_current_thread( unsigned long cpu ) noexcept
+        {
+            return set_current_thread_cpus( { cpu } );
+        }
+
+        // parse a cpu list such as "0-7,16-23" or "0,2,4", empty if malformed
+        inline std::vector<unsigned long> parse_cpu_list( std::string const& list )
+        {
+            std::vector<unsigned long> ans;
+            std::stringstream ss{ list };
+            for ( std::string item; std::getline( ss, item, ',' ); )
+            {
+                unsigned long first = 0;
+                unsigned long last = 0;
+                char dash = 0;
+                std::stringstream is{ item };
+                if ( !( is >> first ) )
+                    return {};
+                last = first;
+                if ( ( is >> dash ) && ( dash != '-' || !( is >> last ) || last < first ) )
+                    return {};
+                for ( unsigned long cpu = first; cpu <= last; ++cpu )
+                    ans.push_back( cpu );
+            }
+            return ans;
+        }
+
+        // true in the workers of the pool, and in a thread while it runs the tasks of a parallel job
+        inline bool& in_parallel_region() noexcept
+        {
+            thread_local bool ans = false;
+            return ans;
+        }
+
+        //
+        // The persistent threads shared by all the `parallel` calls.
+        //
+        // A job of n tasks is split in contiguous ranges, one per participant, the calling thread being one of them.
+        // Each participant pops the tasks of its range, then steals half of the remaining range of another, until no task is left.
+        // Idle workers spin for a short while, then sleep until the next job. Jobs posted from a task, or while another job runs, run on the calling thread.
+        //
+        class thread_pool
+        {
+            std::vector<std::thread> workers_;
+            std::unique_ptr<task_range[]> ranges_;
+            unsigned long participants_ = 1;
+            std::vector<unsigned long> cpus_; // participant i runs on cpus_[i % cpus_.size()], unpinned if empty
+
+            // the job: task t calls invoke_( function_, first, last ) for the indices [t*grain_, min((t+1)*grain_, count_))
+            void (*invoke_)( void const*, unsigned long, unsigned long ) = nullptr;
+            void const* function_ = nullptr;
+            unsigned long count_ = 0;
+            unsigned long grain_ = 1;
+            std::atomic<unsigned long> pending_{ 0 };
+            std::exception_ptr exception_;
+            std::mutex exception_mutex_;
+
+            std::atomic<bool> busy_{ false };
+            std::atomic<bool> open_{ false }; // workers join the job only while it is open
+            std::atomic<unsigned long> active_{ 0 }; // the workers inside `work`
+            std::atomic<unsigned long> generation_{ 0 };
+            std::atomic<bool> stop_{ false };
+            std::mutex sleep_mutex_;
+            std::condition_variable wake_;
+
+            template< typename Function >
+            static void invoke( void const* function, unsigned long first, unsigned long last )
+            {
+                ( *static_cast<Function const*>( function ) )( first, last );
+            }
+
+            void run_task( std::uint64_t task )
+            {
+                unsigned long const first = task * grain_;
+                unsigned long const last = std::min( count_, first + grain_ );
+                try
+                {
+                    invoke_( function_, first, last );
+                }
+                catch ( ... )
+                {
+                    std::lock_guard<std::mutex> const lock{ exception_mutex_ };
+                    if ( !exception_ )
+                        exception_ = std::current_exception();
+                }
+                pending_.fetch_sub( 1, std::memory_order_acq_rel );
+            }
+
+            // run the tasks of the participant `self`, then those stolen from the others, until all the ranges are empty
+            void work( unsigned long self )
+            {
+                task_range& own = ranges_[self];
+                for ( ;; )
+                {
+                    for ( std::uint64_t task; own.pop( task ); )
+                        run_task( task );
+                    bool stolen = false;
+                    for ( unsigned long offset = 1; offset != participants_ && !stolen; ++offset )
+                    {
+                        std::uint64_t first;
+                        std::uint64_t last;
+                        if ( ranges_[( self + offset ) % participants_].steal( first, last ) )
+                        {
+                            own.reset( first, last );
+                            stolen = true;
+                        }
+                    }
+                    if ( !stolen )
+                        return;
+                }
+            }
+
+            // a worker woken late may find the job over, or the ranges of the next one being reset: it only runs a job still open,
+            // and `run` closes its job, then waits for the workers still inside before resetting the ranges
+            void join( unsigned long self )
+            {
+                active_.fetch_add( 1 );
+                if ( open_.load() )
+                    work( self );
+                active_.fetch_sub( 1, std::memory_order_release );
+            }
+
+            void worker_loop( unsigned long self )
+            {
+                if ( !cpus_.empty() )
+                    pin_current_thread( cpus_[self % cpus_.size()] );
+                in_parallel_region() = true;
+                unsigned long seen = generation_.load( std::memory_order_acquire );
+                for ( ;; )
+                {
+                    // spin for the next job of a tight loop of parallel calls, then sleep
+                    for ( unsigned long spin = 0; spin != 4096 && generation_.load( std::memory_order_acquire ) == seen && !stop_.load( std::memory_order_relaxed ); ++spin )
+                        std::this_thread::yield();
+                    {
+                        std::unique_lock<std::mutex> lock{ sleep_mutex_ };
+                        wake_.wait( lock, [&](){ return generation_.load( std::memory_order_acquire ) != seen || stop_.load( std::memory_order_acquire ); } );
+                    }
+                    if ( stop_.load( std::memory_order_acquire ) )
+                        return;
+                    seen = generation_.load( std::memory_order_acquire );
+                    join( self );
+                }
+            }
+
+            void start( unsigned long participants, std::vector<unsigned long> const& cpus )
+            {
+                participants_ = std::max( 1UL, participants );
+                // the calling thread is participant 0, and the workers inherit its cpus before pinning themselves
+                if ( !cpus.empty() )
+                    pin_current_thread( cpus[0] );
+                else if ( !cpus_.empty() )
+                    set_current_thread_cpus( available_cpus() );
+                cpus_ = cpus;
+                ranges_.reset( new task_range[participants_] );
+                stop_.store( false, std::memory_order_release );
+                for ( unsigned long self = 1; self < participants_; ++self )
+                    workers_.emplace_back( [this, self](){ worker_loop( self ); } );
+            }
+
+            void stop()
+            {
+                {
+                    std::lock_guard<std::mutex> const lock{ sleep_mutex_ };
+                    stop_.store( true, std::memory_order_release );
+                }
+                wake_.notify_all();
+                for ( auto& worker : workers_ )
+                    worker.join();
+                workers_.clear();
+            }
+
+        public:
+            explicit thread_pool( unsigned long participants, std::vector<unsigned long> const& cpus = {} )
+            {
+                start( participants, cpus );
+            }
+
+            ~thread_pool()
+            {
+                stop();
+            }
+
+            thread_pool( thread_pool const& ) = delete;
+            thread_pool& operator=( thread_pool const& ) = delete;
+
+            // the threads running a job, the calling one included
+            unsigned long size() const noexcept
+            {
+                return participants_;
+            }
+
+            // the cpus the threads are pinned to, empty if they are not
+            std::vector<unsigned long> const& cpus() const noexcept
+            {
+                return cpus_;
+            }
+
+            // restart with `participants` threads, the calling one included, pinned to `cpus`, once the running job is over
+            void resize( unsigned long participants, std::vector<unsigned long> const& cpus )
+            {
+                for ( bool expected = false; !busy_.compare_exchange_weak( expected, true, std::memory_order_acquire ); expected = false )
+                    std::this_thread::yield();
+                stop();
+                start( participants, cpus );
+                busy_.store( false, std::memory_order_release );
+            }
+
+            //
+            // run func( first, last ) on the ranges [t*grain, min((t+1)*grain, count)) covering [0, count), on the threads of the pool;
+            // a grain of 0 makes a few ranges per thread. False, running nothing, if called from a task or while another job runs.
+            //
+            template< typename Function >
+            bool run( Function const& func, unsigned long count, unsigned long grain = 0 )
+            {
+                if ( count == 0 )
+                    return true;
+                if ( in_parallel_region() || participants_ <= 1 )
+                    return false;
+                bool expected = false;
+                if ( !busy_.compare_exchange_strong( expected, true, std::memory_order_acquire ) )
+                    return false;
+
+                // a few tasks per participant, so that the stolen halves still balance the load
+                unsigned long const max_tasks = grain ? 0xffffffffUL : std::min( participants_ * 16UL, 0xffffffffUL );
+                grain_ = std::max( grain, ( count + max_tasks - 1 ) / max_tasks );
+                unsigned long const tasks = ( count + grain_ - 1 ) / grain_;
+                invoke_ = &invoke<Function>;
+                function_ = &func;
+                count_ = count;
+                exception_ = nullptr;
+                pending_.store( tasks, std::memory_order_relaxed );
+                for ( unsigned long self = 0; self != participants_; ++self )
+                    ranges_[self].reset( tasks * self / participants_, tasks * ( self + 1 ) / participants_ );
+                open_.store( true );
+                {
+                    std::lock_guard<std::mutex> const lock{ sleep_mutex_ };
+                    generation_.fetch_add( 1, std::memory_order_acq_rel );
+                }
+                wake_.notify_all();
+
+                in_parallel_region() = true;
+                work( 0 );
+                while ( pending_.load( std::memory_order_acquire ) )
+                    std::this_thread::yield();
+                open_.store( false );
+                while ( active_.load() ) // a worker may still be stealing from an empty range, and storing to its own
+                    std::this_thread::yield();
+                in_parallel_region() = false;
+
+                std::exception_ptr const exception = exception_;
+                busy_.store( false, std::memory_order_release );
+                if ( exception )
+                    std::rethrow_exception( exception );
+                return true;
+            }
+        };
+
+        //
+        // The pool of the parallel loops, sized by the environment variables
+        //  - CERAS_NUM_THREADS, the number of threads, the calling thread included,
+        //  - CERAS_CPU_AFFINITY, a cpu list such as "0-7,16-23" the threads are pinned to, one thread per cpu unless CERAS_NUM_THREADS says otherwise,
+        // and by default with a thread per hardware thread, unpinned.
+        //
+        inline std::unique_ptr<thread_pool>& default_thread_pool()
+        {
+            static std::unique_ptr<thread_pool> ans = []()
+            {
+                available_cpus();
+                std::vector<unsigned long> cpus;
+                if ( char const* env = std::getenv( "CERAS_CPU_AFFINITY" ); env )
+                    cpus = parse_cpu_list( env );
+                unsigned long threads = cpus.empty() ? std::max( 1U, std::thread::hardware_concurrency() ) : cpus.size();
+                if ( char const* env = std::getenv( "CERAS_NUM_THREADS" ); env && std::atol( env ) > 0 )
+                    threads = std::atol( env );
+                return std::make_unique<thread_pool>( parallel_mode ? threads : 1UL, cpus );
+            }();
+            return ans;
+        }
+    }//namespace ceras_private
+
+    ///
+    /// @brief The number of threads running the parallel loops of the library, the calling thread included; the number of hardware threads by default.
+    ///
+    inline unsigned long parallel_threads()
+    {
+        return ceras_private::default_thread_pool()->size();
+    }
+
+    ///
+    /// @brief Set the number of threads running the parallel loops of the library, the calling thread included, 0 for the number of hardware threads.
+    ///
+    /// The pool is restarted once the running loop is over. Without parallel support (`NOPARALLEL`), the loops stay on the calling thread.
+    ///
+    /// \code{.cpp}
+    /// set_parallel_threads( 4 ); // the calling thread and 3 workers
+    /// \endcode
+    ///
+    inline void set_parallel_threads( unsigned long threads )
+    {
+        if ( threads == 0 )
+            threads = std::max( 1U, std::thread::hardware_concurrency() );
+        auto& pool = ceras_private::default_thread_pool();
+        pool->resize( parallel_mode ? threads : 1UL, pool->cpus() );
+    }
+
+    ///
+    /// @brief Pin the threads running the parallel loops to `cpus`, the calling thread to the first one, and the i-th worker to `cpus[i % cpus.size()]`.
+    ///
+    /// @param cpus The cpus, for example those of a socket, to confine a job to; an empty list stops pinning the workers.
+    /// @param threads The number of threads, the calling one included; 0 for one thread per cpu.
+    ///
+    /// Returns false if a cpu is not available to the process, or if the platform does not support pinning (only Linux does), leaving the threads unchanged.
+    /// The same can be done before the first parallel loop with the environment variables CERAS_CPU_AFFINITY, a cpu list such as "0-7,16-23", and CERAS_NUM_THREADS.
+    ///
+    /// \code{.cpp}
+    /// set_parallel_affinity( {0, 1, 2, 3, 4, 5, 6, 7} ); // 8 threads on the cpus 0 to 7
+    /// \endcode
+    ///
+    inline bool set_parallel_affinity( std::vector<unsigned long> const& cpus, unsigned long threads = 0 )
+    {
+        auto& pool = ceras_private::default_thread_pool();
+        if ( cpus.empty() )
+        {
+            pool->resize( pool->size(), cpus );
+            return true;
+        }
+        auto const& available = ceras_private::available_cpus();
+        for ( auto cpu : cpus )
+            if ( std::find( available.begin(), available.end(), cpu ) == available.end() )
+                return false;
+        pool->resize( parallel_mode ? ( threads ? threads : cpus.size() ) : 1UL, cpus );
+        return true;
+    }
+
+    ///
+    /// @brief The cpus the threads running the parallel loops are pinned to, empty if they are not.
+    ///
+    inline std::vector<unsigned long> parallel_affinity()
+    {
+        return ceras_private::default_thread_pool()->cpus();
+    }
+
+}//namespace ceras
+
+#endif//THREAD_POOL_HPP_INCLUDED_RMXQZKWTNBHVJLPGYDECAUSOIFRZMQKXTWNHBJVLPGYDCEAUSOIF
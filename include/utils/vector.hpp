@@ -22,21 +22,26 @@ namespace ceras
 
         unsigned long size_;
         pointer data_;
+        bool borrowed_ = false; // the storage is lent by an arena, not deallocated by this vector
 
         constexpr vector( vector && other ) noexcept
         {
             size_ = other.size_;
             data_ = other.data_;
+            borrowed_ = other.borrowed_;
             other.size_ = 0;
             other.data_ = nullptr;
+            other.borrowed_ = false;
         }
 
         constexpr vector& operator = ( vector && other ) noexcept
         {
             size_ = other.size_;
             data_ = other.data_;
+            borrowed_ = other.borrowed_;
             other.size_ = 0;
             other.data_ = nullptr;
+            other.borrowed_ = false;
             return *this;
         }
 
@@ -77,13 +82,28 @@ namespace ceras
 
         constexpr void clear()
         {
-            if ( !empty() )
+            if ( !empty() && !borrowed_ )
             {
                 allocator_type alloc;
                 alloc.deallocate( data_, size_ );
             }
             data_ = nullptr;
             size_ = 0;
+            borrowed_ = false;
+        }
+
+        // use `size` elements starting from `data` as the storage, which should outlive this vector or be replaced before being released
+        constexpr void borrow( pointer data, unsigned long size ) noexcept
+        {
+            clear();
+            data_ = data;
+            size_ = size;
+            borrowed_ = size != 0;
+        }
+
+        constexpr bool borrowed() const noexcept
+        {
+            return borrowed_;
         }
 
         constexpr void resize( unsigned long size )
@@ -23,12 +23,21 @@ namespace ceras
     template< Tensor Tsor >
     ceras_private::session<Tsor>& get_default_session();
 
+    template< typename T >
+    struct packed_data_cache
+    {
+        packed_matrix<T> matrix_;
+        unsigned long version_ = -1UL;
+    };
+
     template< Tensor Tsor >
     struct variable_state
     {
         Tsor data_;
         Tsor gradient_;
         std::vector<Tsor> contexts_;
+        unsigned long version_ = 0; // increased by every write access to data_, invalidating the packed copies
+        std::array<packed_data_cache<typename Tsor::value_type>, 4> packed_; // gemm-ready copies of data_, as [rhs, transposed rhs, lhs, transposed lhs]
     };
 
     template< typename Float > requires std::floating_point<Float>
@@ -129,9 +138,13 @@ namespace ceras
             return state.contexts_;
         }
 
+        ///
+        /// @brief Access the data for writing. The packed copies of the data are refreshed on their next use.
+        ///
         tensor_type& data()
         {
             auto& state = *((*this).state_);
+            ++state.version_;
             return state.data_;
         }
 
@@ -141,6 +154,25 @@ namespace ceras
             return state.data_;
         }
 
+        ///
+        /// @brief The data viewed as a matrix of [rows x cols], or the transpose of a [cols x rows] matrix, packed as the lhs or the rhs operand of `cpu_gemm`.
+        ///
+        /// The packed copy is reused until the data is accessed for writing by `data()`, which the optimizers do once per step, or until `set_isa` changes the micro-kernel.
+        /// Thus inference packs a weight only once, and training at most once per step and layout.
+        ///
+        packed_matrix<value_type> const& packed_data( bool as_lhs, bool transposed, unsigned long rows, unsigned long cols ) const
+        {
+            auto& state = *((*this).state_);
+            auto& cache = state.packed_[ (as_lhs ? 2 : 0) + (transposed ? 1 : 0) ];
+            if ( cache.version_ != state.version_ || cache.matrix_.rows_ != rows || cache.matrix_.cols_ != cols || cache.matrix_.isa_ != current_isa() )
+            {
+                better_assert( rows * cols == state.data_.size(), "packed_data: expecting ", state.data_.size(), " elements, but got rows = ", rows, " and cols = ", cols );
+                cache.matrix_ = as_lhs ? cpu_pack_lhs( state.data_.data(), transposed, rows, cols ) : cpu_pack_rhs( state.data_.data(), transposed, rows, cols );
+                cache.version_ = state.version_;
+            }
+            return cache.matrix_;
+        }
+
         tensor_type& gradient()
         {
             auto& state = *((*this).state_);
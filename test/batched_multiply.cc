@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+// the b-th matrix of a [B, r, c] tensor, or the tensor itself if it holds a single matrix
+template< Tensor Tsor >
+Tsor matrix_at( Tsor const& tsor, unsigned long b )
+{
+    unsigned long const r = *(tsor.shape().rbegin()+1);
+    unsigned long const c = *(tsor.shape().rbegin());
+    if ( tsor.size() == r*c )
+        return reshape( tsor, {r, c} ).deep_copy();
+    Tsor ans{ {r, c} };
+    std::copy_n( tsor.data() + b*r*c, r*c, ans.data() );
+    return ans;
+}
+
+template< Tensor Tsor >
+Tsor transposed( Tsor const& tsor )
+{
+    unsigned long const r = tsor.shape()[0];
+    unsigned long const c = tsor.shape()[1];
+    Tsor ans{ {c, r} };
+    for ( auto idx : range( r ) )
+        for ( auto jdx : range( c ) )
+            ans[jdx*r+idx] = tsor[idx*c+jdx];
+    return ans;
+}
+
+template< Tensor Tsor >
+void require_close( Tsor const& lhs, Tsor const& rhs )
+{
+    REQUIRE( lhs.size() == rhs.size() );
+    for ( auto idx : range( lhs.size() ) )
+        REQUIRE( std::abs( lhs[idx] - rhs[idx] ) < 1.0e-4 );
+}
+
+TEST_CASE( "batched_multiply_tensor", "[batched_multiply]" )
+{
+    unsigned long const batch = 5;
+    for ( auto [lhs_batch, rhs_batch] : { std::make_pair(batch, batch), std::make_pair(1UL, batch), std::make_pair(batch, 1UL) } )
+    {
+        auto a = random<float>( {lhs_batch, 7, 11} );
+        auto b = random<float>( {rhs_batch, 11, 13} );
+        auto c = bmm( a, b );
+        REQUIRE( c.shape() == std::vector<unsigned long>{ {batch, 7, 13} } );
+        for ( auto idx : range( batch ) )
+            require_close( matrix_at( c, idx ), matrix_at( a, idx ) * matrix_at( b, idx ) );
+    }
+
+    // 2D operand broadcasted to a 4D batch
+    auto a = random<double>( {2, 3, 4, 6} );
+    auto b = random<double>( {6, 5} );
+    auto c = batched_multiply( a, b );
+    REQUIRE( c.shape() == std::vector<unsigned long>{ {2, 3, 4, 5} } );
+    for ( auto idx : range( 6UL ) )
+        require_close( matrix_at( reshape( c, {6, 4, 5} ), idx ), matrix_at( reshape( a, {6, 4, 6} ), idx ) * b );
+}
+
+TEST_CASE( "batched_multiply_gradient", "[batched_multiply]" )
+{
+    unsigned long const batch = 4;
+    for ( auto [lhs_batch, rhs_batch] : { std::make_pair(batch, batch), std::make_pair(1UL, batch), std::make_pair(batch, 1UL) } )
+    {
+        auto a = variable{ random<float>( {lhs_batch, 3, 5} ) };
+        auto b = variable{ random<float>( {rhs_batch, 5, 2} ) };
+        auto ab = bmm( a, b );
+        auto& s = get_default_session<tensor<float>>();
+        auto output = s.run( ab );
+        REQUIRE( output.shape() == std::vector<unsigned long>{ {batch, 3, 2} } );
+
+        auto grad = random<float>( {batch, 3, 2} );
+        ab.backward( grad );
+
+        // reference: per-matrix gradients, summed over a broadcasted operand
+        auto a_grad = zeros<float>( {lhs_batch, 3, 5} );
+        auto b_grad = zeros<float>( {rhs_batch, 5, 2} );
+        for ( auto idx : range( batch ) )
+        {
+            auto const& g = matrix_at( grad, idx );
+            auto const& da = multiply( g, transposed( matrix_at( b.data(), idx ) ) );
+            auto const& db = multiply( transposed( matrix_at( a.data(), idx ) ), g );
+            unsigned long const ia = (lhs_batch == 1) ? 0 : idx;
+            unsigned long const ib = (rhs_batch == 1) ? 0 : idx;
+            for ( auto jdx : range( da.size() ) )
+                a_grad[ia*da.size()+jdx] += da[jdx];
+            for ( auto jdx : range( db.size() ) )
+                b_grad[ib*db.size()+jdx] += db[jdx];
+        }
+        require_close( a.gradient(), a_grad );
+        require_close( b.gradient(), b_grad );
+    }
+}
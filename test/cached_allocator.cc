@@ -0,0 +1,164 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+TEST_CASE( "cached_allocator_size_classes", "[cached_allocator]" )
+{
+    using namespace ceras_private;
+    REQUIRE( memory_class( 0 ) == 0 );
+    REQUIRE( memory_class( 64 ) == 0 );
+    REQUIRE( memory_class( 65 ) == 1 );
+    REQUIRE( memory_class_size( 1 ) == 80 );
+    REQUIRE( memory_class_size( 4 ) == 128 );
+    REQUIRE( memory_class_size( 5 ) == 160 );
+    REQUIRE( memory_class( ~0UL ) == memory_classes - 1 );
+
+    unsigned long previous = 0;
+    for ( unsigned long size = 1; size < ( 1UL << 40 ); size = size + 1 + size / 7 )
+    {
+        unsigned long const c = memory_class( size );
+        REQUIRE( c >= previous );
+        REQUIRE( memory_class_size( c ) >= size );
+        REQUIRE( ( c == 0 || memory_class_size( c - 1 ) < size ) );
+        REQUIRE( ( size <= 64 || memory_class_size( c ) * 4 <= size * 5 + 4 ) ); // at most a fifth wasted
+        previous = c;
+    }
+}
+
+TEST_CASE( "cached_allocator_reuse", "[cached_allocator]" )
+{
+    cached_allocator<float> alloc;
+    float* a = alloc.allocate( 1000 );
+    REQUIRE( reinterpret_cast<std::uintptr_t>( a ) % memory_alignment == 0 );
+    alloc.deallocate( a, 1000 );
+    // another size of the same class reuses the block, zeroed
+    float* b = alloc.allocate( 1010 );
+    REQUIRE( a == b );
+    for ( auto idx : range( 1010UL ) )
+        REQUIRE( b[idx] == 0.0f );
+    alloc.deallocate( b, 1010 );
+
+    // large blocks are shared between the threads
+    float* large = alloc.allocate( 1UL << 22 );
+    alloc.deallocate( large, 1UL << 22 );
+    float* reused = nullptr;
+    std::thread{ [&](){ reused = cached_allocator<float>{}.allocate( ( 1UL << 22 ) - 100 ); } }.join();
+    REQUIRE( reused == large );
+    alloc.deallocate( reused, ( 1UL << 22 ) - 100 );
+
+    // the blocks of an exiting thread go to the shared cache
+    float* small = nullptr;
+    std::thread{ [&](){ cached_allocator<float> a; small = a.allocate( 333 ); a.deallocate( small, 333 ); } }.join();
+    float* again = nullptr;
+    std::thread{ [&](){ again = cached_allocator<float>{}.allocate( 333 ); } }.join();
+    REQUIRE( again == small );
+    alloc.deallocate( again, 333 );
+}
+
+TEST_CASE( "cached_allocator_threads", "[cached_allocator]" )
+{
+    // blocks allocated, written, checked and freed concurrently, some freed by another thread than the one allocating them
+    unsigned long const threads = 8;
+    std::vector<std::vector<std::pair<unsigned long*, unsigned long>>> handed( threads );
+    std::vector<std::mutex> mutexes( threads );
+    std::atomic<unsigned long> errors{ 0 };
+    std::vector<std::thread> workers;
+    for ( auto t : range( threads ) )
+        workers.emplace_back( [&, t]()
+        {
+            cached_allocator<unsigned long> alloc;
+            std::mt19937 engine{ static_cast<unsigned int>( t ) };
+            for ( unsigned long iteration = 0; iteration != 5000; ++iteration )
+            {
+                unsigned long const n = 1 + engine() % ( iteration % 10 == 0 ? 100000 : 1000 );
+                unsigned long* p = alloc.allocate( n );
+                for ( auto idx : range( n ) )
+                    if ( p[idx] != 0 )
+                        errors.fetch_add( 1 );
+                for ( auto idx : range( n ) )
+                    p[idx] = t * 1000003 + iteration;
+                std::this_thread::yield();
+                for ( auto idx : range( n ) )
+                    if ( p[idx] != t * 1000003 + iteration )
+                        errors.fetch_add( 1 );
+                std::fill( p, p + n, 0UL );
+                if ( iteration % 3 == 0 )
+                {
+                    std::lock_guard<std::mutex> const lock{ mutexes[( t + 1 ) % threads] };
+                    handed[( t + 1 ) % threads].emplace_back( p, n );
+                }
+                else
+                {
+                    alloc.deallocate( p, n );
+                }
+                std::lock_guard<std::mutex> const lock{ mutexes[t] };
+                for ( auto [q, m] : handed[t] )
+                    alloc.deallocate( q, m );
+                handed[t].clear();
+            }
+        } );
+    for ( auto& worker : workers )
+        worker.join();
+    REQUIRE( errors.load() == 0 );
+    for ( auto& blocks : handed )
+        for ( auto [q, m] : blocks )
+            cached_allocator<unsigned long>{}.deallocate( q, m );
+}
+
+TEST_CASE( "cached_allocator_sessions", "[cached_allocator]" )
+{
+    // tensors computed in several threads at once
+    unsigned long const threads = 4;
+    std::vector<double> errors( threads, 0.0 );
+    std::vector<std::thread> workers;
+    for ( auto t : range( threads ) )
+        workers.emplace_back( [&errors, t]()
+        {
+            for ( [[maybe_unused]] auto _ : range( 50 ) )
+            {
+                auto const a = random<double>( {37, 41} );
+                auto const b = random<double>( {41, 29} );
+                tensor<double> const d = a * b;
+                for ( auto r : range( 37UL ) )
+                    for ( auto col : range( 29UL ) )
+                    {
+                        double expected = 0.0;
+                        for ( auto k : range( 41UL ) )
+                            expected += a[r*41+k] * b[k*29+col];
+                        errors[t] = std::max( errors[t], std::abs( d[r*29+col] - expected ) );
+                    }
+            }
+        } );
+    for ( auto& worker : workers )
+        worker.join();
+    for ( auto error : errors )
+        REQUIRE( error < 1.0e-10 );
+}
+
+TEST_CASE( "cached_allocator_benchmark", "[cached_allocator_benchmark]" )
+{
+    auto const& seconds = [&]( unsigned long threads )
+    {
+        auto const start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for ( auto t : range( threads ) )
+            workers.emplace_back( [t]()
+            {
+                std::mt19937 engine{ static_cast<unsigned int>( t ) };
+                for ( [[maybe_unused]] auto _ : range( 100000 ) )
+                {
+                    tensor<float> x{ {1 + engine() % 4096} }; // sizes rarely repeating exactly, yet of a few classes
+                    x[0] = 1.0f;
+                }
+            } );
+        for ( auto& worker : workers )
+            worker.join();
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    };
+    for ( unsigned long threads : { 1UL, 4UL } )
+        std::cout << threads << " threads, 100000 tensors of random sizes each: " << seconds( threads ) << " s" << std::endl;
+}
@@ -0,0 +1,190 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./dense_network.hpp"
+
+using namespace ceras;
+
+auto checkpointed( unsigned long segments )
+{
+    return [segments]( auto const& ex ) { return checkpoint( ex, segments ); };
+}
+
+TEST_CASE( "checkpoint_gradients", "[checkpoint]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 16;
+    auto& s = get_default_session<tensor_type>();
+    tensor_type const input = random<float>( {batch, 64} );
+    tensor_type const target = random<float>( {batch, 64}, 0.0f, 1.0f );
+
+    // the loss, and the gradients of the weights, after each of 3 training steps
+    auto const& train = [&]( auto const& wrap3, auto const& wrap6, std::vector<tensor_type> const& initial_weights )
+    {
+        auto [x, y, output, loss, weights] = make_network<tensor_type>( 64, 64, wrap3, wrap6 );
+        for ( auto idx : range( initial_weights.size() ) )
+            weights[idx].data().deep_copy( initial_weights[idx] );
+        s.bind( x, input );
+        s.bind( y, target );
+        auto optimizer = sgd{ loss, batch, 0.1f };
+
+        std::vector<float> losses;
+        std::vector<tensor_type> gradients;
+        for ( [[maybe_unused]] auto _ : range( 3 ) )
+        {
+            losses.push_back( s.run( loss ).as_scalar() );
+            loss.backward( ones<float>( {1,} ) );
+            for ( auto& w : weights )
+                gradients.push_back( w.gradient().deep_copy() );
+            s.run( optimizer );
+        }
+        std::vector<tensor_type> final_weights;
+        for ( auto& w : weights )
+            final_weights.push_back( w.data().deep_copy() );
+        return std::make_tuple( losses, gradients, final_weights );
+    };
+
+    std::vector<tensor_type> initial_weights;
+    {
+        auto [x, y, output, loss, weights] = make_network<tensor_type>( 64, 64 );
+        for ( auto& w : weights )
+            initial_weights.push_back( w.data().deep_copy() );
+    }
+    auto const& [losses, gradients, final_weights] = train( unchanged, unchanged, initial_weights );
+
+    auto const& check = [&]( auto const& wrap3, auto const& wrap6 )
+    {
+        auto const& [checked_losses, checked_gradients, checked_weights] = train( wrap3, wrap6, initial_weights );
+        for ( auto idx : range( losses.size() ) )
+            REQUIRE( checked_losses[idx] == Approx( losses[idx] ) );
+        REQUIRE( checked_gradients.size() == gradients.size() );
+        for ( auto idx : range( gradients.size() ) )
+            for ( auto jdx : range( gradients[idx].size() ) )
+                REQUIRE( checked_gradients[idx][jdx] == Approx( gradients[idx][jdx] ).margin( 1.0e-6 ) );
+        for ( auto idx : range( final_weights.size() ) )
+            for ( auto jdx : range( final_weights[idx].size() ) )
+                REQUIRE( checked_weights[idx][jdx] == Approx( final_weights[idx][jdx] ).margin( 1.0e-6 ) );
+    };
+
+    check( unchanged, checkpointed( 1 ) ); // everything recomputed from the inputs
+    check( unchanged, checkpointed( 3 ) );
+    check( unchanged, checkpointed( 0 ) ); // about sqrt(N) segments
+    check( unchanged, checkpointed( 100 ) ); // more segments than operators, nothing dropped
+    check( checkpointed( 1 ), checkpointed( 0 ) ); // nested
+}
+
+TEST_CASE( "checkpoint_in_place", "[checkpoint]" )
+{
+    // the softmax overwrites the output of the first multiplication, both dropped and recomputed in the backward pass
+    typedef tensor<float> tensor_type;
+    auto& s = get_default_session<tensor_type>();
+    auto x = place_holder<tensor_type>{};
+    auto w = variable{ random<float>( {8, 6} ) };
+    auto v = variable{ random<float>( {6, 5} ) };
+    s.bind( x, random<float>( {4, 8} ) );
+    tensor_type const grad = random<float>( {4, 5} );
+
+    auto plain = softmax( x * w ) * v;
+    tensor_type const expected_output = s.run( plain ).deep_copy();
+    plain.backward( grad.deep_copy() ); // overwritten by the backward pass
+    tensor_type const expected_gradient = w.gradient().deep_copy();
+
+    auto checked = checkpoint( softmax( x * w ) * v, 1 );
+    tensor_type const output = s.run( checked ).deep_copy();
+    checked.backward( grad.deep_copy() );
+    for ( auto idx : range( output.size() ) )
+        REQUIRE( output[idx] == Approx( expected_output[idx] ) );
+    for ( auto idx : range( expected_gradient.size() ) )
+        REQUIRE( w.gradient()[idx] == Approx( expected_gradient[idx] ).margin( 1.0e-6 ) );
+}
+
+// `h + relu( h * w )` for each of the weights from the last, every output read twice
+template< unsigned long Blocks, Expression Ex, typename Tsor >
+auto residual( Ex const& h, std::vector<variable<Tsor>> const& weights )
+{
+    if constexpr( Blocks == 0 )
+        return h;
+    else
+        return residual<Blocks-1>( h + relu( h * weights[Blocks-1] ), weights );
+}
+
+TEST_CASE( "checkpoint_residual", "[checkpoint]" )
+{
+    typedef tensor<float> tensor_type;
+    auto& s = get_default_session<tensor_type>();
+    auto x = place_holder<tensor_type>{};
+    std::vector<variable<tensor_type>> weights;
+    for ( [[maybe_unused]] auto _ : range( 12 ) )
+        weights.push_back( variable{ random<float>( {16, 16}, -0.1f, 0.1f ) } );
+    s.bind( x, random<float>( {8, 16} ) );
+    tensor_type const grad = random<float>( {8, 16} );
+
+    auto const& gradients = [&]( auto ex )
+    {
+        std::vector<tensor_type> ans{ s.run( ex ).deep_copy() };
+        ex.backward( grad.deep_copy() );
+        for ( auto& w : weights )
+            ans.push_back( w.gradient().deep_copy() );
+        return ans;
+    };
+
+    auto const& expected = gradients( residual<12>( x, weights ) );
+    for ( auto segments : { 1UL, 4UL, 0UL } )
+    {
+        auto const& checked = gradients( checkpoint( residual<12>( x, weights ), segments ) );
+        for ( auto idx : range( expected.size() ) )
+            for ( auto jdx : range( expected[idx].size() ) )
+                REQUIRE( checked[idx][jdx] == Approx( expected[idx][jdx] ).margin( 1.0e-5 ) );
+    }
+}
+
+TEST_CASE( "checkpoint_memory", "[checkpoint]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 64;
+    auto& s = get_default_session<tensor_type>();
+
+    // the largest number of bytes in use during the forward and the backward pass of a training step
+    auto const& peak = [&]( auto const& wrap6 )
+    {
+        reset_memory_peak();
+        unsigned long const before = memory_stats().in_use;
+        auto [x, y, output, loss, weights] = make_network<tensor_type>( 256, 256, unchanged, wrap6 );
+        s.bind( x, random<float>( {batch, 256} ) );
+        s.bind( y, random<float>( {batch, 256}, 0.0f, 1.0f ) );
+        for ( [[maybe_unused]] auto _ : range( 2 ) )
+        {
+            s.run( loss );
+            loss.backward( ones<float>( {1,} ) );
+        }
+        return memory_stats().peak - before;
+    };
+
+    unsigned long const plain = peak( unchanged );
+    unsigned long const checked = peak( checkpointed( 1 ) );
+    unsigned long const auto_checked = peak( []( auto const& ex ) { return checkpoint( ex ); } ); // about sqrt(N) segments by default
+    REQUIRE( checked < plain );
+    REQUIRE( auto_checked < plain );
+}
+
+TEST_CASE( "checkpoint_benchmark", "[checkpoint_benchmark]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 256;
+    auto& s = get_default_session<tensor_type>();
+
+    auto const& measure = [&]( auto const& wrap6 )
+    {
+        auto [x, y, output, loss, weights] = make_network<tensor_type>( 512, 512, unchanged, wrap6 );
+        s.bind( x, random<float>( {batch, 512} ) );
+        s.bind( y, random<float>( {batch, 512}, 0.0f, 1.0f ) );
+        auto optimizer = sgd{ loss, batch, 0.01f };
+        return benchmark_training( loss, optimizer, 10 );
+    };
+
+    auto const& [plain_seconds, plain_bytes] = measure( unchanged );
+    auto const& [checked_seconds, checked_bytes] = measure( checkpointed( 0 ) );
+    std::cout << "10 training steps of a 7-layer perceptron of width 512, batch 256: " << plain_seconds << " s with a peak of " << plain_bytes << " bytes, checkpointed "
+              << checked_seconds << " s with a peak of " << checked_bytes << " bytes" << std::endl;
+}
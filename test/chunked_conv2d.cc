@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+template< typename T >
+void check_chunks( unsigned long bs, unsigned long size, unsigned long channels, unsigned long filters, unsigned long kernel, unsigned long stride, std::string const& padding, unsigned long limit )
+{
+    auto const x = random<T>( {bs, size, size, channels} );
+    auto const w = random<T>( {filters, kernel, kernel, channels} );
+    unsigned long const pad = ( padding == "same" ) ? ( kernel - stride + ( kernel & 1 ) ) / 2 : 0;
+    unsigned long const output_size = ( size + 2 * pad - kernel ) / stride + 1;
+    auto const grad = random<T>( {bs, output_size, output_size, filters} );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, w, grad, stride, 1, padding, 1, -1UL );
+    auto const& [chunked_output, chunked_x_grad, chunked_w_grad] = convolve( conv2d_algorithm::img2col, x, w, grad, stride, 1, padding, 1, limit );
+    REQUIRE( chunked_output.shape() == output.shape() );
+    for ( auto idx : range( output.size() ) )
+        REQUIRE( chunked_output[idx] == Approx( output[idx] ) );
+    for ( auto idx : range( x_grad.size() ) )
+        REQUIRE( chunked_x_grad[idx] == Approx( x_grad[idx] ) );
+    for ( auto idx : range( w_grad.size() ) )
+        REQUIRE( chunked_w_grad[idx] == Approx( w_grad[idx] ) );
+}
+
+TEST_CASE( "chunked_conv2d", "[chunked_conv2d]" )
+{
+    REQUIRE( ceras_private::images_per_chunk<float>( 100, 1000 ) == std::min( 100UL, convolution_workspace_limit / 4000 ) );
+    unsigned long const backup_limit = convolution_workspace_limit;
+    convolution_workspace_limit = 10000;
+    REQUIRE( ceras_private::images_per_chunk<double>( 7, 100 ) == 7 );
+    REQUIRE( ceras_private::images_per_chunk<double>( 7, 500 ) == 2 );
+    REQUIRE( ceras_private::images_per_chunk<double>( 7, 5000 ) == 1 );
+    convolution_workspace_limit = backup_limit;
+
+    // a chunk of 1 image, of 3 images with a partial last chunk, and the whole batch
+    check_chunks<double>( 5, 9, 3, 4, 3, 1, "same", 1 );
+    check_chunks<double>( 7, 8, 2, 5, 3, 2, "valid", 3 * 9 * 9 * 18 * sizeof( double ) );
+    check_chunks<double>( 4, 6, 3, 2, 2, 1, "valid", -1UL );
+    check_chunks<float>( 9, 12, 8, 16, 3, 1, "same", 4 * 144 * 72 * sizeof( float ) );
+}
+
+TEST_CASE( "chunked_conv2d_winograd", "[chunked_conv2d]" )
+{
+    // Winograd transforms larger than the limit fall back to the implicit GEMM
+    conv2d_geometry const g{ 64, 28, 28, 64, 64, 3, 3, 1, 1, 1, 1, 1, 1 };
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::winograd_4x4 );
+    unsigned long const backup_limit = convolution_workspace_limit;
+    convolution_workspace_limit = 1UL << 20;
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::implicit_gemm );
+    conv2d_algorithm const backup = convolution_algorithm;
+    convolution_algorithm = conv2d_algorithm::winograd_2x2;
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::implicit_gemm );
+    convolution_algorithm = backup;
+    convolution_workspace_limit = backup_limit;
+}
+
+TEST_CASE( "chunked_conv2d_benchmark", "[chunked_conv2d_benchmark]" )
+{
+    // the img2col matrix of the whole batch is of 32*56*56*576 floats, 231 MiB
+    auto const x = random<float>( {32, 56, 56, 64} );
+    auto const w = random<float>( {64, 3, 3, 64} );
+    auto const grad = random<float>( {32, 56, 56, 64} );
+    for ( unsigned long limit : { 1UL << 30, 1UL << 26, 1UL << 23 } )
+    {
+        convolve( conv2d_algorithm::img2col, x, w, grad, 1, 1, "same", 1, limit );
+        double best = 1.0e10;
+        for ( [[maybe_unused]] auto _ : range( 3 ) )
+        {
+            auto const start = std::chrono::steady_clock::now();
+            convolve( conv2d_algorithm::img2col, x, w, grad, 1, 1, "same", 1, limit );
+            best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+        }
+        std::cout << "32 x 56 x 56 x 64 -> 64, 3x3, img2col forward and backward with a workspace limit of " << ( limit >> 20 ) << " MiB: " << best << " s" << std::endl;
+    }
+}
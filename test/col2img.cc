@@ -0,0 +1,103 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace ceras;
+
+// img2col of a random input, checked entry by entry, and its backward pass, checked as the adjoint: <img2col(x), y> == <x, col2img(y)>
+void check_img2col( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long kr, unsigned long kc,
+                    unsigned long pr, unsigned long pc, unsigned long sr, unsigned long sc, unsigned long dr, unsigned long dc )
+{
+    auto x = variable{ random<double>( {bs, rows, cols, channels} ) };
+    auto col = img2col( kr, kc, pr, pc, sr, sc, dr, dc )( x );
+    auto& s = get_default_session<tensor<double>>();
+    auto const output = s.run( col ).deep_copy();
+
+    unsigned long const output_rows = ( rows + 2 * pr - dr * ( kr - 1 ) - 1 ) / sr + 1;
+    unsigned long const output_cols = ( cols + 2 * pc - dc * ( kc - 1 ) - 1 ) / sc + 1;
+    unsigned long const pixels = bs * output_rows * output_cols;
+    REQUIRE( output.shape() == std::vector<unsigned long>{ {kr * kc * channels, pixels} } );
+    for ( auto ch : range( channels ) )
+        for ( auto r : range( kr ) )
+            for ( auto c : range( kc ) )
+                for ( auto b : range( bs ) )
+                    for ( auto y : range( output_rows ) )
+                        for ( auto z : range( output_cols ) )
+                        {
+                            std::int64_t const row = static_cast<std::int64_t>( y * sr + r * dr ) - static_cast<std::int64_t>( pr );
+                            std::int64_t const column = static_cast<std::int64_t>( z * sc + c * dc ) - static_cast<std::int64_t>( pc );
+                            bool const inside = row >= 0 && row < static_cast<std::int64_t>( rows ) && column >= 0 && column < static_cast<std::int64_t>( cols );
+                            double const expected = inside ? x.data()[( ( b * rows + row ) * cols + column ) * channels + ch] : 0.0;
+                            REQUIRE( output[( ( ch * kr + r ) * kc + c ) * pixels + ( b * output_rows + y ) * output_cols + z] == expected );
+                        }
+
+    auto const grad = random<double>( output.shape() );
+    col.backward( grad );
+    auto const x_grad = x.gradient();
+    double lhs = 0.0;
+    for ( auto idx : range( output.size() ) )
+        lhs += output[idx] * grad[idx];
+    double rhs = 0.0;
+    for ( auto idx : range( x_grad.size() ) )
+        rhs += x.data()[idx] * x_grad[idx];
+    REQUIRE( lhs == Approx( rhs ) );
+}
+
+TEST_CASE( "img2col", "[col2img]" )
+{
+    check_img2col( 1, 4, 4, 2, 3, 3, 0, 0, 1, 1, 1, 1 );
+    check_img2col( 2, 7, 9, 3, 3, 3, 1, 1, 1, 1, 1, 1 );
+    check_img2col( 3, 9, 8, 2, 2, 3, 1, 0, 2, 2, 1, 1 );
+    check_img2col( 2, 11, 13, 4, 3, 3, 2, 2, 1, 2, 2, 2 );
+    check_img2col( 1, 10, 10, 1, 5, 5, 2, 2, 3, 3, 1, 1 );
+}
+
+// the backward pass of a convolution computed through the img2col matrix, which col2img sums back to the input
+TEST_CASE( "col2img_conv2d", "[col2img]" )
+{
+    conv2d_algorithm const backup = convolution_algorithm;
+    for ( auto [stride, dilation] : { std::make_tuple( 1UL, 1UL ), std::make_tuple( 2UL, 1UL ), std::make_tuple( 1UL, 2UL ) } )
+    {
+        auto const x = random<double>( {2, 10, 11, 3} );
+        auto const w = random<double>( {4, 3, 3, 3} );
+        tensor<double> x_grads[2];
+        for ( auto idx : range( 2UL ) )
+        {
+            convolution_algorithm = ( idx == 0 ) ? conv2d_algorithm::img2col : conv2d_algorithm::implicit_gemm;
+            auto vx = variable{ x.deep_copy() };
+            auto vw = variable{ w.deep_copy() };
+            auto y = general_conv2d( stride, stride, dilation, dilation, "valid" )( vx, vw );
+            auto& s = get_default_session<tensor<double>>();
+            auto const output = s.run( y );
+            y.backward( ones_like( output ) );
+            x_grads[idx] = vx.gradient().deep_copy();
+        }
+        for ( auto idx : range( x.size() ) )
+            REQUIRE( x_grads[0][idx] == Approx( x_grads[1][idx] ) );
+    }
+    convolution_algorithm = backup;
+}
+
+TEST_CASE( "col2img_benchmark", "[col2img_benchmark]" )
+{
+    auto x = variable{ random<float>( {16, 56, 56, 64} ) };
+    auto col = img2col( 3, 3, 1, 1 )( x );
+    auto& s = get_default_session<tensor<float>>();
+    auto const output = s.run( col );
+    auto const grad = random<float>( output.shape() );
+    double forward = 1.0e10;
+    double backward = 1.0e10;
+    for ( [[maybe_unused]] auto _ : range( 3 ) )
+    {
+        auto const start = std::chrono::steady_clock::now();
+        s.run( col );
+        auto const middle = std::chrono::steady_clock::now();
+        col.backward( grad );
+        forward = std::min( forward, std::chrono::duration<double>( middle - start ).count() );
+        backward = std::min( backward, std::chrono::duration<double>( std::chrono::steady_clock::now() - middle ).count() );
+    }
+    std::cout << "img2col of 16 x 56 x 56 x 64 by 3 x 3: forward " << forward << " s, backward " << backward << " s" << std::endl;
+}
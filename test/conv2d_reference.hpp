@@ -0,0 +1,49 @@
+#ifndef TKQWZNBMRLEHYUDOAXVGCJPSIFKTNWQZEMRHLYBUDAOXCVGSJPTIKFNWZQMERHYLBDUXAOVCGS
+#define TKQWZNBMRLEHYUDOAXVGCJPSIFKTNWQZEMRHLYBUDAOXCVGSJPTIKFNWZQMERHYLBDUXAOVCGS
+
+//
+// Shared by the tests comparing the convolution algorithms against each other.
+//
+
+#include "catch.hpp"
+#include "../include/ceras.hpp"
+#include <cmath>
+
+// output, input gradient and kernel gradient of a convolution computed by `algorithm`, with at most `workspace_limit` bytes of workspace
+// an empty `grad` back-propagates ones
+template< typename T >
+auto convolve( ceras::conv2d_algorithm algorithm, ceras::tensor<T> const& x, ceras::tensor<T> const& w, ceras::tensor<T> const& grad,
+               unsigned long stride = 1, unsigned long dilation = 1, std::string const& padding = "valid", unsigned long groups = 1,
+               unsigned long workspace_limit = ceras::convolution_workspace_limit )
+{
+    using namespace ceras;
+    conv2d_algorithm const backup = convolution_algorithm;
+    unsigned long const backup_limit = convolution_workspace_limit;
+    convolution_algorithm = algorithm;
+    convolution_workspace_limit = workspace_limit;
+    auto vx = variable{ x.deep_copy() };
+    auto vw = variable{ w.deep_copy() };
+    auto y = general_conv2d( stride, stride, dilation, dilation, padding, groups )( vx, vw );
+    auto& s = get_default_session<tensor<T>>();
+    auto output = s.run( y ).deep_copy();
+    y.backward( grad.empty() ? ones_like( output ) : grad );
+    convolution_algorithm = backup;
+    convolution_workspace_limit = backup_limit;
+    return std::make_tuple( output, vx.gradient().deep_copy(), vw.gradient().deep_copy() );
+}
+
+template< typename T >
+double relative_error( ceras::tensor<T> const& x, ceras::tensor<T> const& y )
+{
+    REQUIRE( x.shape() == y.shape() );
+    double diff = 0.0;
+    double norm = 0.0;
+    for ( auto idx : ceras::range( x.size() ) )
+    {
+        diff += ( x[idx] - y[idx] ) * ( x[idx] - y[idx] );
+        norm += y[idx] * y[idx];
+    }
+    return std::sqrt( diff / std::max( norm, 1.0e-20 ) );
+}
+
+#endif//TKQWZNBMRLEHYUDOAXVGCJPSIFKTNWQZEMRHLYBUDAOXCVGSJPTIKFNWZQMERHYLBDUXAOVCGS
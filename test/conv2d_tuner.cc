@@ -0,0 +1,128 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+namespace
+{
+    std::filesystem::path temporary_cache()
+    {
+        auto const ans = std::filesystem::temp_directory_path() / "ceras_test_conv2d_tuner" / "conv2d_tuning.txt";
+        std::filesystem::remove( ans );
+        ceras_private::tuned_conv2d_algorithms().clear();
+        return ans;
+    }
+}
+
+TEST_CASE( "conv2d_algorithm_candidates", "[conv2d_tuner]" )
+{
+    conv2d_geometry const g{ 8, 28, 28, 32, 64, 3, 3, 1, 1, 1, 1, 1, 1 };
+    auto const candidates = ceras_private::conv2d_algorithm_candidates<float>( g );
+    REQUIRE( candidates == std::vector<conv2d_algorithm>{ { conv2d_algorithm::winograd_4x4, conv2d_algorithm::img2col, conv2d_algorithm::implicit_gemm, conv2d_algorithm::winograd_2x2 } } );
+
+    conv2d_geometry pointwise = g;
+    pointwise.kernel_rows = pointwise.kernel_cols = 1;
+    pointwise.row_padding = pointwise.col_padding = 0;
+    REQUIRE( ceras_private::conv2d_algorithm_candidates<float>( pointwise ) == std::vector<conv2d_algorithm>{ { conv2d_algorithm::pointwise, conv2d_algorithm::img2col, conv2d_algorithm::implicit_gemm } } );
+
+    // a single candidate is selected without tuning
+    conv2d_geometry depthwise = g;
+    depthwise.filters = depthwise.groups = depthwise.channels;
+    REQUIRE( select_conv2d_algorithm<float>( depthwise, conv2d_algorithm::autotuned ) == conv2d_algorithm::depthwise );
+}
+
+TEST_CASE( "save_load_conv2d_algorithm", "[conv2d_tuner]" )
+{
+    auto const cache = temporary_cache();
+    REQUIRE( !load_conv2d_algorithm( "layer a", cache ) );
+    REQUIRE( save_conv2d_algorithm( "layer a", conv2d_algorithm::winograd_2x2, cache ) );
+    REQUIRE( save_conv2d_algorithm( "layer b", conv2d_algorithm::pointwise, cache ) );
+    REQUIRE( save_conv2d_algorithm( "layer a", conv2d_algorithm::implicit_gemm, cache ) ); // replacing the first one
+
+    // from this process, then from the file
+    for ( [[maybe_unused]] auto _ : range( 2 ) )
+    {
+        REQUIRE( load_conv2d_algorithm( "layer a", cache ) == conv2d_algorithm::implicit_gemm );
+        REQUIRE( load_conv2d_algorithm( "layer b", cache ) == conv2d_algorithm::pointwise );
+        REQUIRE( !load_conv2d_algorithm( "layer c", cache ) );
+        ceras_private::tuned_conv2d_algorithms().clear();
+    }
+    std::filesystem::remove( cache );
+}
+
+TEST_CASE( "autotuned_conv2d", "[conv2d_tuner]" )
+{
+    auto const cache = temporary_cache();
+    setenv( "CERAS_CONV2D_TUNING_CACHE", cache.c_str(), 1 );
+
+    auto const x = random<double>( {4, 10, 10, 8} );
+    auto const w = random<double>( {6, 3, 3, 8} );
+    conv2d_geometry const g{ 4, 10, 10, 8, 6, 3, 3, 1, 1, 1, 1, 1, 1 };
+    REQUIRE( select_conv2d_algorithm<double>( g, conv2d_algorithm::autotuned ) == conv2d_algorithm::autotuned );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, w, tensor<double>{}, 1, 1, "same" );
+    auto const& [tuned_output, tuned_x_grad, tuned_w_grad] = convolve( conv2d_algorithm::autotuned, x, w, tensor<double>{}, 1, 1, "same" );
+    for ( auto idx : range( output.size() ) )
+        REQUIRE( tuned_output[idx] == Approx( output[idx] ) );
+    for ( auto idx : range( x_grad.size() ) )
+        REQUIRE( tuned_x_grad[idx] == Approx( x_grad[idx] ) );
+    for ( auto idx : range( w_grad.size() ) )
+        REQUIRE( tuned_w_grad[idx] == Approx( w_grad[idx] ) );
+
+    // the choice is kept for the process and in the cache file
+    auto const tuned = select_conv2d_algorithm<double>( g, conv2d_algorithm::autotuned );
+    auto const candidates = ceras_private::conv2d_algorithm_candidates<double>( g );
+    REQUIRE( std::find( candidates.begin(), candidates.end(), tuned ) != candidates.end() );
+    ceras_private::tuned_conv2d_algorithms().clear();
+    REQUIRE( load_conv2d_algorithm( conv2d_tuning_key<double>( g ) ) == tuned );
+
+    // the next convolutions of the geometry keep the algorithm selected at the first one, without looking it up
+    {
+        conv2d_algorithm const backup = convolution_algorithm;
+        convolution_algorithm = conv2d_algorithm::autotuned;
+        auto vx = variable{ x.deep_copy() };
+        auto vw = variable{ w.deep_copy() };
+        auto y = general_conv2d( 1, 1, 1, 1, "same" )( vx, vw );
+        auto& s = get_default_session<tensor<double>>();
+        s.run( y );
+        ceras_private::tuned_conv2d_algorithms().clear();
+        std::filesystem::remove( cache );
+        auto const again = s.run( y ).deep_copy();
+        REQUIRE( ceras_private::tuned_conv2d_algorithms().empty() );
+        for ( auto idx : range( output.size() ) )
+            REQUIRE( again[idx] == Approx( output[idx] ) );
+        convolution_algorithm = backup;
+    }
+
+    unsetenv( "CERAS_CONV2D_TUNING_CACHE" );
+    std::filesystem::remove( cache );
+}
+
+TEST_CASE( "conv2d_tuner_benchmark", "[conv2d_tuner_benchmark]" )
+{
+    auto const cache = temporary_cache();
+    setenv( "CERAS_CONV2D_TUNING_CACHE", cache.c_str(), 1 );
+    // layers of vgg16 at batch 8, input size, channels, filters
+    for ( auto [size, channels, filters] : { std::make_tuple( 224UL, 3UL, 64UL ), std::make_tuple( 112UL, 64UL, 128UL ), std::make_tuple( 56UL, 128UL, 256UL ),
+                                             std::make_tuple( 28UL, 256UL, 512UL ), std::make_tuple( 14UL, 512UL, 512UL ) } )
+    {
+        auto const x = random<float>( {8, size, size, channels} );
+        auto const w = random<float>( {filters, 3, 3, channels} );
+        auto const start = std::chrono::steady_clock::now();
+        convolve( conv2d_algorithm::autotuned, x, w, tensor<float>{}, 1, 1, "same" );
+        double const tuning = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        auto const& seconds = [&]( conv2d_algorithm algorithm )
+        {
+            return ceras_private::shortest_time( [&](){ convolve( algorithm, x, w, tensor<float>{}, 1, 1, "same" ); }, 2 );
+        };
+        conv2d_geometry const g{ 8, size, size, channels, filters, 3, 3, 1, 1, 1, 1, 1, 1 };
+        std::cout << "8 x " << size << " x " << size << " x " << channels << " -> " << filters << ": tuned " << conv2d_algorithm_name( select_conv2d_algorithm<float>( g, conv2d_algorithm::autotuned ) )
+                  << " in " << tuning << " s, forward and backward: tuned " << seconds( conv2d_algorithm::autotuned ) << " s, automatic " << seconds( conv2d_algorithm::automatic ) << " s" << std::endl;
+    }
+    unsetenv( "CERAS_CONV2D_TUNING_CACHE" );
+    std::filesystem::remove( cache );
+}
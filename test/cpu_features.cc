@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "../include/tensor.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+namespace
+{
+    // all the instruction sets this CPU can run
+    std::vector<isa> supported_isas()
+    {
+        std::vector<isa> ans;
+        for ( auto candidate : { isa::generic, isa::sse42, isa::avx2, isa::avx512 } )
+            if ( candidate <= detected_isa() )
+                ans.push_back( candidate );
+        return ans;
+    }
+}
+
+TEST_CASE( "set_isa", "[cpu_features]" )
+{
+    isa const original = current_isa();
+    for ( auto instruction_set : supported_isas() )
+    {
+        REQUIRE( set_isa( instruction_set ) == instruction_set );
+        REQUIRE( current_isa() == instruction_set );
+    }
+    REQUIRE( set_isa( isa::avx512 ) == detected_isa() );
+    set_isa( original );
+}
+
+TEST_CASE( "gemm_all_isas", "[cpu_features]" )
+{
+    isa const original = current_isa();
+    for ( auto [m, n, k] : { std::make_tuple( 1UL, 1UL, 1UL ), std::make_tuple( 17UL, 33UL, 51UL ), std::make_tuple( 130UL, 300UL, 97UL ) } )
+    {
+        auto A = random<double>( {m*n,} );
+        auto B = random<double>( {n*k,} );
+        auto C_naive = zeros<double>( {m*k,} );
+        gemm_cpu_naive( A.data(), false, B.data(), true, m, n, k, C_naive.data() );
+
+        for ( auto instruction_set : supported_isas() )
+        {
+            set_isa( instruction_set );
+            auto C = zeros<double>( {m*k,} );
+            gemm_cpu( A.data(), false, B.data(), true, m, n, k, C.data() );
+            for ( auto idx : range( m*k ) )
+                REQUIRE( std::abs( C_naive[idx] - C[idx] ) < 1.0e-10 * ( 1.0 + n ) );
+
+            auto const packed = cpu_pack_rhs( B.data(), true, n, k );
+            REQUIRE( packed.isa_ == instruction_set );
+            std::fill( C.begin(), C.end(), 0.0 );
+            cpu_gemm( A.data(), false, packed, m, n, k, C.data() );
+            for ( auto idx : range( m*k ) )
+                REQUIRE( std::abs( C_naive[idx] - C[idx] ) < 1.0e-10 * ( 1.0 + n ) );
+        }
+    }
+    set_isa( original );
+}
+
+TEST_CASE( "packed_with_other_isa", "[cpu_features]" )
+{
+    // a matrix packed for one instruction set stays usable after switching to another one
+    isa const original = current_isa();
+    unsigned long const m = 23, n = 45, k = 67;
+    auto A = random<float>( {m*n,} );
+    auto B = random<float>( {n*k,} );
+    auto C_naive = zeros<float>( {m*k,} );
+    gemm_cpu_naive( A.data(), false, B.data(), false, m, n, k, C_naive.data() );
+
+    auto const packed = cpu_pack_lhs( A.data(), false, m, n );
+    set_isa( isa::generic );
+    auto C = zeros<float>( {m*k,} );
+    cpu_gemm( packed, B.data(), false, m, n, k, C.data() );
+    for ( auto idx : range( m*k ) )
+        REQUIRE( std::abs( C_naive[idx] - C[idx] ) < 1.0e-5f * ( 1.0f + n ) );
+
+    variable<tensor<float>> weight{ random<float>( {n, k} ) };
+    REQUIRE( weight.packed_data( false, false, n, k ).isa_ == isa::generic );
+    set_isa( original );
+    REQUIRE( weight.packed_data( false, false, n, k ).isa_ == original );
+}
+
+TEST_CASE( "elementwise_and_reductions_all_isas", "[cpu_features]" )
+{
+    isa const original = current_isa();
+    auto x = random<float>( {3, 1031} );
+    auto y = random<float>( {3, 1031} );
+    auto const reference_sum = std::accumulate( x.begin(), x.end(), 0.0 );
+
+    for ( auto instruction_set : supported_isas() )
+    {
+        set_isa( instruction_set );
+        auto z = x.deep_copy() + y;
+        for ( auto idx : range( x.size() ) )
+            REQUIRE( std::abs( z[idx] - ( x[idx] + y[idx] ) ) < 1.0e-6f );
+        REQUIRE( std::abs( sum( x ) - reference_sum ) < 1.0e-2 );
+        REQUIRE( std::abs( reduce_sum( x )[0] - reference_sum ) < 1.0e-2 );
+    }
+    set_isa( original );
+}
@@ -0,0 +1,83 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "../include/tensor.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+namespace
+{
+    std::filesystem::path temporary_cache()
+    {
+        auto const ans = std::filesystem::temp_directory_path() / "ceras_test_cpu_tuner" / "cpu_gemm_tuning.txt";
+        std::filesystem::remove( ans );
+        return ans;
+    }
+}
+
+TEST_CASE( "cpu_model", "[cpu_tuner]" )
+{
+    REQUIRE( !cpu_model().empty() );
+    REQUIRE( cpu_gemm_tuning_key().find( cpu_model() ) == 0 );
+}
+
+TEST_CASE( "save_load_cpu_gemm_config", "[cpu_tuner]" )
+{
+    auto const cache = temporary_cache();
+    REQUIRE( !load_cpu_gemm_config( cache, "host a" ) );
+
+    REQUIRE( save_cpu_gemm_config( cpu_gemm_config{ 96, 384, 2048, 3, 4096, 7 }, cache, "host a" ) );
+    REQUIRE( save_cpu_gemm_config( cpu_gemm_config{ 48, 128, 1024, 1, 8192, 0 }, cache, "host b" ) );
+    REQUIRE( save_cpu_gemm_config( cpu_gemm_config{ 192, 512, 8192, 2, 1024, 5 }, cache, "host a" ) ); // replacing the first one
+
+    auto const a = load_cpu_gemm_config( cache, "host a" );
+    REQUIRE( a );
+    REQUIRE( a->row_block == 192 );
+    REQUIRE( a->depth_block == 512 );
+    REQUIRE( a->col_block == 8192 );
+    REQUIRE( a->threads == 2 );
+    REQUIRE( a->parallel_threshold == 1024 );
+    REQUIRE( a->cblas_threshold == 5 );
+
+    auto const b = load_cpu_gemm_config( cache, "host b" );
+    REQUIRE( b );
+    REQUIRE( b->row_block == 48 );
+    REQUIRE( !load_cpu_gemm_config( cache, "host c" ) );
+
+    std::filesystem::remove( cache );
+}
+
+TEST_CASE( "tune_cpu_gemm", "[cpu_tuner]" )
+{
+    auto const cache = temporary_cache();
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+
+    auto const tuned = tune_cpu_gemm( cache );
+    REQUIRE( get_cpu_gemm_config().depth_block == tuned.depth_block );
+    REQUIRE( tuned.row_block > 0 );
+    REQUIRE( tuned.col_block > 0 );
+
+    auto const loaded = load_cpu_gemm_config( cache );
+    REQUIRE( loaded );
+    REQUIRE( loaded->row_block == tuned.row_block );
+    REQUIRE( loaded->depth_block == tuned.depth_block );
+    REQUIRE( loaded->col_block == tuned.col_block );
+    REQUIRE( loaded->threads == tuned.threads );
+    REQUIRE( loaded->parallel_threshold == tuned.parallel_threshold );
+
+    // the tuned configuration gives the same results
+    unsigned long const m = 67, n = 301, k = 129;
+    auto A = random<float>( {m*n,} );
+    auto B = random<float>( {n*k,} );
+    auto C_naive = zeros<float>( {m*k,} );
+    auto C = zeros<float>( {m*k,} );
+    gemm_cpu_naive( A.data(), true, B.data(), false, m, n, k, C_naive.data() );
+    gemm( A.data(), true, B.data(), false, m, n, k, C.data() );
+    for ( auto idx : range( m*k ) )
+        REQUIRE( std::abs( C_naive[idx] - C[idx] ) < 1.0e-5f * ( 1.0f + n ) );
+
+    get_cpu_gemm_config() = backup;
+    std::filesystem::remove( cache );
+}
@@ -0,0 +1,168 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+template< Tensor Tsor >
+void require_close( Tsor const& lhs, Tsor const& rhs )
+{
+    REQUIRE( lhs.size() == rhs.size() );
+    for ( auto idx : range( lhs.size() ) )
+        REQUIRE( std::abs( lhs[idx] - rhs[idx] ) < 1.0e-4 );
+}
+
+void check_dense( std::string const& activation, unsigned long m, unsigned long n, unsigned long k )
+{
+    auto const input = random<float>( {m, n} );
+    auto const weight = random<float>( {n, k} );
+    auto const bias = random<float>( {1, k} );
+    auto const grad = random<float>( {m, k} );
+
+    auto x = variable{ input.deep_copy() };
+    auto w = variable{ weight.deep_copy() };
+    auto b = variable{ bias.deep_copy() };
+    auto y = dense( x, w, b, activation );
+
+    auto x_ = variable{ input.deep_copy() };
+    auto w_ = variable{ weight.deep_copy() };
+    auto b_ = variable{ bias.deep_copy() };
+    auto z_ = x_ * w_ + b_;
+
+    auto& s = get_default_session<tensor<float>>();
+    auto const output = s.run( y );
+    y.backward( grad );
+
+    tensor<float> expected;
+    if ( activation == "relu" )
+    {
+        auto y_ = relu( z_ );
+        expected = s.run( y_ );
+        y_.backward( grad );
+    }
+    else if ( activation == "sigmoid" )
+    {
+        auto y_ = sigmoid( z_ );
+        expected = s.run( y_ );
+        y_.backward( grad );
+    }
+    else if ( activation == "tanh" )
+    {
+        auto y_ = tanh( z_ );
+        expected = s.run( y_ );
+        y_.backward( grad );
+    }
+    else
+    {
+        expected = s.run( z_ );
+        z_.backward( grad );
+    }
+
+    require_close( output, expected );
+    require_close( x.gradient(), x_.gradient() );
+    require_close( w.gradient(), w_.gradient() );
+    require_close( b.gradient(), b_.gradient() );
+}
+
+TEST_CASE( "dense_activations", "[dense]" )
+{
+    for ( auto activation : { "linear", "relu", "sigmoid", "tanh" } )
+    {
+        check_dense( activation, 1, 1, 1 );
+        check_dense( activation, 37, 130, 75 );
+    }
+}
+
+TEST_CASE( "dense_depth_split", "[dense]" )
+{
+    // the epilogue follows the reduction of the partial products
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config().threads = 8;
+    get_cpu_gemm_config().parallel_threshold = 0;
+    for ( auto activation : { "linear", "relu" } )
+        check_dense( activation, 5, 1024, 7 );
+    get_cpu_gemm_config() = backup;
+}
+
+TEST_CASE( "dense_parallel_backward", "[dense]" )
+{
+    // the gradients of the pre-activation and of the bias are computed by blocks of rows on several threads
+    unsigned long const threads = parallel_threads();
+    set_parallel_threads( 4 );
+    for ( auto activation : { "linear", "relu", "sigmoid", "tanh" } )
+        check_dense( activation, 100, 17, 129 );
+    set_parallel_threads( threads );
+}
+
+TEST_CASE( "cpu_gemm_epilogue", "[dense]" )
+{
+    unsigned long const m = 29, n = 300, k = 53;
+    auto A = random<double>( {m*n,} );
+    auto B = random<double>( {n*k,} );
+    auto C_naive = zeros<double>( {m*k,} );
+    gemm_cpu_naive( A.data(), false, B.data(), false, m, n, k, C_naive.data() );
+
+    // every element visited exactly once, with its coordinates
+    auto C = zeros<double>( {m*k,} );
+    auto visits = zeros<double>( {m*k,} );
+    cpu_gemm( A.data(), false, B.data(), false, m, n, k, C.data(), [&]( double* c, unsigned long ldc, unsigned long row_first, unsigned long rows, unsigned long col_first, unsigned long cols )
+    {
+        for ( auto r : range( rows ) )
+            for ( auto j : range( cols ) )
+            {
+                REQUIRE( c + r*ldc + j == C.data() + (row_first+r)*k + col_first + j );
+                c[r*ldc+j] *= 2.0;
+                visits[(row_first+r)*k+col_first+j] += 1.0;
+            }
+    } );
+    for ( auto idx : range( m*k ) )
+    {
+        REQUIRE( std::abs( 2.0 * C_naive[idx] - C[idx] ) < 1.0e-10 * ( 1.0 + n ) );
+        REQUIRE( visits[idx] == 1.0 );
+    }
+}
+
+TEST_CASE( "dense_layer", "[dense]" )
+{
+    auto x = Input( {13,} );
+    auto y = Dense( 8, "relu" )( x );
+    auto z = Dense( 3 )( y );
+    auto& s = get_default_session<tensor<float>>();
+    s.bind( x, random<float>( {4, 13} ) );
+    auto output = s.run( z );
+    REQUIRE( output.shape() == std::vector<unsigned long>{ {4, 3} } );
+    auto hidden = s.run( y );
+    for ( auto v : hidden )
+        REQUIRE( v >= 0.0f );
+}
+
+TEST_CASE( "dense_benchmark", "[dense_benchmark]" )
+{
+    // relu layers of MLPs, forward and backward, fused and built from separated operators: the seconds of a step, and the bytes allocated by the first one
+    for ( auto [m, n, k] : { std::make_tuple( 256UL, 1024UL, 1024UL ), std::make_tuple( 4096UL, 64UL, 1024UL ) } )
+    {
+        auto x = variable{ random<float>( {m, n} ) };
+        auto w = variable{ random<float>( {n, k}, -0.05f, 0.05f ) };
+        auto b = variable{ random<float>( {1, k} ) };
+        auto const grad = random<float>( {m, k} );
+        auto& s = get_default_session<tensor<float>>();
+        auto const& measure = [&]( auto y )
+        {
+            s.clear_forward_cache(); // the outputs of the last layer measured
+            reset_memory_peak();
+            unsigned long const before = memory_stats().in_use;
+            s.run( y );
+            y.backward( grad );
+            unsigned long const bytes = memory_stats().peak - before;
+            double const seconds = ceras_private::shortest_time( [&](){ s.run( y ); y.backward( grad ); }, 10 );
+            return std::make_tuple( seconds, bytes );
+        };
+        measure( x * w + b ); // the gradients of the variables
+        auto const [fused, fused_bytes] = measure( dense( x, w, b, "relu" ) );
+        auto const [separated, separated_bytes] = measure( relu( x * w + b ) );
+        std::cout << m << " x " << n << " x " << k << " relu layer, forward and backward: fused " << fused << " s, " << fused_bytes << " bytes; separated "
+                  << separated << " s, " << separated_bytes << " bytes" << std::endl;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef KEMUBCRDLSBQGBCNNCHCRNBSDHUUSBSSMBHBREJNERDSJRVFDSSUGLDRWCSBTGPVRNYKOSOL
+#define KEMUBCRDLSBQGBCNNCHCRNBSDHUUSBSSMBHBREJNERDSJRVFDSSUGLDRWCSBTGPVRNYKOSOL
+
+//
+// Shared by the tests training a small perceptron under different memory policies.
+//
+
+#include "../include/ceras.hpp"
+#include <chrono>
+
+inline auto const unchanged = []( auto const& ex ) { return ex; };
+
+// a stack of six dense layers, `wrap3` and `wrap6` applied to the outputs of the third and of the sixth layer
+template< typename Tsor >
+auto make_network( unsigned long inputs, unsigned long width, auto const& wrap3, auto const& wrap6 )
+{
+    using namespace ceras;
+    auto x = place_holder<Tsor>{};
+    auto y = place_holder<Tsor>{};
+    std::vector<variable<Tsor>> weights;
+    typedef typename Tsor::value_type value_type;
+    auto const& layer = [&]<Expression Ex>( Ex const& ex, unsigned long input_size, unsigned long output_size )
+    {
+        auto w = variable<Tsor>{ random<value_type, typename Tsor::allocator>( {input_size, output_size}, value_type{-0.1}, value_type{0.1} ) };
+        auto b = variable<Tsor>{ random<value_type, typename Tsor::allocator>( {1, output_size}, value_type{-0.1}, value_type{0.1} ) };
+        weights.push_back( w );
+        weights.push_back( b );
+        return relu( ex * w + b );
+    };
+    auto const& h1 = layer( x, inputs, width );
+    auto const& h2 = layer( h1, width, width );
+    auto const& h3 = wrap3( layer( h2, width, width ) );
+    auto const& h4 = layer( h3, width, width );
+    auto const& h5 = layer( h4, width, width );
+    auto const& h6 = wrap6( layer( h5, width, width ) );
+    auto output = sigmoid( h6 * weights[0] ); // reading the first weight again, the width of the input being the width of the layers
+    auto loss = mean_squared_error( y, output );
+    return std::make_tuple( x, y, output, loss, weights );
+}
+
+template< typename Tsor >
+auto make_network( unsigned long inputs, unsigned long width )
+{
+    return make_network<Tsor>( inputs, width, unchanged, unchanged );
+}
+
+// the seconds taken by `steps` training steps, and the largest number of bytes in use above the bytes in use before them
+template< typename Loss, typename Optimizer >
+auto benchmark_training( Loss& loss, Optimizer& optimizer, unsigned long steps )
+{
+    using namespace ceras;
+    auto& s = get_default_session<typename Loss::tensor_type>();
+    trim_memory();
+    reset_memory_peak();
+    unsigned long const before = memory_stats().in_use;
+    auto const start = std::chrono::steady_clock::now();
+    for ( [[maybe_unused]] auto _ : range( steps ) )
+    {
+        s.run( loss );
+        s.run( optimizer );
+    }
+    double const seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    return std::make_tuple( seconds, memory_stats().peak - before );
+}
+
+#endif//KEMUBCRDLSBQGBCNNCHCRNBSDHUUSBSSMBHBREJNERDSJRVFDSSUGLDRWCSBTGPVRNYKOSOL
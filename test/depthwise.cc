@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+// a grouped convolution against the dense convolution of the block diagonal kernels, computed by img2col; the kernels are read as [NC, CH, r, c]
+template< typename T >
+void check_groups( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters, unsigned long kernel,
+                   unsigned long stride, unsigned long dilation, std::string const& padding, unsigned long groups, double tolerance )
+{
+    unsigned long const group_channels = channels / groups;
+    unsigned long const group_filters = filters / groups;
+    auto const x = random<T>( {bs, rows, cols, channels} );
+    auto const w = random<T>( {filters, kernel, kernel, group_channels} );
+    auto dense_w = zeros<T>( {filters, kernel, kernel, channels} );
+    for ( auto f : range( filters ) )
+        for ( auto position : range( kernel * kernel ) )
+            for ( auto ch : range( group_channels ) )
+                dense_w[( f * channels + ( f / group_filters ) * group_channels + ch ) * kernel * kernel + position] = w[( f * group_channels + ch ) * kernel * kernel + position];
+
+    unsigned long const pad = ( padding == "same" ) ? ( dilation * ( kernel - 1 ) + 1 - stride + ( kernel & 1 ) ) / 2 : 0;
+    unsigned long const output_rows = ( rows + 2 * pad - dilation * ( kernel - 1 ) - 1 ) / stride + 1;
+    unsigned long const output_cols = ( cols + 2 * pad - dilation * ( kernel - 1 ) - 1 ) / stride + 1;
+    auto const grad = random<T>( {bs, output_rows, output_cols, filters} );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, dense_w, grad, stride, dilation, padding, 1 );
+    auto const& [grouped_output, grouped_x_grad, grouped_w_grad] = convolve( conv2d_algorithm::automatic, x, w, grad, stride, dilation, padding, groups );
+    REQUIRE( grouped_output.shape() == output.shape() );
+    for ( auto idx : range( output.size() ) )
+        REQUIRE( grouped_output[idx] == Approx( output[idx] ).epsilon( tolerance ).margin( tolerance ) );
+    for ( auto idx : range( x_grad.size() ) )
+        REQUIRE( grouped_x_grad[idx] == Approx( x_grad[idx] ).epsilon( tolerance ).margin( tolerance ) );
+    for ( auto f : range( filters ) )
+        for ( auto position : range( kernel * kernel ) )
+            for ( auto ch : range( group_channels ) )
+                REQUIRE( grouped_w_grad[( f * group_channels + ch ) * kernel * kernel + position] ==
+                         Approx( w_grad[( f * channels + ( f / group_filters ) * group_channels + ch ) * kernel * kernel + position] ).epsilon( tolerance ).margin( tolerance ) );
+}
+
+TEST_CASE( "depthwise_conv2d", "[depthwise]" )
+{
+    conv2d_geometry const g{ 2, 8, 8, 16, 16, 3, 3, 1, 1, 1, 1, 1, 1, 16 };
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::depthwise );
+
+    check_groups<double>( 2, 7, 9, 3, 3, 3, 1, 1, "same", 3, 1.0e-10 );
+    check_groups<double>( 2, 9, 8, 4, 8, 3, 1, 1, "valid", 4, 1.0e-10 );     // depth multiplier 2
+    check_groups<double>( 3, 11, 10, 5, 5, 5, 2, 1, "same", 5, 1.0e-10 );
+    check_groups<double>( 1, 12, 13, 6, 18, 3, 1, 2, "same", 6, 1.0e-10 );   // dilated, depth multiplier 3
+    check_groups<float>( 4, 28, 28, 32, 32, 3, 2, 1, "same", 32, 1.0e-4 );
+}
+
+TEST_CASE( "grouped_conv2d", "[depthwise]" )
+{
+    conv2d_geometry const g{ 2, 8, 8, 16, 32, 3, 3, 1, 1, 1, 1, 1, 1, 4 };
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::implicit_gemm );
+
+    check_groups<double>( 2, 7, 9, 4, 6, 3, 1, 1, "same", 2, 1.0e-10 );
+    check_groups<double>( 2, 10, 9, 8, 4, 3, 2, 1, "valid", 4, 1.0e-10 );
+    check_groups<double>( 1, 12, 11, 6, 9, 5, 1, 2, "same", 3, 1.0e-10 );
+    check_groups<float>( 4, 16, 16, 32, 64, 3, 1, 1, "same", 8, 1.0e-4 );
+}
+
+TEST_CASE( "depthwise_layer", "[depthwise]" )
+{
+    auto x = variable{ random<float>( {2, 12, 12, 8} ) };
+    auto y = DepthwiseConv2D( {3, 3}, "same", {1, 1}, {1, 1}, 2 )( x );
+    auto z = Conv2D( 12, {1, 1}, "valid", {1, 1}, {1, 1}, true, 0.0f, 0.0f, 0.0f, 0.0f, 4 )( y );
+    auto& s = get_default_session<tensor<float>>();
+    REQUIRE( s.run( y ).shape() == std::vector<unsigned long>{ {2, 12, 12, 16} } );
+    REQUIRE( s.run( z ).shape() == std::vector<unsigned long>{ {2, 12, 12, 12} } );
+}
+
+TEST_CASE( "depthwise_benchmark", "[depthwise_benchmark]" )
+{
+    for ( auto [bs, size, channels] : { std::make_tuple( 32UL, 56UL, 64UL ), std::make_tuple( 32UL, 28UL, 256UL ), std::make_tuple( 32UL, 14UL, 512UL ) } )
+    {
+        auto const x = random<float>( {bs, size, size, channels} );
+        auto const w = random<float>( {channels, 3, 3, 1} );
+        auto const grad = random<float>( {bs, size, size, channels} );
+        auto const& seconds = [&]( auto const& run )
+        {
+            run();
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 3 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                run();
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return best;
+        };
+        double const depthwise = seconds( [&](){ convolve( conv2d_algorithm::automatic, x, w, grad, 1, 1, "same", channels ); } );
+        // the same convolution as a convolution per channel, of the channel sliced out of the input, concatenated
+        double const separate = seconds( [&]()
+        {
+            auto vx = variable{ x.deep_copy() };
+            auto vw = variable{ w.deep_copy() };
+            auto& s = get_default_session<tensor<float>>();
+            std::vector<tensor<float>> outputs;
+            for ( auto ch : range( channels ) )
+            {
+                tensor<float> xc{ {bs, size, size, 1} };
+                for ( auto idx : range( bs * size * size ) )
+                    xc[idx] = x[idx * channels + ch];
+                tensor<float> wc{ {1, 3, 3, 1} };
+                std::copy_n( w.data() + ch * 9, 9, wc.data() );
+                auto y = general_conv2d( 1, 1, 1, 1, "same" )( variable{ xc }, variable{ wc } );
+                outputs.push_back( s.run( y ).deep_copy() );
+            }
+            tensor<float> output{ {bs, size, size, channels} };
+            for ( auto ch : range( channels ) )
+                for ( auto idx : range( bs * size * size ) )
+                    output[idx * channels + ch] = outputs[ch][idx];
+        } );
+        double const forward = seconds( [&]()
+        {
+            auto y = general_conv2d( 1, 1, 1, 1, "same", channels )( variable{ x }, variable{ w } );
+            get_default_session<tensor<float>>().run( y );
+        } );
+        std::cout << bs << " x " << size << " x " << size << " x " << channels << " depthwise 3x3: forward " << forward << " s, forward and backward " << depthwise
+                  << " s, forward as " << channels << " separate convolutions " << separate << " s" << std::endl;
+    }
+}
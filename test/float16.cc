@@ -0,0 +1,196 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace ceras;
+
+template< typename T >
+void check_round_trip()
+{
+    // every 16-bit pattern widens to a float which rounds back to the same pattern
+    std::vector<T> halves( 1UL << 16 );
+    for ( auto idx : range( halves.size() ) )
+        halves[idx] = T::from_bits( static_cast<std::uint16_t>( idx ) );
+    std::vector<float> floats( halves.size() );
+    convert( halves.data(), halves.size(), floats.data() );
+    std::vector<T> back( halves.size() );
+    convert( floats.data(), floats.size(), back.data() );
+    for ( auto idx : range( halves.size() ) )
+    {
+        REQUIRE( std::bit_cast<std::uint32_t>( floats[idx] ) == std::bit_cast<std::uint32_t>( static_cast<float>( halves[idx] ) ) );
+        // bit tests, as -ffast-math assumes no NaN
+        std::uint32_t const bits = std::bit_cast<std::uint32_t>( floats[idx] ) & 0x7fffffffU;
+        if ( bits > 0x7f800000U )
+            REQUIRE( ( back[idx].bits_ & 0x7fffU ) > std::numeric_limits<T>::infinity().bits_ );
+        else if ( bits >= 0x00800000U || bits == 0 ) // subnormal floats may be flushed by vcvtneps2bf16
+            REQUIRE( back[idx].bits_ == halves[idx].bits_ );
+    }
+}
+
+TEST_CASE( "float16_round_trip", "[float16_round_trip]" )
+{
+    isa const detected = detected_isa();
+    for ( auto instruction_set : { isa::generic, isa::avx2, isa::avx512 } )
+    {
+        if ( instruction_set > detected )
+            continue;
+        set_isa( instruction_set );
+        check_round_trip<bfloat16>();
+        check_round_trip<float16>();
+    }
+    set_isa( detected );
+}
+
+TEST_CASE( "float16_rounding", "[float16_rounding]" )
+{
+    // to the nearest, ties to even
+    REQUIRE( bfloat16{ 1.0f + 1.0f / 256.0f }.bits_ == bfloat16{ 1.0f }.bits_ );
+    REQUIRE( bfloat16{ 1.0f + 3.0f / 256.0f }.bits_ == bfloat16{ 1.0f + 4.0f / 256.0f }.bits_ );
+    REQUIRE( float16{ 1.0f + 1.0f / 2048.0f }.bits_ == float16{ 1.0f }.bits_ );
+    REQUIRE( float16{ 1.0f + 3.0f / 2048.0f }.bits_ == float16{ 1.0f + 4.0f / 2048.0f }.bits_ );
+    // range
+    REQUIRE( static_cast<float>( float16{ 65504.0f } ) == 65504.0f );
+    REQUIRE( std::isinf( static_cast<float>( float16{ 65520.0f } ) ) );
+    REQUIRE( static_cast<float>( float16{ std::ldexp( 1.0f, -24 ) } ) == std::ldexp( 1.0f, -24 ) );
+    REQUIRE( static_cast<float>( float16{ std::ldexp( 1.0f, -26 ) } ) == 0.0f );
+    REQUIRE( static_cast<float>( bfloat16{ 1.0e38f } ) == Approx( 1.0e38f ).epsilon( 0.01 ) );
+    REQUIRE( static_cast<float>( std::numeric_limits<float16>::max() ) == 65504.0f );
+    REQUIRE( static_cast<float>( std::numeric_limits<bfloat16>::epsilon() ) == 1.0f / 128.0f );
+
+    // vectorized rounding of random floats, ties included, matches the scalar one
+    auto const x = random<float>( {1027,}, -100.0f, 100.0f );
+    std::vector<float> values{ x.begin(), x.end() };
+    for ( auto idx : range( 64UL ) )
+        values.push_back( 1.0f + static_cast<float>( idx ) / 256.0f + 1.0f / 512.0f );
+    std::vector<bfloat16> b( values.size() );
+    std::vector<float16> h( values.size() );
+    convert( values.data(), values.size(), b.data() );
+    convert( values.data(), values.size(), h.data() );
+    for ( auto idx : range( values.size() ) )
+    {
+        REQUIRE( b[idx].bits_ == bfloat16{ values[idx] }.bits_ );
+        REQUIRE( h[idx].bits_ == float16{ values[idx] }.bits_ );
+    }
+}
+
+TEST_CASE( "float16_tensor", "[float16_tensor]" )
+{
+    auto const x = random<float>( {3, 5}, -2.0f, 2.0f );
+    auto const y = random<float>( {3, 5}, -2.0f, 2.0f );
+    auto const bx = x.as_type<bfloat16>();
+    auto const by = y.as_type<bfloat16>();
+    REQUIRE( sizeof( *bx.data() ) == 2 );
+
+    auto const sum = ( bx.deep_copy() + by ).as_type<float>(); // the sum of same shapes is computed in the lhs
+    auto const product = elementwise_product( bx, by ).as_type<float>();
+    auto const negative = ( -bx ).as_type<float>();
+    for ( auto idx : range( x.size() ) )
+    {
+        REQUIRE( sum[idx] == Approx( x[idx] + y[idx] ).margin( 0.05 ) );
+        REQUIRE( product[idx] == Approx( x[idx] * y[idx] ).margin( 0.05 ) );
+        REQUIRE( negative[idx] == -static_cast<float>( bx[idx] ) );
+    }
+}
+
+template< typename T >
+void check_gemm( unsigned long m, unsigned long n, unsigned long k, bool a_transposed, bool b_transposed )
+{
+    // operands exact in 16 bits, so that only the rounding of C differs from the float product
+    auto const a = random<float>( a_transposed ? std::vector<unsigned long>{n, m} : std::vector<unsigned long>{m, n} ).as_type<T>();
+    auto const b = random<float>( b_transposed ? std::vector<unsigned long>{k, n} : std::vector<unsigned long>{n, k} ).as_type<T>();
+    auto const fa = a.template as_type<float>();
+    auto const fb = b.template as_type<float>();
+    tensor<float> expected{ {m, k} };
+    gemm_cpu_naive( fa.data(), a_transposed, fb.data(), b_transposed, m, n, k, expected.data() );
+
+    tensor<T> c{ {m, k} };
+    gemm( a.data(), a_transposed, b.data(), b_transposed, m, n, k, c.data() );
+    float const tolerance = std::is_same_v<T, bfloat16> ? 1.0f / 256.0f : 1.0f / 2048.0f;
+    for ( auto idx : range( m * k ) ) // a single rounding of the float result
+        REQUIRE( std::abs( static_cast<float>( c[idx] ) - expected[idx] ) <= tolerance * std::abs( expected[idx] ) + 1.0e-4f );
+
+    // the epilogue sees the float accumulators
+    gemm( a.data(), a_transposed, b.data(), b_transposed, m, n, k, c.data(),
+          []( float* p, unsigned long ldc, unsigned long, unsigned long rows, unsigned long, unsigned long cols ){ for ( auto r : range( rows ) ) for ( auto j : range( cols ) ) p[r*ldc+j] = 2.0f * p[r*ldc+j] + 1.0f; } );
+    for ( auto idx : range( m * k ) )
+        REQUIRE( std::abs( static_cast<float>( c[idx] ) - 2.0f * expected[idx] - 1.0f ) <= tolerance * std::abs( 2.0f * expected[idx] + 1.0f ) + 2.0e-4f );
+}
+
+TEST_CASE( "float16_gemm", "[float16_gemm]" )
+{
+    isa const detected = detected_isa();
+    for ( auto instruction_set : { isa::generic, isa::sse42, isa::avx2, isa::avx512 } )
+    {
+        if ( instruction_set > detected )
+            continue;
+        set_isa( instruction_set );
+        for ( auto [m, n, k] : { std::make_tuple( 1UL, 1UL, 1UL ), std::make_tuple( 7UL, 13UL, 5UL ), std::make_tuple( 37UL, 300UL, 75UL ) } )
+            for ( bool a_transposed : { false, true } )
+                for ( bool b_transposed : { false, true } )
+                {
+                    check_gemm<bfloat16>( m, n, k, a_transposed, b_transposed );
+                    check_gemm<float16>( m, n, k, a_transposed, b_transposed );
+                }
+    }
+    set_isa( detected );
+}
+
+TEST_CASE( "float16_multiply", "[float16_multiply]" )
+{
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config().threads = 4;
+    get_cpu_gemm_config().parallel_threshold = 0;
+
+    auto const a = random<float>( {4, 33, 70} ).as_type<bfloat16>();
+    auto const b = random<float>( {4, 70, 19} ).as_type<bfloat16>();
+    auto const c = batched_multiply( a, b );
+    auto const expected = batched_multiply( a.as_type<float>(), b.as_type<float>() );
+    REQUIRE( c.shape() == expected.shape() );
+    for ( auto idx : range( c.size() ) )
+        REQUIRE( std::abs( static_cast<float>( c[idx] ) - expected[idx] ) <= std::abs( expected[idx] ) / 256.0f + 1.0e-4f );
+
+    auto const x = random<float>( {5, 2048} ).as_type<float16>(); // depth splits
+    auto const y = random<float>( {2048, 3} ).as_type<float16>();
+    auto const z = x * y;
+    auto const fz = x.as_type<float>() * y.as_type<float>();
+    for ( auto idx : range( z.size() ) )
+        REQUIRE( std::abs( static_cast<float>( z[idx] ) - fz[idx] ) <= std::abs( fz[idx] ) / 2048.0f + 1.0e-3f );
+
+    get_cpu_gemm_config() = backup;
+}
+
+TEST_CASE( "float16_benchmark", "[float16_benchmark]" )
+{
+    for ( auto [m, n, k] : { std::make_tuple( 256UL, 1024UL, 1024UL ), std::make_tuple( 64UL, 4608UL, 196UL ) } )
+    {
+        auto const a = random<float>( {m, n} );
+        auto const b = random<float>( {n, k} );
+        tensor<float> c{ {m, k} };
+        auto const ha = a.as_type<bfloat16>();
+        auto const hb = b.as_type<bfloat16>();
+        tensor<bfloat16> hc{ {m, k} };
+        auto const fa = a.as_type<float16>();
+        auto const fb = b.as_type<float16>();
+        tensor<float16> fc{ {m, k} };
+
+        auto const& gflops = [&]( auto const& func )
+        {
+            func();
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 5 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                func();
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return 2.0e-9 * m * n * k / best;
+        };
+        double const float_gflops = gflops( [&](){ cpu_gemm( a.data(), false, b.data(), false, m, n, k, c.data() ); } );
+        double const bfloat16_gflops = gflops( [&](){ cpu_gemm( ha.data(), false, hb.data(), false, m, n, k, hc.data() ); } );
+        double const float16_gflops = gflops( [&](){ cpu_gemm( fa.data(), false, fb.data(), false, m, n, k, fc.data() ); } );
+        std::cout << m << " x " << n << " x " << k << ": float " << float_gflops << " GFLOP/s, bfloat16 " << bfloat16_gflops << " GFLOP/s, float16 " << float16_gflops << " GFLOP/s" << std::endl;
+    }
+}
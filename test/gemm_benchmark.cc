@@ -0,0 +1,79 @@
+#include "../include/ceras.hpp"
+#include "../include/tensor.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace ceras;
+
+template< typename Func >
+double seconds_of( Func const& func, unsigned long repeats )
+{
+    auto const start = std::chrono::steady_clock::now();
+    for ( [[maybe_unused]] auto _ : range( repeats ) )
+        func();
+    auto const stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>( stop - start ).count() / repeats;
+}
+
+template< typename T >
+void benchmark( unsigned long m, unsigned long n, unsigned long k, bool a_transposed, bool b_transposed )
+{
+    auto A = random<T>( {m*n,} );
+    auto B = random<T>( {n*k,} );
+    auto C = zeros<T>( {m*k,} );
+    double const flops = 2.0 * m * n * k;
+    unsigned long const repeats = std::max( 1UL, static_cast<unsigned long>( 2.0e9 / flops ) );
+
+    double const t_naive = seconds_of( [&](){ gemm_cpu_naive( A.data(), a_transposed, B.data(), b_transposed, m, n, k, C.data() ); }, std::max( 1UL, repeats/8 ) );
+    double const t_packed = seconds_of( [&](){ gemm_cpu( A.data(), a_transposed, B.data(), b_transposed, m, n, k, C.data() ); }, repeats );
+
+    std::cout << std::setw(7) << std::left << type2string<T>() << std::right << std::setw(6) << m << std::setw(6) << n << std::setw(6) << k << "  "
+              << (a_transposed ? 'T' : 'N') << (b_transposed ? 'T' : 'N') << std::fixed << std::setprecision(2)
+              << "  naive: " << std::setw(8) << flops / t_naive * 1.0e-9 << " GFLOP/s"
+              << "  packed: " << std::setw(8) << flops / t_packed * 1.0e-9 << " GFLOP/s"
+              << "  speedup: " << std::setw(6) << t_naive / t_packed << "x" << std::endl;
+}
+
+template< typename T >
+void benchmark_threads( unsigned long m, unsigned long n, unsigned long k )
+{
+    auto A = random<T>( {m*n,} );
+    auto B = random<T>( {n*k,} );
+    auto C = zeros<T>( {m*k,} );
+    double const flops = 2.0 * m * n * k;
+    unsigned long const repeats = std::max( 1UL, static_cast<unsigned long>( 4.0e9 / flops ) );
+
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    for ( unsigned long threads = 1; threads <= std::max( 1U, std::thread::hardware_concurrency() ); threads *= 2 )
+    {
+        get_cpu_gemm_config().threads = threads;
+        double const t = seconds_of( [&](){ gemm_cpu( A.data(), false, B.data(), false, m, n, k, C.data() ); }, repeats );
+        std::cout << std::setw(7) << std::left << type2string<T>() << std::right << std::setw(6) << m << std::setw(6) << n << std::setw(6) << k
+                  << "  threads: " << std::setw(3) << threads << std::fixed << std::setprecision(2) << "  packed: " << std::setw(8) << flops / t * 1.0e-9 << " GFLOP/s" << std::endl;
+    }
+    get_cpu_gemm_config() = backup;
+}
+
+int main()
+{
+    for ( auto dim : { 64UL, 128UL, 256UL, 512UL, 1024UL } )
+    {
+        benchmark<float>( dim, dim, dim, false, false );
+        benchmark<double>( dim, dim, dim, false, false );
+    }
+
+    // transposed operands as used in the backward pass of dense layers
+    benchmark<float>( 512, 512, 512, true, false );
+    benchmark<float>( 512, 512, 512, false, true );
+    benchmark<float>( 512, 512, 512, true, true );
+
+    // shapes from the convolutional examples: [filters x kernel*channels] * [kernel*channels x batch*pixels]
+    benchmark<float>( 32, 288, 12544, false, false );
+    benchmark<float>( 64, 576, 3136, false, false );
+
+    // scaling with threads, including a tall-skinny product split along the depth
+    benchmark_threads<float>( 1024, 1024, 1024 );
+    benchmark_threads<float>( 128, 65536, 10 );
+
+    return 0;
+}
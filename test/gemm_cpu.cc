@@ -0,0 +1,131 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "../include/tensor.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+template< typename T >
+void check_gemm_cpu( unsigned long m, unsigned long n, unsigned long k, T tolerance )
+{
+    auto A = random<T>( {m*n,} );
+    auto B = random<T>( {n*k,} );
+    auto C_naive = zeros<T>( {m*k,} );
+    auto C_packed = zeros<T>( {m*k,} );
+
+    for ( bool a_transposed : { false, true } )
+        for ( bool b_transposed : { false, true } )
+        {
+            gemm_cpu_naive( A.data(), a_transposed, B.data(), b_transposed, m, n, k, C_naive.data() );
+            gemm_cpu( A.data(), a_transposed, B.data(), b_transposed, m, n, k, C_packed.data() );
+            for ( auto idx : range( m*k ) )
+                REQUIRE( std::abs( C_naive[idx] - C_packed[idx] ) < tolerance * ( 1.0 + n ) );
+        }
+}
+
+TEST_CASE( "gemm_cpu_small", "[gemm_cpu]" )
+{
+    unsigned long const upper_dims = 20;
+    for ( auto m : range( 1UL, upper_dims ) )
+        for ( auto n : range( 1UL, upper_dims ) )
+            for ( auto k : range( 1UL, upper_dims ) )
+            {
+                check_gemm_cpu<double>( m, n, k, 1.0e-10 );
+                check_gemm_cpu<float>( m, n, k, 1.0e-5f );
+            }
+}
+
+TEST_CASE( "gemm_cpu_blocked", "[gemm_cpu]" )
+{
+    // shrink the blocks so that every border case of the blocking is visited
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config() = cpu_gemm_config{ 12, 7, 40 };
+
+    for ( auto m : { 1UL, 13UL, 37UL } )
+        for ( auto n : { 1UL, 8UL, 29UL } )
+            for ( auto k : { 1UL, 33UL, 81UL } )
+            {
+                check_gemm_cpu<double>( m, n, k, 1.0e-10 );
+                check_gemm_cpu<float>( m, n, k, 1.0e-5f );
+            }
+
+    get_cpu_gemm_config() = backup;
+
+    check_gemm_cpu<float>( 301, 517, 263, 1.0e-5f );
+    check_gemm_cpu<double>( 263, 301, 517, 1.0e-10 );
+}
+
+TEST_CASE( "gemm_cpu_zero_depth", "[gemm_cpu]" )
+{
+    auto C = ones<float>( {3, 5} );
+    gemm_cpu( static_cast<float const*>(nullptr), false, static_cast<float const*>(nullptr), false, 3UL, 0UL, 5UL, C.data() );
+    for ( auto x : C )
+        REQUIRE( x == 0.0f );
+}
+
+TEST_CASE( "gemm_cpu_partitioned", "[gemm_cpu]" )
+{
+    // force the multi-threaded decomposition, the partition does not depend on the cores available
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config().threads = 5;
+    get_cpu_gemm_config().parallel_threshold = 0;
+
+    for ( auto m : { 1UL, 7UL, 50UL } )
+        for ( auto n : { 3UL, 700UL } )
+            for ( auto k : { 1UL, 10UL, 131UL } )
+            {
+                check_gemm_cpu<double>( m, n, k, 1.0e-10 );
+                check_gemm_cpu<float>( m, n, k, 1.0e-5f );
+            }
+
+    get_cpu_gemm_config() = backup;
+}
+
+TEST_CASE( "gemm_partition", "[gemm_cpu]" )
+{
+    using namespace ceras::ceras_private;
+    {   // square output, plenty of tiles: 2D grid only
+        auto const p = make_gemm_partition( 512, 512, 512, 8, 48, 8 );
+        REQUIRE( p.grid_rows * p.grid_cols <= 8 );
+        REQUIRE( p.grid_rows * p.grid_cols >= 6 );
+        REQUIRE( p.depth_splits == 1 );
+    }
+    {   // tall-skinny: the weight gradient of a Dense(10) layer with a large batch
+        auto const p = make_gemm_partition( 8, 4096, 10, 8, 48, 8 );
+        REQUIRE( p.grid_rows * p.grid_cols == 1 );
+        REQUIRE( p.depth_splits == 8 );
+    }
+    {   // short depth is never split
+        auto const p = make_gemm_partition( 8, 64, 10, 8, 48, 8 );
+        REQUIRE( p.depth_splits == 1 );
+    }
+}
+
+TEST_CASE( "cpu_batched_gemm", "[gemm_cpu]" )
+{
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config().threads = 6;
+    get_cpu_gemm_config().parallel_threshold = 0;
+
+    unsigned long const batch = 3, m = 17, n = 9, k = 53;
+    for ( bool broadcast_a : { false, true } )
+        for ( bool a_transposed : { false, true } )
+            for ( bool b_transposed : { false, true } )
+            {
+                auto A = random<double>( {broadcast_a ? 1UL : batch, m*n} );
+                auto B = random<double>( {batch, n*k} );
+                auto C = zeros<double>( {batch, m*k} );
+                auto C_naive = zeros<double>( {m*k,} );
+                cpu_batched_gemm( A.data(), a_transposed, broadcast_a ? 0UL : m*n, B.data(), b_transposed, n*k, batch, m, n, k, C.data() );
+                for ( auto b : range( batch ) )
+                {
+                    gemm_cpu_naive( A.data() + (broadcast_a ? 0UL : b*m*n), a_transposed, B.data() + b*n*k, b_transposed, m, n, k, C_naive.data() );
+                    for ( auto idx : range( m*k ) )
+                        REQUIRE( std::abs( C[b*m*k+idx] - C_naive[idx] ) < 1.0e-10 );
+                }
+            }
+
+    get_cpu_gemm_config() = backup;
+}
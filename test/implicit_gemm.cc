@@ -0,0 +1,78 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+template< typename T >
+void check_implicit_gemm( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters, unsigned long kernel_rows, unsigned long kernel_cols,
+                          unsigned long stride, unsigned long dilation, std::string const& padding, double tolerance )
+{
+    auto const x = random<T>( {bs, rows, cols, channels} );
+    auto const w = random<T>( {filters, kernel_rows, kernel_cols, channels} );
+    unsigned long const row_padding = ( padding == "same" ) ? ( ( kernel_rows & 1 ) + dilation * ( kernel_rows - 1 ) + 1 - stride ) / 2 : 0;
+    unsigned long const col_padding = ( padding == "same" ) ? ( ( kernel_cols & 1 ) + dilation * ( kernel_cols - 1 ) + 1 - stride ) / 2 : 0;
+    unsigned long const output_rows = ( rows + 2 * row_padding - dilation * ( kernel_rows - 1 ) - 1 ) / stride + 1;
+    unsigned long const output_cols = ( cols + 2 * col_padding - dilation * ( kernel_cols - 1 ) - 1 ) / stride + 1;
+    auto const grad = random<T>( {bs, output_rows, output_cols, filters} );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, w, grad, stride, dilation, padding );
+    auto const& [implicit_output, implicit_x_grad, implicit_w_grad] = convolve( conv2d_algorithm::implicit_gemm, x, w, grad, stride, dilation, padding );
+    REQUIRE( relative_error( implicit_output, output ) < tolerance );
+    REQUIRE( relative_error( implicit_x_grad, x_grad ) < tolerance );
+    REQUIRE( relative_error( implicit_w_grad, w_grad ) < tolerance );
+}
+
+TEST_CASE( "implicit_gemm_double", "[implicit_gemm]" )
+{
+    check_implicit_gemm<double>( 1, 3, 3, 1, 1, 3, 3, 1, 1, "valid", 1.0e-12 );
+    check_implicit_gemm<double>( 2, 7, 9, 3, 5, 3, 3, 1, 1, "same", 1.0e-12 );
+    check_implicit_gemm<double>( 2, 9, 9, 3, 4, 3, 3, 2, 1, "valid", 1.0e-12 );
+    check_implicit_gemm<double>( 2, 12, 10, 5, 7, 5, 5, 1, 1, "same", 1.0e-12 );
+    check_implicit_gemm<double>( 3, 11, 13, 4, 6, 3, 3, 1, 2, "same", 1.0e-12 );
+    check_implicit_gemm<double>( 2, 16, 16, 3, 8, 3, 3, 2, 1, "same", 1.0e-12 );
+    check_implicit_gemm<double>( 2, 15, 14, 2, 3, 1, 1, 1, 1, "valid", 1.0e-12 );
+    check_implicit_gemm<double>( 1, 17, 19, 3, 5, 3, 5, 3, 2, "valid", 1.0e-12 );
+}
+
+TEST_CASE( "implicit_gemm_float", "[implicit_gemm]" )
+{
+    check_implicit_gemm<float>( 4, 28, 28, 16, 32, 3, 3, 2, 1, "same", 1.0e-5 );
+    check_implicit_gemm<float>( 2, 32, 32, 32, 64, 5, 5, 1, 1, "same", 1.0e-5 );
+    check_implicit_gemm<float>( 2, 23, 17, 17, 9, 3, 3, 1, 2, "valid", 1.0e-5 );
+}
+
+TEST_CASE( "implicit_gemm_benchmark", "[implicit_gemm_benchmark]" )
+{
+    for ( auto [bs, size, channels, filters, kernel, stride] : { std::make_tuple( 32UL, 28UL, 32UL, 64UL, 5UL, 1UL ), std::make_tuple( 16UL, 56UL, 64UL, 128UL, 3UL, 2UL ),
+                                                                 std::make_tuple( 8UL, 14UL, 256UL, 256UL, 3UL, 1UL ) } )
+    {
+        auto const x = random<float>( {bs, size, size, channels} );
+        auto const w = random<float>( {filters, kernel, kernel, channels} );
+        auto const grad = random<float>( {bs, ( size - 1 ) / stride + 1, ( size - 1 ) / stride + 1, filters} );
+        std::string const padding = ( stride == 1 ) ? "same" : "valid";
+        auto const output_size = ( stride == 1 ) ? size : ( size - kernel ) / stride + 1;
+        auto const valid_grad = random<float>( {bs, output_size, output_size, filters} );
+        auto const& seconds = [&]( conv2d_algorithm algorithm )
+        {
+            tensor<float> const& g = ( stride == 1 ) ? grad : valid_grad;
+            convolve( algorithm, x, w, g, stride, 1UL, padding );
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 3 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                convolve( algorithm, x, w, g, stride, 1UL, padding );
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return best;
+        };
+        double const img2col = seconds( conv2d_algorithm::img2col );
+        double const implicit_gemm = seconds( conv2d_algorithm::implicit_gemm );
+        unsigned long const col_bytes = bs * output_size * output_size * kernel * kernel * channels * sizeof( float );
+        std::cout << bs << " x " << size << " x " << size << " x " << channels << " -> " << filters << ", " << kernel << "x" << kernel << " stride " << stride
+                  << ", forward and backward: img2col " << img2col << " s with a " << col_bytes / ( 1024.0 * 1024.0 ) << " MB matrix, implicit GEMM " << implicit_gemm << " s" << std::endl;
+    }
+}
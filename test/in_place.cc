@@ -0,0 +1,117 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./dense_network.hpp"
+
+using namespace ceras;
+
+TEST_CASE( "in_place_single_consumer", "[in_place]" )
+{
+    typedef tensor<float> tensor_type;
+    auto& s = get_default_session<tensor_type>();
+    auto x = place_holder<tensor_type>{};
+    auto w = variable{ random<float>( {8, 6} ) };
+    auto b = variable{ random<float>( {1, 6} ) };
+    tensor_type const input = random<float>( {4, 8} );
+    s.bind( x, input );
+
+    auto affine = x * w + b;
+    tensor_type const expected = s.run( affine ).deep_copy();
+
+    // the output of the plus overwritten
+    auto r = relu( x * w + b );
+    tensor_type const rr = s.run( r );
+    REQUIRE( r.input_data_.data() == r.output_data_.data() );
+    for ( auto idx : range( expected.size() ) )
+        REQUIRE( rr[idx] == Approx( std::max( expected[idx], 0.0f ) ) );
+
+    in_place_execution = false;
+    s.run( r );
+    REQUIRE( r.input_data_.data() != r.output_data_.data() );
+    in_place_execution = true;
+
+    // the data of a variable are never overwritten
+    tensor_type const weights = w.data().deep_copy();
+    auto rw = relu( w );
+    s.run( rw );
+    REQUIRE( rw.input_data_.data() != rw.output_data_.data() );
+    for ( auto idx : range( weights.size() ) )
+        REQUIRE( w.data()[idx] == weights[idx] );
+
+    // nor the output of an operator whose backward pass reads it
+    auto rs = relu( sigmoid( x * w + b ) );
+    s.run( rs );
+    REQUIRE( rs.input_data_.data() != rs.output_data_.data() );
+
+    // a plus read by two operators
+    auto p = x * w + b;
+    auto two = relu( p ) + sigmoid( p );
+    tensor_type const tt = s.run( two );
+    for ( auto idx : range( expected.size() ) )
+        REQUIRE( tt[idx] == Approx( std::max( expected[idx], 0.0f ) + 1.0f / ( 1.0f + std::exp( -expected[idx] ) ) ) );
+
+    // the rows of a softmax
+    auto sm = softmax( x * w );
+    tensor_type const ss = s.run( sm );
+    REQUIRE( sm.input_data_.data() == sm.output_data_.data() );
+    for ( auto row : range( 4UL ) )
+        REQUIRE( std::accumulate( ss.begin()+row*6, ss.begin()+(row+1)*6, 0.0f ) == Approx( 1.0f ) );
+}
+
+TEST_CASE( "in_place_gradients", "[in_place]" )
+{
+    // finite differences of a loss through relu, tanh and sigmoid, all of them computed in place
+    typedef tensor<double> tensor_type;
+    auto& s = get_default_session<tensor_type>();
+    auto x = place_holder<tensor_type>{};
+    auto y = place_holder<tensor_type>{};
+    auto w1 = variable{ random<double>( {5, 6}, -1.0, 1.0 ) };
+    auto b1 = variable{ random<double>( {1, 6}, -1.0, 1.0 ) };
+    auto w2 = variable{ random<double>( {6, 6}, -1.0, 1.0 ) };
+    auto w3 = variable{ random<double>( {6, 3}, -1.0, 1.0 ) };
+    auto output = sigmoid( tanh( relu( x * w1 + b1 ) * w2 ) * w3 );
+    auto loss = sum_reduce( square( y - output ) ); // as mean_reduce scales the gradient by the batch size only
+    s.bind( x, random<double>( {4, 5}, -1.0, 1.0 ) );
+    s.bind( y, random<double>( {4, 3}, 0.0, 1.0 ) );
+
+    s.run( loss );
+    REQUIRE( output.input_data_.data() == output.output_data_.data() );
+    loss.backward( ones<double>( {1,} ) );
+
+    for ( auto [w, grad] : { std::make_tuple( w1, w1.gradient().deep_copy() ), std::make_tuple( w2, w2.gradient().deep_copy() ) } )
+        for ( auto idx : range( grad.size() ) )
+        {
+            double const delta = 1.0e-6;
+            double const original = w.data()[idx];
+            w.data()[idx] = original + delta;
+            double const upper = s.run( loss ).as_scalar();
+            w.data()[idx] = original - delta;
+            double const lower = s.run( loss ).as_scalar();
+            w.data()[idx] = original;
+            REQUIRE( grad[idx] == Approx( ( upper - lower ) / ( delta + delta ) ).margin( 1.0e-7 ) );
+        }
+}
+
+TEST_CASE( "in_place_benchmark", "[in_place_benchmark]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 1024;
+    auto& s = get_default_session<tensor_type>();
+
+    auto const& measure = [&]( bool in_place )
+    {
+        in_place_execution = in_place;
+        auto [x, y, output, loss, weights] = make_network<tensor_type>( 256, 256 );
+        s.bind( x, random<float>( {batch, 256} ) );
+        s.bind( y, random<float>( {batch, 256}, 0.0f, 1.0f ) );
+        auto optimizer = sgd{ loss, batch, 0.01f };
+        unsigned long const misses = memory_stats().misses;
+        auto const& [seconds, bytes] = benchmark_training( loss, optimizer, 20 );
+        std::cout << "20 training steps of a 7-layer perceptron of width 256, batch 1024, " << ( in_place ? "in place: " : "out of place: " ) << seconds << " s, a peak of "
+                  << bytes << " bytes, " << memory_stats().misses - misses << " blocks allocated" << std::endl;
+    };
+    measure( false );
+    measure( true );
+    in_place_execution = true;
+}
@@ -0,0 +1,205 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+// the reserved bytes of the class of `bytes`
+unsigned long reserved_of_class( unsigned long bytes )
+{
+    unsigned long const size = ceras_private::memory_class_size( ceras_private::memory_class( bytes ) );
+    for ( auto const& c : memory_stats().classes )
+        if ( c.size == size )
+            return c.reserved;
+    return 0;
+}
+
+TEST_CASE( "memory_statistics", "[memory_limit]" )
+{
+    trim_memory();
+    reset_memory_peak();
+    cached_allocator<float> alloc;
+    auto const before = memory_stats();
+    REQUIRE( before.reserved == 0 );
+
+    float* a = alloc.allocate( 1000 ); // 4096 bytes
+    auto const allocated = memory_stats();
+    REQUIRE( allocated.in_use == before.in_use + 4096 );
+    REQUIRE( allocated.peak == allocated.in_use );
+    REQUIRE( allocated.misses == before.misses + 1 );
+
+    alloc.deallocate( a, 1000 );
+    auto const freed = memory_stats();
+    REQUIRE( freed.in_use == before.in_use );
+    REQUIRE( freed.reserved == 4096 );
+    REQUIRE( freed.peak == allocated.peak );
+    REQUIRE( reserved_of_class( 4000 ) == 4096 );
+
+    float* b = alloc.allocate( 999 );
+    auto const reused = memory_stats();
+    REQUIRE( b == a );
+    REQUIRE( reused.hits == freed.hits + 1 );
+    REQUIRE( reused.reserved == 0 );
+    REQUIRE( reused.hit_ratio() > 0.0 );
+    alloc.deallocate( b, 999 );
+
+    reset_memory_peak();
+    REQUIRE( memory_stats().peak == memory_stats().in_use );
+
+    std::stringstream ss;
+    ss << memory_stats();
+    REQUIRE( ss.str().find( "ceras_memory_in_use_bytes " ) != std::string::npos );
+    REQUIRE( ss.str().find( "ceras_memory_class_reserved_bytes{size=\"4096\"} 4096" ) != std::string::npos );
+
+    trim_memory();
+    REQUIRE( memory_stats().reserved == 0 );
+}
+
+TEST_CASE( "memory_trim_lru", "[memory_limit]" )
+{
+    trim_memory();
+    cached_allocator<std::byte> alloc;
+    unsigned long const old_size = 3UL << 20;
+    unsigned long const new_size = 5UL << 20;
+    std::byte* old_block = alloc.allocate( old_size );
+    std::byte* new_block = alloc.allocate( new_size );
+    alloc.deallocate( old_block, old_size );
+    alloc.deallocate( new_block, new_size );
+    REQUIRE( memory_stats().reserved == old_size + new_size );
+
+    // the least recently freed block goes first
+    trim_memory( new_size );
+    REQUIRE( reserved_of_class( old_size ) == 0 );
+    REQUIRE( reserved_of_class( new_size ) == new_size );
+    trim_memory();
+    REQUIRE( memory_stats().reserved == 0 );
+}
+
+TEST_CASE( "memory_soft_limit", "[memory_limit]" )
+{
+    trim_memory();
+    cached_allocator<std::byte> alloc;
+    unsigned long const block = 1UL << 21;
+    memory_soft_limit = memory_stats().in_use + 8 * block;
+
+    std::vector<std::byte*> blocks;
+    for ( [[maybe_unused]] auto _ : range( 6 ) )
+        blocks.push_back( alloc.allocate( block ) );
+    for ( auto b : blocks )
+        alloc.deallocate( b, block );
+    REQUIRE( memory_stats().reserved == 6 * block ); // under the limit, all kept
+
+    // sizes of other classes, so that the free blocks do not serve them
+    blocks.clear();
+    for ( auto idx : range( 6UL ) )
+        blocks.push_back( alloc.allocate( block + ( idx + 1 ) * ( block / 4 ) ) );
+    REQUIRE( memory_stats().in_use > memory_soft_limit ); // the live blocks are not limited
+    REQUIRE( memory_stats().reserved == 0 );
+    for ( auto idx : range( 6UL ) )
+        alloc.deallocate( blocks[idx], block + ( idx + 1 ) * ( block / 4 ) );
+    REQUIRE( memory_stats().in_use + memory_stats().reserved <= memory_soft_limit );
+
+    memory_soft_limit = 0;
+    trim_memory();
+}
+
+TEST_CASE( "memory_soft_limit_live_above", "[memory_limit]" )
+{
+    // with the live blocks alone above the soft limit, a block freed still serves the next allocation
+    trim_memory();
+    cached_allocator<std::byte> alloc;
+    unsigned long const block = 1UL << 20;
+    memory_soft_limit = memory_stats().in_use + 4 * block;
+
+    std::vector<std::byte*> blocks;
+    for ( [[maybe_unused]] auto _ : range( 8 ) )
+        blocks.push_back( alloc.allocate( block ) );
+    unsigned long const misses = memory_stats().misses;
+    for ( [[maybe_unused]] auto _ : range( 100 ) )
+    {
+        alloc.deallocate( blocks.back(), block );
+        blocks.back() = alloc.allocate( block );
+    }
+    REQUIRE( memory_stats().misses == misses );
+
+    for ( auto b : blocks )
+        alloc.deallocate( b, block );
+    REQUIRE( memory_stats().in_use + memory_stats().reserved <= memory_soft_limit );
+    memory_soft_limit = 0;
+    trim_memory();
+}
+
+TEST_CASE( "memory_hard_limit", "[memory_limit]" )
+{
+    trim_memory();
+    cached_allocator<std::byte> alloc;
+    unsigned long const block = 1UL << 22;
+    memory_hard_limit = memory_stats().in_use + 3 * block;
+
+    std::byte* a = alloc.allocate( block );
+    std::byte* b = alloc.allocate( 2 * block );
+    REQUIRE_THROWS_AS( alloc.allocate( block ), std::bad_alloc );
+
+    // free blocks are returned to the system to make room
+    alloc.deallocate( b, 2 * block );
+    std::byte* c = alloc.allocate( 2 * block - block / 2 - 1 ); // of another class
+    REQUIRE( memory_stats().in_use + memory_stats().reserved <= memory_hard_limit );
+    alloc.deallocate( c, 2 * block - block / 2 - 1 );
+    alloc.deallocate( a, block );
+
+    // tensors
+    REQUIRE_THROWS_AS( ( tensor<float>{ {4 * block} } ), std::bad_alloc );
+    tensor<float> x{ {block / 8} };
+    REQUIRE( x.size() == block / 8 );
+
+    memory_hard_limit = 0;
+    trim_memory();
+}
+
+TEST_CASE( "memory_limit_benchmark", "[memory_limit_benchmark]" )
+{
+    // a long running process serving requests of varying sizes, without and with a soft limit
+    auto const& serve = [&]()
+    {
+        trim_memory();
+        reset_memory_peak();
+        auto const before = memory_stats();
+        std::mt19937 engine{ 0 };
+        auto const start = std::chrono::steady_clock::now();
+        for ( [[maybe_unused]] auto _ : range( 2000 ) )
+        {
+            tensor<float> x{ {( 1UL << 16 ) + engine() % ( 1UL << 20 )} };
+            x[0] = 1.0f;
+        }
+        double const seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        auto const stats = memory_stats();
+        double const hit_ratio = static_cast<double>( stats.hits - before.hits ) / static_cast<double>( stats.hits + stats.misses - before.hits - before.misses );
+        std::cout << "soft limit " << memory_soft_limit << ": " << seconds << " s, peak " << stats.peak << " bytes, reserved " << stats.reserved << " bytes, hit ratio " << hit_ratio << std::endl;
+    };
+    serve();
+    memory_soft_limit = 16UL << 20;
+    serve();
+
+    // the live tensors alone above the soft limit, while a tensor is freed and allocated again
+    {
+        trim_memory();
+        std::vector<tensor<float>> live;
+        for ( [[maybe_unused]] auto _ : range( 20 ) )
+            live.emplace_back( std::vector<unsigned long>{ 1UL << 18 } );
+        auto const before = memory_stats();
+        auto const start = std::chrono::steady_clock::now();
+        for ( [[maybe_unused]] auto _ : range( 2000 ) )
+        {
+            tensor<float> x{ {1UL << 18} };
+            x[0] = 1.0f;
+        }
+        double const seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        auto const stats = memory_stats();
+        double const hit_ratio = static_cast<double>( stats.hits - before.hits ) / static_cast<double>( stats.hits + stats.misses - before.hits - before.misses );
+        std::cout << "soft limit " << memory_soft_limit << ", " << stats.in_use << " bytes in use: " << seconds << " s, hit ratio " << hit_ratio << std::endl;
+    }
+    memory_soft_limit = 0;
+    trim_memory();
+}
@@ -0,0 +1,157 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./dense_network.hpp"
+
+using namespace ceras;
+
+TEST_CASE( "memory_planner_interval_coloring", "[memory_planner]" )
+{
+    using namespace ceras_private;
+    {
+        std::vector<memory_interval> const intervals{ {100, 0, 2}, {200, 1, 3}, {100, 3, 5}, {300, 4, 6} };
+        auto const& [offsets, arena] = interval_coloring( intervals, 1 );
+        REQUIRE( offsets == std::vector<unsigned long>{ 200, 0, 300, 0 } );
+        REQUIRE( arena == 400 );
+        REQUIRE( live_bytes_peak( intervals, 1 ) == 400 );
+    }
+
+    // buffers alive at the same time never share bytes
+    std::mt19937 engine{ 0 };
+    std::vector<memory_interval> intervals;
+    for ( [[maybe_unused]] auto _ : range( 500 ) )
+    {
+        unsigned long const first = engine() % 1000;
+        intervals.push_back( memory_interval{ 1 + engine() % 100000, first, first + engine() % 50 } );
+    }
+    auto const& [offsets, arena] = interval_coloring( intervals );
+    unsigned long total = 0;
+    for ( auto i : range( intervals.size() ) )
+    {
+        total += aligned_bytes( intervals[i].bytes );
+        REQUIRE( offsets[i] % memory_alignment == 0 );
+        REQUIRE( offsets[i] + intervals[i].bytes <= arena );
+        for ( auto j : range( i ) )
+            if ( intervals[i].first <= intervals[j].last && intervals[j].first <= intervals[i].last )
+                REQUIRE( ( offsets[i] + intervals[i].bytes <= offsets[j] || offsets[j] + intervals[j].bytes <= offsets[i] ) );
+    }
+    REQUIRE( arena >= live_bytes_peak( intervals ) );
+    REQUIRE( arena < total );
+}
+
+TEST_CASE( "memory_planner_borrowed_vector", "[memory_planner]" )
+{
+    std::vector<float> arena( 16, 1.0f );
+    {
+        vector<float, cached_allocator<float>> v( 8 );
+        v.borrow( arena.data() + 4, 8 );
+        REQUIRE( v.borrowed() );
+        v.data()[0] = 2.0f;
+        REQUIRE( arena[4] == 2.0f );
+        v.resize( 8 ); // the same size keeps the storage
+        REQUIRE( v.data() == arena.data() + 4 );
+        v.resize( 9 ); // another one is allocated
+        REQUIRE( !v.borrowed() );
+        v.borrow( arena.data(), 16 );
+    } // not deallocated
+    REQUIRE( arena[4] == 2.0f );
+}
+
+TEST_CASE( "memory_planner_training", "[memory_planner]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 32;
+    auto [x, y, output, loss, weights] = make_network<tensor_type>( 96, 96 );
+    std::vector<tensor_type> initial_weights;
+    for ( auto& w : weights )
+        initial_weights.push_back( w.data().deep_copy() );
+
+    auto& s = get_default_session<tensor_type>();
+    tensor_type const input = random<float>( {batch, 96} );
+    tensor_type const target = random<float>( {batch, 96}, 0.0f, 1.0f );
+    s.bind( x, input );
+    s.bind( y, target );
+    auto optimizer = sgd{ loss, batch, 0.1f };
+
+    auto const& train = [&]()
+    {
+        for ( auto idx : range( weights.size() ) )
+            weights[idx].data().deep_copy( initial_weights[idx] );
+        std::vector<float> losses;
+        for ( [[maybe_unused]] auto _ : range( 5 ) )
+        {
+            losses.push_back( s.run( loss ).as_scalar() );
+            s.run( optimizer );
+        }
+        return std::make_tuple( losses, s.run( output ).deep_copy(), weights[2].data().deep_copy() );
+    };
+
+    auto const& [losses, prediction, trained] = train();
+    benchmark_training( loss, optimizer, 1 );
+    unsigned long const unplanned_memory = memory_stats().peak;
+
+    memory_plan const plan = s.plan_memory( loss );
+    REQUIRE( plan.buffers > 0 );
+    REQUIRE( plan.peak_bytes <= plan.arena_bytes );
+    REQUIRE( plan.arena_bytes < plan.unplanned_bytes );
+    REQUIRE( s.memory_arena_ );
+
+    // the planned buffers keep their bytes in the arena: a training step takes fewer bytes at peak, the arena included
+    benchmark_training( loss, optimizer, 1 );
+    REQUIRE( memory_stats().peak < unplanned_memory );
+    for ( auto const& planned : s.planned_buffers_ )
+    {
+        auto const storage = planned.lock();
+        REQUIRE( ( storage && (*storage).borrowed() ) );
+    }
+
+    // the same steps give the same results
+    auto const& [planned_losses, planned_prediction, planned_trained] = train();
+    for ( auto idx : range( losses.size() ) )
+        REQUIRE( planned_losses[idx] == Approx( losses[idx] ) );
+    for ( auto idx : range( prediction.size() ) )
+        REQUIRE( planned_prediction[idx] == Approx( prediction[idx] ) );
+    for ( auto idx : range( trained.size() ) )
+        REQUIRE( planned_trained[idx] == Approx( trained[idx] ) );
+
+    // leaving the learning phase releases the plan
+    learning_phase = 0;
+    tensor_type const inferred = s.run( output ).deep_copy();
+    REQUIRE( !s.memory_arena_ );
+    auto const inference_plan = s.plan_memory( output );
+    REQUIRE( inference_plan.arena_bytes < plan.arena_bytes ); // the activations share bytes once consumed
+    for ( [[maybe_unused]] auto _ : range( 2 ) )
+    {
+        tensor_type const planned_inferred = s.run( output );
+        for ( auto idx : range( inferred.size() ) )
+            REQUIRE( planned_inferred[idx] == Approx( inferred[idx] ) );
+    }
+    learning_phase = 1;
+    s.release_memory_plan();
+}
+
+TEST_CASE( "memory_planner_benchmark", "[memory_planner_benchmark]" )
+{
+    typedef tensor<float> tensor_type;
+    unsigned long const batch = 256;
+    auto [x, y, output, loss, weights] = make_network<tensor_type>( 512, 512 );
+    auto& s = get_default_session<tensor_type>();
+    s.bind( x, random<float>( {batch, 512} ) );
+    s.bind( y, random<float>( {batch, 512}, 0.0f, 1.0f ) );
+    auto optimizer = sgd{ loss, batch, 0.01f };
+
+    s.run( loss );
+    s.run( optimizer );
+    auto const& [unplanned, unplanned_peak] = benchmark_training( loss, optimizer, 10 );
+    unsigned long const unplanned_memory = memory_stats().peak;
+
+    memory_plan const plan = s.plan_memory( loss );
+    auto const& [planned, planned_peak] = benchmark_training( loss, optimizer, 10 );
+    unsigned long const planned_memory = memory_stats().peak;
+
+    std::cout << plan << std::endl;
+    std::cout << "10 training steps of a 7-layer perceptron of width 512, batch 256: unplanned " << unplanned << " s with a peak of " << unplanned_memory << " bytes in use, "
+              << unplanned_peak << " above the steps; planned " << planned << " s with a peak of " << planned_memory << " bytes in use, " << planned_peak << " above the steps" << std::endl;
+    s.release_memory_plan();
+}
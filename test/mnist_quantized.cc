@@ -0,0 +1,69 @@
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <iostream>
+
+// accuracy and throughput of the float model and of its int8 quantization on the test set
+int main()
+{
+    using namespace ceras;
+    random_generator.seed( 42 );
+
+    auto input = Input( {28, 28} ); // shape( 28, 28 )
+    auto l0 = Reshape({28, 28, 1})( input );
+    auto l1 = ReLU( Conv2D( 32, {3, 3}, "same" )(l0) );
+    auto l2 = MaxPooling2D( 2 )( l1 );
+    auto l3 = ReLU( Conv2D( 64, {3, 3}, "same" )(l2) );
+    auto l4 = MaxPooling2D( 2 )( l3 ); // 7, 7, 64
+    auto l5 = Flatten()( l4 );
+    auto l6 = ReLU( Dense( 128 )( l5 ) );
+    auto output = Dense( 10 )( l6 );
+    auto m = model( input, output );
+
+    std::size_t const batch_size = 1000;
+    float learning_rate = 0.005f;
+    auto cm = m.compile( CategoricalCrossentropy(), SGD(batch_size, learning_rate) );
+
+    unsigned long epoches = 5;
+    int verbose = 1;
+    double validation_split = 0.1;
+    auto const& [x_training, y_training, x_test, y_test] = dataset::mnist::load_data();
+
+    auto const x_train = x_training.as_type<float>()/255.0f;
+    cm.fit( x_train, y_training.as_type<float>(), batch_size, epoches, verbose, validation_split );
+
+    // calibrate the activations on the first 1000 training samples
+    unsigned long const calibration_samples = 1000;
+    tensor<float> x_calibration{ {calibration_samples, 28, 28} };
+    std::copy_n( x_train.begin(), x_calibration.size(), x_calibration.begin() );
+    auto qm = m.quantize( x_calibration, 100 );
+
+    auto const x = x_test.as_type<float>()/255.0f;
+    unsigned long const samples = x.shape()[0];
+    unsigned long const predict_batch = 500;
+    auto const& report = [&]( auto& predictor, char const* name )
+    {
+        tensor<float> batch{ {predict_batch, 28, 28} };
+        unsigned long correct = 0;
+        double elapsed = 0.0;
+        for ( unsigned long first = 0; first + predict_batch <= samples; first += predict_batch )
+        {
+            std::copy_n( x.begin() + first * 28 * 28, batch.size(), batch.begin() );
+            auto const start = std::chrono::steady_clock::now();
+            auto prediction = predictor.predict( batch );
+            elapsed += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            for ( auto idx : range( predict_batch ) )
+            {
+                auto const row = prediction.begin() + idx * 10;
+                unsigned long const predicted = std::max_element( row, row + 10 ) - row;
+                correct += y_test[(first+idx)*10+predicted];
+            }
+        }
+        unsigned long const evaluated = samples / predict_batch * predict_batch;
+        std::cout << name << ": accuracy " << 1.0 * correct / evaluated << ", " << evaluated / elapsed << " samples/s" << std::endl;
+    };
+
+    report( m, "float" );
+    report( qm, "int8" );
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <cmath>
+
+using namespace ceras;
+
+template< Tensor Tsor >
+void require_close( Tsor const& lhs, Tsor const& rhs )
+{
+    REQUIRE( lhs.size() == rhs.size() );
+    for ( auto idx : range( lhs.size() ) )
+        REQUIRE( std::abs( lhs[idx] - rhs[idx] ) < 1.0e-4 );
+}
+
+TEST_CASE( "packed_data_cache", "[packed_weight]" )
+{
+    auto w = variable{ random<float>( {13, 7} ) };
+
+    auto const* first = w.packed_data( false, false, 13, 7 ).data_.get();
+    REQUIRE( w.packed_data( false, false, 13, 7 ).data_.get() == first ); // reused
+    REQUIRE( w.packed_data( false, true, 7, 13 ).data_.get() != first ); // another layout
+
+    std::as_const( w ).data(); // read only access keeps the packed copies
+    REQUIRE( w.packed_data( false, false, 13, 7 ).data_.get() == first );
+
+    w.data() *= 2.0f; // write access invalidates them
+    auto const& repacked = w.packed_data( false, false, 13, 7 );
+    auto x = random<float>( {5, 13} );
+    auto y = zeros<float>( {5, 7} );
+    cpu_gemm( x.data(), false, repacked, 5, 13, 7, y.data() );
+    require_close( y, x * w.data() );
+}
+
+TEST_CASE( "packed_dense", "[packed_weight]" )
+{
+    auto x = place_holder<tensor<float>>{};
+    auto w = variable{ random<float>( {11, 6} ) };
+    auto y = x * w;
+
+    auto& s = get_default_session<tensor<float>>();
+    auto input = random<float>( {4, 11} );
+    s.bind( x, input );
+
+    for ( [[maybe_unused]] auto step : range( 3 ) )
+    {
+        auto output = s.run( y );
+        require_close( output, input * w.data() );
+
+        auto grad = random<float>( {4, 6} );
+        y.backward( grad );
+
+        // gradient of x is grad * w^T, checked through the expression gradient of the weight: x^T * grad
+        auto expected = zeros<float>( {11, 6} );
+        gemm( input.data(), true, grad.data(), false, 11, 4, 6, expected.data() );
+        require_close( w.gradient(), expected );
+
+        w.data() -= 0.1f * w.gradient(); // an optimizer step
+    }
+}
+
+TEST_CASE( "packed_dense_input_gradient", "[packed_weight]" )
+{
+    auto x = variable{ random<float>( {4, 11} ) };
+    auto w = variable{ random<float>( {11, 6} ) };
+    auto y = x * w;
+
+    auto& s = get_default_session<tensor<float>>();
+    s.run( y );
+    auto grad = random<float>( {4, 6} );
+    y.backward( grad );
+
+    auto expected = zeros<float>( {4, 11} );
+    gemm( grad.data(), false, w.data().data(), true, 4, 6, 11, expected.data() );
+    require_close( x.gradient(), expected );
+}
+
+TEST_CASE( "packed_conv2d", "[packed_weight]" )
+{
+    auto x = variable{ random<double>( {2, 6, 6, 2} ) };
+    auto w = variable{ random<double>( {4, 3, 3, 2} ) };
+    auto y = conv2d( 6, 6, 1, 1, 1, 1, "same" )( x, w );
+
+    auto& s = get_default_session<tensor<double>>();
+    auto packed_output = s.run( y ).deep_copy();
+    auto grad = random<double>( packed_output.shape() );
+    y.backward( grad );
+    auto packed_gradient = x.gradient().deep_copy();
+
+    // the same convolution with a kernel that is not read from a variable directly
+    auto z = conv2d( 6, 6, 1, 1, 1, 1, "same" )( x, w * value<double>{1.0} );
+    auto reference = s.run( z );
+    z.backward( grad );
+    require_close( packed_output, reference );
+    require_close( packed_gradient, x.gradient() );
+}
@@ -0,0 +1,196 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace ceras;
+
+TEST_CASE( "parallel_for_coverage", "[parallel_for]" )
+{
+    set_parallel_threads( 4 );
+    for ( double cost : { 1.0, 1000.0, 1.0e6 } )
+    {
+        for ( unsigned long n : { 0UL, 1UL, 7UL, 100UL, 100003UL } )
+        {
+            std::vector<std::atomic<unsigned long>> visits( n );
+            parallel_for( [&]( unsigned long idx ){ visits[idx].fetch_add( 1 ); }, n, cost );
+            for ( auto const& v : visits )
+                REQUIRE( v.load() == 1 );
+        }
+
+        for ( auto [rows, cols] : { std::make_tuple( 0UL, 5UL ), std::make_tuple( 5UL, 0UL ), std::make_tuple( 1UL, 1UL ), std::make_tuple( 13UL, 7UL ), std::make_tuple( 301UL, 257UL ) } )
+        {
+            std::vector<std::atomic<unsigned long>> visits( rows * cols );
+            parallel_for( [&]( unsigned long r, unsigned long c ){ REQUIRE( ( r < rows && c < cols ) ); visits[r*cols+c].fetch_add( 1 ); }, rows, cols, cost );
+            for ( auto const& v : visits )
+                REQUIRE( v.load() == 1 );
+        }
+
+        std::vector<std::atomic<unsigned long>> visits( 17 * 11 * 29 );
+        parallel_for( [&]( unsigned long i, unsigned long j, unsigned long k ){ visits[(i*11+j)*29+k].fetch_add( 1 ); }, 17UL, 11UL, 29UL, cost );
+        for ( auto const& v : visits )
+            REQUIRE( v.load() == 1 );
+    }
+}
+
+TEST_CASE( "parallel_for_grain", "[parallel_for]" )
+{
+    set_parallel_threads( 4 );
+    // cheap loops stay on the calling thread
+    REQUIRE( ceras_private::parallel_grain( 9, 1.0 ) == 9 );
+    REQUIRE( ceras_private::parallel_grain( 1000, 10.0 ) == 1000 );
+    // expensive ones are split in at most 16 tasks per thread, each of at least parallel_grain_cost
+    REQUIRE( ceras_private::parallel_grain( 1UL << 20, 1.0 ) == ( 1UL << 20 ) / 64 );
+    REQUIRE( ceras_private::parallel_grain( 9, 1.0e6 ) == 1 );
+    unsigned long const grain = ceras_private::parallel_grain( 100000, 1.0 );
+    REQUIRE( grain * 1.0 >= static_cast<double>( parallel_grain_cost ) );
+
+    std::thread::id const caller = std::this_thread::get_id();
+    bool elsewhere = false;
+    parallel_for( [&]( unsigned long ){ if ( std::this_thread::get_id() != caller ) elsewhere = true; }, 1000UL );
+    REQUIRE( !elsewhere );
+
+    set_parallel_threads( 1 );
+    REQUIRE( ceras_private::parallel_grain( 1UL << 20, 1.0 ) == ( 1UL << 20 ) );
+    set_parallel_threads( 4 );
+}
+
+TEST_CASE( "parallel_reduce", "[parallel_for]" )
+{
+    set_parallel_threads( 4 );
+    for ( unsigned long n : { 0UL, 1UL, 1000UL, 1000003UL } )
+    {
+        unsigned long const sum = parallel_reduce( n, 0UL, []( unsigned long first, unsigned long last, unsigned long init )
+        {
+            for ( auto idx : range( first, last ) )
+                init += idx;
+            return init;
+        }, std::plus<unsigned long>{} );
+        REQUIRE( sum == ( n ? n * ( n - 1 ) / 2 : 0 ) );
+    }
+
+    // the ranges are combined in order
+    std::string const order = parallel_reduce( 100UL, std::string{}, []( unsigned long first, unsigned long last, std::string init )
+    {
+        for ( auto idx : range( first, last ) )
+            init += std::to_string( idx ) + ",";
+        return init;
+    }, std::plus<std::string>{}, 1.0e6 );
+    std::string expected;
+    for ( auto idx : range( 100UL ) )
+        expected += std::to_string( idx ) + ",";
+    REQUIRE( order == expected );
+
+    // reproducible
+    auto const x = random<float>( {1UL << 20} );
+    float const first = sum( x );
+    for ( [[maybe_unused]] auto _ : range( 10 ) )
+        REQUIRE( sum( x ) == first );
+}
+
+TEST_CASE( "parallel_reductions", "[parallel_for]" )
+{
+    set_parallel_threads( 4 );
+    auto const x = random<double>( {64, 33, 129} );
+
+    double reference = 0.0;
+    for ( auto idx : range( x.size() ) )
+        reference += x[idx];
+    REQUIRE( sum( x ) == Approx( reference ) );
+    REQUIRE( reduce_sum( x )[0] == Approx( reference ) );
+    REQUIRE( reduce_mean( x )[0] == Approx( reference / x.size() ) );
+
+    double squares = 0.0;
+    for ( auto idx : range( x.size() ) )
+        squares += ( x[idx] - reference / x.size() ) * ( x[idx] - reference / x.size() );
+    REQUIRE( var( x ) == Approx( squares ) );
+
+    // along an axis
+    auto const s1 = sum( x, 1 );
+    auto const v1 = variance( x, 1 );
+    REQUIRE( s1.shape() == std::vector<unsigned long>{ {64, 129} } );
+    for ( auto i : range( 64UL ) )
+        for ( auto k : range( 129UL ) )
+        {
+            double s = 0.0;
+            for ( auto j : range( 33UL ) )
+                s += x[(i*33+j)*129+k];
+            double v = 0.0;
+            for ( auto j : range( 33UL ) )
+                v += ( x[(i*33+j)*129+k] - s / 33.0 ) * ( x[(i*33+j)*129+k] - s / 33.0 );
+            REQUIRE( s1[i*129+k] == Approx( s ) );
+            REQUIRE( v1[i*129+k] == Approx( v / 33.0 ) );
+        }
+
+    // softmax rows
+    auto const p = softmax( x );
+    for ( auto row : range( 64UL * 33UL ) )
+    {
+        double mx = x[row*129];
+        for ( auto c : range( 129UL ) )
+            mx = std::max( mx, x[row*129+c] );
+        double total = 0.0;
+        for ( auto c : range( 129UL ) )
+            total += std::exp( x[row*129+c] - mx );
+        for ( auto c : range( 129UL ) )
+            REQUIRE( p[row*129+c] == Approx( std::exp( x[row*129+c] - mx ) / total ) );
+    }
+
+    // the operators
+    auto vx = variable{ x.deep_copy() };
+    auto& s = get_default_session<tensor<double>>();
+    auto axis_sum_op = reduce_sum( 1 )( vx );
+    auto const axis_sum = s.run( axis_sum_op ).deep_copy();
+    for ( auto idx : range( axis_sum.size() ) )
+        REQUIRE( axis_sum[idx] == Approx( s1[idx] ) );
+    auto activation_op = softmax( vx );
+    auto const activation = s.run( activation_op ).deep_copy();
+    for ( auto idx : range( activation.size() ) )
+        REQUIRE( activation[idx] == Approx( p[idx] ) );
+
+    // batch normalization in training, over the last axis
+    auto normalized_op = normalization_batch( 0.9 )( vx );
+    auto const normalized = s.run( normalized_op ).deep_copy();
+    for ( auto c : range( 129UL ) )
+    {
+        double m = 0.0;
+        for ( auto r : range( 64UL * 33UL ) )
+            m += x[r*129+c];
+        m /= 64.0 * 33.0;
+        double v = 0.0;
+        for ( auto r : range( 64UL * 33UL ) )
+            v += ( x[r*129+c] - m ) * ( x[r*129+c] - m );
+        v /= 64.0 * 33.0;
+        for ( auto r : { 0UL, 1000UL, 64UL * 33UL - 1UL } )
+            REQUIRE( normalized[r*129+c] == Approx( ( x[r*129+c] - m ) / std::sqrt( v + eps ) ) );
+    }
+}
+
+TEST_CASE( "parallel_for_benchmark", "[parallel_for_benchmark]" )
+{
+    auto const x = random<float>( {1UL << 24} );
+    auto const y = random<float>( {4096, 1000} );
+    auto const& seconds = [&]( auto const& func )
+    {
+        func();
+        double best = 1.0e10;
+        for ( [[maybe_unused]] auto _ : range( 5 ) )
+        {
+            auto const start = std::chrono::steady_clock::now();
+            func();
+            best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+        }
+        return best;
+    };
+    for ( unsigned long threads : { 1UL, 0UL } )
+    {
+        set_parallel_threads( threads );
+        double const summation = seconds( [&](){ return sum( x ); } );
+        double const activation = seconds( [&](){ return softmax( y ); } );
+        double const axis = seconds( [&](){ return variance( y, 0 ); } );
+        std::cout << parallel_threads() << " threads: sum of " << x.size() << " floats " << summation << " s, softmax of 4096 x 1000 " << activation
+                  << " s, variance along the rows of 4096 x 1000 " << axis << " s" << std::endl;
+    }
+}
@@ -0,0 +1,76 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+// a 1x1 convolution against img2col
+template< typename T >
+void check_pointwise( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters, unsigned long stride, std::string const& padding, double tolerance )
+{
+    auto const x = random<T>( {bs, rows, cols, channels} );
+    auto const w = random<T>( {filters, 1, 1, channels} );
+    auto const grad = random<T>( {bs, ( rows - 1 ) / stride + 1, ( cols - 1 ) / stride + 1, filters} );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, w, grad, stride, 1, padding );
+    auto const& [pointwise_output, pointwise_x_grad, pointwise_w_grad] = convolve( conv2d_algorithm::automatic, x, w, grad, stride, 1, padding );
+    REQUIRE( pointwise_output.shape() == output.shape() );
+    for ( auto idx : range( output.size() ) )
+        REQUIRE( static_cast<double>( pointwise_output[idx] ) == Approx( static_cast<double>( output[idx] ) ).epsilon( tolerance ).margin( tolerance ) );
+    for ( auto idx : range( x_grad.size() ) )
+        REQUIRE( static_cast<double>( pointwise_x_grad[idx] ) == Approx( static_cast<double>( x_grad[idx] ) ).epsilon( tolerance ).margin( tolerance ) );
+    for ( auto idx : range( w_grad.size() ) )
+        REQUIRE( static_cast<double>( pointwise_w_grad[idx] ) == Approx( static_cast<double>( w_grad[idx] ) ).epsilon( tolerance ).margin( tolerance ) );
+}
+
+TEST_CASE( "pointwise_conv2d", "[pointwise_conv2d]" )
+{
+    conv2d_geometry g{ 2, 8, 8, 16, 32, 1, 1, 0, 0, 1, 1, 1, 1 };
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::pointwise );
+    REQUIRE( select_conv2d_algorithm<bfloat16>( g ) == conv2d_algorithm::pointwise );
+    conv2d_geometry strided = g;
+    strided.row_stride = 2;
+    REQUIRE( select_conv2d_algorithm<float>( strided ) == conv2d_algorithm::pointwise );
+    REQUIRE( select_conv2d_algorithm<bfloat16>( strided ) == conv2d_algorithm::img2col );
+    conv2d_geometry padded = g;
+    padded.row_padding = 1;
+    REQUIRE( select_conv2d_algorithm<float>( padded ) == conv2d_algorithm::implicit_gemm );
+
+    check_pointwise<double>( 2, 7, 9, 3, 5, 1, "valid", 1.0e-10 );
+    check_pointwise<double>( 3, 8, 8, 17, 9, 1, "same", 1.0e-10 );
+    check_pointwise<double>( 2, 9, 7, 6, 11, 2, "valid", 1.0e-10 );
+    check_pointwise<double>( 1, 10, 11, 13, 4, 3, "same", 1.0e-10 );
+    check_pointwise<float>( 4, 14, 14, 64, 32, 1, "same", 1.0e-4 );
+    check_pointwise<float>( 4, 14, 14, 32, 64, 2, "valid", 1.0e-4 );
+}
+
+TEST_CASE( "pointwise_conv2d_benchmark", "[pointwise_conv2d_benchmark]" )
+{
+    for ( auto [bs, size, channels, filters, stride] : { std::make_tuple( 32UL, 56UL, 64UL, 256UL, 1UL ), std::make_tuple( 32UL, 28UL, 256UL, 128UL, 1UL ),
+                                                         std::make_tuple( 32UL, 14UL, 512UL, 512UL, 1UL ), std::make_tuple( 32UL, 56UL, 256UL, 512UL, 2UL ) } )
+    {
+        auto const x = random<float>( {bs, size, size, channels} );
+        auto const w = random<float>( {filters, 1, 1, channels} );
+        auto const grad = random<float>( {bs, ( size - 1 ) / stride + 1, ( size - 1 ) / stride + 1, filters} );
+        auto const& seconds = [&]( conv2d_algorithm algorithm )
+        {
+            convolve( algorithm, x, w, grad, stride, 1, "valid" );
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 3 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                convolve( algorithm, x, w, grad, stride, 1, "valid" );
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return best;
+        };
+        double const img2col = seconds( conv2d_algorithm::img2col );
+        double const implicit_gemm = seconds( conv2d_algorithm::implicit_gemm );
+        double const pointwise = seconds( conv2d_algorithm::automatic );
+        std::cout << bs << " x " << size << " x " << size << " x " << channels << " -> " << filters << ", 1x1 stride " << stride << ", forward and backward: img2col " << img2col
+                  << " s, implicit GEMM " << implicit_gemm << " s, pointwise " << pointwise << " s" << std::endl;
+    }
+}
@@ -0,0 +1,186 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace ceras;
+
+// a [rows x cols] matrix of integers in [-127, 127], scaled by scales[row] or scales[col], with 127 in every channel so that its int8 quantization is exact
+std::vector<float> exact_matrix( unsigned long rows, unsigned long cols, std::vector<float> const& scales, bool per_row )
+{
+    std::vector<float> ans( rows * cols );
+    for ( auto r : range( rows ) )
+        for ( auto c : range( cols ) )
+        {
+            float const value = ( r == c || ( per_row ? c == 0 : r == 0 ) ) ? 127.0f : static_cast<float>( static_cast<int>( ( r * 31 + c * 17 ) % 255 ) - 127 );
+            ans[r*cols+c] = value * scales[per_row ? r : c];
+        }
+    return ans;
+}
+
+std::vector<float> reference_gemm( std::vector<float> const& a, std::vector<float> const& b, unsigned long m, unsigned long n, unsigned long k )
+{
+    std::vector<float> ans( m * k, 0.0f );
+    for ( auto r : range( m ) )
+        for ( auto c : range( k ) )
+        {
+            double sum = 0.0;
+            for ( auto d : range( n ) )
+                sum += static_cast<double>( a[r*n+d] ) * static_cast<double>( b[d*k+c] );
+            ans[r*k+c] = static_cast<float>( sum );
+        }
+    return ans;
+}
+
+std::vector<float> channel_scales( unsigned long channels )
+{
+    std::vector<float> ans( channels );
+    for ( auto idx : range( channels ) )
+        ans[idx] = 0.5f + 0.25f * static_cast<float>( idx % 5 );
+    return ans;
+}
+
+void check_exact( unsigned long m, unsigned long n, unsigned long k )
+{
+    // activation scale 1, per-channel weight scales
+    std::vector<float> const unit_rows( m, 1.0f );
+    std::vector<float> const unit_cols( k, 1.0f );
+
+    {
+        std::vector<float> const a = exact_matrix( m, n, unit_rows, true );
+        std::vector<float> const b = exact_matrix( n, k, channel_scales( k ), false );
+        std::vector<float> const expected = reference_gemm( a, b, m, n, k );
+        std::vector<float> c( m * k, -1.0f );
+        cpu_gemm_int8( a.data(), false, 127.0f, cpu_quantize_rhs( b.data(), false, n, k ), m, n, k, c.data() );
+        for ( auto idx : range( m * k ) )
+            REQUIRE( std::abs( c[idx] - expected[idx] ) <= 1.0e-5f * std::max( 1.0f, std::abs( expected[idx] ) ) );
+    }
+
+    {
+        std::vector<float> const a = exact_matrix( m, n, channel_scales( m ), true );
+        std::vector<float> const b = exact_matrix( n, k, unit_cols, false );
+        std::vector<float> const expected = reference_gemm( a, b, m, n, k );
+        std::vector<float> c( m * k, -1.0f );
+        cpu_gemm_int8( cpu_quantize_lhs( a.data(), false, m, n ), b.data(), false, 127.0f, m, n, k, c.data() );
+        for ( auto idx : range( m * k ) )
+            REQUIRE( std::abs( c[idx] - expected[idx] ) <= 1.0e-5f * std::max( 1.0f, std::abs( expected[idx] ) ) );
+    }
+}
+
+TEST_CASE( "cpu_gemm_int8_exact", "[cpu_gemm_int8_exact]" )
+{
+    isa const detected = detected_isa();
+    for ( auto instruction_set : { isa::generic, isa::sse42, isa::avx2, isa::avx512 } )
+    {
+        if ( instruction_set > detected )
+            continue;
+        set_isa( instruction_set );
+        for ( auto [m, n, k] : { std::make_tuple( 1UL, 1UL, 1UL ), std::make_tuple( 7UL, 13UL, 5UL ), std::make_tuple( 37UL, 130UL, 75UL ), std::make_tuple( 64UL, 257UL, 48UL ) } )
+            check_exact( m, n, k );
+    }
+    set_isa( detected );
+}
+
+TEST_CASE( "cpu_gemm_int8_threads", "[cpu_gemm_int8_threads]" )
+{
+    cpu_gemm_config const backup = get_cpu_gemm_config();
+    get_cpu_gemm_config().threads = 8;
+    get_cpu_gemm_config().parallel_threshold = 0;
+    check_exact( 5, 2048, 7 ); // depth splits
+    check_exact( 97, 300, 131 ); // 2D blocks
+    get_cpu_gemm_config() = backup;
+}
+
+TEST_CASE( "cpu_gemm_int8_transposed", "[cpu_gemm_int8_transposed]" )
+{
+    unsigned long const m = 19, n = 41, k = 23;
+    auto const a = random<float>( {n, m} );
+    auto const b = random<float>( {k, n} );
+    tensor<float> expected{ {m, k} };
+    gemm( a.data(), true, b.data(), true, m, n, k, expected.data() );
+
+    float a_range = 0.0f;
+    for ( auto v : a )
+        a_range = std::max( a_range, std::abs( v ) );
+
+    tensor<float> c{ {m, k} };
+    cpu_gemm_int8( a.data(), true, a_range, cpu_quantize_rhs( b.data(), true, n, k ), m, n, k, c.data() );
+    for ( auto idx : range( m * k ) )
+        REQUIRE( std::abs( c[idx] - expected[idx] ) < 0.05f * ( 1.0f + std::abs( expected[idx] ) ) );
+
+    // with the range of the activation, and an epilogue
+    cpu_gemm_int8( cpu_quantize_lhs( a.data(), true, m, n ), b.data(), true, 0.0f, m, n, k, c.data(),
+                   []( float* p, unsigned long ldc, unsigned long, unsigned long rows, unsigned long, unsigned long cols ){ for ( auto r : range( rows ) ) for ( auto j : range( cols ) ) p[r*ldc+j] += 1.0f; } );
+    for ( auto idx : range( m * k ) )
+        REQUIRE( std::abs( c[idx] - expected[idx] - 1.0f ) < 0.05f * ( 1.0f + std::abs( expected[idx] ) ) );
+}
+
+template< Tensor Tsor >
+double relative_error( Tsor const& x, Tsor const& y )
+{
+    double diff = 0.0;
+    double norm = 0.0;
+    for ( auto idx : range( x.size() ) )
+    {
+        diff += ( x[idx] - y[idx] ) * ( x[idx] - y[idx] );
+        norm += y[idx] * y[idx];
+    }
+    return std::sqrt( diff / std::max( norm, 1.0e-20 ) );
+}
+
+TEST_CASE( "quantized_model", "[quantized_model]" )
+{
+    random_generator.seed( 42 );
+    auto input = Input( {12, 12} );
+    auto l0 = Reshape( {12, 12, 1} )( input );
+    auto l1 = ReLU( Conv2D( 8, {3, 3}, "same" )( l0 ) );
+    auto l2 = MaxPooling2D( 2 )( l1 );
+    auto l3 = Flatten()( l2 );
+    auto l4 = Dense( 32, "relu" )( l3 );
+    auto output = Dense( 10 )( l4 );
+    auto m = model( input, output );
+
+    auto const calibration = random<float>( {64, 12, 12} );
+    auto const samples = random<float>( {16, 12, 12} );
+
+    auto const expected = m.predict( samples ).deep_copy();
+    auto qm = m.quantize( calibration, 16 );
+    auto const prediction = qm.predict( samples ).deep_copy();
+    auto const again = m.predict( samples ).deep_copy();
+
+    REQUIRE( prediction.shape() == expected.shape() );
+    REQUIRE( relative_error( again, expected ) < 1.0e-6 );
+    REQUIRE( relative_error( prediction, expected ) > 0.0 );
+    REQUIRE( relative_error( prediction, expected ) < 0.05 );
+    REQUIRE( quantization_phase == quantization_mode::none );
+}
+
+TEST_CASE( "cpu_gemm_int8_benchmark", "[cpu_gemm_int8_benchmark]" )
+{
+    for ( auto [m, n, k] : { std::make_tuple( 256UL, 1024UL, 1024UL ), std::make_tuple( 64UL, 784UL, 256UL ), std::make_tuple( 32UL, 288UL, 12544UL ) } )
+    {
+        auto const a = random<float>( {m, n} );
+        auto const b = random<float>( {n, k} );
+        tensor<float> c{ {m, k} };
+        auto const packed = cpu_pack_rhs( b.data(), false, n, k );
+        auto const quantized = cpu_quantize_rhs( b.data(), false, n, k );
+
+        auto const& gflops = [&]( auto const& func )
+        {
+            func();
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 5 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                func();
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return 2.0e-9 * m * n * k / best;
+        };
+        double const float_gflops = gflops( [&](){ cpu_gemm( a.data(), false, packed, m, n, k, c.data() ); } );
+        double const int8_gflops = gflops( [&](){ cpu_gemm_int8( a.data(), false, 1.0f, quantized, m, n, k, c.data() ); } );
+        std::cout << m << " x " << n << " x " << k << ": float " << float_gflops << " GFLOP/s, int8 " << int8_gflops << " GOP/s, speedup " << int8_gflops / float_gflops << "x" << std::endl;
+    }
+}
@@ -0,0 +1,110 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cstdlib>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace ceras;
+
+// first, so that the pool is created from the environment
+TEST_CASE( "thread_affinity_environment", "[thread_affinity]" )
+{
+    std::string const cpu = std::to_string( ceras_private::available_cpus()[0] );
+    setenv( "CERAS_CPU_AFFINITY", cpu.c_str(), 1 );
+    setenv( "CERAS_NUM_THREADS", "3", 1 );
+    REQUIRE( parallel_threads() == 3 );
+#if defined(__linux__)
+    REQUIRE( parallel_affinity() == std::vector<unsigned long>{ ceras_private::available_cpus()[0] } );
+#endif
+    unsetenv( "CERAS_CPU_AFFINITY" );
+    unsetenv( "CERAS_NUM_THREADS" );
+}
+
+TEST_CASE( "thread_affinity_cpu_list", "[thread_affinity]" )
+{
+    using ceras_private::parse_cpu_list;
+    REQUIRE( parse_cpu_list( "3" ) == std::vector<unsigned long>{ 3 } );
+    REQUIRE( parse_cpu_list( "0-3" ) == std::vector<unsigned long>{ 0, 1, 2, 3 } );
+    REQUIRE( parse_cpu_list( "0-1,8,16-17" ) == std::vector<unsigned long>{ 0, 1, 8, 16, 17 } );
+    REQUIRE( parse_cpu_list( "" ).empty() );
+    REQUIRE( parse_cpu_list( "a" ).empty() );
+    REQUIRE( parse_cpu_list( "3-1" ).empty() );
+    REQUIRE( parse_cpu_list( "1:2" ).empty() );
+}
+
+TEST_CASE( "thread_affinity_pinning", "[thread_affinity]" )
+{
+#if defined(__linux__)
+    auto const& available = ceras_private::available_cpus();
+    REQUIRE( !available.empty() );
+    unsigned long const cpu = available.back();
+
+    REQUIRE( set_parallel_affinity( { cpu }, 4 ) );
+    REQUIRE( parallel_threads() == 4 );
+    REQUIRE( parallel_affinity() == std::vector<unsigned long>{ cpu } );
+    std::vector<int> cpus( 64, -1 );
+    parallel( [&]( unsigned long idx ){ cpus[idx] = sched_getcpu(); }, 0UL, cpus.size(), 1UL );
+    for ( auto c : cpus )
+        REQUIRE( c == static_cast<int>( cpu ) );
+
+    // one thread per cpu by default
+    REQUIRE( set_parallel_affinity( available ) );
+    REQUIRE( parallel_threads() == available.size() );
+
+    // unavailable cpus leave the threads unchanged
+    REQUIRE( !set_parallel_affinity( { CPU_SETSIZE + 1UL } ) );
+    REQUIRE( parallel_affinity() == available );
+
+    // the thread count is kept by set_parallel_threads, the pinning is cleared by an empty list
+    set_parallel_threads( 2 );
+    REQUIRE( parallel_affinity() == available );
+    REQUIRE( set_parallel_affinity( {} ) );
+    REQUIRE( parallel_affinity().empty() );
+    REQUIRE( parallel_threads() == 2 );
+    cpu_set_t mask;
+    REQUIRE( 0 == sched_getaffinity( 0, sizeof( mask ), &mask ) );
+    REQUIRE( static_cast<unsigned long>( CPU_COUNT( &mask ) ) == available.size() );
+#endif
+    set_parallel_threads( 0 );
+}
+
+TEST_CASE( "thread_affinity_first_touch", "[thread_affinity]" )
+{
+    set_parallel_threads( 4 );
+    bool const backup = numa_first_touch;
+    numa_first_touch = true;
+    for ( [[maybe_unused]] auto _ : range( 3 ) )
+    {
+        // the blocks are zeroed, including the cached ones written before
+        tensor<float> x{ {( 1UL << 20 ) + 17UL} };
+        for ( auto idx : range( x.size() ) )
+            REQUIRE( x[idx] == 0.0f );
+        std::fill( x.begin(), x.end(), 1.0f );
+    }
+    numa_first_touch = backup;
+    set_parallel_threads( 0 );
+}
+
+TEST_CASE( "thread_affinity_benchmark", "[thread_affinity_benchmark]" )
+{
+    set_parallel_threads( std::max( 4U, std::thread::hardware_concurrency() ) );
+    auto const& seconds = [&]( bool first_touch )
+    {
+        numa_first_touch = first_touch;
+        auto const start = std::chrono::steady_clock::now();
+        for ( unsigned long idx = 0; idx != 16; ++idx )
+        {
+            tensor<float> x{ {( 1UL << 24 ) + idx * 1024UL + ( first_touch ? 512UL : 0UL )} }; // fresh blocks, not reused from the cache
+            x[0] = 1.0f;
+        }
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    };
+    double const serial = seconds( false );
+    double const first_touch = seconds( true );
+    numa_first_touch = false;
+    std::cout << "allocating 16 tensors of 64 MB on " << parallel_threads() << " threads: serial zeroing " << serial << " s, first-touch zeroing " << first_touch << " s" << std::endl;
+}
@@ -0,0 +1,155 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+TEST_CASE( "thread_pool_coverage", "[thread_pool]" )
+{
+    set_parallel_threads( 4 );
+    REQUIRE( parallel_threads() == 4 );
+
+    // every index visited exactly once, below, at and above the number of tasks of a job
+    for ( unsigned long n : { 0UL, 1UL, 3UL, 9UL, 63UL, 64UL, 65UL, 1000UL, 123457UL } )
+    {
+        std::vector<std::atomic<unsigned long>> visits( n );
+        parallel( [&]( unsigned long idx ){ visits[idx].fetch_add( 1 ); }, 0UL, n, 1UL );
+        for ( auto const& v : visits )
+            REQUIRE( v.load() == 1 );
+    }
+
+    // offset ranges
+    std::vector<std::atomic<unsigned long>> visits( 100 );
+    parallel( [&]( unsigned long idx ){ visits[idx].fetch_add( 1 ); }, 37UL, 100UL, 1UL );
+    for ( auto idx : range( 100UL ) )
+        REQUIRE( visits[idx].load() == ( idx >= 37 ? 1UL : 0UL ) );
+}
+
+TEST_CASE( "thread_pool_nested", "[thread_pool]" )
+{
+    set_parallel_threads( 4 );
+    std::vector<std::atomic<unsigned long>> visits( 64 * 64 );
+    parallel( [&]( unsigned long r )
+    {
+        parallel( [&]( unsigned long c ){ visits[r*64+c].fetch_add( 1 ); }, 0UL, 64UL, 1UL );
+    }, 0UL, 64UL, 1UL );
+    for ( auto const& v : visits )
+        REQUIRE( v.load() == 1 );
+}
+
+TEST_CASE( "thread_pool_exception", "[thread_pool]" )
+{
+    set_parallel_threads( 4 );
+    std::atomic<unsigned long> visited{ 0 };
+    REQUIRE_THROWS_AS( parallel( [&]( unsigned long idx ){ visited.fetch_add( 1 ); if ( idx == 517 ) throw std::runtime_error{ "task 517" }; }, 0UL, 1000UL, 1UL ), std::runtime_error );
+    REQUIRE( visited.load() <= 1000 ); // the task of the throwing index stops there, the others run
+
+    // the pool is still usable
+    std::atomic<unsigned long> sum{ 0 };
+    parallel( [&]( unsigned long idx ){ sum.fetch_add( idx ); }, 0UL, 1000UL, 1UL );
+    REQUIRE( sum.load() == 999UL * 1000UL / 2UL );
+}
+
+TEST_CASE( "thread_pool_resize", "[thread_pool]" )
+{
+    for ( unsigned long threads : { 1UL, 2UL, 3UL, 8UL, 4UL } )
+    {
+        set_parallel_threads( threads );
+        REQUIRE( parallel_threads() == threads );
+        std::atomic<unsigned long> sum{ 0 };
+        parallel( [&]( unsigned long idx ){ sum.fetch_add( idx ); }, 0UL, 10000UL, 1UL );
+        REQUIRE( sum.load() == 9999UL * 10000UL / 2UL );
+    }
+    set_parallel_threads( 0 );
+    REQUIRE( parallel_threads() == std::max( 1U, std::thread::hardware_concurrency() ) );
+    set_parallel_threads( 4 );
+}
+
+TEST_CASE( "thread_pool_concurrent_callers", "[thread_pool]" )
+{
+    set_parallel_threads( 4 );
+    // loops posted from several threads at once share the pool or run on their caller
+    std::vector<unsigned long> sums( 4, 0 );
+    std::vector<std::thread> callers;
+    for ( auto caller : range( 4UL ) )
+        callers.emplace_back( [&sums, caller]()
+        {
+            for ( [[maybe_unused]] auto _ : range( 200 ) )
+            {
+                std::atomic<unsigned long> sum{ 0 };
+                parallel( [&]( unsigned long idx ){ sum.fetch_add( idx ); }, 0UL, 1000UL, 1UL );
+                sums[caller] += sum.load();
+            }
+        } );
+    for ( auto& caller : callers )
+        caller.join();
+    for ( auto sum : sums )
+        REQUIRE( sum == 200UL * 999UL * 1000UL / 2UL );
+}
+
+TEST_CASE( "thread_pool_tiny_jobs", "[thread_pool]" )
+{
+    // back to back jobs of a few tasks, the workers of a job often still stealing when the next one starts
+    set_parallel_threads( 8 );
+    std::vector<std::atomic<unsigned long>> visits( 8 );
+    for ( auto job : range( 100000UL ) )
+    {
+        unsigned long const n = 1 + job % 8;
+        parallel( [&]( unsigned long idx ){ visits[idx].fetch_add( 1, std::memory_order_relaxed ); }, 0UL, n, 1UL );
+        for ( auto idx : range( n ) )
+            REQUIRE( visits[idx].exchange( 0 ) == 1 );
+    }
+    set_parallel_threads( 4 );
+}
+
+TEST_CASE( "thread_pool_gemm", "[thread_pool]" )
+{
+    set_parallel_threads( 3 );
+    auto const a = random<float>( {67, 129} );
+    auto const b = random<float>( {129, 93} );
+    tensor<float> c{ {67, 93} };
+    gemm( a.data(), false, b.data(), false, 67, 129, 93, c.data() );
+    for ( auto r : range( 67UL ) )
+        for ( auto col : range( 93UL ) )
+        {
+            double expected = 0.0;
+            for ( auto k : range( 129UL ) )
+                expected += a[r*129+k] * b[k*93+col];
+            REQUIRE( c[r*93+col] == Approx( expected ).epsilon( 1.0e-4 ) );
+        }
+    set_parallel_threads( 0 );
+}
+
+TEST_CASE( "thread_pool_benchmark", "[thread_pool_benchmark]" )
+{
+    set_parallel_threads( std::max( 4U, std::thread::hardware_concurrency() ) );
+    std::vector<float> data( 4096, 1.0f );
+    unsigned long const calls = 10000;
+    unsigned long const threads = parallel_threads();
+
+    auto const start = std::chrono::steady_clock::now();
+    for ( [[maybe_unused]] auto _ : range( calls ) )
+        parallel( [&]( unsigned long idx ){ data[idx] = data[idx] * 0.5f + 0.5f; }, 0UL, data.size(), 1UL );
+    double const pool = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    // the former strategy: threads spawned and joined by each call
+    auto const spawn_start = std::chrono::steady_clock::now();
+    for ( [[maybe_unused]] auto _ : range( calls ) )
+    {
+        std::vector<std::thread> workers;
+        unsigned long const chunk = ( data.size() + threads - 1 ) / threads;
+        for ( auto t : range( threads ) )
+            workers.emplace_back( [&, t]()
+            {
+                for ( unsigned long idx = t * chunk; idx < std::min( data.size(), ( t + 1 ) * chunk ); ++idx )
+                    data[idx] = data[idx] * 0.5f + 0.5f;
+            } );
+        for ( auto& worker : workers )
+            worker.join();
+    }
+    double const spawn = std::chrono::duration<double>( std::chrono::steady_clock::now() - spawn_start ).count();
+
+    std::cout << calls << " parallel loops of " << data.size() << " indices on " << threads << " threads: thread pool " << pool << " s, threads spawned per call " << spawn << " s" << std::endl;
+}
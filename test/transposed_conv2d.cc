@@ -0,0 +1,149 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace ceras;
+
+template< typename T >
+double dot( tensor<T> const& x, tensor<T> const& y )
+{
+    double ans = 0.0;
+    for ( auto idx : range( x.size() ) )
+        ans += x[idx] * y[idx];
+    return ans;
+}
+
+// output, input gradient and kernel gradient of conv2d_transpose computed by `algorithm`
+template< typename T >
+auto transposed_convolve( conv2d_algorithm algorithm, tensor<T> const& x, tensor<T> const& w, unsigned long stride, unsigned long dilation, std::string const& padding, tensor<T> const& grad )
+{
+    conv2d_algorithm const backup = convolution_algorithm;
+    convolution_algorithm = algorithm;
+    auto vx = variable{ x.deep_copy() };
+    auto vw = variable{ w.deep_copy() };
+    auto y = conv2d_transpose( w.shape()[1], w.shape()[2], stride, stride, dilation, dilation, padding )( vx, vw );
+    auto& s = get_default_session<tensor<T>>();
+    auto output = s.run( y ).deep_copy();
+    if ( grad.size() )
+        y.backward( grad );
+    convolution_algorithm = backup;
+    return std::make_tuple( output, vx.gradient().deep_copy(), vw.gradient().deep_copy() );
+}
+
+// the transposed convolution by its definition, output[a*stride + r*dilation - padding] += input[a] * kernels[r]
+void check_transposed_conv2d( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters, unsigned long kernel,
+                              unsigned long stride, unsigned long dilation, std::string const& padding )
+{
+    auto const x = random<double>( {bs, rows, cols, channels} );
+    auto const w = random<double>( {filters, kernel, kernel, channels} );
+    conv2d_geometry const g = ceras_private::transposed_conv2d_geometry( bs, rows, cols, channels, filters, kernel, kernel, stride, stride, dilation, dilation, padding == "same" );
+    unsigned long const span = dilation * ( kernel - 1 ) + 1;
+    unsigned long const output_rows = ( padding == "same" ) ? rows * stride : ( rows - 1 ) * stride + span;
+    unsigned long const output_cols = ( padding == "same" ) ? cols * stride : ( cols - 1 ) * stride + span;
+    // the larger half of the total padding before the output
+    unsigned long const pad = ( padding == "same" && span > stride ) ? ( span - stride + 1 ) / 2 : 0;
+
+    auto expected = zeros<double>( {bs, output_rows, output_cols, filters} );
+    for ( auto b : range( bs ) )
+        for ( auto y : range( rows ) )
+            for ( auto z : range( cols ) )
+                for ( auto r : range( kernel ) )
+                    for ( auto c : range( kernel ) )
+                    {
+                        std::int64_t const row = static_cast<std::int64_t>( y * stride + r * dilation ) - static_cast<std::int64_t>( pad );
+                        std::int64_t const col = static_cast<std::int64_t>( z * stride + c * dilation ) - static_cast<std::int64_t>( pad );
+                        if ( row < 0 || row >= static_cast<std::int64_t>( output_rows ) || col < 0 || col >= static_cast<std::int64_t>( output_cols ) )
+                            continue;
+                        for ( auto nc : range( filters ) )
+                            for ( auto ch : range( channels ) )
+                                expected[( ( b * output_rows + row ) * output_cols + col ) * filters + nc] +=
+                                    x[( ( b * rows + y ) * cols + z ) * channels + ch] * w[ceras_private::transposed_conv2d_kernel_offset( g, ch, nc, r, c )];
+                    }
+
+    auto const grad = random<double>( expected.shape() );
+    for ( auto algorithm : { conv2d_algorithm::automatic, conv2d_algorithm::img2col } )
+    {
+        auto const& [output, x_grad, w_grad] = transposed_convolve( algorithm, x, w, stride, dilation, padding, grad );
+        REQUIRE( output.shape() == expected.shape() );
+        for ( auto idx : range( output.size() ) )
+            REQUIRE( output[idx] == Approx( expected[idx] ) );
+        // the operator is linear in the input and in the kernels, the gradients are the adjoints
+        REQUIRE( dot( output, grad ) == Approx( dot( x, x_grad ) ) );
+        REQUIRE( dot( output, grad ) == Approx( dot( w, w_grad ) ) );
+    }
+}
+
+TEST_CASE( "transposed_conv2d", "[transposed_conv2d]" )
+{
+    check_transposed_conv2d( 1, 2, 2, 1, 1, 2, 1, 1, "valid" );
+    check_transposed_conv2d( 2, 5, 6, 3, 4, 3, 1, 1, "same" );
+    check_transposed_conv2d( 2, 5, 6, 3, 4, 3, 2, 1, "same" );
+    check_transposed_conv2d( 2, 5, 4, 3, 2, 3, 2, 1, "valid" );
+    check_transposed_conv2d( 1, 4, 5, 2, 3, 4, 2, 1, "same" );
+    check_transposed_conv2d( 2, 3, 3, 2, 5, 5, 3, 1, "valid" );
+    check_transposed_conv2d( 2, 4, 4, 3, 2, 3, 2, 2, "same" );
+    check_transposed_conv2d( 1, 6, 5, 4, 3, 2, 1, 1, "same" );
+}
+
+// unit strides compute as the convolution of the zero padded input with the flipped kernels did,
+// except for even kernels with same padding, whose output now keeps the size of the input
+TEST_CASE( "transposed_conv2d_unit_stride", "[transposed_conv2d]" )
+{
+    for ( std::string const padding : { "valid", "same" } )
+        for ( auto kernel : { 2UL, 3UL, 5UL } )
+        {
+            if ( padding == "same" && kernel % 2 == 0 )
+                continue;
+            auto const x = random<double>( {2, 7, 6, 3} );
+            auto const w = random<double>( {4, kernel, kernel, 3} );
+            auto const& [output, x_grad, w_grad] = transposed_convolve( conv2d_algorithm::automatic, x, w, 1, 1, padding, tensor<double>{} );
+
+            auto vx = variable{ x.deep_copy() };
+            auto vw = variable{ w.deep_copy() };
+            auto y = general_conv2d( 1, 1, 1, 1, padding )( conv2d_tranpose_intermediate( kernel, kernel, 1, 1, padding )( vx ), flip(1)(flip(2)(vw)) );
+            auto& s = get_default_session<tensor<double>>();
+            auto const expected = s.run( y );
+            REQUIRE( output.shape() == expected.shape() );
+            for ( auto idx : range( output.size() ) )
+                REQUIRE( output[idx] == Approx( expected[idx] ) );
+        }
+}
+
+TEST_CASE( "transposed_conv2d_benchmark", "[transposed_conv2d_benchmark]" )
+{
+    for ( auto [bs, size, channels, filters] : { std::make_tuple( 64UL, 7UL, 128UL, 64UL ), std::make_tuple( 64UL, 14UL, 64UL, 32UL ), std::make_tuple( 16UL, 32UL, 64UL, 64UL ) } )
+    {
+        auto const x = random<float>( {bs, size, size, channels} );
+        auto const w = random<float>( {filters, 3, 3, channels} );
+        auto const grad = random<float>( {bs, 2 * size, 2 * size, filters} );
+        auto const& seconds = [&]( auto const& run )
+        {
+            run();
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 3 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                run();
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return best;
+        };
+        double const direct = seconds( [&](){ transposed_convolve( conv2d_algorithm::automatic, x, w, 2, 1, "same", grad ); } );
+        double const col2img = seconds( [&](){ transposed_convolve( conv2d_algorithm::img2col, x, w, 2, 1, "same", grad ); } );
+        // the zero-inserted input, twice the size in rows and columns, convolved with unit strides
+        double const zero_inserted = seconds( [&]()
+        {
+            auto vx = variable{ x.deep_copy() };
+            auto vw = variable{ w.deep_copy() };
+            auto y = general_conv2d( 1, 1, 1, 1, "same" )( conv2d_tranpose_intermediate( 3, 3, 2, 2, "same" )( vx ), flip(1)(flip(2)(vw)) );
+            auto& s = get_default_session<tensor<float>>();
+            s.run( y );
+            y.backward( grad );
+        } );
+        std::cout << bs << " x " << size << " x " << size << " x " << channels << " -> " << filters << ", 3x3 stride 2, forward and backward: implicit GEMM " << direct
+                  << " s, col2img " << col2img << " s, convolution of the zero-inserted input " << zero_inserted << " s" << std::endl;
+    }
+}
@@ -0,0 +1,121 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include "../include/ceras.hpp"
+#include "./conv2d_reference.hpp"
+#include <chrono>
+
+using namespace ceras;
+
+template< typename T >
+void check_winograd( unsigned long bs, unsigned long rows, unsigned long cols, unsigned long channels, unsigned long filters, std::string const& padding, double tolerance )
+{
+    auto const x = random<T>( {bs, rows, cols, channels} );
+    auto const w = random<T>( {filters, 3, 3, channels} );
+    unsigned long const pad = ( padding == "same" ) ? 1 : 0;
+    auto const grad = random<T>( {bs, rows + 2*pad - 2, cols + 2*pad - 2, filters} );
+
+    auto const& [output, x_grad, w_grad] = convolve( conv2d_algorithm::img2col, x, w, grad, 1, 1, padding );
+    for ( auto algorithm : { conv2d_algorithm::winograd_2x2, conv2d_algorithm::winograd_4x4 } )
+    {
+        auto const& [winograd_output, winograd_x_grad, winograd_w_grad] = convolve( algorithm, x, w, grad, 1, 1, padding );
+        REQUIRE( relative_error( winograd_output, output ) < tolerance );
+        REQUIRE( relative_error( winograd_x_grad, x_grad ) < tolerance );
+        REQUIRE( relative_error( winograd_w_grad, w_grad ) < tolerance );
+    }
+}
+
+TEST_CASE( "winograd_double", "[winograd]" )
+{
+    // partial tiles, single channels and filters
+    check_winograd<double>( 1, 3, 3, 1, 1, "valid", 1.0e-12 );
+    check_winograd<double>( 2, 7, 9, 3, 5, "same", 1.0e-12 );
+    check_winograd<double>( 2, 7, 9, 3, 5, "valid", 1.0e-12 );
+    check_winograd<double>( 3, 16, 13, 8, 4, "same", 1.0e-12 );
+}
+
+TEST_CASE( "winograd_float", "[winograd]" )
+{
+    check_winograd<float>( 4, 12, 12, 16, 32, "same", 1.0e-4 );
+    check_winograd<float>( 2, 28, 28, 32, 64, "same", 1.0e-4 );
+    check_winograd<float>( 2, 11, 6, 17, 9, "valid", 1.0e-4 );
+}
+
+TEST_CASE( "winograd_selection", "[winograd]" )
+{
+    conv2d_geometry g{ 8, 28, 28, 32, 64, 3, 3, 1, 1, 1, 1, 1, 1 };
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::winograd_4x4 );
+    REQUIRE( select_conv2d_algorithm<bfloat16>( g ) == conv2d_algorithm::img2col );
+
+    conv2d_geometry small = g;
+    small.rows = 3;
+    small.cols = 3;
+    REQUIRE( select_conv2d_algorithm<float>( small ) == conv2d_algorithm::winograd_2x2 );
+
+    conv2d_geometry strided = g;
+    strided.row_stride = 2;
+    REQUIRE( select_conv2d_algorithm<float>( strided ) == conv2d_algorithm::implicit_gemm );
+
+    conv2d_geometry dilated = g;
+    dilated.col_dilation = 2;
+    REQUIRE( select_conv2d_algorithm<float>( dilated ) == conv2d_algorithm::implicit_gemm );
+
+    conv2d_geometry large = g;
+    large.kernel_rows = 5;
+    large.kernel_cols = 5;
+    REQUIRE( select_conv2d_algorithm<float>( large ) == conv2d_algorithm::implicit_gemm );
+
+    // a forced Winograd algorithm still falls back to the implicit GEMM where it does not apply
+    conv2d_algorithm const backup = convolution_algorithm;
+    convolution_algorithm = conv2d_algorithm::winograd_2x2;
+    REQUIRE( select_conv2d_algorithm<float>( g ) == conv2d_algorithm::winograd_2x2 );
+    REQUIRE( select_conv2d_algorithm<float>( strided ) == conv2d_algorithm::implicit_gemm );
+    REQUIRE( select_conv2d_algorithm<bfloat16>( strided ) == conv2d_algorithm::img2col );
+    convolution_algorithm = backup;
+
+    // the other convolutions are unchanged
+    auto x = variable{ random<double>( {2, 9, 9, 3} ) };
+    auto w = variable{ random<double>( {4, 3, 3, 3} ) };
+    auto y = general_conv2d( 2, 2, 1, 1, "valid" )( x, w );
+    auto& s = get_default_session<tensor<double>>();
+    auto const output = s.run( y );
+    REQUIRE( output.shape() == std::vector<unsigned long>{ {2, 4, 4, 4} } );
+    for ( auto r : range( 4UL ) )
+        for ( auto c : range( 4UL ) )
+            for ( auto nc : range( 4UL ) )
+            {
+                double expected = 0.0;
+                for ( auto ch : range( 3UL ) )
+                    for ( auto i : range( 3UL ) )
+                        for ( auto j : range( 3UL ) )
+                            expected += x.data()[( ( 9 + 2*r + i ) * 9 + 2*c + j ) * 3 + ch] * w.data()[( nc * 3 + ch ) * 9 + i * 3 + j];
+                REQUIRE( output[( ( 4 + r ) * 4 + c ) * 4 + nc] == Approx( expected ) );
+            }
+}
+
+TEST_CASE( "winograd_benchmark", "[winograd_benchmark]" )
+{
+    for ( auto [bs, size, channels, filters] : { std::make_tuple( 32UL, 28UL, 32UL, 64UL ), std::make_tuple( 16UL, 56UL, 64UL, 64UL ), std::make_tuple( 8UL, 14UL, 256UL, 256UL ) } )
+    {
+        auto const x = random<float>( {bs, size, size, channels} );
+        auto const w = random<float>( {filters, 3, 3, channels} );
+        auto const grad = random<float>( {bs, size, size, filters} );
+        auto const& seconds = [&]( conv2d_algorithm algorithm )
+        {
+            convolve( algorithm, x, w, grad, 1, 1, "same" );
+            double best = 1.0e10;
+            for ( [[maybe_unused]] auto _ : range( 3 ) )
+            {
+                auto const start = std::chrono::steady_clock::now();
+                convolve( algorithm, x, w, grad, 1, 1, "same" );
+                best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+            }
+            return best;
+        };
+        double const img2col = seconds( conv2d_algorithm::img2col );
+        double const winograd_2x2 = seconds( conv2d_algorithm::winograd_2x2 );
+        double const winograd_4x4 = seconds( conv2d_algorithm::winograd_4x4 );
+        std::cout << bs << " x " << size << " x " << size << " x " << channels << " -> " << filters << ", forward and backward: img2col " << img2col
+                  << " s, winograd 2x2 " << winograd_2x2 << " s, winograd 4x4 " << winograd_4x4 << " s" << std::endl;
+    }
+}